@@ -30,7 +30,6 @@ layout(location = 2) out vec4 out_Velocity;
 layout (push_constant) uniform Constants
 {
 	int MaterialIndex;
-	int TransformsIndex;
 } constants;
 
 layout(binding = 2) uniform sampler2D u_AlbedoMap;
@@ -61,12 +60,14 @@ void main()
 	mat3 tbn = mat3(tangent, bitangent, normal);
 
 	vec3 texColor 	= pow(texture(u_AlbedoMap, texcoord).rgb, vec3(GAMMA));
-	vec3 normalMap 	= texture(u_NormalMap, texcoord).rgb;
+	vec2 normalMap 	= texture(u_NormalMap, texcoord).rg;
 	float ao 		= texture(u_AmbientOcclusionMap, texcoord).r;
 	float metallic 	= texture(u_MetallicMap, texcoord).r;
 	float roughness = texture(u_RoughnessMap, texcoord).r;
 
-	vec3 sampledNormal 	= ((normalMap * 2.0f) - 1.0f);
+	//Normal maps can be BC5 compressed and only store x and y, z is reconstructed
+	vec3 sampledNormal 	= vec3((normalMap * 2.0f) - 1.0f, 0.0f);
+	sampledNormal.z 	= sqrt(max(0.0f, 1.0f - dot(sampledNormal.xy, sampledNormal.xy)));
 	sampledNormal 		= normalize(tbn * normalize(sampledNormal));
 
 	MaterialParameters materialParameters = u_MaterialParameters.mp[constants.MaterialIndex];
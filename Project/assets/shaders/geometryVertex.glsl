@@ -1,14 +1,6 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
-struct Vertex
-{
-	vec4 Position;
-	vec4 Normal;
-	vec4 Tangent;
-	vec4 TexCoord;
-};
-
 struct MaterialParameters
 {
 	vec4 Albedo;
@@ -34,7 +26,6 @@ layout(location = 5) out vec4 out_PrevPosition;
 layout (push_constant) uniform Constants
 {
 	int MaterialIndex;
-	int TransformsIndex;
 } constants;
 
 layout (binding = 0) uniform PerFrameBuffer
@@ -50,11 +41,15 @@ layout (binding = 0) uniform PerFrameBuffer
 	vec4 Up;
 } g_PerFrame;
 
+layout (constant_id = 0) const int VERTEX_FORMAT = 0;
+
 layout(binding = 1) buffer vertexBuffer
 {
-	Vertex vertices[];
+	uint vertexData[];
 };
 
+#include "vertexFormat.glsl"
+
 layout(binding = 7, set = 0) buffer CombinedMaterialParameters
 {
 	MaterialParameters mp[];
@@ -65,22 +60,30 @@ layout(binding = 8, set = 0) buffer CombinedInstanceTransforms
 	InstanceTransforms t[];
 } u_Transforms;
 
-void main()
+//Transform index of every instance, the draws start at their own offset through the first instance
+layout(binding = 9, set = 0) buffer InstanceIndices
 {
-	mat4 currTransform = u_Transforms.t[constants.TransformsIndex].CurrTransform;
-	mat4 prevTransform = u_Transforms.t[constants.TransformsIndex].PrevTransform;
+	uint i[];
+} u_InstanceIndices;
 
-	vec3 position 				= vertices[gl_VertexIndex].Position.xyz;
-    vec3 normal 				= vertices[gl_VertexIndex].Normal.xyz;
-	vec3 tangent 				= vertices[gl_VertexIndex].Tangent.xyz;
+void main()
+{
+	uint transformsIndex = u_InstanceIndices.i[gl_InstanceIndex];
+	mat4 currTransform = u_Transforms.t[transformsIndex].CurrTransform;
+	mat4 prevTransform = u_Transforms.t[transformsIndex].PrevTransform;
+
+	Vertex vertex 				= loadVertex(uint(gl_VertexIndex));
+	vec3 position 				= vertex.Position;
+    vec3 normal 				= vertex.Normal;
+	vec3 tangent 				= vertex.Tangent;
 	vec4 worldPosition 			= currTransform * vec4(position, 1.0);
 	vec4 prevWorldPosition 		= prevTransform * vec4(position, 1.0);
 
 	normal 	= normalize((currTransform * vec4(normal, 0.0)).xyz);
 	tangent = normalize((currTransform * vec4(tangent, 0.0)).xyz);
 
-	vec3 bitangent 	= normalize(cross(normal, tangent));
-	vec2 texCoord 	= vertices[gl_VertexIndex].TexCoord.xy;
+	vec3 bitangent 	= normalize(cross(normal, tangent)) * vertex.BitangentSign;
+	vec2 texCoord 	= vertex.TexCoord;
 
 	vec4 viewPosition 		= g_PerFrame.View 		* worldPosition;
 	vec4 prevViewPosition 	= g_PerFrame.LastView 	* prevWorldPosition;
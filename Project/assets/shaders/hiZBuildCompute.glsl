@@ -0,0 +1,57 @@
+#version 450
+
+layout(local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+layout(push_constant) uniform Constants
+{
+	ivec2 SourceSize;
+	ivec2 DestinationSize;
+	uint IsFirstLevel;
+} u_Constants;
+
+layout(binding = 0, set = 0) uniform sampler2D u_Depth;
+layout(binding = 1, set = 0, r32f) readonly uniform image2D u_Source;
+layout(binding = 2, set = 0, r32f) writeonly uniform image2D u_Destination;
+
+float loadSource(ivec2 texel)
+{
+	return imageLoad(u_Source, min(texel, u_Constants.SourceSize - ivec2(1))).r;
+}
+
+void main()
+{
+	ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+	if (any(greaterThanEqual(texel, u_Constants.DestinationSize)))
+	{
+		return;
+	}
+
+	float depth = 0.0f;
+	if (u_Constants.IsFirstLevel != 0)
+	{
+		depth = texelFetch(u_Depth, texel, 0).r;
+	}
+	else
+	{
+		ivec2 source = texel * 2;
+		depth = max(max(loadSource(source), loadSource(source + ivec2(1, 0))), max(loadSource(source + ivec2(0, 1)), loadSource(source + ivec2(1, 1))));
+
+		//The last texel of a level takes in the row or column that an odd size leaves over, so that no depth is missed
+		bool hasExtraColumn	= (u_Constants.SourceSize.x & 1) != 0 && texel.x == u_Constants.DestinationSize.x - 1;
+		bool hasExtraRow	= (u_Constants.SourceSize.y & 1) != 0 && texel.y == u_Constants.DestinationSize.y - 1;
+		if (hasExtraColumn)
+		{
+			depth = max(depth, max(loadSource(source + ivec2(2, 0)), loadSource(source + ivec2(2, 1))));
+		}
+		if (hasExtraRow)
+		{
+			depth = max(depth, max(loadSource(source + ivec2(0, 2)), loadSource(source + ivec2(1, 2))));
+		}
+		if (hasExtraColumn && hasExtraRow)
+		{
+			depth = max(depth, loadSource(source + ivec2(2, 2)));
+		}
+	}
+
+	imageStore(u_Destination, texel, vec4(depth));
+}
@@ -0,0 +1,201 @@
+#version 450
+
+layout(local_size_x = 64, local_size_y = 1, local_size_z = 1) in;
+
+//Has to match GPUCullerVK.h
+const uint PHASE_EARLY	= 0;
+const uint PHASE_LATE	= 1;
+
+struct CullObject
+{
+	vec4 CenterRadius;
+	vec3 Extent;
+	uint BatchIndex;
+	uint FirstIndex;
+	uint IndexCount;
+	uint FirstDraw;
+	uint DrawIndex;
+};
+
+struct DrawIndexedIndirectCommand
+{
+	uint IndexCount;
+	uint InstanceCount;
+	uint FirstIndex;
+	int  VertexOffset;
+	uint FirstInstance;
+};
+
+layout(push_constant) uniform Constants
+{
+	uint Phase;
+} u_Constants;
+
+layout(binding = 0, set = 0) readonly buffer Objects
+{
+	CullObject o[];
+} u_Objects;
+
+layout(binding = 1, set = 0) writeonly buffer Commands
+{
+	DrawIndexedIndirectCommand c[];
+} u_Commands;
+
+layout(binding = 2, set = 0) buffer Counts
+{
+	uint c[];
+} u_Counts;
+
+layout(binding = 3, set = 0) writeonly buffer InstanceIndices
+{
+	uint i[];
+} u_InstanceIndices;
+
+layout(binding = 4, set = 0) buffer Occluded
+{
+	uint o[];
+} u_Occluded;
+
+layout(binding = 5, set = 0) uniform CullingParams
+{
+	vec4 FrustumPlanes[6];
+	mat4 ViewProjection;
+	mat4 LastViewProjection;
+	vec2 HiZSize;
+	uint HiZLevelCount;
+	uint ObjectCount;
+	uint FirstInstance;
+	uint FirstLateInstance;
+	uint IsCompacted;
+	uint IsOcclusionEnabled;
+	uint LateCommandOffset;
+	uint LateCountOffset;
+} u_Params;
+
+layout(binding = 6, set = 0) uniform sampler2D u_HiZ;
+
+//Same test as ObjectCuller, a plane culls the object when either its box or its sphere is behind it
+bool isInFrustum(CullObject object)
+{
+	for (uint p = 0; p < 6; p++)
+	{
+		vec4 plane		= u_Params.FrustumPlanes[p];
+		float distance	= dot(plane.xyz, object.CenterRadius.xyz) + plane.w;
+		float boxRadius	= dot(abs(plane.xyz), object.Extent);
+		if (distance + min(boxRadius, object.CenterRadius.w) < 0.0f)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//The box is occluded when its nearest depth lies behind the farthest depth of the pyramid texels that its screen space rectangle covers
+bool isOccluded(CullObject object, mat4 viewProjection)
+{
+	vec3 boundsMin = object.CenterRadius.xyz - object.Extent;
+	vec3 boundsMax = object.CenterRadius.xyz + object.Extent;
+
+	vec2 screenMin	= vec2(1.0f);
+	vec2 screenMax	= vec2(0.0f);
+	float minDepth	= 1.0f;
+	for (uint corner = 0; corner < 8; corner++)
+	{
+		vec3 position	= vec3((corner & 1) != 0 ? boundsMax.x : boundsMin.x, (corner & 2) != 0 ? boundsMax.y : boundsMin.y, (corner & 4) != 0 ? boundsMax.z : boundsMin.z);
+		vec4 clip		= viewProjection * vec4(position, 1.0f);
+
+		//Boxes that reach behind the viewer are never culled
+		if (clip.w <= 0.0f)
+		{
+			return false;
+		}
+
+		vec3 ndc	= clip.xyz / clip.w;
+		vec2 screen	= ndc.xy * 0.5f + 0.5f;
+		screenMin	= min(screenMin, screen);
+		screenMax	= max(screenMax, screen);
+		minDepth	= min(minDepth, ndc.z);
+	}
+
+	ivec2 texelMin = ivec2(clamp(screenMin, vec2(0.0f), vec2(1.0f)) * u_Params.HiZSize);
+	ivec2 texelMax = ivec2(clamp(screenMax, vec2(0.0f), vec2(1.0f)) * u_Params.HiZSize);
+	texelMin = min(texelMin, ivec2(u_Params.HiZSize) - ivec2(1));
+	texelMax = min(texelMax, ivec2(u_Params.HiZSize) - ivec2(1));
+
+	//The level where the rectangle covers at most two texels along each axis. A texel of a level covers the texels of the first level shifted down to it
+	int level = 0;
+	while (level + 1 < int(u_Params.HiZLevelCount) && any(greaterThan((texelMax >> level) - (texelMin >> level), ivec2(1))))
+	{
+		level++;
+	}
+
+	ivec2 levelMax = textureSize(u_HiZ, level) - ivec2(1);
+	ivec2 first	= min(texelMin >> level, levelMax);
+	ivec2 last	= min(texelMax >> level, levelMax);
+
+	float maxDepth = 0.0f;
+	for (int y = first.y; y <= last.y; y++)
+	{
+		for (int x = first.x; x <= last.x; x++)
+		{
+			maxDepth = max(maxDepth, texelFetch(u_HiZ, ivec2(x, y), level).r);
+		}
+	}
+
+	return minDepth > maxDepth;
+}
+
+void main()
+{
+	uint objectIndex = gl_GlobalInvocationID.x;
+	if (objectIndex >= u_Params.ObjectCount)
+	{
+		return;
+	}
+
+	CullObject object	= u_Objects.o[objectIndex];
+	uint phase			= u_Constants.Phase;
+
+	//The early phase tests the objects against the pyramid of the last frame, seen from where the camera was then. The late phase tests the objects that
+	//the early phase found occluded against the pyramid of this frame, which has been built from the objects that the early phase drew
+	bool visible = false;
+	if (phase == PHASE_EARLY)
+	{
+		bool inFrustum	= isInFrustum(object);
+		bool occluded	= inFrustum && u_Params.IsOcclusionEnabled != 0 && isOccluded(object, u_Params.LastViewProjection);
+
+		u_Occluded.o[objectIndex]	= occluded ? 1 : 0;
+		visible						= inFrustum && !occluded;
+	}
+	else
+	{
+		visible = u_Occluded.o[objectIndex] != 0 && !isOccluded(object, u_Params.ViewProjection);
+	}
+
+	uint firstCommand	= (phase == PHASE_LATE) ? u_Params.LateCommandOffset : 0;
+	uint firstCount		= (phase == PHASE_LATE) ? u_Params.LateCountOffset : 0;
+	uint firstInstance	= (phase == PHASE_LATE) ? u_Params.FirstLateInstance : u_Params.FirstInstance;
+
+	//Compacted commands are appended to the batch and counted, the others keep their place and are drawn without instances when culled
+	uint drawIndex = object.DrawIndex;
+	if (u_Params.IsCompacted != 0)
+	{
+		if (!visible)
+		{
+			return;
+		}
+
+		drawIndex = object.FirstDraw + atomicAdd(u_Counts.c[firstCount + object.BatchIndex], 1);
+	}
+
+	DrawIndexedIndirectCommand command;
+	command.IndexCount		= object.IndexCount;
+	command.InstanceCount	= visible ? 1 : 0;
+	command.FirstIndex		= object.FirstIndex;
+	command.VertexOffset	= 0;
+	command.FirstInstance	= firstInstance + drawIndex;
+
+	u_Commands.c[firstCommand + drawIndex]			= command;
+	u_InstanceIndices.i[firstInstance + drawIndex]	= objectIndex;
+}
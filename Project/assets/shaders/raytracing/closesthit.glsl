@@ -15,14 +15,6 @@ struct ShadowRayPayload
 	float Occlusion;
 };
 
-struct Vertex
-{
-	vec4 Position;
-	vec4 Normal;
-	vec4 Tangent;
-	vec4 TexCoord;
-};
-
 struct MaterialParameters
 {
 	vec4 Albedo;
@@ -47,9 +39,10 @@ hitAttributeNV vec3 attribs;
 layout (constant_id = 0) const int MAX_RECURSION = 0;
 layout (constant_id = 1) const int MAX_NUM_UNIQUE_GRAPHICS_OBJECT_TEXTURES = 16;
 layout (constant_id = 2) const int MAX_POINT_LIGHTS = 4;
+layout (constant_id = 3) const int VERTEX_FORMAT = 0;
 
 layout(binding = 2, set = 0) uniform accelerationStructureNV u_TopLevelAS;
-layout(binding = 6, set = 0) buffer Vertices { Vertex v[]; } u_SceneVertices;
+layout(binding = 6, set = 0) buffer Vertices { uint vertexData[]; };
 layout(binding = 7, set = 0) buffer Indices { uint i[]; } u_SceneIndices;
 layout(binding = 8, set = 0) buffer MeshIndices { uint mi[]; } u_MeshIndices;
 layout(binding = 9 , set = 0) uniform sampler2D u_SceneAlbedoMaps[MAX_NUM_UNIQUE_GRAPHICS_OBJECT_TEXTURES];
@@ -68,6 +61,8 @@ layout (binding = 16) uniform LightBuffer
 layout(binding = 18, set = 0) uniform sampler2D u_BrdfLUT;
 layout(binding = 20, set = 0) uniform sampler2D u_BlueNoiseLUT;
 
+#include "../vertexFormat.glsl"
+
 layout (push_constant) uniform PushConstants
 {
 	float Counter;
@@ -107,13 +102,13 @@ void calculateTriangleData(out uint materialIndex, out vec2 texCoords, out vec3
 	uint meshIndexOffset = 	u_MeshIndices.mi[3 * gl_InstanceCustomIndexNV + 1];
 	ivec3 index = ivec3(u_SceneIndices.i[meshIndexOffset + 3 * gl_PrimitiveID], u_SceneIndices.i[meshIndexOffset + 3 * gl_PrimitiveID + 1], u_SceneIndices.i[meshIndexOffset + 3 * gl_PrimitiveID + 2]);
 
-	Vertex v0 = u_SceneVertices.v[meshVertexOffset + index.x];
-	Vertex v1 = u_SceneVertices.v[meshVertexOffset + index.y];
-	Vertex v2 = u_SceneVertices.v[meshVertexOffset + index.z];
+	Vertex v0 = loadVertex(meshVertexOffset + index.x);
+	Vertex v1 = loadVertex(meshVertexOffset + index.y);
+	Vertex v2 = loadVertex(meshVertexOffset + index.z);
 
 	const vec3 barycentricCoords = vec3(1.0f - attribs.x - attribs.y, attribs.x, attribs.y);
 
-	texCoords = (v0.TexCoord.xy * barycentricCoords.x + v1.TexCoord.xy * barycentricCoords.y + v2.TexCoord.xy * barycentricCoords.z);
+	texCoords = (v0.TexCoord * barycentricCoords.x + v1.TexCoord * barycentricCoords.y + v2.TexCoord * barycentricCoords.z);
 
 	mat4 transform;
 	transform[0] = vec4(gl_ObjectToWorldNV[0], 0.0f);
@@ -121,17 +116,19 @@ void calculateTriangleData(out uint materialIndex, out vec2 texCoords, out vec3
 	transform[2] = vec4(gl_ObjectToWorldNV[2], 0.0f);
 	transform[3] = vec4(gl_ObjectToWorldNV[3], 1.0f);
 
-	vec3 T = normalize(v0.Tangent.xyz * barycentricCoords.x + v1.Tangent.xyz * barycentricCoords.y + v2.Tangent.xyz * barycentricCoords.z);
-	vec3 N  = normalize(v0.Normal.xyz * barycentricCoords.x + v1.Normal.xyz * barycentricCoords.y + v2.Normal.xyz * barycentricCoords.z);
+	vec3 T = normalize(v0.Tangent * barycentricCoords.x + v1.Tangent * barycentricCoords.y + v2.Tangent * barycentricCoords.z);
+	vec3 N  = normalize(v0.Normal * barycentricCoords.x + v1.Normal * barycentricCoords.y + v2.Normal * barycentricCoords.z);
 
 	T = normalize(vec3(transform * vec4(T, 0.0)));
 	N = normalize(vec3(transform * vec4(N, 0.0)));
 	T = normalize(T - dot(T, N) * N);
-	vec3 B = cross(N, T);
+	vec3 B = cross(N, T) * v0.BitangentSign;
 	mat3 TBN = mat3(T, B, N);
 
-	normal = texture(u_SceneNormalMaps[materialIndex], texCoords).xyz;
-	normal = normalize(normal * 2.0f - 1.0f);
+	//Normal maps can be BC5 compressed and only store x and y, z is reconstructed
+	normal.xy = texture(u_SceneNormalMaps[materialIndex], texCoords).xy * 2.0f - 1.0f;
+	normal.z = sqrt(max(0.0f, 1.0f - dot(normal.xy, normal.xy)));
+	normal = normalize(normal);
 	normal = TBN * normal;
 }
 
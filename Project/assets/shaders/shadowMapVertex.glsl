@@ -1,25 +1,12 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
-struct Vertex
-{
-	vec4 Position;
-	vec4 Normal;
-	vec4 Tangent;
-	vec4 TexCoord;
-};
-
 struct InstanceTransforms
 {
 	mat4 CurrTransform;
 	mat4 PrevTransform;
 };
 
-layout (push_constant) uniform Constants
-{
-	int TransformsIndex;
-} constants;
-
 layout (binding = 0) uniform PerFrameBuffer
 {
 	mat4 Projection;
@@ -33,16 +20,25 @@ layout (binding = 0) uniform PerFrameBuffer
 	vec4 Up;
 } g_PerFrame;
 
+layout (constant_id = 0) const int VERTEX_FORMAT = 0;
+
 layout (binding = 1) buffer vertexBuffer
 {
-	Vertex vertices[];
+	uint vertexData[];
 };
 
+#include "vertexFormat.glsl"
+
 layout (binding = 8, set = 0) buffer CombinedInstanceTransforms
 {
 	InstanceTransforms t[];
 } u_Transforms;
 
+layout (binding = 9, set = 0) buffer InstanceIndices
+{
+	uint i[];
+} u_InstanceIndices;
+
 layout (binding = 9, set = 1) uniform DirectionalLight
 {
 	mat4 viewProj, invViewProj;
@@ -52,8 +48,8 @@ layout (binding = 9, set = 1) uniform DirectionalLight
 
 void main()
 {
-    vec3 position       = vertices[gl_VertexIndex].Position.xyz;
-	mat4 currTransform  = u_Transforms.t[constants.TransformsIndex].CurrTransform;
+    vec3 position       = loadVertexPosition(uint(gl_VertexIndex));
+	mat4 currTransform  = u_Transforms.t[u_InstanceIndices.i[gl_InstanceIndex]].CurrTransform;
 
 	vec4 worldPosition  = currTransform * vec4(position, 1.0);
     gl_Position         = u_DirectionalLight.viewProj * worldPosition;
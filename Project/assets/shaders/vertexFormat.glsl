@@ -0,0 +1,70 @@
+//Decodes vertices from a vertex buffer in either of the formats in EVertexFormat.
+//The including shader declares the vertex buffer as uint vertexData[] and the specialization constant VERTEX_FORMAT before including this
+
+//Has to match EVertexFormat in Core/PackedVertex.h
+#define VERTEX_FORMAT_STANDARD	0
+#define VERTEX_FORMAT_PACKED	1
+
+//Size of a vertex in uints
+#define STANDARD_VERTEX_STRIDE	16
+#define PACKED_VERTEX_STRIDE	6
+
+struct Vertex
+{
+	vec3 Position;
+	vec3 Normal;
+	vec3 Tangent;
+	vec2 TexCoord;
+	//-1 when the bitangent has to be flipped
+	float BitangentSign;
+};
+
+vec3 decodeOctahedral(vec2 encoded)
+{
+	vec3 direction = vec3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+
+	float fold = max(-direction.z, 0.0f);
+	direction.x += direction.x >= 0.0f ? -fold : fold;
+	direction.y += direction.y >= 0.0f ? -fold : fold;
+	return normalize(direction);
+}
+
+vec3 loadVec3(uint offset)
+{
+	return uintBitsToFloat(uvec3(vertexData[offset], vertexData[offset + 1], vertexData[offset + 2]));
+}
+
+vec3 loadVertexPosition(uint vertexIndex)
+{
+	uint stride = VERTEX_FORMAT == VERTEX_FORMAT_PACKED ? PACKED_VERTEX_STRIDE : STANDARD_VERTEX_STRIDE;
+	return loadVec3(vertexIndex * stride);
+}
+
+Vertex loadVertex(uint vertexIndex)
+{
+	Vertex vertex;
+	if (VERTEX_FORMAT == VERTEX_FORMAT_PACKED)
+	{
+		uint offset = vertexIndex * PACKED_VERTEX_STRIDE;
+		vertex.Position = loadVec3(offset);
+		vertex.Normal 	= decodeOctahedral(unpackSnorm2x16(vertexData[offset + 3]));
+
+		uint tangent 			= vertexData[offset + 4];
+		vec2 encodedTangent 	= vec2(tangent & 0x7fffu, (tangent >> 15) & 0x7fffu) * (2.0f / 32767.0f) - 1.0f;
+		vertex.Tangent 			= decodeOctahedral(encodedTangent);
+		vertex.BitangentSign 	= (tangent & 0x80000000u) != 0 ? -1.0f : 1.0f;
+
+		vertex.TexCoord = unpackHalf2x16(vertexData[offset + 5]);
+	}
+	else
+	{
+		uint offset = vertexIndex * STANDARD_VERTEX_STRIDE;
+		vertex.Position 		= loadVec3(offset);
+		vertex.Normal 			= loadVec3(offset + 4);
+		vertex.Tangent 			= loadVec3(offset + 8);
+		vertex.TexCoord 		= uintBitsToFloat(uvec2(vertexData[offset + 12], vertexData[offset + 13]));
+		vertex.BitangentSign 	= uintBitsToFloat(vertexData[offset + 14]);
+	}
+
+	return vertex;
+}
@@ -12,6 +12,8 @@
 :: Deferred
 "tools/glslc.exe" -O -fshader-stage=vertex assets/shaders/geometryVertex.glsl -o assets/shaders/geometryVertex.spv
 "tools/glslc.exe" -O -fshader-stage=fragment assets/shaders/geometryFragment.glsl -o assets/shaders/geometryFragment.spv
+"tools/glslc.exe" -O -fshader-stage=compute assets/shaders/objectCullingCompute.glsl -o assets/shaders/objectCullingCompute.spv
+"tools/glslc.exe" -O -fshader-stage=compute assets/shaders/hiZBuildCompute.glsl -o assets/shaders/hiZBuildCompute.spv
 
 "tools/glslc.exe" -O -fshader-stage=fragment assets/shaders/lightFragment.glsl -o assets/shaders/lightFragment.spv
 :: Cube-Map filtering
@@ -129,5 +129,49 @@ workspace "Vulkan-Project"
 			"GLFW",
 			"imgui",
 		}
+
+	project "AssetPacker"
+		language "C++"
+		cppdialect "C++17"
+		systemversion "latest"
+		staticruntime "on"
+		kind "ConsoleApp"
+
+		targetdir 	("Build/bin/" .. outputdir .. "/%{prj.name}")
+		objdir 		("Build/bin-int/" .. outputdir .. "/%{prj.name}")
+
+		files
+		{
+			"tools/AssetPacker/**.cpp",
+			"src/Common/Debug.h",
+			"src/Core/Core.h",
+			"src/Core/Hash.h",
+			"src/Core/Log.h",
+			"src/Core/Log.cpp",
+			"src/Core/LZ4.h",
+			"src/Core/LZ4.cpp",
+			"src/Core/MappedFile.h",
+			"src/Core/MappedFile.cpp",
+			"src/Core/AssetArchive.h",
+			"src/Core/AssetArchive.cpp",
+		}
+
+		filter { "action:vs*" }
+			defines
+			{
+				"_CRT_SECURE_NO_WARNINGS"
+			}
+		filter {}
+
+		includedirs
+		{
+			"src",
+		}
+
+		sysincludedirs
+		{
+			"Dependencies/",
+			"Dependencies/glm",
+		}
     project "*"
 
@@ -1,5 +1,6 @@
 #pragma once
 #include "Core/Core.h"
+#include "Core/PackedVertex.h"
 
 #include <glm/glm.hpp>
 
@@ -10,7 +11,8 @@ class IMesh
 public:
     DECL_INTERFACE(IMesh);
     
-    virtual bool initFromFile(const std::string& filepath) = 0;
+    //Meshes that are rendered by a scene have to be loaded in the vertex format of the scene
+    virtual bool initFromFile(const std::string& filepath, EVertexFormat vertexFormat = EVertexFormat::STANDARD) = 0;
     virtual bool initFromMemory(const void* pVertices, size_t vertexSize, uint32_t vertexCount, const uint32_t* pIndices, uint32_t indexCount) = 0;
 	virtual bool initAsSphere(uint32_t subDivisions) = 0;
 	virtual bool initAsCube() = 0;
@@ -22,4 +24,5 @@ public:
     virtual uint32_t getIndexCount() const = 0;
 
     virtual uint32_t getMeshID() const = 0;
+    virtual EVertexFormat getVertexFormat() const = 0;
 };
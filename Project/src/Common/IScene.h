@@ -3,9 +3,11 @@
 
 #include "Core/Camera.h"
 #include "Core/LightSetup.h"
+#include "Core/PackedVertex.h"
 
 class IMesh;
 class Material;
+class ITexture2D;
 
 class IScene
 {
@@ -14,7 +16,8 @@ public:
 
 	virtual bool loadFromFile(const std::string& dir, const std::string& fileName) = 0;
 
-	virtual bool init() = 0;
+	//Every mesh in the scene uses vertexFormat, the renderers that draw the scene decode the vertices in it
+	virtual bool init(EVertexFormat vertexFormat) = 0;
 	virtual bool finalize() = 0;
 
 	virtual void updateMeshesAndGraphicsObjects() = 0;
@@ -25,7 +28,11 @@ public:
 	virtual uint32_t submitGraphicsObject(const IMesh* pMesh, const Material* pMaterial, const glm::mat4& transform = glm::mat4(1.0f), uint8_t customMask = 0x80) = 0;
 	virtual void updateGraphicsObjectTransform(uint32_t index, const glm::mat4& transform) = 0;
 
+	//Loads the texture on a background thread. Materials that use it are rendered with a default texture until the load has completed
+	virtual void streamTexture(ITexture2D* pTexture, const std::string& filename, ETextureFormat format, ETextureCompression compression) = 0;
+
 	virtual LightSetup& getLightSetup() = 0;
+	virtual EVertexFormat getVertexFormat() const = 0;
 
 	//Debug
 	virtual void renderUI() = 0;
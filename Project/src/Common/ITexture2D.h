@@ -6,6 +6,7 @@ class ITexture2D
 public:
 	DECL_INTERFACE(ITexture2D);
 
-	virtual bool initFromFile(const std::string& filename, ETextureFormat format, bool generateMips = true) = 0;
+	//A compression other than NONE loads the texture block compressed from a cache file, only supported for RGBA8 textures
+	virtual bool initFromFile(const std::string& filename, ETextureFormat format, bool generateMips = true, ETextureCompression compression = ETextureCompression::NONE) = 0;
 	virtual bool initFromMemory(const void* pData, uint32_t width, uint32_t height, ETextureFormat format, uint32_t usageFlags, bool generateMips = false) = 0;
 };
\ No newline at end of file
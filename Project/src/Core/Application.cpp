@@ -3,6 +3,8 @@
 #include "Input.h"
 #include "TaskDispatcher.h"
 #include "Transform.h"
+#include "AssetArchive.h"
+#include "MeshCache.h"
 
 #include "Common/Profiler.h"
 #include "Common/RenderingHandler.hpp"
@@ -32,6 +34,7 @@
 #include "Vulkan/CommandPoolVK.h"
 #include "Vulkan/GraphicsContextVK.h"
 #include "Vulkan/DescriptorSetLayoutVK.h"
+#include "Vulkan/MeshRendererVK.h"
 
 #ifdef max
 	#undef max
@@ -44,8 +47,12 @@
 Application* Application::s_pInstance = nullptr;
 
 constexpr bool	FORCE_RAY_TRACING_OFF	= false;
+//Textures are streamed in after the first frame, otherwise init blocks until every asset has been loaded
+constexpr bool	STREAM_ASSETS			= true;
 constexpr bool	HIGH_RESOLUTION_SPHERE	= false;
 constexpr float CAMERA_PAN_LENGTH		= 10.0f;
+//Built by the AssetPacker, assets that are not in it are loaded from the assets directory
+constexpr const char* ASSET_ARCHIVE_FILEPATH = "assets" ASSET_ARCHIVE_EXTENSION;
 
 Application::Application()
 	: m_pWindow(nullptr),
@@ -83,12 +90,18 @@ Application::~Application()
 	s_pInstance = nullptr;
 }
 
-void Application::init()
+void Application::init(EVertexFormat vertexFormat)
 {
 	LOG("Starting application");
+	auto startTime = std::chrono::high_resolution_clock::now();
 
 	TaskDispatcher::init();
 
+	if (!AssetArchive::mount(ASSET_ARCHIVE_FILEPATH))
+	{
+		LOG("No asset archive found, loading loose files");
+	}
+
 	//Create window
 	m_pWindow = IWindow::create("Hello Vulkan", 1440, 900);
 	if (m_pWindow)
@@ -115,14 +128,16 @@ void Application::init()
 
 	//Create Scene
 	m_pScene = m_pContext->createScene(m_pRenderingHandler);
-	m_pScene->init();
+	m_pScene->init(vertexFormat);
 
 	m_pRenderingHandler->setScene(m_pScene);
 
+	//Geometry and the skybox are needed before the first frame, the textures are not
+	TaskGroup requiredLoads;
 	TaskDispatcher::execute([this]
 		{
 			m_pScene->loadFromFile("assets/sponza/", "sponza.obj");
-		});
+		}, requiredLoads, ETaskPool::BACKGROUND);
 
 	//Setup lights
 	LightSetup& lightSetup = m_pScene->getLightSetup();
@@ -188,37 +203,25 @@ void Application::init()
 		{
 			pPanorama->initFromFile("assets/textures/arches.hdr", ETextureFormat::FORMAT_R32G32B32A32_FLOAT, false);
 			m_pSkybox = m_pRenderingHandler->generateTextureCube(pPanorama, ETextureFormat::FORMAT_R16G16B16A16_FLOAT, 2048, 1);
-		});
+		}, requiredLoads, ETaskPool::BACKGROUND);
 
 	m_pGunMesh = m_pContext->createMesh();
 	TaskDispatcher::execute([&]
 		{
-			m_pGunMesh->initFromFile("assets/meshes/gun.obj");
-		});
+			m_pGunMesh->initFromFile("assets/meshes/gun.obj", m_pScene->getVertexFormat());
+		}, requiredLoads, ETaskPool::BACKGROUND);
 
 	m_pGunAlbedo = m_pContext->createTexture2D();
-	TaskDispatcher::execute([this]
-		{
-			m_pGunAlbedo->initFromFile("assets/textures/gunAlbedo.tga", ETextureFormat::FORMAT_R8G8B8A8_UNORM);
-		});
+	m_pScene->streamTexture(m_pGunAlbedo, "assets/textures/gunAlbedo.tga", ETextureFormat::FORMAT_R8G8B8A8_UNORM, ETextureCompression::COLOR);
 
 	m_pGunNormal = m_pContext->createTexture2D();
-	TaskDispatcher::execute([this]
-		{
-			m_pGunNormal->initFromFile("assets/textures/gunNormal.tga", ETextureFormat::FORMAT_R8G8B8A8_UNORM);
-		});
+	m_pScene->streamTexture(m_pGunNormal, "assets/textures/gunNormal.tga", ETextureFormat::FORMAT_R8G8B8A8_UNORM, ETextureCompression::NORMAL_MAP);
 
 	m_pGunMetallic = m_pContext->createTexture2D();
-	TaskDispatcher::execute([this]
-		{
-			m_pGunMetallic->initFromFile("assets/textures/gunMetallic.tga", ETextureFormat::FORMAT_R8G8B8A8_UNORM);
-		});
+	m_pScene->streamTexture(m_pGunMetallic, "assets/textures/gunMetallic.tga", ETextureFormat::FORMAT_R8G8B8A8_UNORM, ETextureCompression::SINGLE_CHANNEL);
 
 	m_pGunRoughness = m_pContext->createTexture2D();
-	TaskDispatcher::execute([this]
-		{
-			m_pGunRoughness->initFromFile("assets/textures/gunRoughness.tga", ETextureFormat::FORMAT_R8G8B8A8_UNORM);
-		});
+	m_pScene->streamTexture(m_pGunRoughness, "assets/textures/gunRoughness.tga", ETextureFormat::FORMAT_R8G8B8A8_UNORM, ETextureCompression::SINGLE_CHANNEL);
 
 	// Setup particles
 	m_pParticleTexture = m_pContext->createTexture2D();
@@ -267,7 +270,14 @@ void Application::init()
 	m_Camera.setProjection(90.0f, (float)m_pWindow->getWidth(), (float)m_pWindow->getHeight(), 0.0001f, 50.0f);
 	m_Camera.update();
 
-	TaskDispatcher::waitForTasks();
+	if (STREAM_ASSETS)
+	{
+		requiredLoads.wait();
+	}
+	else
+	{
+		TaskDispatcher::waitForTasks();
+	}
 
 	glm::mat4 scale = glm::scale(glm::vec3(0.75f));
 	m_GraphicsIndex0 = m_pScene->submitGraphicsObject(m_pGunMesh, &m_GunMaterial, glm::translate(glm::mat4(1.0f), glm::vec3( 0.0f, 1.0f, 0.1f)) * scale);
@@ -327,6 +337,9 @@ void Application::init()
 	m_pCameraDirectionSpline = DBG_NEW LoopingUniformCRSpline<glm::vec3, float>(directionControlPoints);
 	m_CameraSplineTimer = 0.0f;
 	m_CameraSplineEnabled = false;
+
+	std::chrono::duration<double, std::milli> initTime = std::chrono::high_resolution_clock::now() - startTime;
+	LOG("Ready for the first frame after %.2f ms", initTime.count());
 }
 
 void Application::run()
@@ -366,6 +379,8 @@ void Application::release()
 	m_pWindow->removeEventHandler(m_pImgui);
 	m_pWindow->removeEventHandler(this);
 
+	//Streamed textures may still be loading
+	TaskDispatcher::waitForTasks();
 	m_pContext->sync();
 
 	m_GunMaterial.release();
@@ -398,6 +413,7 @@ void Application::release()
 	SAFEDELETE(m_pCameraPositionSpline);
 
 	TaskDispatcher::release();
+	AssetArchive::unmount();
 
 	LOG("Exiting Application");
 }
@@ -556,6 +572,7 @@ void Application::update(double dt)
 
 		// API Profiling statistics
 		m_TestParameters.FrameTimeSumMeshRenderer		+= float(m_pMeshRenderer->getElapsedTime());
+		m_TestParameters.FrameTimeSumGeometryPass		+= float(reinterpret_cast<MeshRendererVK*>(m_pMeshRenderer)->getGeometryProfiler()->getElapsedTime());
 		if (m_pRayTracingRenderer) {
 			m_TestParameters.FrameTimeSumRayTracer			+= float(m_pRayTracingRenderer->getElapsedTime());
 		}
@@ -756,6 +773,14 @@ void Application::renderUI(double dt)
 			//TODO: If the renderinghandler have all renderers/handlers, why are we calling their draw UI functions should this not be done by the renderinghandler
 			m_pParticleEmitterHandler->drawProfilerUI();
 			m_pRenderingHandler->drawProfilerUI();
+
+			//Peak depths are reset every frame so that they show the worst backlog of the last frame
+			for (uint32_t i = 0; i < TASK_POOL_COUNT; i++)
+			{
+				TaskPoolStats poolStats = TaskDispatcher::getPoolStats(ETaskPool(i));
+				ImGui::Text("%s Pool (%u workers):\tqueued %u, peak %u, completed %llu", poolStats.pName, poolStats.WorkerCount, poolStats.QueueDepth, poolStats.PeakQueueDepth, (unsigned long long)poolStats.CompletedTasks);
+			}
+			TaskDispatcher::resetPeakQueueDepths();
 		}
 		ImGui::End();
 
@@ -823,6 +848,7 @@ void Application::renderUI(double dt)
 				m_TestParameters.CurrentRound = 0;
 
 				m_TestParameters.FrameTimeSumMeshRenderer		= 0.0f;
+				m_TestParameters.FrameTimeSumGeometryPass		= 0.0f;
 				m_TestParameters.FrameTimeSumRayTracer			= 0.0f;
 				m_TestParameters.FrameTimeSumShadowmapRenderer	= 0.0f;
 				m_TestParameters.FrameTimeSumParticleRenderer	= 0.0f;
@@ -877,7 +903,7 @@ void Application::testFinished()
 
 	if (fileStream.is_open())
 	{
-		fileStream << "Avg. FT\tWorst FT\tBest FT\tFrame Count\tAvg. Mesh Renderer\tAvg. Ray Tracer\tAvg. Shadowmap Renderer\tAvg. Particle Renderer\tAvg. Volumetric Lighting" << std::endl;
+		fileStream << "Avg. FT\tWorst FT\tBest FT\tFrame Count\tAvg. Mesh Renderer\tAvg. Ray Tracer\tAvg. Shadowmap Renderer\tAvg. Particle Renderer\tAvg. Volumetric Lighting\tAvg. Geometry Pass\tMesh Optimization\tVertex Format" << std::endl;
 		fileStream << m_TestParameters.AverageFrametime << "\t";
 		fileStream << m_TestParameters.WorstFrametime << "\t";
 		fileStream << m_TestParameters.BestFrametime << "\t";
@@ -886,7 +912,10 @@ void Application::testFinished()
 		fileStream << m_TestParameters.FrameTimeSumRayTracer			/ m_TestParameters.FrameCount << "\t";
 		fileStream << m_TestParameters.FrameTimeSumShadowmapRenderer	/ m_TestParameters.FrameCount << "\t";
 		fileStream << m_TestParameters.FrameTimeSumParticleRenderer		/ m_TestParameters.FrameCount << "\t";
-		fileStream << m_TestParameters.FrameTimeSumVolumetricLighting	/ m_TestParameters.FrameCount;
+		fileStream << m_TestParameters.FrameTimeSumVolumetricLighting	/ m_TestParameters.FrameCount << "\t";
+		fileStream << m_TestParameters.FrameTimeSumGeometryPass			/ m_TestParameters.FrameCount << "\t";
+		fileStream << (MeshCache::isOptimizationEnabled() ? "On" : "Off") << "\t";
+		fileStream << VertexPacker::getName(m_pScene->getVertexFormat());
 	}
 
 	fileStream.close();
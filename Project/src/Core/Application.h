@@ -1,6 +1,7 @@
 #pragma once
 #include "Camera.h"
 #include "Material.h"
+#include "PackedVertex.h"
 
 #include "Common/CommonEventHandler.h"
 #include "Common/ParticleEmitterHandler.h"
@@ -38,6 +39,7 @@ class Application : public CommonEventHandler
 
 		// API profiler results
 		float FrameTimeSumMeshRenderer = 0.0f;
+		float FrameTimeSumGeometryPass = 0.0f;
 		float FrameTimeSumShadowmapRenderer = 0.0f;
 		float FrameTimeSumParticleRenderer = 0.0f;
 		float FrameTimeSumRayTracer = 0.0f;
@@ -53,7 +55,7 @@ public:
 
 	DECL_NO_COPY(Application);
 
-	void init();
+	void init(EVertexFormat vertexFormat);
 	void run();
 	void release();
 
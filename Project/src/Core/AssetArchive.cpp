@@ -0,0 +1,329 @@
+#include "AssetArchive.h"
+#include "Hash.h"
+#include "LZ4.h"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+
+//"VBPK" in little endian
+#define ASSET_ARCHIVE_MAGIC		0x4b504256U
+//Has to be increased whenever the file layout changes
+#define ASSET_ARCHIVE_VERSION	1U
+//Entries are only stored compressed when that makes them at least this much smaller, so that small savings do not cost the zero-copy reads
+#define ASSET_ARCHIVE_MIN_COMPRESSION_RATIO 0.9
+
+enum class EAssetCompression : uint32_t
+{
+	NONE	= 0,
+	LZ4		= 1,
+};
+
+struct AssetArchiveHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint32_t EntryCount;
+	uint32_t Padding;
+	uint64_t EntriesOffset;
+	uint64_t PathsOffset;
+	uint64_t PathsSizeInBytes;
+};
+
+struct AssetArchiveEntry
+{
+	uint64_t PathHash;
+	uint32_t PathOffset;
+	uint32_t PathLength;
+	uint64_t DataOffset;
+	uint64_t StoredSizeInBytes;
+	uint64_t SizeInBytes;
+	uint32_t Compression;
+	uint32_t Padding;
+};
+
+MappedFile AssetArchive::s_File;
+const AssetArchiveEntry* AssetArchive::s_pEntries = nullptr;
+const char* AssetArchive::s_pPaths = nullptr;
+uint32_t AssetArchive::s_EntryCount = 0;
+
+static uint64_t alignOffset(uint64_t offset)
+{
+	return (offset + ASSET_ARCHIVE_ALIGNMENT - 1) & ~uint64_t(ASSET_ARCHIVE_ALIGNMENT - 1);
+}
+
+static uint64_t hashPath(const std::string& path)
+{
+	return hashMemory(path.data(), path.size());
+}
+
+AssetView::AssetView()
+	: m_Decompressed(),
+	m_pData(nullptr),
+	m_SizeInBytes(0)
+{
+}
+
+void AssetView::release()
+{
+	m_Decompressed.clear();
+	m_Decompressed.shrink_to_fit();
+
+	m_pData			= nullptr;
+	m_SizeInBytes	= 0;
+}
+
+bool AssetArchive::mount(const std::string& filepath)
+{
+	unmount();
+
+	if (!s_File.open(filepath))
+	{
+		return false;
+	}
+
+	const uint8_t* pData = reinterpret_cast<const uint8_t*>(s_File.getData());
+	const uint64_t fileSize = s_File.getSizeInBytes();
+
+	const AssetArchiveHeader* pHeader = reinterpret_cast<const AssetArchiveHeader*>(pData);
+	bool isValid = fileSize >= sizeof(AssetArchiveHeader) &&
+		pHeader->Magic		== ASSET_ARCHIVE_MAGIC &&
+		pHeader->Version	== ASSET_ARCHIVE_VERSION &&
+		pHeader->EntriesOffset	+ uint64_t(pHeader->EntryCount) * sizeof(AssetArchiveEntry)	<= fileSize &&
+		pHeader->PathsOffset	+ pHeader->PathsSizeInBytes										<= fileSize;
+
+	const AssetArchiveEntry* pEntries = reinterpret_cast<const AssetArchiveEntry*>(pData + pHeader->EntriesOffset);
+	for (uint32_t i = 0; isValid && i < pHeader->EntryCount; i++)
+	{
+		const AssetArchiveEntry& entry = pEntries[i];
+		isValid =
+			uint64_t(entry.PathOffset) + entry.PathLength <= pHeader->PathsSizeInBytes &&
+			entry.DataOffset + entry.StoredSizeInBytes <= fileSize &&
+			(entry.Compression == uint32_t(EAssetCompression::LZ4) || (entry.Compression == uint32_t(EAssetCompression::NONE) && entry.StoredSizeInBytes == entry.SizeInBytes));
+	}
+
+	if (!isValid)
+	{
+		LOG("-- AssetArchive: '%s' is not a valid archive", filepath.c_str());
+		s_File.close();
+		return false;
+	}
+
+	s_pEntries		= pEntries;
+	s_pPaths		= reinterpret_cast<const char*>(pData + pHeader->PathsOffset);
+	s_EntryCount	= pHeader->EntryCount;
+
+	//The loaders touch the entries in an order that the disk can not predict, reading everything ahead turns that into one sequential read
+	s_File.prefetch(0, fileSize);
+
+	LOG("-- AssetArchive: Mounted '%s' with %u entries, %.2f MB", filepath.c_str(), s_EntryCount, double(fileSize) / double(MB(1)));
+	return true;
+}
+
+void AssetArchive::unmount()
+{
+	s_File.close();
+	s_pEntries		= nullptr;
+	s_pPaths		= nullptr;
+	s_EntryCount	= 0;
+}
+
+bool AssetArchive::read(const std::string& filepath, AssetView& view)
+{
+	view.release();
+
+	const AssetArchiveEntry* pEntry = findEntry(filepath);
+	if (!pEntry)
+	{
+		return false;
+	}
+
+	const uint8_t* pStoredData = reinterpret_cast<const uint8_t*>(s_File.getData()) + pEntry->DataOffset;
+	if (pEntry->Compression == uint32_t(EAssetCompression::NONE))
+	{
+		view.m_pData		= pStoredData;
+		view.m_SizeInBytes	= pEntry->SizeInBytes;
+		return true;
+	}
+
+	view.m_Decompressed.resize(size_t(pEntry->SizeInBytes));
+	if (!LZ4::decompress(pStoredData, pEntry->StoredSizeInBytes, view.m_Decompressed.data(), pEntry->SizeInBytes))
+	{
+		LOG("-- AssetArchive: Failed to decompress '%s'", filepath.c_str());
+		view.release();
+		return false;
+	}
+
+	view.m_pData		= view.m_Decompressed.data();
+	view.m_SizeInBytes	= pEntry->SizeInBytes;
+	return true;
+}
+
+bool AssetArchive::contains(const std::string& filepath)
+{
+	return findEntry(filepath) != nullptr;
+}
+
+const AssetArchiveEntry* AssetArchive::findEntry(const std::string& filepath)
+{
+	if (s_EntryCount == 0)
+	{
+		return nullptr;
+	}
+
+	const std::string path	= normalizePath(filepath);
+	const uint64_t hash		= hashPath(path);
+
+	const AssetArchiveEntry* pEnd = s_pEntries + s_EntryCount;
+	const AssetArchiveEntry* pEntry = std::lower_bound(s_pEntries, pEnd, hash, [](const AssetArchiveEntry& entry, uint64_t value) { return entry.PathHash < value; });
+	for (; pEntry != pEnd && pEntry->PathHash == hash; pEntry++)
+	{
+		if (pEntry->PathLength == path.size() && memcmp(s_pPaths + pEntry->PathOffset, path.data(), path.size()) == 0)
+		{
+			return pEntry;
+		}
+	}
+
+	return nullptr;
+}
+
+bool AssetArchive::pack(const std::string& directory, const std::string& archiveFilepath, bool allowCompression)
+{
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	std::error_code error;
+	std::vector<std::string> filepaths;
+	for (std::filesystem::recursive_directory_iterator it(directory, error), end; !error && it != end; it.increment(error))
+	{
+		//Half written cache files and the archive itself are left out
+		const std::filesystem::path& filepath = it->path();
+		if (it->is_regular_file() && filepath.extension() != ".tmp" && filepath.extension() != ASSET_ARCHIVE_EXTENSION)
+		{
+			filepaths.push_back(normalizePath(filepath.generic_string()));
+		}
+	}
+
+	if (error)
+	{
+		LOG("-- AssetArchive: Failed to list '%s'", directory.c_str());
+		return false;
+	}
+
+	//The data is laid out in path order so that files from the same directory, which tend to be loaded together, are next to each other
+	std::sort(filepaths.begin(), filepaths.end());
+
+	std::vector<AssetArchiveEntry> entries(filepaths.size());
+	std::string paths;
+	for (size_t i = 0; i < filepaths.size(); i++)
+	{
+		AssetArchiveEntry& entry = entries[i];
+		entry.PathHash		= hashPath(filepaths[i]);
+		entry.PathOffset	= uint32_t(paths.size());
+		entry.PathLength	= uint32_t(filepaths[i].size());
+		paths += filepaths[i];
+	}
+
+	AssetArchiveHeader header = {};
+	header.Magic			= ASSET_ARCHIVE_MAGIC;
+	header.Version			= ASSET_ARCHIVE_VERSION;
+	header.EntryCount		= uint32_t(entries.size());
+	header.EntriesOffset	= alignOffset(sizeof(AssetArchiveHeader));
+	header.PathsOffset		= alignOffset(header.EntriesOffset + entries.size() * sizeof(AssetArchiveEntry));
+	header.PathsSizeInBytes	= paths.size();
+
+	//Write to a temporary file first so that an archive is never seen half written
+	const std::string temporaryFilepath = archiveFilepath + ".tmp";
+	uint64_t totalSizeInBytes	= 0;
+	uint64_t storedSizeInBytes	= 0;
+	uint32_t compressedCount	= 0;
+	{
+		std::ofstream file(temporaryFilepath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			LOG("-- AssetArchive: Failed to create '%s'", temporaryFilepath.c_str());
+			return false;
+		}
+
+		const char padding[ASSET_ARCHIVE_ALIGNMENT] = {};
+		auto writeAt = [&](uint64_t offset, const void* pData, uint64_t sizeInBytes)
+		{
+			file.write(padding, std::streamsize(offset - uint64_t(file.tellp())));
+			file.write(reinterpret_cast<const char*>(pData), std::streamsize(sizeInBytes));
+		};
+
+		//The table of contents is written again once the data offsets are known
+		writeAt(0,						&header,		sizeof(AssetArchiveHeader));
+		writeAt(header.EntriesOffset,	entries.data(),	entries.size() * sizeof(AssetArchiveEntry));
+		writeAt(header.PathsOffset,		paths.data(),	paths.size());
+
+		std::vector<uint8_t> compressed;
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			AssetArchiveEntry& entry = entries[i];
+
+			//MappedFile can not map empty files, they are stored as empty entries
+			MappedFile sourceFile;
+			const bool isEmpty = !sourceFile.open(filepaths[i]) && std::filesystem::file_size(filepaths[i], error) == 0 && !error;
+			if (!sourceFile.isOpen() && !isEmpty)
+			{
+				LOG("-- AssetArchive: Failed to read '%s'", filepaths[i].c_str());
+				return false;
+			}
+
+			const void* pData		= sourceFile.getData();
+			entry.SizeInBytes		= sourceFile.getSizeInBytes();
+			entry.StoredSizeInBytes	= entry.SizeInBytes;
+			entry.Compression		= uint32_t(EAssetCompression::NONE);
+
+			if (allowCompression && entry.SizeInBytes > 0)
+			{
+				compressed.resize(size_t(LZ4::getCompressBound(entry.SizeInBytes)));
+				const uint64_t compressedSize = LZ4::compress(pData, entry.SizeInBytes, compressed.data(), compressed.size());
+				if (compressedSize > 0 && double(compressedSize) < double(entry.SizeInBytes) * ASSET_ARCHIVE_MIN_COMPRESSION_RATIO)
+				{
+					pData					= compressed.data();
+					entry.StoredSizeInBytes	= compressedSize;
+					entry.Compression		= uint32_t(EAssetCompression::LZ4);
+					compressedCount++;
+				}
+			}
+
+			entry.DataOffset = alignOffset(uint64_t(file.tellp()));
+			writeAt(entry.DataOffset, pData, entry.StoredSizeInBytes);
+
+			totalSizeInBytes	+= entry.SizeInBytes;
+			storedSizeInBytes	+= entry.StoredSizeInBytes;
+		}
+
+		//Lookups binary search the hashes, paths with the same hash are compared one by one
+		std::sort(entries.begin(), entries.end(), [](const AssetArchiveEntry& a, const AssetArchiveEntry& b) { return a.PathHash < b.PathHash; });
+
+		file.seekp(std::streamoff(header.EntriesOffset));
+		file.write(reinterpret_cast<const char*>(entries.data()), std::streamsize(entries.size() * sizeof(AssetArchiveEntry)));
+
+		if (!file.good())
+		{
+			LOG("-- AssetArchive: Failed to write '%s'", temporaryFilepath.c_str());
+			return false;
+		}
+	}
+
+	std::filesystem::rename(temporaryFilepath, archiveFilepath, error);
+	if (error)
+	{
+		LOG("-- AssetArchive: Failed to replace '%s'", archiveFilepath.c_str());
+		return false;
+	}
+
+	std::chrono::duration<double, std::milli> packTime = std::chrono::high_resolution_clock::now() - startTime;
+	LOG("-- AssetArchive: Packed %u files (%.2f MB) into '%s' (%.2f MB, %u compressed) in %.2f ms",
+		header.EntryCount, double(totalSizeInBytes) / double(MB(1)), archiveFilepath.c_str(), double(storedSizeInBytes) / double(MB(1)), compressedCount, packTime.count());
+	return true;
+}
+
+std::string AssetArchive::normalizePath(const std::string& filepath)
+{
+	return std::filesystem::path(filepath).lexically_normal().generic_string();
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include "Core.h"
+#include "MappedFile.h"
+
+#include <string>
+#include <vector>
+#include <istream>
+#include <streambuf>
+
+#define ASSET_ARCHIVE_EXTENSION ".vbpak"
+//Every entry starts at a multiple of this, which keeps the cache file headers and the data behind them aligned when they are used in place
+#define ASSET_ARCHIVE_ALIGNMENT 64U
+
+struct AssetArchiveEntry;
+
+//Contents of one file in the asset archive. Stored entries point straight into the mapped archive, compressed entries are decompressed into the view
+class AssetView
+{
+	friend class AssetArchive;
+
+public:
+	AssetView();
+	~AssetView() = default;
+
+	DECL_NO_COPY(AssetView);
+
+	void release();
+
+	FORCEINLINE const uint8_t*	getData() const			{ return m_pData; }
+	FORCEINLINE uint64_t		getSizeInBytes() const	{ return m_SizeInBytes; }
+	FORCEINLINE bool			isValid() const			{ return m_pData != nullptr; }
+	FORCEINLINE bool			isZeroCopy() const		{ return m_Decompressed.empty(); }
+
+private:
+	std::vector<uint8_t> m_Decompressed;
+	const uint8_t* m_pData;
+	uint64_t m_SizeInBytes;
+};
+
+//Lets parsers that read from a std::istream read an asset without copying it
+class AssetStream : public std::istream
+{
+	struct Buffer : public std::streambuf
+	{
+		Buffer(const AssetView& view)
+		{
+			char* pData = const_cast<char*>(reinterpret_cast<const char*>(view.getData()));
+			setg(pData, pData, pData + view.getSizeInBytes());
+		}
+	};
+
+public:
+	AssetStream(const AssetView& view)
+		: std::istream(nullptr),
+		m_Buffer(view)
+	{
+		rdbuf(&m_Buffer);
+	}
+
+private:
+	Buffer m_Buffer;
+};
+
+//Single file that packs the loose files under the assets directory. The archive starts with a table of contents that is sorted by path hash,
+//followed by the paths and then the data of every entry, optionally compressed with LZ4.
+//While an archive is mounted the loaders look for their files in it first and only fall back to loose files for what it does not contain
+class AssetArchive
+{
+public:
+	DECL_STATIC_CLASS(AssetArchive);
+
+	//Maps the archive and starts reading all of it in the background. Has to be called before anything is loaded
+	static bool mount(const std::string& filepath);
+	//Nothing that was read from the archive may be in use when this is called
+	static void unmount();
+
+	//Thread safe while the archive is mounted. Fails if nothing is mounted or the archive does not contain filepath
+	static bool read(const std::string& filepath, AssetView& view);
+	static bool contains(const std::string& filepath);
+
+	FORCEINLINE static bool isMounted()	{ return s_File.isOpen(); }
+
+	//Packs every file under directory into a new archive. Entries are stored compressed when LZ4 saves enough to be worth decompressing
+	static bool pack(const std::string& directory, const std::string& archiveFilepath, bool allowCompression);
+
+	//Paths are looked up with forward slashes and without any "." or ".." parts
+	static std::string normalizePath(const std::string& filepath);
+
+private:
+	static const AssetArchiveEntry* findEntry(const std::string& filepath);
+
+private:
+	static MappedFile s_File;
+	static const AssetArchiveEntry* s_pEntries;
+	static const char* s_pPaths;
+	static uint32_t s_EntryCount;
+};
@@ -0,0 +1,228 @@
+#include "BlockCompression.h"
+
+#include <cstring>
+
+#define BLOCK_PIXEL_COUNT 16U
+
+static uint16_t packColor565(const glm::vec3& color)
+{
+	const uint32_t r = uint32_t(glm::clamp(color.r, 0.0f, 255.0f) * (31.0f / 255.0f) + 0.5f);
+	const uint32_t g = uint32_t(glm::clamp(color.g, 0.0f, 255.0f) * (63.0f / 255.0f) + 0.5f);
+	const uint32_t b = uint32_t(glm::clamp(color.b, 0.0f, 255.0f) * (31.0f / 255.0f) + 0.5f);
+	return uint16_t((r << 11) | (g << 5) | b);
+}
+
+//Expands the same way as the hardware, so the indices are chosen against the colors that are actually sampled
+static glm::ivec3 unpackColor565(uint16_t color)
+{
+	const int32_t r = (color >> 11) & 31;
+	const int32_t g = (color >> 5) & 63;
+	const int32_t b = color & 31;
+	return glm::ivec3((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+}
+
+//Copies a 4x4 block out of the image, texels outside the image repeat the edge
+static void fetchBlock(const uint8_t* pPixels, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, uint8_t* pBlock)
+{
+	for (uint32_t y = 0; y < BLOCK_DIMENSION; y++)
+	{
+		const uint32_t sourceY = std::min(blockY * BLOCK_DIMENSION + y, height - 1);
+		for (uint32_t x = 0; x < BLOCK_DIMENSION; x++)
+		{
+			const uint32_t sourceX = std::min(blockX * BLOCK_DIMENSION + x, width - 1);
+			memcpy(pBlock + (y * BLOCK_DIMENSION + x) * 4, pPixels + (size_t(sourceY) * width + sourceX) * 4, 4);
+		}
+	}
+}
+
+uint64_t BlockCompression::getCompressedSize(ETextureFormat format, uint32_t width, uint32_t height)
+{
+	const uint64_t blocksX = (width + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+	const uint64_t blocksY = (height + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+	return blocksX * blocksY * textureFormatBlockSize(format);
+}
+
+uint32_t BlockCompression::getBlockRowCount(uint32_t height)
+{
+	return (height + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+}
+
+void BlockCompression::compressBlockRows(const uint8_t* pPixels, uint32_t width, uint32_t height, ETextureFormat format, uint32_t firstBlockRow, uint32_t lastBlockRow, uint8_t* pDestination)
+{
+	const uint32_t blocksX		= (width + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+	const uint32_t blockSize	= textureFormatBlockSize(format);
+
+	uint8_t block[BLOCK_PIXEL_COUNT * 4];
+	for (uint32_t blockY = firstBlockRow; blockY < lastBlockRow; blockY++)
+	{
+		uint8_t* pRow = pDestination + size_t(blockY) * blocksX * blockSize;
+		for (uint32_t blockX = 0; blockX < blocksX; blockX++)
+		{
+			fetchBlock(pPixels, width, height, blockX, blockY, block);
+
+			uint8_t* pBlockDestination = pRow + size_t(blockX) * blockSize;
+			switch (format)
+			{
+			case ETextureFormat::FORMAT_BC1_RGB_UNORM:	encodeBC1(block, pBlockDestination);	break;
+			case ETextureFormat::FORMAT_BC4_UNORM:		encodeBC4(block, 0, pBlockDestination);	break;
+			case ETextureFormat::FORMAT_BC5_UNORM:		encodeBC5(block, pBlockDestination);	break;
+			default: ASSERT(false); break;
+			}
+		}
+	}
+}
+
+void BlockCompression::encodeBC1(const uint8_t* pBlock, uint8_t* pDestination)
+{
+	glm::vec3 colors[BLOCK_PIXEL_COUNT];
+	glm::vec3 mean = glm::vec3(0.0f);
+	for (uint32_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+	{
+		colors[i] = glm::vec3(pBlock[i * 4 + 0], pBlock[i * 4 + 1], pBlock[i * 4 + 2]);
+		mean += colors[i];
+	}
+	mean /= float(BLOCK_PIXEL_COUNT);
+
+	//The endpoints are placed along the principal axis of the colors, found by power iteration on their covariance
+	float covariance[6] = {};
+	for (uint32_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+	{
+		const glm::vec3 d = colors[i] - mean;
+		covariance[0] += d.r * d.r;
+		covariance[1] += d.r * d.g;
+		covariance[2] += d.r * d.b;
+		covariance[3] += d.g * d.g;
+		covariance[4] += d.g * d.b;
+		covariance[5] += d.b * d.b;
+	}
+
+	glm::vec3 axis = glm::vec3(1.0f);
+	for (uint32_t iteration = 0; iteration < 8; iteration++)
+	{
+		const glm::vec3 next = glm::vec3(
+			covariance[0] * axis.r + covariance[1] * axis.g + covariance[2] * axis.b,
+			covariance[1] * axis.r + covariance[3] * axis.g + covariance[4] * axis.b,
+			covariance[2] * axis.r + covariance[4] * axis.g + covariance[5] * axis.b);
+
+		const float length = glm::length(next);
+		if (length < 1e-6f)
+		{
+			break;
+		}
+
+		axis = next / length;
+	}
+
+	float minProjection = 0.0f;
+	float maxProjection = 0.0f;
+	for (uint32_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+	{
+		const float projection = glm::dot(colors[i] - mean, axis);
+		minProjection = std::min(minProjection, projection);
+		maxProjection = std::max(maxProjection, projection);
+	}
+
+	uint16_t color0 = packColor565(mean + axis * maxProjection);
+	uint16_t color1 = packColor565(mean + axis * minProjection);
+
+	//color0 > color1 selects the four color mode, equal endpoints select the three color mode where index 0 still is color0
+	if (color0 < color1)
+	{
+		std::swap(color0, color1);
+	}
+
+	glm::ivec3 palette[4];
+	palette[0] = unpackColor565(color0);
+	palette[1] = unpackColor565(color1);
+	palette[2] = (palette[0] * 2 + palette[1]) / 3;
+	palette[3] = (palette[0] + palette[1] * 2) / 3;
+
+	uint32_t indices = 0;
+	if (color0 != color1)
+	{
+		for (uint32_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+		{
+			const glm::ivec3 color = glm::ivec3(pBlock[i * 4 + 0], pBlock[i * 4 + 1], pBlock[i * 4 + 2]);
+
+			uint32_t bestIndex		= 0;
+			int32_t bestDistance	= INT32_MAX;
+			for (uint32_t p = 0; p < 4; p++)
+			{
+				const glm::ivec3 d = color - palette[p];
+				const int32_t distance = d.r * d.r + d.g * d.g + d.b * d.b;
+				if (distance < bestDistance)
+				{
+					bestDistance	= distance;
+					bestIndex		= p;
+				}
+			}
+
+			indices |= bestIndex << (i * 2);
+		}
+	}
+
+	pDestination[0] = uint8_t(color0 & 0xff);
+	pDestination[1] = uint8_t(color0 >> 8);
+	pDestination[2] = uint8_t(color1 & 0xff);
+	pDestination[3] = uint8_t(color1 >> 8);
+	memcpy(pDestination + 4, &indices, sizeof(uint32_t));
+}
+
+void BlockCompression::encodeBC4(const uint8_t* pBlock, uint32_t channel, uint8_t* pDestination)
+{
+	uint8_t minValue = 255;
+	uint8_t maxValue = 0;
+	for (uint32_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+	{
+		minValue = std::min(minValue, pBlock[i * 4 + channel]);
+		maxValue = std::max(maxValue, pBlock[i * 4 + channel]);
+	}
+
+	//With value0 > value1 the palette is value0, value1 and six values between them
+	const int32_t value0 = maxValue;
+	const int32_t value1 = minValue;
+
+	int32_t palette[8];
+	palette[0] = value0;
+	palette[1] = value1;
+	for (int32_t p = 1; p < 7; p++)
+	{
+		palette[p + 1] = ((7 - p) * value0 + p * value1) / 7;
+	}
+
+	uint64_t indices = 0;
+	if (value0 != value1)
+	{
+		for (uint32_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+		{
+			const int32_t value = pBlock[i * 4 + channel];
+
+			uint64_t bestIndex		= 0;
+			int32_t bestDistance	= INT32_MAX;
+			for (uint32_t p = 0; p < 8; p++)
+			{
+				const int32_t distance = std::abs(value - palette[p]);
+				if (distance < bestDistance)
+				{
+					bestDistance	= distance;
+					bestIndex		= p;
+				}
+			}
+
+			indices |= bestIndex << (i * 3);
+		}
+	}
+
+	pDestination[0] = uint8_t(value0);
+	pDestination[1] = uint8_t(value1);
+	for (uint32_t b = 0; b < 6; b++)
+	{
+		pDestination[2 + b] = uint8_t(indices >> (b * 8));
+	}
+}
+
+void BlockCompression::encodeBC5(const uint8_t* pBlock, uint8_t* pDestination)
+{
+	encodeBC4(pBlock, 0, pDestination);
+	encodeBC4(pBlock, 1, pDestination + 8);
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "Core.h"
+
+#define BLOCK_DIMENSION 4U
+
+//CPU encoders for the BCn formats. The input is always RGBA8, BC1 uses the color, BC4 the red channel and BC5 the red and green channels
+class BlockCompression
+{
+public:
+	DECL_STATIC_CLASS(BlockCompression);
+
+	//Blocks that reach outside the image are padded by repeating the last row and column
+	static uint64_t getCompressedSize(ETextureFormat format, uint32_t width, uint32_t height);
+	static uint32_t getBlockRowCount(uint32_t height);
+
+	//Compresses the block rows [firstBlockRow, lastBlockRow) of an image, rows are independent so an image can be split between threads.
+	//pDestination points at the start of the compressed image, not at firstBlockRow
+	static void compressBlockRows(const uint8_t* pPixels, uint32_t width, uint32_t height, ETextureFormat format, uint32_t firstBlockRow, uint32_t lastBlockRow, uint8_t* pDestination);
+
+	//pBlock is 4x4 RGBA8 pixels in row order
+	static void encodeBC1(const uint8_t* pBlock, uint8_t* pDestination);
+	static void encodeBC4(const uint8_t* pBlock, uint32_t channel, uint8_t* pDestination);
+	static void encodeBC5(const uint8_t* pBlock, uint8_t* pDestination);
+};
@@ -17,6 +17,7 @@ Camera::Camera()
 	m_Direction(0.0f),
 	m_Right(0.0f),
 	m_Up(0.0f),
+	m_Frustum(),
 	m_IsDirty(true)
 {
 }
@@ -39,6 +40,8 @@ void Camera::setProjection(float fovDegrees, float width, float height, float ne
 {
 	m_Projection	= glm::perspective(glm::radians(fovDegrees), width / height, nearPlane, farPlane);
 	m_ProjectionInv = glm::inverse(m_Projection);
+
+	m_IsDirty = true;
 }
 
 void Camera::setRotation(const glm::vec3& rotation)
@@ -72,6 +75,7 @@ void Camera::update()
 		//Update view
 		m_View		= glm::lookAt(m_Position, m_Position + m_Direction, m_Up);
 		m_ViewInv	= glm::inverse(m_View);
+		m_Frustum	= Frustum(m_Projection * m_View);
 
 		m_IsDirty = false;
 	}
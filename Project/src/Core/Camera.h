@@ -1,5 +1,6 @@
 #pragma once
 #include "Core.h"
+#include "Frustum.h"
 
 struct CameraBuffer
 {
@@ -38,6 +39,8 @@ public:
 	const glm::vec3& getRotation() const { return m_Rotation; }
 	const glm::vec3& getRightVec() const { return m_Right; }
 	const glm::vec3& getUpVec() const { return m_Up; }
+	//Planes of the view volume in world space, rebuilt by update when the view or the projection has changed
+	const Frustum& getFrustum() const { return m_Frustum; }
 
 private:
 	void calculateVectors();
@@ -55,6 +58,8 @@ private:
 	glm::vec3 m_Right;
 	glm::vec3 m_Up;
 
+	Frustum m_Frustum;
+
 	bool m_IsDirty;
 };
 
@@ -65,6 +65,12 @@
 	#define FORCEINLINE inline
 #endif
 
+//SSE is part of every x64 target, 32 bit targets only have it when the compiler is told to use it
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1) || defined(__SSE__)
+	#define SSE_ENABLED
+	#include <xmmintrin.h>
+#endif
+
 // Size macros
 #define MB(bytes) bytes * 1024 * 1024
 
@@ -75,28 +81,12 @@ struct Vertex
 	alignas(16) glm::vec3 Normal;
 	alignas(16) glm::vec3 Tangent;
 	alignas(16) glm::vec2 TexCoord;
+	//Handedness of the tangent frame, -1 when the bitangent is -cross(normal, tangent) as on mirrored texture coordinates. Fills padding, the size stays 64 bytes
+	float BitangentSign = 1.0f;
 
 	bool operator==(const Vertex& other) const
 	{
-		return Position == other.Position && Normal == other.Normal && Tangent == other.Tangent && TexCoord == other.TexCoord;
-	}
-
-	void calculateTangent(const Vertex& v1, const Vertex& v2)
-	{
-		glm::vec3 edge1 = v1.Position - this->Position;
-		glm::vec3 edge2 = v2.Position - this->Position;
-		glm::vec2 deltaUV1 = v1.TexCoord - this->TexCoord;
-		glm::vec2 deltaUV2 = v2.TexCoord - this->TexCoord;
-
-		float f = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y);
-
-		glm::vec3 tangent;
-		tangent.x = f * (deltaUV2.y * edge1.x - deltaUV1.y * edge2.x);
-		tangent.y = f * (deltaUV2.y * edge1.y - deltaUV1.y * edge2.y);
-		tangent.z = f * (deltaUV2.y * edge1.z - deltaUV1.y * edge2.z);
-		tangent = glm::normalize(tangent);
-
-		this->Tangent = tangent;
+		return Position == other.Position && Normal == other.Normal && Tangent == other.Tangent && TexCoord == other.TexCoord && BitangentSign == other.BitangentSign;
 	}
 };
 
@@ -104,13 +94,8 @@ namespace std
 {
 	template<> struct hash<Vertex>
 	{
-		size_t operator()(Vertex const& vertex) const
-		{
-			return
-				((hash<glm::vec3>()(vertex.Position) ^
-				(hash<glm::vec3>()(vertex.Normal) << 1)) >> 1) ^
-				(hash<glm::vec2>()(vertex.TexCoord) << 1);
-		}
+		//Defined in VertexWelder.cpp, uses VertexWelder::hash
+		size_t operator()(Vertex const& vertex) const;
 	};
 }
 
@@ -120,7 +105,19 @@ enum class ETextureFormat : uint8_t
 	FORMAT_R8G8B8A8_UNORM		= 1,
 	FORMAT_R16G16_FLOAT			= 2,
 	FORMAT_R16G16B16A16_FLOAT	= 3,
-	FORMAT_R32G32B32A32_FLOAT	= 4
+	FORMAT_R32G32B32A32_FLOAT	= 4,
+	FORMAT_BC1_RGB_UNORM		= 5,
+	FORMAT_BC4_UNORM			= 6,
+	FORMAT_BC5_UNORM			= 7
+};
+
+//How a texture loaded from file is compressed on the GPU, chosen by what the texture is used for
+enum class ETextureCompression : uint8_t
+{
+	NONE			= 0,
+	COLOR			= 1,
+	NORMAL_MAP		= 2,
+	SINGLE_CHANNEL	= 3
 };
 
 inline uint32_t textureFormatStride(ETextureFormat format)
@@ -133,5 +130,23 @@ inline uint32_t textureFormatStride(ETextureFormat format)
 	case ETextureFormat::FORMAT_R32G32B32A32_FLOAT: return 16;
 	}
 
+	return 0;
+}
+
+inline bool isBlockCompressed(ETextureFormat format)
+{
+	return format == ETextureFormat::FORMAT_BC1_RGB_UNORM || format == ETextureFormat::FORMAT_BC4_UNORM || format == ETextureFormat::FORMAT_BC5_UNORM;
+}
+
+//Size of one 4x4 block of a block compressed format
+inline uint32_t textureFormatBlockSize(ETextureFormat format)
+{
+	switch (format)
+	{
+	case ETextureFormat::FORMAT_BC1_RGB_UNORM:
+	case ETextureFormat::FORMAT_BC4_UNORM:	return 8;
+	case ETextureFormat::FORMAT_BC5_UNORM:	return 16;
+	}
+
 	return 0;
 }
\ No newline at end of file
@@ -12,6 +12,7 @@
 DirectionalLight::DirectionalLight(const VolumetricLightSettings& volumetricLightSettings, const glm::vec3& direction, const glm::vec4& color)
     :m_Direction(direction),
     m_Color(color),
+    m_Frustum(),
     m_ScatterAmount(volumetricLightSettings.m_ScatterAmount),
     m_ParticleG(volumetricLightSettings.m_ParticleG),
     m_pFrameBuffer(nullptr),
@@ -46,6 +47,7 @@ void DirectionalLight::createLightTransformBuffer(DirectionalLightBuffer& buffer
     glm::mat4 projection    = glm::ortho(-width * 0.5f, width * 0.5f, -height * 0.5f, height * 0.5f, -DEPTH_MAX, DEPTH_MAX);
     buffer.viewProj         = projection * view;
     buffer.invViewProj      = glm::inverse(buffer.viewProj);
+    m_Frustum               = Frustum(buffer.viewProj);
     buffer.direction        = glm::vec4(m_Direction, 0.0f);
     buffer.color            = m_Color;
     buffer.scatterAmount    = m_ScatterAmount;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Core/Frustum.h"
 #include "Core/VolumetricLight.h"
 
 #include <glm/glm.hpp>
@@ -36,6 +37,8 @@ public:
     glm::vec4 getColor() const      { return m_Color; }
     float getScatterAmount() const  { return m_ScatterAmount; }
     float getParticleG() const      { return m_ParticleG; }
+    // View volume of the shadow map, updated by createLightTransformBuffer
+    const Frustum& getFrustum() const { return m_Frustum; }
 
     void setFrameBuffer(IFrameBuffer* pFrameBuffer)     { m_pFrameBuffer = pFrameBuffer; }
     void setDepthImage(IImage* pDepthImage)             { m_pDepthImage = pDepthImage; }
@@ -57,6 +60,7 @@ public:
 private:
     glm::vec3 m_Position, m_Direction;
     glm::vec4 m_Color;
+    Frustum m_Frustum;
 
     // Volumetric light settings
     float m_ScatterAmount, m_ParticleG;
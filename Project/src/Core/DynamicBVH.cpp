@@ -0,0 +1,739 @@
+#include "DynamicBVH.h"
+
+#include <limits>
+#include <utility>
+#include <algorithm>
+
+//Half the surface area of a box, only ever compared against other areas
+static FORCEINLINE float area(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	const glm::vec3 size = boundsMax - boundsMin;
+	return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+static FORCEINLINE float unionArea(const glm::vec3& min0, const glm::vec3& max0, const glm::vec3& min1, const glm::vec3& max1)
+{
+	return area(glm::min(min0, min1), glm::max(max0, max1));
+}
+
+static FORCEINLINE bool contains(const glm::vec3& outerMin, const glm::vec3& outerMax, const glm::vec3& innerMin, const glm::vec3& innerMax)
+{
+	return glm::all(glm::lessThanEqual(outerMin, innerMin)) && glm::all(glm::greaterThanEqual(outerMax, innerMax));
+}
+
+//Returns -1 if the box is outside of one of the planes in the mask, otherwise the mask without the planes that the box is completely inside of
+static FORCEINLINE int32_t testPlanes(const Frustum& frustum, uint32_t planeMask, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	const glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+	const glm::vec3 extent = (boundsMax - boundsMin) * 0.5f;
+
+	for (uint32_t p = 0; p < 6; p++)
+	{
+		if ((planeMask & (1U << p)) == 0)
+		{
+			continue;
+		}
+
+		const glm::vec4& plane	= frustum.getPlane(p);
+		const float distance	= glm::dot(glm::vec3(plane), center) + plane.w;
+		const float radius		= glm::dot(glm::abs(glm::vec3(plane)), extent);
+		if (distance + radius < 0.0f)
+		{
+			return -1;
+		}
+		else if (distance - radius >= 0.0f)
+		{
+			planeMask &= ~(1U << p);
+		}
+	}
+
+	return int32_t(planeMask);
+}
+
+static FORCEINLINE bool intersectsSphere(const glm::vec3& center, float radiusSquared, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	const glm::vec3 offset = glm::clamp(center, boundsMin, boundsMax) - center;
+	return glm::dot(offset, offset) <= radiusSquared;
+}
+
+static FORCEINLINE bool intersectsRay(const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	//Slab test, a zero component of the direction gives infinite distances that min and max sort out
+	const glm::vec3 t0 = (boundsMin - origin) * inverseDirection;
+	const glm::vec3 t1 = (boundsMax - origin) * inverseDirection;
+	const glm::vec3 tNear	= glm::min(t0, t1);
+	const glm::vec3 tFar	= glm::max(t0, t1);
+
+	const float enter	= std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+	const float exit	= std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+	return enter <= exit;
+}
+
+DynamicBVH::DynamicBVH()
+	: m_Nodes(),
+	m_Root(DYNAMIC_BVH_NULL_NODE),
+	m_FreeList(DYNAMIC_BVH_NULL_NODE),
+	m_LeafCount(0)
+{
+}
+
+uint32_t DynamicBVH::insert(uint32_t objectIndex, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	const uint32_t leaf = allocateNode();
+
+	Node& node = m_Nodes[leaf];
+	node.Child2 = objectIndex;
+	setFatBounds(node, boundsMin, boundsMax);
+	m_ObjectBounds[leaf] = { boundsMin, boundsMax };
+
+	insertLeaf(leaf);
+	m_LeafCount++;
+	return leaf;
+}
+
+void DynamicBVH::remove(uint32_t leaf)
+{
+	ASSERT(isLeaf(leaf));
+
+	removeLeaf(leaf);
+	freeNode(leaf);
+	m_LeafCount--;
+}
+
+bool DynamicBVH::move(uint32_t leaf, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	ASSERT(isLeaf(leaf));
+
+	m_ObjectBounds[leaf] = { boundsMin, boundsMax };
+
+	const Node& node = m_Nodes[leaf];
+
+	Node fatNode = {};
+	setFatBounds(fatNode, boundsMin, boundsMax);
+
+	const bool isContained	= contains(node.BoundsMin, node.BoundsMax, boundsMin, boundsMax);
+	const bool isTooLarge	= area(node.BoundsMin, node.BoundsMax) > DYNAMIC_BVH_MAX_FAT_RATIO * area(fatNode.BoundsMin, fatNode.BoundsMax);
+	if (isContained && !isTooLarge)
+	{
+		return false;
+	}
+
+	removeLeaf(leaf);
+
+	m_Nodes[leaf].BoundsMin = fatNode.BoundsMin;
+	m_Nodes[leaf].BoundsMax = fatNode.BoundsMax;
+	insertLeaf(leaf);
+	return true;
+}
+
+void DynamicBVH::clear()
+{
+	m_Nodes.clear();
+	m_ObjectBounds.clear();
+	m_Root		= DYNAMIC_BVH_NULL_NODE;
+	m_FreeList	= DYNAMIC_BVH_NULL_NODE;
+	m_LeafCount	= 0;
+}
+
+void DynamicBVH::rebuild()
+{
+	if (m_LeafCount < 2)
+	{
+		return;
+	}
+
+	//The inner nodes are freed while the leaves are gathered and allocated again by the build
+	std::vector<uint32_t> leaves;
+	leaves.reserve(m_LeafCount);
+
+	std::vector<uint32_t> stack = { m_Root };
+	while (!stack.empty())
+	{
+		const uint32_t index = stack.back();
+		stack.pop_back();
+
+		if (isLeaf(index))
+		{
+			leaves.push_back(index);
+		}
+		else
+		{
+			stack.push_back(m_Nodes[index].Child1);
+			stack.push_back(m_Nodes[index].Child2);
+			freeNode(index);
+		}
+	}
+
+	m_Root = buildSubtree(leaves.data(), uint32_t(leaves.size()), 0);
+	m_Nodes[m_Root].Parent = DYNAMIC_BVH_NULL_NODE;
+}
+
+void DynamicBVH::queryFrustum(const Frustum& frustum, std::vector<uint32_t>& objects) const
+{
+	objects.clear();
+	if (m_Root == DYNAMIC_BVH_NULL_NODE)
+	{
+		return;
+	}
+
+	//Every node carries the planes that its parent was not completely inside of, subtrees inside of all planes are added without any tests
+	std::vector<std::pair<uint32_t, uint32_t>> stack;
+	stack.reserve(64);
+	stack.push_back({ m_Root, 0x3FU });
+
+	while (!stack.empty())
+	{
+		const uint32_t index	= stack.back().first;
+		uint32_t planeMask		= stack.back().second;
+		stack.pop_back();
+
+		const Node& node = m_Nodes[index];
+		if (isLeaf(index))
+		{
+			const ObjectBounds& bounds = m_ObjectBounds[index];
+			if (planeMask == 0 || testPlanes(frustum, planeMask, bounds.BoundsMin, bounds.BoundsMax) >= 0)
+			{
+				objects.push_back(node.Child2);
+			}
+
+			continue;
+		}
+
+		if (planeMask != 0)
+		{
+			const int32_t result = testPlanes(frustum, planeMask, node.BoundsMin, node.BoundsMax);
+			if (result < 0)
+			{
+				continue;
+			}
+
+			planeMask = uint32_t(result);
+		}
+
+		stack.push_back({ node.Child1, planeMask });
+		stack.push_back({ node.Child2, planeMask });
+	}
+}
+
+void DynamicBVH::querySphere(const glm::vec3& center, float radius, std::vector<uint32_t>& objects) const
+{
+	objects.clear();
+	if (m_Root == DYNAMIC_BVH_NULL_NODE)
+	{
+		return;
+	}
+
+	const float radiusSquared = radius * radius;
+
+	std::vector<uint32_t> stack;
+	stack.reserve(64);
+	stack.push_back(m_Root);
+
+	while (!stack.empty())
+	{
+		const uint32_t index = stack.back();
+		stack.pop_back();
+
+		const Node& node = m_Nodes[index];
+		if (isLeaf(index))
+		{
+			const ObjectBounds& bounds = m_ObjectBounds[index];
+			if (intersectsSphere(center, radiusSquared, bounds.BoundsMin, bounds.BoundsMax))
+			{
+				objects.push_back(node.Child2);
+			}
+		}
+		else if (intersectsSphere(center, radiusSquared, node.BoundsMin, node.BoundsMax))
+		{
+			stack.push_back(node.Child1);
+			stack.push_back(node.Child2);
+		}
+	}
+}
+
+void DynamicBVH::queryRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, std::vector<uint32_t>& objects) const
+{
+	objects.clear();
+	if (m_Root == DYNAMIC_BVH_NULL_NODE)
+	{
+		return;
+	}
+
+	const glm::vec3 inverseDirection = 1.0f / direction;
+
+	std::vector<uint32_t> stack;
+	stack.reserve(64);
+	stack.push_back(m_Root);
+
+	while (!stack.empty())
+	{
+		const uint32_t index = stack.back();
+		stack.pop_back();
+
+		const Node& node = m_Nodes[index];
+		if (isLeaf(index))
+		{
+			const ObjectBounds& bounds = m_ObjectBounds[index];
+			if (intersectsRay(origin, inverseDirection, maxDistance, bounds.BoundsMin, bounds.BoundsMax))
+			{
+				objects.push_back(node.Child2);
+			}
+		}
+		else if (intersectsRay(origin, inverseDirection, maxDistance, node.BoundsMin, node.BoundsMax))
+		{
+			stack.push_back(node.Child1);
+			stack.push_back(node.Child2);
+		}
+	}
+}
+
+float DynamicBVH::getAreaRatio() const
+{
+	if (m_Root == DYNAMIC_BVH_NULL_NODE || isLeaf(m_Root))
+	{
+		return 0.0f;
+	}
+
+	const float rootArea = area(m_Nodes[m_Root].BoundsMin, m_Nodes[m_Root].BoundsMax);
+	if (rootArea <= 0.0f)
+	{
+		return 0.0f;
+	}
+
+	float totalArea = 0.0f;
+
+	std::vector<uint32_t> stack = { m_Root };
+	while (!stack.empty())
+	{
+		const uint32_t index = stack.back();
+		stack.pop_back();
+
+		if (!isLeaf(index))
+		{
+			const Node& node = m_Nodes[index];
+			totalArea += area(node.BoundsMin, node.BoundsMax);
+			stack.push_back(node.Child1);
+			stack.push_back(node.Child2);
+		}
+	}
+
+	return totalArea / rootArea;
+}
+
+bool DynamicBVH::validate() const
+{
+	if (m_Root == DYNAMIC_BVH_NULL_NODE)
+	{
+		return m_LeafCount == 0;
+	}
+
+	if (m_Nodes[m_Root].Parent != DYNAMIC_BVH_NULL_NODE)
+	{
+		return false;
+	}
+
+	uint32_t leafCount = 0;
+
+	std::vector<uint32_t> stack = { m_Root };
+	while (!stack.empty())
+	{
+		const uint32_t index = stack.back();
+		stack.pop_back();
+
+		const Node& node = m_Nodes[index];
+		if (isLeaf(index))
+		{
+			if (node.Height != 0 || !contains(node.BoundsMin, node.BoundsMax, m_ObjectBounds[index].BoundsMin, m_ObjectBounds[index].BoundsMax))
+			{
+				return false;
+			}
+
+			leafCount++;
+			continue;
+		}
+
+		const Node& child1 = m_Nodes[node.Child1];
+		const Node& child2 = m_Nodes[node.Child2];
+		if (child1.Parent != index || child2.Parent != index || node.Height != 1 + std::max(child1.Height, child2.Height))
+		{
+			return false;
+		}
+
+		if (node.BoundsMin != glm::min(child1.BoundsMin, child2.BoundsMin) || node.BoundsMax != glm::max(child1.BoundsMax, child2.BoundsMax))
+		{
+			return false;
+		}
+
+		stack.push_back(node.Child1);
+		stack.push_back(node.Child2);
+	}
+
+	return leafCount == m_LeafCount;
+}
+
+uint32_t DynamicBVH::allocateNode()
+{
+	uint32_t index = m_FreeList;
+	if (index != DYNAMIC_BVH_NULL_NODE)
+	{
+		m_FreeList = m_Nodes[index].Child1;
+	}
+	else
+	{
+		index = uint32_t(m_Nodes.size());
+		m_Nodes.emplace_back();
+		m_ObjectBounds.emplace_back();
+	}
+
+	Node& node = m_Nodes[index];
+	node.Parent			= DYNAMIC_BVH_NULL_NODE;
+	node.Child1			= DYNAMIC_BVH_NULL_NODE;
+	node.Child2			= DYNAMIC_BVH_NULL_NODE;
+	node.Height			= 0;
+	return index;
+}
+
+void DynamicBVH::freeNode(uint32_t index)
+{
+	m_Nodes[index].Child1 = m_FreeList;
+	m_FreeList = index;
+}
+
+void DynamicBVH::insertLeaf(uint32_t leaf)
+{
+	if (m_Root == DYNAMIC_BVH_NULL_NODE)
+	{
+		m_Root = leaf;
+		m_Nodes[leaf].Parent = DYNAMIC_BVH_NULL_NODE;
+		return;
+	}
+
+	const uint32_t sibling		= findBestSibling(m_Nodes[leaf].BoundsMin, m_Nodes[leaf].BoundsMax);
+	const uint32_t oldParent	= m_Nodes[sibling].Parent;
+	const uint32_t newParent	= allocateNode();
+
+	Node& parentNode = m_Nodes[newParent];
+	parentNode.Parent		= oldParent;
+	parentNode.Child1		= sibling;
+	parentNode.Child2		= leaf;
+	parentNode.BoundsMin	= glm::min(m_Nodes[sibling].BoundsMin, m_Nodes[leaf].BoundsMin);
+	parentNode.BoundsMax	= glm::max(m_Nodes[sibling].BoundsMax, m_Nodes[leaf].BoundsMax);
+	parentNode.Height		= m_Nodes[sibling].Height + 1;
+
+	if (oldParent != DYNAMIC_BVH_NULL_NODE)
+	{
+		replaceChild(oldParent, sibling, newParent);
+	}
+	else
+	{
+		m_Root = newParent;
+	}
+
+	m_Nodes[sibling].Parent	= newParent;
+	m_Nodes[leaf].Parent	= newParent;
+
+	refitAncestors(newParent);
+}
+
+void DynamicBVH::removeLeaf(uint32_t leaf)
+{
+	if (leaf == m_Root)
+	{
+		m_Root = DYNAMIC_BVH_NULL_NODE;
+		return;
+	}
+
+	const uint32_t parent		= m_Nodes[leaf].Parent;
+	const uint32_t grandParent	= m_Nodes[parent].Parent;
+	const uint32_t sibling		= (m_Nodes[parent].Child1 == leaf) ? m_Nodes[parent].Child2 : m_Nodes[parent].Child1;
+
+	freeNode(parent);
+	m_Nodes[leaf].Parent = DYNAMIC_BVH_NULL_NODE;
+
+	if (grandParent != DYNAMIC_BVH_NULL_NODE)
+	{
+		replaceChild(grandParent, parent, sibling);
+		m_Nodes[sibling].Parent = grandParent;
+		refitAncestors(grandParent);
+	}
+	else
+	{
+		m_Root = sibling;
+		m_Nodes[sibling].Parent = DYNAMIC_BVH_NULL_NODE;
+	}
+}
+
+uint32_t DynamicBVH::findBestSibling(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const
+{
+	//Pairing the leaf with a node costs the area of their union plus the area that every ancestor of the node grows by. The search goes down one path
+	//and takes the child with the lowest bound for its subtree, which is the area of the leaf plus the growth of the child and its ancestors
+	const float leafArea = area(boundsMin, boundsMax);
+
+	uint32_t index		= m_Root;
+	float directCost	= unionArea(m_Nodes[m_Root].BoundsMin, m_Nodes[m_Root].BoundsMax, boundsMin, boundsMax);
+	float inheritedCost	= 0.0f;
+
+	uint32_t bestSibling	= m_Root;
+	float bestCost			= directCost;
+
+	while (!isLeaf(index))
+	{
+		const Node& node = m_Nodes[index];
+		inheritedCost += directCost - area(node.BoundsMin, node.BoundsMax);
+
+		uint32_t children[2]	= { node.Child1, node.Child2 };
+		float directCosts[2]	= {};
+		float lowerBounds[2]	= {};
+		for (uint32_t c = 0; c < 2; c++)
+		{
+			const Node& child	= m_Nodes[children[c]];
+			directCosts[c]		= unionArea(child.BoundsMin, child.BoundsMax, boundsMin, boundsMax);
+
+			const float cost = directCosts[c] + inheritedCost;
+			if (cost < bestCost)
+			{
+				bestSibling	= children[c];
+				bestCost	= cost;
+			}
+
+			lowerBounds[c] = isLeaf(children[c]) ? std::numeric_limits<float>::max() : leafArea + inheritedCost + directCosts[c] - area(child.BoundsMin, child.BoundsMax);
+		}
+
+		const uint32_t next = (lowerBounds[1] < lowerBounds[0]) ? 1 : 0;
+		if (lowerBounds[next] >= bestCost)
+		{
+			break;
+		}
+
+		index		= children[next];
+		directCost	= directCosts[next];
+	}
+
+	return bestSibling;
+}
+
+uint32_t DynamicBVH::buildSubtree(uint32_t* pLeaves, uint32_t leafCount, uint32_t depth)
+{
+	if (leafCount == 1)
+	{
+		return pLeaves[0];
+	}
+
+	glm::vec3 centroidMin = glm::vec3(std::numeric_limits<float>::max());
+	glm::vec3 centroidMax = glm::vec3(std::numeric_limits<float>::lowest());
+	for (uint32_t i = 0; i < leafCount; i++)
+	{
+		const Node& leaf = m_Nodes[pLeaves[i]];
+		const glm::vec3 centroid = (leaf.BoundsMin + leaf.BoundsMax) * 0.5f;
+		centroidMin = glm::min(centroidMin, centroid);
+		centroidMax = glm::max(centroidMax, centroid);
+	}
+
+	const glm::vec3 centroidSize = centroidMax - centroidMin;
+	const uint32_t axis = (centroidSize.x >= centroidSize.y && centroidSize.x >= centroidSize.z) ? 0 : (centroidSize.y >= centroidSize.z ? 1 : 2);
+
+	//The leaves are put into bins along the longest axis of their centroids and the tree is split between the bins where
+	//the area of each side times the number of leaves on it is the lowest
+	uint32_t splitCount	= leafCount / 2;
+	bool isSplit		= false;
+	if (centroidSize[axis] > 0.0f && depth < DYNAMIC_BVH_MAX_SAH_DEPTH)
+	{
+		const float binScale = float(DYNAMIC_BVH_BIN_COUNT) / centroidSize[axis];
+		auto getBin = [&](uint32_t leaf)
+		{
+			const float centroid = (m_Nodes[leaf].BoundsMin[axis] + m_Nodes[leaf].BoundsMax[axis]) * 0.5f;
+			return std::min(uint32_t((centroid - centroidMin[axis]) * binScale), DYNAMIC_BVH_BIN_COUNT - 1);
+		};
+
+		glm::vec3 binMin[DYNAMIC_BVH_BIN_COUNT];
+		glm::vec3 binMax[DYNAMIC_BVH_BIN_COUNT];
+		uint32_t binCounts[DYNAMIC_BVH_BIN_COUNT] = {};
+		for (uint32_t b = 0; b < DYNAMIC_BVH_BIN_COUNT; b++)
+		{
+			binMin[b] = glm::vec3(std::numeric_limits<float>::max());
+			binMax[b] = glm::vec3(std::numeric_limits<float>::lowest());
+		}
+
+		for (uint32_t i = 0; i < leafCount; i++)
+		{
+			const Node& leaf = m_Nodes[pLeaves[i]];
+			const uint32_t bin = getBin(pLeaves[i]);
+			binMin[bin] = glm::min(binMin[bin], leaf.BoundsMin);
+			binMax[bin] = glm::max(binMax[bin], leaf.BoundsMax);
+			binCounts[bin]++;
+		}
+
+		//The costs of the right sides are summed from the last bin, the left sides while the splits are compared
+		float rightCosts[DYNAMIC_BVH_BIN_COUNT] = {};
+		glm::vec3 sideMin = glm::vec3(std::numeric_limits<float>::max());
+		glm::vec3 sideMax = glm::vec3(std::numeric_limits<float>::lowest());
+		uint32_t sideCount = 0;
+		for (uint32_t b = DYNAMIC_BVH_BIN_COUNT - 1; b > 0; b--)
+		{
+			sideMin		= glm::min(sideMin, binMin[b]);
+			sideMax		= glm::max(sideMax, binMax[b]);
+			sideCount	+= binCounts[b];
+			rightCosts[b] = (sideCount > 0) ? area(sideMin, sideMax) * float(sideCount) : 0.0f;
+		}
+
+		float bestCost		= std::numeric_limits<float>::max();
+		uint32_t bestSplit	= 0;
+		sideMin		= glm::vec3(std::numeric_limits<float>::max());
+		sideMax		= glm::vec3(std::numeric_limits<float>::lowest());
+		sideCount	= 0;
+		for (uint32_t b = 1; b < DYNAMIC_BVH_BIN_COUNT; b++)
+		{
+			sideMin		= glm::min(sideMin, binMin[b - 1]);
+			sideMax		= glm::max(sideMax, binMax[b - 1]);
+			sideCount	+= binCounts[b - 1];
+
+			if (sideCount == 0 || sideCount == leafCount)
+			{
+				continue;
+			}
+
+			const float cost = area(sideMin, sideMax) * float(sideCount) + rightCosts[b];
+			if (cost < bestCost)
+			{
+				bestCost	= cost;
+				bestSplit	= b;
+			}
+		}
+
+		if (bestSplit > 0)
+		{
+			uint32_t* pMiddle = std::partition(pLeaves, pLeaves + leafCount, [&](uint32_t leaf) { return getBin(leaf) < bestSplit; });
+			splitCount	= uint32_t(pMiddle - pLeaves);
+			isSplit		= true;
+		}
+	}
+
+	//Leaves with the same centroids, and subtrees that are too deep, are split in half along the axis
+	if (!isSplit)
+	{
+		std::nth_element(pLeaves, pLeaves + splitCount, pLeaves + leafCount, [&](uint32_t first, uint32_t second)
+			{
+				return m_Nodes[first].BoundsMin[axis] + m_Nodes[first].BoundsMax[axis] < m_Nodes[second].BoundsMin[axis] + m_Nodes[second].BoundsMax[axis];
+			});
+	}
+
+	const uint32_t child1 = buildSubtree(pLeaves, splitCount, depth + 1);
+	const uint32_t child2 = buildSubtree(pLeaves + splitCount, leafCount - splitCount, depth + 1);
+
+	const uint32_t index = allocateNode();
+	m_Nodes[index].Child1	= child1;
+	m_Nodes[index].Child2	= child2;
+	m_Nodes[child1].Parent	= index;
+	m_Nodes[child2].Parent	= index;
+	refitNode(index);
+	return index;
+}
+
+void DynamicBVH::refitAncestors(uint32_t index)
+{
+	while (index != DYNAMIC_BVH_NULL_NODE)
+	{
+		refitNode(index);
+		rotate(index);
+		index = m_Nodes[index].Parent;
+	}
+}
+
+void DynamicBVH::refitNode(uint32_t index)
+{
+	Node& node = m_Nodes[index];
+	const Node& child1 = m_Nodes[node.Child1];
+	const Node& child2 = m_Nodes[node.Child2];
+
+	node.BoundsMin	= glm::min(child1.BoundsMin, child2.BoundsMin);
+	node.BoundsMax	= glm::max(child1.BoundsMax, child2.BoundsMax);
+	node.Height		= 1 + std::max(child1.Height, child2.Height);
+}
+
+void DynamicBVH::rotate(uint32_t index)
+{
+	//A node with the children B and C can swap B with a child of C or C with a child of B. The box of the node stays the same,
+	//only the child that receives the grandchild changes, so the rotation that shrinks that child the most is picked
+	const uint32_t b = m_Nodes[index].Child1;
+	const uint32_t c = m_Nodes[index].Child2;
+
+	float bestDelta			= 0.0f;
+	uint32_t bestChild		= DYNAMIC_BVH_NULL_NODE;
+	uint32_t bestGrandChild	= DYNAMIC_BVH_NULL_NODE;
+
+	auto tryRotations = [&](uint32_t child, uint32_t inner)
+	{
+		if (isLeaf(inner))
+		{
+			return;
+		}
+
+		const Node& childNode	= m_Nodes[child];
+		const Node& innerNode	= m_Nodes[inner];
+		const Node& first		= m_Nodes[innerNode.Child1];
+		const Node& second		= m_Nodes[innerNode.Child2];
+		const float innerArea	= area(innerNode.BoundsMin, innerNode.BoundsMax);
+
+		//Swapping the child with the first grandchild leaves the inner node with the child and the second grandchild
+		const float firstDelta = unionArea(childNode.BoundsMin, childNode.BoundsMax, second.BoundsMin, second.BoundsMax) - innerArea;
+		if (firstDelta < bestDelta)
+		{
+			bestDelta		= firstDelta;
+			bestChild		= child;
+			bestGrandChild	= innerNode.Child1;
+		}
+
+		const float secondDelta = unionArea(childNode.BoundsMin, childNode.BoundsMax, first.BoundsMin, first.BoundsMax) - innerArea;
+		if (secondDelta < bestDelta)
+		{
+			bestDelta		= secondDelta;
+			bestChild		= child;
+			bestGrandChild	= innerNode.Child2;
+		}
+	};
+
+	tryRotations(b, c);
+	tryRotations(c, b);
+
+	if (bestChild != DYNAMIC_BVH_NULL_NODE)
+	{
+		swapNodes(index, bestChild, bestGrandChild);
+	}
+}
+
+void DynamicBVH::swapNodes(uint32_t parent, uint32_t child, uint32_t grandChild)
+{
+	const uint32_t inner = m_Nodes[grandChild].Parent;
+
+	replaceChild(parent, child, grandChild);
+	m_Nodes[grandChild].Parent = parent;
+
+	replaceChild(inner, grandChild, child);
+	m_Nodes[child].Parent = inner;
+
+	refitNode(inner);
+	refitNode(parent);
+}
+
+void DynamicBVH::replaceChild(uint32_t parent, uint32_t oldChild, uint32_t newChild)
+{
+	Node& node = m_Nodes[parent];
+	if (node.Child1 == oldChild)
+	{
+		node.Child1 = newChild;
+	}
+	else
+	{
+		ASSERT(node.Child2 == oldChild);
+		node.Child2 = newChild;
+	}
+}
+
+void DynamicBVH::setFatBounds(Node& node, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	const glm::vec3 size	= boundsMax - boundsMin;
+	const glm::vec3 margin	= glm::vec3(DYNAMIC_BVH_FAT_MARGIN * std::max(size.x, std::max(size.y, size.z)));
+
+	node.BoundsMin = boundsMin - margin;
+	node.BoundsMax = boundsMax + margin;
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include "Core.h"
+#include "Frustum.h"
+
+#include <vector>
+
+#define DYNAMIC_BVH_NULL_NODE		UINT32_MAX
+//Leaves are larger than their objects by this fraction of the longest side of the object, objects that move inside of their leaf do not change the tree
+#define DYNAMIC_BVH_FAT_MARGIN		0.1f
+//A leaf is shrunk when its surface area is this many times larger than a new fat box around the object would be
+#define DYNAMIC_BVH_MAX_FAT_RATIO	4.0f
+//Number of bins along the longest axis that the SAH splits of a rebuild are picked from
+#define DYNAMIC_BVH_BIN_COUNT		16U
+//Subtrees of a rebuild that are deeper than this are split at the median instead, which bounds the height of the tree
+#define DYNAMIC_BVH_MAX_SAH_DEPTH	32U
+
+//Axis aligned bounding box tree over a changing set of objects (Catto, "Dynamic Bounding Volume Hierarchies", GDC 2019).
+//A new leaf is paired with the node on a path down the tree that adds the least surface area, and the nodes above it are rotated whenever that lowers the
+//surface area of the tree, which keeps the SAH cost low as objects come and go. The leaves hold fat boxes, so only objects that leave them touch the tree
+class DynamicBVH
+{
+	struct Node
+	{
+		//Fat box for leaves, union of the children for inner nodes
+		glm::vec3 BoundsMin;
+		glm::vec3 BoundsMax;
+		uint32_t Parent;
+		//DYNAMIC_BVH_NULL_NODE for leaves, links the free nodes together
+		uint32_t Child1;
+		//Index of the object for leaves
+		uint32_t Child2;
+		//Zero for leaves
+		uint32_t Height;
+	};
+
+	//Exact box of the object in a leaf, kept apart from the nodes so that they stay small while the tree is walked
+	struct ObjectBounds
+	{
+		glm::vec3 BoundsMin;
+		glm::vec3 BoundsMax;
+	};
+
+public:
+	DynamicBVH();
+	~DynamicBVH() = default;
+
+	DECL_NO_COPY(DynamicBVH);
+
+	//Returns the leaf that holds the object, which is used to move and remove it
+	uint32_t insert(uint32_t objectIndex, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+	void remove(uint32_t leaf);
+	//Only reinserts the leaf when the object has left its fat box or become a lot smaller than it, returns true if the tree changed
+	bool move(uint32_t leaf, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+	void clear();
+	//Rebuilds the inner nodes from the top down with binned SAH splits, which gives a better tree than inserting the objects one at a time.
+	//The leaves are kept, so the handles returned by insert stay valid
+	void rebuild();
+
+	//The queries replace the contents of objects with the indices of the objects whose exact boxes are hit, in no particular order
+	void queryFrustum(const Frustum& frustum, std::vector<uint32_t>& objects) const;
+	void querySphere(const glm::vec3& center, float radius, std::vector<uint32_t>& objects) const;
+	//The direction does not have to be normalized, maxDistance is measured in lengths of the direction
+	void queryRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, std::vector<uint32_t>& objects) const;
+
+	//Surface area of the inner nodes relative to the root, the part of the SAH cost that depends on the shape of the tree
+	float getAreaRatio() const;
+	//Checks the links, heights and boxes of every node
+	bool validate() const;
+
+	FORCEINLINE uint32_t getHeight() const		{ return (m_Root != DYNAMIC_BVH_NULL_NODE) ? m_Nodes[m_Root].Height : 0; }
+	FORCEINLINE uint32_t getLeafCount() const	{ return m_LeafCount; }
+
+private:
+	uint32_t allocateNode();
+	void freeNode(uint32_t index);
+
+	void insertLeaf(uint32_t leaf);
+	//Unlinks the leaf from the tree without freeing it
+	void removeLeaf(uint32_t leaf);
+	uint32_t findBestSibling(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const;
+	//Returns the root of a subtree over the leaves
+	uint32_t buildSubtree(uint32_t* pLeaves, uint32_t leafCount, uint32_t depth);
+
+	//Recomputes the boxes and heights from the node up to the root and rotates every node on the way
+	void refitAncestors(uint32_t index);
+	void refitNode(uint32_t index);
+	void rotate(uint32_t index);
+	//Swaps child, a child of parent, with grandChild, a child of the other child of parent
+	void swapNodes(uint32_t parent, uint32_t child, uint32_t grandChild);
+	void replaceChild(uint32_t parent, uint32_t oldChild, uint32_t newChild);
+
+	static void setFatBounds(Node& node, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+	FORCEINLINE bool isLeaf(uint32_t index) const { return m_Nodes[index].Child1 == DYNAMIC_BVH_NULL_NODE; }
+
+private:
+	std::vector<Node> m_Nodes;
+	std::vector<ObjectBounds> m_ObjectBounds;
+	uint32_t m_Root;
+	uint32_t m_FreeList;
+	uint32_t m_LeafCount;
+};
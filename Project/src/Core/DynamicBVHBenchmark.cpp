@@ -0,0 +1,211 @@
+#include "DynamicBVHBenchmark.h"
+#include "DynamicBVH.h"
+#include "ObjectCuller.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <chrono>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#define BVH_BENCHMARK_FRAMES		64U
+//Part of the objects that move every frame, and how far they move relative to their size
+#define BVH_BENCHMARK_MOVING_PART	0.01f
+#define BVH_BENCHMARK_MOVE_STEP		0.05f
+//The scenes keep the same density, so the side of the cube that the objects are spread over grows with the cube root of the count
+#define BVH_BENCHMARK_SPACING		20.0f
+//Same projection as the camera of the application
+#define BVH_BENCHMARK_FIELD_OF_VIEW	90.0f
+#define BVH_BENCHMARK_FAR_PLANE		100.0f
+#define BVH_BENCHMARK_LIGHT_RADIUS	40.0f
+
+struct BenchmarkScene
+{
+	std::vector<glm::vec3> BoundsMin;
+	std::vector<glm::vec3> BoundsMax;
+	std::vector<uint32_t> Leaves;
+	float Size;
+};
+
+static void generateScene(uint32_t objectCount, std::mt19937& generator, BenchmarkScene& scene)
+{
+	scene.Size = BVH_BENCHMARK_SPACING * std::cbrt(float(objectCount));
+
+	std::uniform_real_distribution<float> position(-0.5f * scene.Size, 0.5f * scene.Size);
+	std::uniform_real_distribution<float> halfSize(0.25f, 2.0f);
+
+	scene.BoundsMin.resize(objectCount);
+	scene.BoundsMax.resize(objectCount);
+	for (uint32_t i = 0; i < objectCount; i++)
+	{
+		const glm::vec3 center = glm::vec3(position(generator), position(generator), position(generator));
+		const glm::vec3 extent = glm::vec3(halfSize(generator), halfSize(generator), halfSize(generator));
+		scene.BoundsMin[i] = center - extent;
+		scene.BoundsMax[i] = center + extent;
+	}
+}
+
+template<typename Function>
+static double measure(Function function)
+{
+	auto startTime = std::chrono::high_resolution_clock::now();
+	function();
+	std::chrono::duration<double, std::milli> time = std::chrono::high_resolution_clock::now() - startTime;
+	return time.count();
+}
+
+static bool isSameSet(std::vector<uint32_t>& first, std::vector<uint32_t>& second)
+{
+	std::sort(first.begin(), first.end());
+	std::sort(second.begin(), second.end());
+	return first == second;
+}
+
+static void testSphereLinear(const BenchmarkScene& scene, const glm::vec3& center, float radius, std::vector<uint32_t>& objects)
+{
+	objects.clear();
+	for (uint32_t i = 0; i < uint32_t(scene.BoundsMin.size()); i++)
+	{
+		const glm::vec3 offset = glm::clamp(center, scene.BoundsMin[i], scene.BoundsMax[i]) - center;
+		if (glm::dot(offset, offset) <= radius * radius)
+		{
+			objects.push_back(i);
+		}
+	}
+}
+
+static void testRayLinear(const BenchmarkScene& scene, const glm::vec3& origin, const glm::vec3& direction, float maxDistance, std::vector<uint32_t>& objects)
+{
+	objects.clear();
+
+	const glm::vec3 inverseDirection = 1.0f / direction;
+	for (uint32_t i = 0; i < uint32_t(scene.BoundsMin.size()); i++)
+	{
+		const glm::vec3 t0 = (scene.BoundsMin[i] - origin) * inverseDirection;
+		const glm::vec3 t1 = (scene.BoundsMax[i] - origin) * inverseDirection;
+		const glm::vec3 tNear	= glm::min(t0, t1);
+		const glm::vec3 tFar	= glm::max(t0, t1);
+
+		const float enter	= std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+		const float exit	= std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+		if (enter <= exit)
+		{
+			objects.push_back(i);
+		}
+	}
+}
+
+static void runScene(uint32_t objectCount)
+{
+	std::mt19937 generator(objectCount);
+
+	BenchmarkScene scene;
+	generateScene(objectCount, generator, scene);
+
+	DynamicBVH tree;
+	scene.Leaves.resize(objectCount);
+	const double buildTime = measure([&]
+		{
+			for (uint32_t i = 0; i < objectCount; i++)
+			{
+				scene.Leaves[i] = tree.insert(i, scene.BoundsMin[i], scene.BoundsMax[i]);
+			}
+		});
+
+	const float buildAreaRatio = tree.getAreaRatio();
+	const double rebuildTime = measure([&] { tree.rebuild(); });
+	const float rebuildAreaRatio = tree.getAreaRatio();
+
+	//The linear culler gets the same boxes, with spheres that never cull anything before the boxes do
+	ObjectCuller objectCuller;
+	for (uint32_t i = 0; i < objectCount; i++)
+	{
+		const glm::vec3 halfSize = (scene.BoundsMax[i] - scene.BoundsMin[i]) * 0.5f;
+		objectCuller.addObject(scene.BoundsMin[i], scene.BoundsMax[i], glm::length(halfSize), glm::mat4(1.0f));
+	}
+
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::uniform_int_distribution<uint32_t> objectIndex(0, objectCount - 1);
+	const uint32_t movingCount = std::max(1U, uint32_t(float(objectCount) * BVH_BENCHMARK_MOVING_PART));
+
+	std::vector<uint32_t> linearObjects;
+	std::vector<uint32_t> treeObjects;
+	linearObjects.reserve(objectCount);
+	treeObjects.reserve(objectCount);
+
+	double moveTime				= 0.0;
+	double linearFrustumTime	= 0.0;
+	double treeFrustumTime		= 0.0;
+	double linearSphereTime		= 0.0;
+	double treeSphereTime		= 0.0;
+	double linearRayTime		= 0.0;
+	double treeRayTime			= 0.0;
+	uint64_t reinsertedCount	= 0;
+	uint64_t visibleCount		= 0;
+	uint32_t mismatchCount		= 0;
+
+	const glm::mat4 projection = glm::perspective(glm::radians(BVH_BENCHMARK_FIELD_OF_VIEW), 16.0f / 9.0f, 0.01f, BVH_BENCHMARK_FAR_PLANE);
+	for (uint32_t frame = 0; frame < BVH_BENCHMARK_FRAMES; frame++)
+	{
+		//Objects drift a bit every frame, most of them stay inside of their fat boxes
+		moveTime += measure([&]
+			{
+				for (uint32_t m = 0; m < movingCount; m++)
+				{
+					const uint32_t i = objectIndex(generator);
+					const glm::vec3 offset = glm::vec3(unit(generator), unit(generator), unit(generator)) * BVH_BENCHMARK_MOVE_STEP * (scene.BoundsMax[i].x - scene.BoundsMin[i].x);
+					scene.BoundsMin[i] += offset;
+					scene.BoundsMax[i] += offset;
+					reinsertedCount += tree.move(scene.Leaves[i], scene.BoundsMin[i], scene.BoundsMax[i]) ? 1 : 0;
+				}
+			});
+
+		for (uint32_t i = 0; i < objectCount; i++)
+		{
+			const glm::vec3 halfSize = (scene.BoundsMax[i] - scene.BoundsMin[i]) * 0.5f;
+			objectCuller.updateObject(i, scene.BoundsMin[i], scene.BoundsMax[i], glm::length(halfSize), glm::mat4(1.0f));
+		}
+
+		const glm::vec3 eye			= glm::vec3(unit(generator), unit(generator), unit(generator)) * 0.5f * scene.Size;
+		const glm::vec3 direction	= glm::normalize(glm::vec3(unit(generator), unit(generator), unit(generator)));
+		const Frustum frustum		= Frustum(projection * glm::lookAt(eye, eye + direction, glm::vec3(0.0f, 1.0f, 0.0f)));
+
+		linearFrustumTime	+= measure([&] { objectCuller.cull(frustum, linearObjects); });
+		treeFrustumTime		+= measure([&] { tree.queryFrustum(frustum, treeObjects); });
+		visibleCount		+= treeObjects.size();
+		mismatchCount		+= isSameSet(linearObjects, treeObjects) ? 0 : 1;
+
+		linearSphereTime	+= measure([&] { testSphereLinear(scene, eye, BVH_BENCHMARK_LIGHT_RADIUS, linearObjects); });
+		treeSphereTime		+= measure([&] { tree.querySphere(eye, BVH_BENCHMARK_LIGHT_RADIUS, treeObjects); });
+		mismatchCount		+= isSameSet(linearObjects, treeObjects) ? 0 : 1;
+
+		linearRayTime		+= measure([&] { testRayLinear(scene, eye, direction, BVH_BENCHMARK_FAR_PLANE, linearObjects); });
+		treeRayTime			+= measure([&] { tree.queryRay(eye, direction, BVH_BENCHMARK_FAR_PLANE, treeObjects); });
+		mismatchCount		+= isSameSet(linearObjects, treeObjects) ? 0 : 1;
+	}
+
+	const double frameCount = double(BVH_BENCHMARK_FRAMES);
+	LOG("%-8u | %-10.3f | %-10.3f | %-10.4f | %-10.1f | %-10.1f | %-8.4f | %-8.4f | %-8.4f | %-8.4f | %-8.4f | %-8.4f | %-6u | %.1f, %.1f, %.1f", objectCount, buildTime, rebuildTime,
+		moveTime / frameCount, double(reinsertedCount) / frameCount, double(visibleCount) / frameCount,
+		linearFrustumTime / frameCount, treeFrustumTime / frameCount, linearSphereTime / frameCount, treeSphereTime / frameCount, linearRayTime / frameCount, treeRayTime / frameCount,
+		tree.getHeight(), buildAreaRatio, rebuildAreaRatio, tree.getAreaRatio());
+
+	if (mismatchCount > 0 || !tree.validate())
+	{
+		LOG("%-8u | %u queries of the tree differ from testing every object, or the tree is broken", objectCount, mismatchCount);
+	}
+}
+
+void DynamicBVHBenchmark::run()
+{
+	LOG("DynamicBVHBenchmark: average of %u frames, %.0f%% of the objects move every frame, all times in ms", BVH_BENCHMARK_FRAMES, BVH_BENCHMARK_MOVING_PART * 100.0f);
+	LOG("%-8s | %-10s | %-10s | %-10s | %-10s | %-10s | %-8s | %-8s | %-8s | %-8s | %-8s | %-8s | %-6s | %s", "Objects", "Build", "Rebuild", "Move", "Reinserted", "Visible",
+		"Frustum", "BVH", "Sphere", "BVH", "Ray", "BVH", "Height", "Area ratio built, rebuilt, last frame");
+
+	const uint32_t objectCounts[] = { 1000, 10000, 100000 };
+	for (uint32_t objectCount : objectCounts)
+	{
+		runScene(objectCount);
+	}
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include "Core.h"
+
+//Measures DynamicBVH on generated scenes of 1k, 10k and 100k boxes: building the tree, moving a part of the objects every frame and frustum, sphere and ray queries.
+//The queries are compared against testing every object, the frustum against the SIMD ObjectCuller, and the results of both are checked to be the same
+class DynamicBVHBenchmark
+{
+public:
+	DECL_STATIC_CLASS(DynamicBVHBenchmark);
+
+	static void run();
+};
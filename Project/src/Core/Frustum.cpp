@@ -0,0 +1,46 @@
+#include "Frustum.h"
+
+Frustum::Frustum(const glm::mat4& viewProjection)
+{
+	//glm matrices are column major, so the rows are gathered from the columns
+	const glm::vec4 row0 = glm::vec4(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+	const glm::vec4 row1 = glm::vec4(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+	const glm::vec4 row2 = glm::vec4(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+	const glm::vec4 row3 = glm::vec4(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+	m_Planes[0] = row3 + row0;
+	m_Planes[1] = row3 - row0;
+	m_Planes[2] = row3 + row1;
+	m_Planes[3] = row3 - row1;
+	m_Planes[4] = row3 + row2;
+	m_Planes[5] = row3 - row2;
+
+	normalizePlanes();
+}
+
+Frustum Frustum::transformed(const glm::mat4& transform) const
+{
+	//A point x in the other space is transform * x in the space of the frustum, so the plane becomes transpose(transform) * plane
+	const glm::mat4 transposed = glm::transpose(transform);
+
+	Frustum frustum;
+	for (uint32_t p = 0; p < 6; p++)
+	{
+		frustum.m_Planes[p] = transposed * m_Planes[p];
+	}
+
+	frustum.normalizePlanes();
+	return frustum;
+}
+
+void Frustum::normalizePlanes()
+{
+	for (uint32_t p = 0; p < 6; p++)
+	{
+		const float length = glm::length(glm::vec3(m_Planes[p]));
+		if (length > 0.0f)
+		{
+			m_Planes[p] /= length;
+		}
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "Core.h"
+
+//The six planes of a view volume, the normals point inwards
+class Frustum
+{
+public:
+	//A frustum without planes, which contains everything
+	Frustum()
+		: m_Planes()
+	{
+	}
+
+	//Extracts the planes of a view-projection matrix (Gribb and Hartmann). The near plane of a projection with a depth range of -1 to 1 is used,
+	//which only makes the test more conservative for projections with a depth range of 0 to 1
+	explicit Frustum(const glm::mat4& viewProjection);
+
+	//Returns the frustum in the space that the transform maps to the space of this frustum, eg. object space for a world space frustum and a model matrix
+	Frustum transformed(const glm::mat4& transform) const;
+
+	//Returns false if the sphere is completely outside of the frustum
+	FORCEINLINE bool intersectsSphere(const glm::vec3& center, float radius) const
+	{
+		for (uint32_t p = 0; p < 6; p++)
+		{
+			if (glm::dot(glm::vec3(m_Planes[p]), center) + m_Planes[p].w < -radius)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	//The xyz of a plane is its normal and w its distance from the origin along the normal
+	FORCEINLINE const glm::vec4& getPlane(uint32_t index) const { return m_Planes[index]; }
+
+private:
+	void normalizePlanes();
+
+private:
+	glm::vec4 m_Planes[6];
+};
@@ -0,0 +1,56 @@
+#pragma once
+#include "Core.h"
+
+#include <cstring>
+
+#define HASH_SEED 0x9e3779b97f4a7c15ULL
+
+FORCEINLINE uint64_t rotateLeft(uint64_t value, uint32_t bits)
+{
+	return (value << bits) | (value >> (64 - bits));
+}
+
+//Finalizer from MurmurHash3, every input bit affects every output bit
+FORCEINLINE uint64_t finalizeHash(uint64_t hash)
+{
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53ULL;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+//MurmurHash3 style mixing of one 64-bit block into the hash
+FORCEINLINE uint64_t mixHash(uint64_t hash, uint64_t block)
+{
+	block *= 0x87c37b91114253d5ULL;
+	block = rotateLeft(block, 31);
+	block *= 0x4cf5ad432745937fULL;
+
+	hash ^= block;
+	return rotateLeft(hash, 27) * 5 + 0x52dce729;
+}
+
+inline uint64_t hashMemory(const void* pData, size_t sizeInBytes, uint64_t seed = HASH_SEED)
+{
+	const unsigned char* pBytes = reinterpret_cast<const unsigned char*>(pData);
+
+	uint64_t hash = seed;
+	size_t offset = 0;
+	for (; offset + sizeof(uint64_t) <= sizeInBytes; offset += sizeof(uint64_t))
+	{
+		uint64_t block;
+		memcpy(&block, pBytes + offset, sizeof(uint64_t));
+		hash = mixHash(hash, block);
+	}
+
+	if (offset < sizeInBytes)
+	{
+		uint64_t block = 0;
+		memcpy(&block, pBytes + offset, sizeInBytes - offset);
+		hash = mixHash(hash, block);
+	}
+
+	return finalizeHash(hash ^ uint64_t(sizeInBytes));
+}
@@ -0,0 +1,69 @@
+#include "Job.h"
+
+#include <mutex>
+
+std::vector<void*>			JobAllocator::s_Chunks;
+JobAllocator::FreeBlock*	JobAllocator::s_pFreeList = nullptr;
+Spinlock					JobAllocator::s_Lock;
+std::atomic<uint64_t>		JobAllocator::s_HeapAllocations(0);
+
+void* JobAllocator::allocate(size_t sizeInBytes)
+{
+	if (sizeInBytes > JOB_POOL_BLOCK_SIZE)
+	{
+		trackHeapAllocation();
+		return ::operator new(sizeInBytes);
+	}
+
+	std::scoped_lock<Spinlock> lock(s_Lock);
+	if (!s_pFreeList)
+	{
+		allocateChunk();
+	}
+
+	FreeBlock* pBlock = s_pFreeList;
+	s_pFreeList = pBlock->pNext;
+	return pBlock;
+}
+
+void JobAllocator::free(void* pMemory, size_t sizeInBytes)
+{
+	if (sizeInBytes > JOB_POOL_BLOCK_SIZE)
+	{
+		::operator delete(pMemory);
+		return;
+	}
+
+	std::scoped_lock<Spinlock> lock(s_Lock);
+	FreeBlock* pBlock = reinterpret_cast<FreeBlock*>(pMemory);
+	pBlock->pNext = s_pFreeList;
+	s_pFreeList = pBlock;
+}
+
+void JobAllocator::release()
+{
+	std::scoped_lock<Spinlock> lock(s_Lock);
+	for (void* pChunk : s_Chunks)
+	{
+		::operator delete(pChunk);
+	}
+
+	s_Chunks.clear();
+	s_pFreeList = nullptr;
+}
+
+void JobAllocator::allocateChunk()
+{
+	//Chunks are kept until release, the pool only grows to the peak number of pooled jobs in flight
+	trackHeapAllocation();
+
+	unsigned char* pChunk = reinterpret_cast<unsigned char*>(::operator new(JOB_POOL_BLOCK_SIZE * JOB_POOL_BLOCKS_PER_CHUNK));
+	s_Chunks.push_back(pChunk);
+
+	for (uint32_t i = 0; i < JOB_POOL_BLOCKS_PER_CHUNK; i++)
+	{
+		FreeBlock* pBlock = reinterpret_cast<FreeBlock*>(pChunk + i * JOB_POOL_BLOCK_SIZE);
+		pBlock->pNext = s_pFreeList;
+		s_pFreeList = pBlock;
+	}
+}
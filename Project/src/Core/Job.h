@@ -0,0 +1,203 @@
+#pragma once
+#include "Spinlock.h"
+
+#include <new>
+#include <atomic>
+#include <vector>
+#include <utility>
+#include <type_traits>
+
+#define JOB_INLINE_SIZE			64U
+#define JOB_INLINE_ALIGNMENT	16U
+//Callables that do not fit inline are placed in pooled blocks of this size, anything larger goes to the heap
+#define JOB_POOL_BLOCK_SIZE		256U
+#define JOB_POOL_BLOCKS_PER_CHUNK	64U
+
+//Fixed-size block pool for callables that are too large to be stored inline in a Job
+class JobAllocator
+{
+public:
+	DECL_STATIC_CLASS(JobAllocator);
+
+	static void* allocate(size_t sizeInBytes);
+	static void free(void* pMemory, size_t sizeInBytes);
+	//Returns all chunks to the heap, no pooled job may be alive when this is called
+	static void release();
+
+	//Called by everything in the job system that has to go to the global heap
+	static FORCEINLINE void trackHeapAllocation()
+	{
+		s_HeapAllocations.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	//Total number of global heap allocations made by the job system, in steady state this should stop increasing
+	static FORCEINLINE uint64_t getHeapAllocationCount()
+	{
+		return s_HeapAllocations.load(std::memory_order_relaxed);
+	}
+
+private:
+	static void allocateChunk();
+
+private:
+	struct FreeBlock
+	{
+		FreeBlock* pNext;
+	};
+
+	static std::vector<void*> s_Chunks;
+	static FreeBlock* s_pFreeList;
+	static Spinlock s_Lock;
+	static std::atomic<uint64_t> s_HeapAllocations;
+};
+
+//Move-only replacement for std::function<void()>. Captures up to JOB_INLINE_SIZE bytes are stored inside the job itself
+class Job
+{
+	struct Operations
+	{
+		void (*pInvoke)(void* pCallable);
+		//Moves the callable from pSrc into the uninitialized memory at pDst and destroys the source
+		void (*pRelocate)(void* pDst, void* pSrc);
+		void (*pDestroy)(void* pCallable);
+		size_t Size;
+	};
+
+	template<typename Callable>
+	struct OperationsFor
+	{
+		static void invoke(void* pCallable)
+		{
+			(*reinterpret_cast<Callable*>(pCallable))();
+		}
+
+		static void relocate(void* pDst, void* pSrc)
+		{
+			Callable* pSrcCallable = reinterpret_cast<Callable*>(pSrc);
+			new (pDst) Callable(std::move(*pSrcCallable));
+			pSrcCallable->~Callable();
+		}
+
+		static void destroy(void* pCallable)
+		{
+			reinterpret_cast<Callable*>(pCallable)->~Callable();
+		}
+
+		static constexpr Operations Table = { invoke, relocate, destroy, sizeof(Callable) };
+	};
+
+public:
+	Job()
+		: m_pCallable(nullptr),
+		m_pOperations(nullptr)
+	{
+	}
+
+	template<typename Func, typename = std::enable_if_t<!std::is_same_v<std::decay_t<Func>, Job>>>
+	Job(Func&& func)
+		: m_pCallable(nullptr),
+		m_pOperations(&OperationsFor<std::decay_t<Func>>::Table)
+	{
+		using Callable = std::decay_t<Func>;
+		if constexpr (fitsInline<Callable>())
+		{
+			m_pCallable = new (m_Storage) Callable(std::forward<Func>(func));
+		}
+		else
+		{
+			static_assert(alignof(Callable) <= JOB_INLINE_ALIGNMENT, "Pooled job blocks are only aligned to JOB_INLINE_ALIGNMENT");
+			m_pCallable = new (JobAllocator::allocate(sizeof(Callable))) Callable(std::forward<Func>(func));
+		}
+	}
+
+	Job(Job&& other) noexcept
+		: m_pCallable(nullptr),
+		m_pOperations(nullptr)
+	{
+		moveFrom(other);
+	}
+
+	Job& operator=(Job&& other) noexcept
+	{
+		if (this != &other)
+		{
+			reset();
+			moveFrom(other);
+		}
+
+		return *this;
+	}
+
+	~Job()
+	{
+		reset();
+	}
+
+	Job(const Job&) = delete;
+	Job& operator=(const Job&) = delete;
+
+	FORCEINLINE void operator()()
+	{
+		m_pOperations->pInvoke(m_pCallable);
+	}
+
+	FORCEINLINE explicit operator bool() const
+	{
+		return m_pCallable != nullptr;
+	}
+
+	void reset()
+	{
+		if (m_pCallable)
+		{
+			m_pOperations->pDestroy(m_pCallable);
+			if (!isInline())
+			{
+				JobAllocator::free(m_pCallable, m_pOperations->Size);
+			}
+
+			m_pCallable		= nullptr;
+			m_pOperations	= nullptr;
+		}
+	}
+
+	FORCEINLINE bool isInline() const
+	{
+		return m_pCallable == m_Storage;
+	}
+
+private:
+	template<typename Callable>
+	static constexpr bool fitsInline()
+	{
+		return sizeof(Callable) <= JOB_INLINE_SIZE && alignof(Callable) <= JOB_INLINE_ALIGNMENT && std::is_nothrow_move_constructible_v<Callable>;
+	}
+
+	void moveFrom(Job& other)
+	{
+		if (!other.m_pCallable)
+		{
+			return;
+		}
+
+		m_pOperations = other.m_pOperations;
+		if (other.isInline())
+		{
+			m_pOperations->pRelocate(m_Storage, other.m_Storage);
+			m_pCallable = m_Storage;
+		}
+		else
+		{
+			//Pooled callables just change owner
+			m_pCallable = other.m_pCallable;
+		}
+
+		other.m_pCallable	= nullptr;
+		other.m_pOperations	= nullptr;
+	}
+
+private:
+	alignas(JOB_INLINE_ALIGNMENT) unsigned char m_Storage[JOB_INLINE_SIZE];
+	void* m_pCallable;
+	const Operations* m_pOperations;
+};
@@ -0,0 +1,235 @@
+#include "LZ4.h"
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+#define LZ4_MIN_MATCH		4U
+#define LZ4_MAX_OFFSET		65535U
+//The last match has to start at least this many bytes before the end of the block
+#define LZ4_MATCH_LIMIT		12U
+//The last bytes of a block are always literals
+#define LZ4_LAST_LITERALS	5U
+#define LZ4_HASH_BITS		16U
+
+static uint32_t read32(const uint8_t* pData)
+{
+	uint32_t value = 0;
+	memcpy(&value, pData, sizeof(uint32_t));
+	return value;
+}
+
+static uint32_t hashSequence(uint32_t sequence)
+{
+	return (sequence * 2654435761U) >> (32U - LZ4_HASH_BITS);
+}
+
+//Writes the 255 bytes that continue a length field that did not fit in the 4 bits of the token
+static bool writeLength(uint64_t length, uint8_t*& pOut, const uint8_t* pOutEnd)
+{
+	for (; length >= 255; length -= 255)
+	{
+		if (pOut >= pOutEnd)
+		{
+			return false;
+		}
+
+		*pOut++ = 255;
+	}
+
+	if (pOut >= pOutEnd)
+	{
+		return false;
+	}
+
+	*pOut++ = uint8_t(length);
+	return true;
+}
+
+static bool readLength(uint64_t& length, const uint8_t*& pIn, const uint8_t* pInEnd)
+{
+	uint8_t value = 255;
+	while (value == 255)
+	{
+		if (pIn >= pInEnd)
+		{
+			return false;
+		}
+
+		value = *pIn++;
+		length += value;
+	}
+
+	return true;
+}
+
+//A match length of zero writes the literals of the last sequence
+static bool writeSequence(const uint8_t* pLiterals, uint64_t literalLength, uint32_t offset, uint64_t matchLength, uint8_t*& pOut, const uint8_t* pOutEnd)
+{
+	if (pOut >= pOutEnd)
+	{
+		return false;
+	}
+
+	uint8_t* pToken = pOut++;
+	*pToken = uint8_t(std::min<uint64_t>(literalLength, 15) << 4);
+	if (literalLength >= 15 && !writeLength(literalLength - 15, pOut, pOutEnd))
+	{
+		return false;
+	}
+
+	if (uint64_t(pOutEnd - pOut) < literalLength)
+	{
+		return false;
+	}
+
+	memcpy(pOut, pLiterals, size_t(literalLength));
+	pOut += literalLength;
+
+	if (matchLength == 0)
+	{
+		return true;
+	}
+
+	if (pOutEnd - pOut < 2)
+	{
+		return false;
+	}
+
+	*pOut++ = uint8_t(offset & 0xff);
+	*pOut++ = uint8_t(offset >> 8);
+
+	const uint64_t matchCode = matchLength - LZ4_MIN_MATCH;
+	*pToken |= uint8_t(std::min<uint64_t>(matchCode, 15));
+	return matchCode < 15 || writeLength(matchCode - 15, pOut, pOutEnd);
+}
+
+uint64_t LZ4::getCompressBound(uint64_t sourceSize)
+{
+	return sourceSize + sourceSize / 255 + 16;
+}
+
+uint64_t LZ4::compress(const void* pSource, uint64_t sourceSize, void* pDestination, uint64_t destinationCapacity)
+{
+	const uint8_t* pIn	= reinterpret_cast<const uint8_t*>(pSource);
+	uint8_t* pOut		= reinterpret_cast<uint8_t*>(pDestination);
+	uint8_t* pOutEnd	= pOut + destinationCapacity;
+
+	//Positions of the last sequence with each hash, offsets past the window are rejected when a match is tested
+	std::vector<uint32_t> table(size_t(1) << LZ4_HASH_BITS, UINT32_MAX);
+
+	uint64_t anchor = 0;
+	if (sourceSize > LZ4_MATCH_LIMIT)
+	{
+		const uint64_t matchStartLimit	= sourceSize - LZ4_MATCH_LIMIT;
+		const uint64_t matchEndLimit	= sourceSize - LZ4_LAST_LITERALS;
+
+		uint64_t position = 0;
+		while (position <= matchStartLimit)
+		{
+			const uint32_t sequence	= read32(pIn + position);
+			const uint32_t hash		= hashSequence(sequence);
+			const uint32_t candidate = table[hash];
+			table[hash] = uint32_t(position);
+
+			if (candidate == UINT32_MAX || position - candidate > LZ4_MAX_OFFSET || read32(pIn + candidate) != sequence)
+			{
+				position++;
+				continue;
+			}
+
+			uint64_t matchLength = LZ4_MIN_MATCH;
+			while (position + matchLength < matchEndLimit && pIn[candidate + matchLength] == pIn[position + matchLength])
+			{
+				matchLength++;
+			}
+
+			if (!writeSequence(pIn + anchor, position - anchor, uint32_t(position - candidate), matchLength, pOut, pOutEnd))
+			{
+				return 0;
+			}
+
+			position	+= matchLength;
+			anchor		= position;
+		}
+	}
+
+	if (!writeSequence(pIn + anchor, sourceSize - anchor, 0, 0, pOut, pOutEnd))
+	{
+		return 0;
+	}
+
+	return uint64_t(pOut - reinterpret_cast<uint8_t*>(pDestination));
+}
+
+bool LZ4::decompress(const void* pSource, uint64_t sourceSize, void* pDestination, uint64_t destinationSize)
+{
+	const uint8_t* pIn		= reinterpret_cast<const uint8_t*>(pSource);
+	const uint8_t* pInEnd	= pIn + sourceSize;
+	uint8_t* pOutStart		= reinterpret_cast<uint8_t*>(pDestination);
+	uint8_t* pOut			= pOutStart;
+	uint8_t* pOutEnd		= pOut + destinationSize;
+
+	while (pIn < pInEnd)
+	{
+		const uint8_t token = *pIn++;
+
+		uint64_t literalLength = token >> 4;
+		if (literalLength == 15 && !readLength(literalLength, pIn, pInEnd))
+		{
+			return false;
+		}
+
+		if (uint64_t(pInEnd - pIn) < literalLength || uint64_t(pOutEnd - pOut) < literalLength)
+		{
+			return false;
+		}
+
+		memcpy(pOut, pIn, size_t(literalLength));
+		pIn		+= literalLength;
+		pOut	+= literalLength;
+
+		//The last sequence only has literals
+		if (pIn == pInEnd)
+		{
+			break;
+		}
+
+		if (pInEnd - pIn < 2)
+		{
+			return false;
+		}
+
+		const uint64_t offset = uint64_t(pIn[0]) | (uint64_t(pIn[1]) << 8);
+		pIn += 2;
+
+		uint64_t matchLength = token & 15;
+		if (matchLength == 15 && !readLength(matchLength, pIn, pInEnd))
+		{
+			return false;
+		}
+		matchLength += LZ4_MIN_MATCH;
+
+		if (offset == 0 || offset > uint64_t(pOut - pOutStart) || uint64_t(pOutEnd - pOut) < matchLength)
+		{
+			return false;
+		}
+
+		//Matches can overlap the bytes they produce, which repeats the last offset bytes
+		const uint8_t* pMatch = pOut - offset;
+		if (offset >= matchLength)
+		{
+			memcpy(pOut, pMatch, size_t(matchLength));
+			pOut += matchLength;
+		}
+		else
+		{
+			for (uint64_t i = 0; i < matchLength; i++)
+			{
+				*pOut++ = *pMatch++;
+			}
+		}
+	}
+
+	return pOut == pOutEnd;
+}
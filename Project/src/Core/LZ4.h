@@ -0,0 +1,17 @@
+#pragma once
+#include "Core.h"
+
+//Compressor and decompressor for the LZ4 block format, used for the entries of the asset archive.
+//The compressor is a plain greedy matcher since it only runs when packing, the decompressor is what runs at load time
+class LZ4
+{
+public:
+	DECL_STATIC_CLASS(LZ4);
+
+	//Largest size that compress can produce for sourceSize bytes of input
+	static uint64_t getCompressBound(uint64_t sourceSize);
+	//Returns the compressed size, or 0 if the result does not fit in destinationCapacity
+	static uint64_t compress(const void* pSource, uint64_t sourceSize, void* pDestination, uint64_t destinationCapacity);
+	//Fails if the input is malformed or does not decompress to exactly destinationSize bytes
+	static bool decompress(const void* pSource, uint64_t sourceSize, void* pDestination, uint64_t destinationSize);
+};
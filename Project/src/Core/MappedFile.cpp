@@ -0,0 +1,148 @@
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <Windows.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+MappedFile::MappedFile()
+	: m_pData(nullptr),
+	m_SizeInBytes(0),
+#if defined(_WIN32)
+	m_pFileHandle(INVALID_HANDLE_VALUE),
+	m_pMappingHandle(nullptr)
+#else
+	m_FileDescriptor(-1)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const std::string& filepath)
+{
+	close();
+
+#if defined(_WIN32)
+	m_pFileHandle = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (m_pFileHandle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize = {};
+	if (!GetFileSizeEx(m_pFileHandle, &fileSize) || fileSize.QuadPart == 0)
+	{
+		close();
+		return false;
+	}
+
+	m_pMappingHandle = CreateFileMappingA(m_pFileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!m_pMappingHandle)
+	{
+		close();
+		return false;
+	}
+
+	m_pData = MapViewOfFile(m_pMappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (!m_pData)
+	{
+		close();
+		return false;
+	}
+
+	m_SizeInBytes = uint64_t(fileSize.QuadPart);
+#else
+	m_FileDescriptor = ::open(filepath.c_str(), O_RDONLY);
+	if (m_FileDescriptor < 0)
+	{
+		return false;
+	}
+
+	struct stat fileStatus = {};
+	if (fstat(m_FileDescriptor, &fileStatus) != 0 || fileStatus.st_size == 0)
+	{
+		close();
+		return false;
+	}
+
+	void* pData = mmap(nullptr, size_t(fileStatus.st_size), PROT_READ, MAP_PRIVATE, m_FileDescriptor, 0);
+	if (pData == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+
+	m_pData			= pData;
+	m_SizeInBytes	= uint64_t(fileStatus.st_size);
+#endif
+
+	return true;
+}
+
+void MappedFile::close()
+{
+#if defined(_WIN32)
+	if (m_pData)
+	{
+		UnmapViewOfFile(m_pData);
+	}
+
+	if (m_pMappingHandle)
+	{
+		CloseHandle(m_pMappingHandle);
+		m_pMappingHandle = nullptr;
+	}
+
+	if (m_pFileHandle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_pFileHandle);
+		m_pFileHandle = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (m_pData)
+	{
+		munmap(const_cast<void*>(m_pData), size_t(m_SizeInBytes));
+	}
+
+	if (m_FileDescriptor >= 0)
+	{
+		::close(m_FileDescriptor);
+		m_FileDescriptor = -1;
+	}
+#endif
+
+	m_pData			= nullptr;
+	m_SizeInBytes	= 0;
+}
+
+void MappedFile::prefetch(uint64_t offset, uint64_t sizeInBytes) const
+{
+	if (!m_pData || offset >= m_SizeInBytes)
+	{
+		return;
+	}
+
+	sizeInBytes = std::min(sizeInBytes, m_SizeInBytes - offset);
+
+#if defined(_WIN32)
+	WIN32_MEMORY_RANGE_ENTRY range = {};
+	range.VirtualAddress	= const_cast<uint8_t*>(reinterpret_cast<const uint8_t*>(m_pData) + offset);
+	range.NumberOfBytes		= size_t(sizeInBytes);
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+	//madvise needs a page aligned address
+	const uint64_t pageSize		= uint64_t(sysconf(_SC_PAGESIZE));
+	const uint64_t alignedOffset	= offset & ~(pageSize - 1);
+	madvise(const_cast<uint8_t*>(reinterpret_cast<const uint8_t*>(m_pData) + alignedOffset), size_t(sizeInBytes + offset - alignedOffset), MADV_WILLNEED);
+#endif
+}
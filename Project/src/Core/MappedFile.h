@@ -0,0 +1,34 @@
+#pragma once
+#include "Core.h"
+
+#include <string>
+
+//Read-only view of a whole file mapped into memory
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	DECL_NO_COPY(MappedFile);
+
+	//Fails for files that do not exist or are empty
+	bool open(const std::string& filepath);
+	void close();
+	//Asks the OS to start reading the range in the background, so that touching it later does not wait for the disk
+	void prefetch(uint64_t offset, uint64_t sizeInBytes) const;
+
+	FORCEINLINE const void*	getData() const			{ return m_pData; }
+	FORCEINLINE uint64_t	getSizeInBytes() const	{ return m_SizeInBytes; }
+	FORCEINLINE bool		isOpen() const			{ return m_pData != nullptr; }
+
+private:
+	const void* m_pData;
+	uint64_t m_SizeInBytes;
+#if defined(_WIN32)
+	void* m_pFileHandle;
+	void* m_pMappingHandle;
+#else
+	int m_FileDescriptor;
+#endif
+};
@@ -0,0 +1,659 @@
+#include "MeshCache.h"
+#include "Hash.h"
+#include "TaskDispatcher.h"
+#include "VertexWelder.h"
+#include "MeshOptimizer.h"
+#include "TangentGenerator.h"
+
+#include <map>
+#include <cctype>
+#include <chrono>
+#include <limits>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+
+//"VBMC" in little endian
+#define MESH_CACHE_MAGIC			0x434d4256U
+//Has to be increased whenever the file layout or the processing of the vertices changes
+#define MESH_CACHE_VERSION			7U
+#define MESH_CACHE_MAX_LIBRARY_NAME	256U
+#define MESH_CACHE_ALIGNMENT		16U
+
+struct MeshCacheHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint64_t SourceTimestamp;
+	uint64_t SourceSizeInBytes;
+	uint64_t SourceHash;
+	uint32_t VertexStride;
+	uint32_t ShapeStride;
+	uint32_t MeshletStride;
+	uint32_t IsMerged;
+	uint32_t IsOptimized;
+	uint32_t ShapeCount;
+	uint32_t VertexCount;
+	uint32_t IndexCount;
+	uint32_t MeshletCount;
+	uint64_t ShapesOffset;
+	uint64_t VerticesOffset;
+	uint64_t IndicesOffset;
+	uint64_t MeshletsOffset;
+	char MaterialLibrary[MESH_CACHE_MAX_LIBRARY_NAME];
+};
+
+//Reads the material libraries of archived OBJ files from the archive, libraries that are not archived are read from disk
+class ArchiveMaterialReader : public tinyobj::MaterialReader
+{
+public:
+	ArchiveMaterialReader(const std::string& directory)
+		: m_Directory(directory),
+		m_FileReader(directory)
+	{
+	}
+
+	virtual bool operator()(const std::string& materialLibrary, std::vector<tinyobj::material_t>* pMaterials, std::map<std::string, int>* pMaterialMap, std::string* pWarn, std::string* pErr) override
+	{
+		AssetView view;
+		if (!AssetArchive::read(m_Directory + materialLibrary, view))
+		{
+			return m_FileReader(materialLibrary, pMaterials, pMaterialMap, pWarn, pErr);
+		}
+
+		AssetStream stream(view);
+		tinyobj::LoadMtl(pMaterialMap, pMaterials, &stream, pWarn, pErr);
+		return true;
+	}
+
+private:
+	std::string m_Directory;
+	tinyobj::MaterialFileReader m_FileReader;
+};
+
+struct ShapeGeometry
+{
+	std::vector<Vertex> Vertices;
+	std::vector<uint32_t> Indices;
+	VertexCacheStatistics StatisticsBefore;
+	VertexCacheStatistics StatisticsAfter;
+	MeshLOD LODs[MESH_MAX_LOD_COUNT];
+	uint32_t LODCount;
+	std::vector<Meshlet> Meshlets;
+};
+
+static uint64_t alignOffset(uint64_t offset)
+{
+	return (offset + MESH_CACHE_ALIGNMENT - 1) & ~uint64_t(MESH_CACHE_ALIGNMENT - 1);
+}
+
+static std::string getDirectory(const std::string& filepath)
+{
+	const size_t separator = filepath.find_last_of("/\\");
+	return (separator == std::string::npos) ? std::string() : filepath.substr(0, separator + 1);
+}
+
+//Welds the vertices of all the shapes together, calculates their tangents, appends the detail levels to the indices and splits the full detail level into meshlets
+static void buildGeometry(const tinyobj::attrib_t& attributes, const tinyobj::shape_t* pShapes, uint32_t shapeCount, VertexWelder& welder, ShapeGeometry& geometry)
+{
+	std::vector<Vertex>& vertices = geometry.Vertices;
+	std::vector<uint32_t>& indices = geometry.Indices;
+
+	//There can not be more unique vertices than indices
+	size_t indexCount = 0;
+	for (uint32_t s = 0; s < shapeCount; s++)
+	{
+		indexCount += pShapes[s].mesh.indices.size();
+	}
+
+	welder.reset(uint32_t(indexCount));
+	indices.reserve(indexCount);
+
+	for (uint32_t s = 0; s < shapeCount; s++)
+	{
+		for (const tinyobj::index_t& index : pShapes[s].mesh.indices)
+		{
+			Vertex vertex = {};
+
+			//Normals and texcoords are optional, while positions are required
+			ASSERT(index.vertex_index >= 0);
+
+			vertex.Position =
+			{
+				attributes.vertices[3 * (size_t)index.vertex_index + 0],
+				attributes.vertices[3 * (size_t)index.vertex_index + 1],
+				attributes.vertices[3 * (size_t)index.vertex_index + 2]
+			};
+
+			if (index.normal_index >= 0)
+			{
+				vertex.Normal =
+				{
+					attributes.normals[3 * (size_t)index.normal_index + 0],
+					attributes.normals[3 * (size_t)index.normal_index + 1],
+					attributes.normals[3 * (size_t)index.normal_index + 2]
+				};
+			}
+
+			if (index.texcoord_index >= 0)
+			{
+				vertex.TexCoord =
+				{
+					attributes.texcoords[2 * (size_t)index.texcoord_index + 0],
+					1.0f - attributes.texcoords[2 * (size_t)index.texcoord_index + 1]
+				};
+			}
+
+			indices.push_back(welder.weld(vertex, vertices));
+		}
+	}
+
+	TangentGenerator::generate(vertices, indices);
+
+	if (MeshCache::isOptimizationEnabled())
+	{
+		MeshOptimizer::optimize(vertices, indices, geometry.StatisticsBefore, geometry.StatisticsAfter);
+	}
+	else
+	{
+		geometry.StatisticsBefore	= MeshOptimizer::analyzeVertexCache(indices, uint32_t(vertices.size()));
+		geometry.StatisticsAfter	= geometry.StatisticsBefore;
+	}
+
+	geometry.LODCount = MeshSimplifier::generateLODs(vertices, indices, geometry.LODs, MeshCache::isOptimizationEnabled());
+	MeshletBuilder::build(vertices, indices.data(), geometry.LODs[0].IndexCount, geometry.Meshlets);
+}
+
+bool MeshCache::s_IsOptimizationEnabled = true;
+
+MeshCache::MeshCache()
+	: m_File(),
+	m_MaterialLibrary(),
+	m_ImportedShapes(),
+	m_ImportedVertices(),
+	m_ImportedIndices(),
+	m_ImportedMeshlets(),
+	m_pShapes(nullptr),
+	m_pVertices(nullptr),
+	m_pIndices(nullptr),
+	m_pMeshlets(nullptr),
+	m_ShapeCount(0),
+	m_VertexCount(0),
+	m_IndexCount(0),
+	m_MeshletCount(0)
+{
+}
+
+bool MeshCache::load(const std::string& filepath, bool mergeShapes, std::vector<tinyobj::material_t>* pMaterials)
+{
+	release();
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	//Archived caches were built from the OBJ files that were packed with them, so they are used without looking at the source
+	SourceFileInfo source = {};
+	const bool isArchived		= loadArchivedCacheFile(filepath, mergeShapes);
+	const bool hasSourceFile	= !isArchived && SourceFile::getInfo(filepath, source);
+	if (!isArchived && !hasSourceFile && !AssetArchive::contains(filepath))
+	{
+		LOG("-- MeshCache: Failed to find '%s'", filepath.c_str());
+		return false;
+	}
+
+	if (isArchived || (hasSourceFile && loadCacheFile(filepath, mergeShapes, source)))
+	{
+		if (pMaterials && !loadMaterials(filepath, *pMaterials))
+		{
+			LOG("-- MeshCache: Failed to load material library '%s' of '%s'", m_MaterialLibrary.c_str(), filepath.c_str());
+		}
+
+		std::chrono::duration<double, std::milli> loadTime = std::chrono::high_resolution_clock::now() - startTime;
+		LOG("-- MeshCache: Loaded '%s' from %s in %.2f ms", filepath.c_str(), isArchived ? "archive" : "cache", loadTime.count());
+		return true;
+	}
+
+	std::vector<tinyobj::material_t> materials;
+	if (!importOBJ(filepath, mergeShapes, materials))
+	{
+		return false;
+	}
+
+	if (pMaterials)
+	{
+		pMaterials->swap(materials);
+	}
+
+	std::chrono::duration<double, std::milli> importTime = std::chrono::high_resolution_clock::now() - startTime;
+	LOG("-- MeshCache: Imported '%s' in %.2f ms", filepath.c_str(), importTime.count());
+	return true;
+}
+
+void MeshCache::release()
+{
+	m_File.close();
+	m_ArchivedFile.release();
+	m_MaterialLibrary.clear();
+
+	m_ImportedShapes.clear();
+	m_ImportedVertices.clear();
+	m_ImportedIndices.clear();
+	m_ImportedMeshlets.clear();
+
+	m_pShapes		= nullptr;
+	m_pVertices		= nullptr;
+	m_pIndices		= nullptr;
+	m_pMeshlets		= nullptr;
+	m_ShapeCount	= 0;
+	m_VertexCount	= 0;
+	m_IndexCount	= 0;
+	m_MeshletCount	= 0;
+}
+
+std::string MeshCache::getCacheFilepath(const std::string& filepath)
+{
+	return filepath + MESH_CACHE_EXTENSION;
+}
+
+//Returns the header if the file is a valid cache file with the same merging of shapes
+static const MeshCacheHeader* getValidHeader(const uint8_t* pData, uint64_t fileSize, bool mergeShapes)
+{
+	const MeshCacheHeader* pHeader = reinterpret_cast<const MeshCacheHeader*>(pData);
+	const bool isValid = fileSize >= sizeof(MeshCacheHeader) &&
+		pHeader->Magic			== MESH_CACHE_MAGIC &&
+		pHeader->Version		== MESH_CACHE_VERSION &&
+		pHeader->VertexStride	== sizeof(Vertex) &&
+		pHeader->ShapeStride	== sizeof(MeshCacheShape) &&
+		pHeader->MeshletStride	== sizeof(Meshlet) &&
+		pHeader->IsMerged		== uint32_t(mergeShapes) &&
+		pHeader->IsOptimized	== uint32_t(MeshCache::isOptimizationEnabled()) &&
+		pHeader->ShapesOffset	+ uint64_t(pHeader->ShapeCount)		* sizeof(MeshCacheShape)	<= fileSize &&
+		pHeader->VerticesOffset	+ uint64_t(pHeader->VertexCount)	* sizeof(Vertex)			<= fileSize &&
+		pHeader->IndicesOffset	+ uint64_t(pHeader->IndexCount)		* sizeof(uint32_t)			<= fileSize &&
+		pHeader->MeshletsOffset	+ uint64_t(pHeader->MeshletCount)	* sizeof(Meshlet)			<= fileSize;
+
+	return isValid ? pHeader : nullptr;
+}
+
+static bool writeSourceTimestamp(const std::string& cacheFilepath, uint64_t timestamp)
+{
+	std::fstream file(cacheFilepath, std::ios::in | std::ios::out | std::ios::binary);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	file.seekp(std::streamoff(offsetof(MeshCacheHeader, SourceTimestamp)));
+	file.write(reinterpret_cast<const char*>(&timestamp), std::streamsize(sizeof(timestamp)));
+	return file.good();
+}
+
+bool MeshCache::loadCacheFile(const std::string& filepath, bool mergeShapes, const SourceFileInfo& source)
+{
+	const std::string cacheFilepath = getCacheFilepath(filepath);
+	if (!m_File.open(cacheFilepath))
+	{
+		return false;
+	}
+
+	const uint8_t* pData = reinterpret_cast<const uint8_t*>(m_File.getData());
+	const MeshCacheHeader* pHeader = getValidHeader(pData, m_File.getSizeInBytes(), mergeShapes);
+	if (!pHeader)
+	{
+		LOG("-- MeshCache: '%s' is not a valid cache file, importing again", cacheFilepath.c_str());
+		m_File.close();
+		return false;
+	}
+
+	const SourceFileInfo cachedSource = { pHeader->SourceTimestamp, pHeader->SourceSizeInBytes };
+	if (!SourceFile::isUnchanged(filepath, source, cachedSource, pHeader->SourceHash))
+	{
+		LOG("-- MeshCache: '%s' is out of date", cacheFilepath.c_str());
+		m_File.close();
+		return false;
+	}
+
+	//The source was copied or checked out again without being modified, storing its new timestamp saves hashing it on every start.
+	//The file is not mapped while it is written to, since a mapped file can not be opened for writing on every platform
+	if (pHeader->SourceTimestamp != source.Timestamp)
+	{
+		m_File.close();
+		if (!writeSourceTimestamp(cacheFilepath, source.Timestamp))
+		{
+			LOG("-- MeshCache: Failed to update the source timestamp in '%s'", cacheFilepath.c_str());
+		}
+
+		if (!m_File.open(cacheFilepath))
+		{
+			return false;
+		}
+
+		pData	= reinterpret_cast<const uint8_t*>(m_File.getData());
+		pHeader	= getValidHeader(pData, m_File.getSizeInBytes(), mergeShapes);
+		if (!pHeader)
+		{
+			m_File.close();
+			return false;
+		}
+	}
+
+	setCacheData(pData, pHeader);
+	return true;
+}
+
+bool MeshCache::loadArchivedCacheFile(const std::string& filepath, bool mergeShapes)
+{
+	const std::string cacheFilepath = getCacheFilepath(filepath);
+	if (!AssetArchive::read(cacheFilepath, m_ArchivedFile))
+	{
+		return false;
+	}
+
+	const MeshCacheHeader* pHeader = getValidHeader(m_ArchivedFile.getData(), m_ArchivedFile.getSizeInBytes(), mergeShapes);
+	if (!pHeader)
+	{
+		LOG("-- MeshCache: '%s' in the archive is not a valid cache file", cacheFilepath.c_str());
+		m_ArchivedFile.release();
+		return false;
+	}
+
+	setCacheData(m_ArchivedFile.getData(), pHeader);
+	return true;
+}
+
+void MeshCache::setCacheData(const uint8_t* pFileData, const void* pCacheHeader)
+{
+	const MeshCacheHeader* pHeader = reinterpret_cast<const MeshCacheHeader*>(pCacheHeader);
+	m_MaterialLibrary.assign(pHeader->MaterialLibrary, strnlen(pHeader->MaterialLibrary, MESH_CACHE_MAX_LIBRARY_NAME));
+
+	m_pShapes		= reinterpret_cast<const MeshCacheShape*>(pFileData + pHeader->ShapesOffset);
+	m_pVertices		= reinterpret_cast<const Vertex*>(pFileData + pHeader->VerticesOffset);
+	m_pIndices		= reinterpret_cast<const uint32_t*>(pFileData + pHeader->IndicesOffset);
+	m_pMeshlets		= reinterpret_cast<const Meshlet*>(pFileData + pHeader->MeshletsOffset);
+	m_ShapeCount	= pHeader->ShapeCount;
+	m_VertexCount	= pHeader->VertexCount;
+	m_IndexCount	= pHeader->IndexCount;
+	m_MeshletCount	= pHeader->MeshletCount;
+}
+
+bool MeshCache::importOBJ(const std::string& filepath, bool mergeShapes, std::vector<tinyobj::material_t>& materials)
+{
+	tinyobj::attrib_t attributes;
+	std::vector<tinyobj::shape_t> shapes;
+	std::string warn, err;
+
+	const std::string directory = getDirectory(filepath);
+	bool isLoaded = false;
+
+	AssetView view;
+	if (AssetArchive::read(filepath, view))
+	{
+		AssetStream stream(view);
+		ArchiveMaterialReader materialReader(directory);
+		isLoaded = tinyobj::LoadObj(&attributes, &shapes, &materials, &warn, &err, &stream, &materialReader, true, false);
+	}
+	else
+	{
+		isLoaded = tinyobj::LoadObj(&attributes, &shapes, &materials, &warn, &err, filepath.c_str(), directory.c_str(), true, false);
+	}
+
+	if (!isLoaded)
+	{
+		LOG("-- MeshCache: Failed to load '%s'. Warning: %s Error: %s", filepath.c_str(), warn.c_str(), err.c_str());
+		return false;
+	}
+
+	if (shapes.empty())
+	{
+		LOG("-- MeshCache: '%s' does not contain any shapes", filepath.c_str());
+		return false;
+	}
+
+	//Every group is welded on its own and written to its own slot, so the result does not depend on the order the groups finish in
+	const uint32_t groupCount = mergeShapes ? 1 : uint32_t(shapes.size());
+	std::vector<ShapeGeometry> groups(groupCount);
+	TaskDispatcher::parallelForRange(0, groupCount, 0, [&](uint32_t begin, uint32_t end)
+		{
+			//One welder per chunk, its table is reused for every group in the chunk
+			VertexWelder welder;
+			for (uint32_t g = begin; g < end; g++)
+			{
+				if (mergeShapes)
+				{
+					buildGeometry(attributes, shapes.data(), uint32_t(shapes.size()), welder, groups[g]);
+				}
+				else
+				{
+					buildGeometry(attributes, &shapes[g], 1, welder, groups[g]);
+				}
+			}
+		});
+
+	size_t vertexCount	= 0;
+	size_t indexCount	= 0;
+	size_t meshletCount	= 0;
+	for (const ShapeGeometry& group : groups)
+	{
+		vertexCount		+= group.Vertices.size();
+		indexCount		+= group.Indices.size();
+		meshletCount	+= group.Meshlets.size();
+	}
+
+	m_ImportedShapes.resize(groupCount);
+	m_ImportedVertices.reserve(vertexCount);
+	m_ImportedIndices.reserve(indexCount);
+	m_ImportedMeshlets.reserve(meshletCount);
+
+	for (uint32_t g = 0; g < groupCount; g++)
+	{
+		const ShapeGeometry& group = groups[g];
+
+		MeshCacheShape& shape = m_ImportedShapes[g];
+		shape.FirstVertex	= uint32_t(m_ImportedVertices.size());
+		shape.VertexCount	= uint32_t(group.Vertices.size());
+		shape.FirstIndex	= uint32_t(m_ImportedIndices.size());
+		shape.IndexCount	= uint32_t(group.Indices.size());
+		shape.BoundsMin		= glm::vec3(std::numeric_limits<float>::max());
+		shape.BoundsMax		= glm::vec3(std::numeric_limits<float>::lowest());
+		shape.LODCount		= group.LODCount;
+		memcpy(shape.LODs, group.LODs, sizeof(shape.LODs));
+		shape.FirstMeshlet	= uint32_t(m_ImportedMeshlets.size());
+		shape.MeshletCount	= uint32_t(group.Meshlets.size());
+
+		const std::vector<int>& materialIDs = shapes[mergeShapes ? 0 : g].mesh.material_ids;
+		shape.MaterialID = materialIDs.empty() ? -1 : materialIDs[0];
+
+		for (const Vertex& vertex : group.Vertices)
+		{
+			shape.BoundsMin = glm::min(shape.BoundsMin, vertex.Position);
+			shape.BoundsMax = glm::max(shape.BoundsMax, vertex.Position);
+		}
+
+		const glm::vec3 center	= (shape.BoundsMin + shape.BoundsMax) * 0.5f;
+		float radiusSquared		= 0.0f;
+		for (const Vertex& vertex : group.Vertices)
+		{
+			const glm::vec3 offset = vertex.Position - center;
+			radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+		}
+
+		shape.BoundingRadius = std::sqrt(radiusSquared);
+
+		LOG("-- MeshCache: '%s' shape %u: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f", filepath.c_str(), g,
+			group.StatisticsBefore.ACMR, group.StatisticsAfter.ACMR, group.StatisticsBefore.ATVR, group.StatisticsAfter.ATVR);
+
+		for (uint32_t l = 1; l < group.LODCount; l++)
+		{
+			LOG("-- MeshCache: '%s' shape %u: LOD %u has %u of %u triangles, error %.4f", filepath.c_str(), g, l,
+				group.LODs[l].IndexCount / 3, group.LODs[0].IndexCount / 3, group.LODs[l].Error);
+		}
+
+		m_ImportedVertices.insert(m_ImportedVertices.end(), group.Vertices.begin(), group.Vertices.end());
+		m_ImportedIndices.insert(m_ImportedIndices.end(), group.Indices.begin(), group.Indices.end());
+		m_ImportedMeshlets.insert(m_ImportedMeshlets.end(), group.Meshlets.begin(), group.Meshlets.end());
+	}
+
+	m_pShapes		= m_ImportedShapes.data();
+	m_pVertices		= m_ImportedVertices.data();
+	m_pIndices		= m_ImportedIndices.data();
+	m_pMeshlets		= m_ImportedMeshlets.data();
+	m_ShapeCount	= uint32_t(m_ImportedShapes.size());
+	m_VertexCount	= uint32_t(m_ImportedVertices.size());
+	m_IndexCount	= uint32_t(m_ImportedIndices.size());
+	m_MeshletCount	= uint32_t(m_ImportedMeshlets.size());
+
+	//OBJ files that only exist in the archive are not cached, the archive should be packed after the caches have been built
+	SourceFileInfo source = {};
+	if (!SourceFile::getInfo(filepath, source))
+	{
+		return true;
+	}
+
+	//Not being able to write the cache only makes the next start slower
+	uint64_t sourceHash = 0;
+	if (!readSource(filepath, sourceHash, m_MaterialLibrary) || !writeCacheFile(filepath, mergeShapes, source, sourceHash, m_MaterialLibrary))
+	{
+		LOG("-- MeshCache: Failed to write cache file for '%s'", filepath.c_str());
+	}
+
+	return true;
+}
+
+bool MeshCache::writeCacheFile(const std::string& filepath, bool mergeShapes, const SourceFileInfo& source, uint64_t sourceHash, const std::string& materialLibrary) const
+{
+	if (materialLibrary.size() >= MESH_CACHE_MAX_LIBRARY_NAME)
+	{
+		return false;
+	}
+
+	MeshCacheHeader header = {};
+	header.Magic				= MESH_CACHE_MAGIC;
+	header.Version				= MESH_CACHE_VERSION;
+	header.SourceTimestamp		= source.Timestamp;
+	header.SourceSizeInBytes	= source.SizeInBytes;
+	header.SourceHash			= sourceHash;
+	header.VertexStride			= sizeof(Vertex);
+	header.ShapeStride			= sizeof(MeshCacheShape);
+	header.MeshletStride		= sizeof(Meshlet);
+	header.IsMerged				= uint32_t(mergeShapes);
+	header.IsOptimized			= uint32_t(s_IsOptimizationEnabled);
+	header.ShapeCount			= m_ShapeCount;
+	header.VertexCount			= m_VertexCount;
+	header.IndexCount			= m_IndexCount;
+	header.MeshletCount			= m_MeshletCount;
+	header.ShapesOffset			= alignOffset(sizeof(MeshCacheHeader));
+	header.VerticesOffset		= alignOffset(header.ShapesOffset + uint64_t(m_ShapeCount) * sizeof(MeshCacheShape));
+	header.IndicesOffset		= alignOffset(header.VerticesOffset + uint64_t(m_VertexCount) * sizeof(Vertex));
+	header.MeshletsOffset		= alignOffset(header.IndicesOffset + uint64_t(m_IndexCount) * sizeof(uint32_t));
+	memcpy(header.MaterialLibrary, materialLibrary.c_str(), materialLibrary.size());
+
+	//Write to a temporary file first so that a cache file is never seen half written
+	const std::string cacheFilepath		= getCacheFilepath(filepath);
+	const std::string temporaryFilepath	= cacheFilepath + ".tmp";
+	{
+		std::ofstream file(temporaryFilepath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		const char padding[MESH_CACHE_ALIGNMENT] = {};
+		auto writeAt = [&](uint64_t offset, const void* pData, uint64_t sizeInBytes)
+		{
+			file.write(padding, std::streamsize(offset - uint64_t(file.tellp())));
+			file.write(reinterpret_cast<const char*>(pData), std::streamsize(sizeInBytes));
+		};
+
+		writeAt(0,						&header,		sizeof(MeshCacheHeader));
+		writeAt(header.ShapesOffset,	m_pShapes,		uint64_t(m_ShapeCount) * sizeof(MeshCacheShape));
+		writeAt(header.VerticesOffset,	m_pVertices,	uint64_t(m_VertexCount) * sizeof(Vertex));
+		writeAt(header.IndicesOffset,	m_pIndices,		uint64_t(m_IndexCount) * sizeof(uint32_t));
+		writeAt(header.MeshletsOffset,	m_pMeshlets,	uint64_t(m_MeshletCount) * sizeof(Meshlet));
+
+		if (!file.good())
+		{
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporaryFilepath, cacheFilepath, error);
+	return !error;
+}
+
+bool MeshCache::loadMaterials(const std::string& filepath, std::vector<tinyobj::material_t>& materials) const
+{
+	materials.clear();
+	if (m_MaterialLibrary.empty())
+	{
+		return true;
+	}
+
+	//Same parser that LoadObj uses, so the material IDs in the cache still match
+	std::map<std::string, int> materialMap;
+	std::string warn, err;
+
+	const std::string materialFilepath = getDirectory(filepath) + m_MaterialLibrary;
+	AssetView view;
+	if (AssetArchive::read(materialFilepath, view))
+	{
+		AssetStream stream(view);
+		tinyobj::LoadMtl(&materialMap, &materials, &stream, &warn, &err);
+		return err.empty();
+	}
+
+	std::ifstream file(materialFilepath);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	tinyobj::LoadMtl(&materialMap, &materials, &file, &warn, &err);
+	return err.empty();
+}
+
+bool MeshCache::readSource(const std::string& filepath, uint64_t& hash, std::string& materialLibrary)
+{
+	MappedFile sourceFile;
+	if (!sourceFile.open(filepath))
+	{
+		return false;
+	}
+
+	const char* pText = reinterpret_cast<const char*>(sourceFile.getData());
+	const size_t sizeInBytes = size_t(sourceFile.getSizeInBytes());
+	hash = hashMemory(pText, sizeInBytes);
+
+	//The first mtllib statement is the one that LoadObj uses
+	const char* pKeyword = "mtllib";
+	const size_t keywordLength = strlen(pKeyword);
+	materialLibrary.clear();
+
+	for (size_t lineStart = 0; lineStart < sizeInBytes; )
+	{
+		const char* pLineEnd = reinterpret_cast<const char*>(memchr(pText + lineStart, '\n', sizeInBytes - lineStart));
+		const size_t lineEnd = pLineEnd ? size_t(pLineEnd - pText) : sizeInBytes;
+
+		if (lineEnd - lineStart > keywordLength && strncmp(pText + lineStart, pKeyword, keywordLength) == 0 && isspace((unsigned char)pText[lineStart + keywordLength]))
+		{
+			size_t nameStart	= lineStart + keywordLength;
+			size_t nameEnd		= lineEnd;
+			while (nameStart < nameEnd && isspace((unsigned char)pText[nameStart]))
+			{
+				nameStart++;
+			}
+
+			while (nameEnd > nameStart && isspace((unsigned char)pText[nameEnd - 1]))
+			{
+				nameEnd--;
+			}
+
+			materialLibrary.assign(pText + nameStart, nameEnd - nameStart);
+			break;
+		}
+
+		lineStart = lineEnd + 1;
+	}
+
+	return true;
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include "Core.h"
+#include "MappedFile.h"
+#include "SourceFile.h"
+#include "AssetArchive.h"
+#include "MeshSimplifier.h"
+#include "Meshlet.h"
+
+#include <string>
+#include <vector>
+#include <tinyobjloader/tiny_obj_loader.h>
+
+#define MESH_CACHE_EXTENSION ".vbmesh"
+
+//Range of one shape in the vertex and index arrays of a MeshCache, the indices are relative to FirstVertex.
+//IndexCount covers all detail levels of the shape, the ranges of the levels are relative to FirstIndex
+struct MeshCacheShape
+{
+	uint32_t FirstVertex;
+	uint32_t VertexCount;
+	uint32_t FirstIndex;
+	uint32_t IndexCount;
+	//Index into the materials of the OBJ, -1 if the shape does not have a material
+	int32_t MaterialID;
+	glm::vec3 BoundsMin;
+	glm::vec3 BoundsMax;
+	//Radius around the center of the bounds that contains every vertex
+	float BoundingRadius;
+	uint32_t LODCount;
+	MeshLOD LODs[MESH_MAX_LOD_COUNT];
+	//Meshlets of the full detail level, their index ranges are relative to FirstIndex as well
+	uint32_t FirstMeshlet;
+	uint32_t MeshletCount;
+};
+
+//Welded vertices with tangents and indices of an OBJ file, in the order MeshOptimizer puts them in, followed by the detail levels MeshSimplifier generates. The first load imports the OBJ and writes a binary cache file next to it,
+//later loads map the cache file and point straight into it for as long as the OBJ stays the same
+class MeshCache
+{
+public:
+	MeshCache();
+	~MeshCache() = default;
+
+	DECL_NO_COPY(MeshCache);
+
+	//With mergeShapes all shapes are welded into a single shape. pMaterials receives the materials of the OBJ if it is not null
+	bool load(const std::string& filepath, bool mergeShapes, std::vector<tinyobj::material_t>* pMaterials);
+	//Pointers returned by the getters are invalid after this
+	void release();
+
+	FORCEINLINE uint32_t				getShapeCount() const				{ return m_ShapeCount; }
+	FORCEINLINE const MeshCacheShape&	getShape(uint32_t shapeIndex) const	{ return m_pShapes[shapeIndex]; }
+	FORCEINLINE const Vertex*			getVertices() const					{ return m_pVertices; }
+	FORCEINLINE const uint32_t*			getIndices() const					{ return m_pIndices; }
+	FORCEINLINE const Meshlet*			getMeshlets() const					{ return m_pMeshlets; }
+	FORCEINLINE uint32_t				getVertexCount() const				{ return m_VertexCount; }
+	FORCEINLINE uint32_t				getIndexCount() const				{ return m_IndexCount; }
+	FORCEINLINE uint32_t				getMeshletCount() const				{ return m_MeshletCount; }
+	FORCEINLINE bool					isLoadedFromCache() const			{ return m_File.isOpen() || m_ArchivedFile.isValid(); }
+
+	static std::string getCacheFilepath(const std::string& filepath);
+
+	//Imported meshes are run through MeshOptimizer unless this is turned off, which is only meant for comparing the optimised and the original order.
+	//Caches remember whether they were optimised, so changing this imports the meshes again
+	FORCEINLINE static void setOptimizationEnabled(bool enabled)	{ s_IsOptimizationEnabled = enabled; }
+	FORCEINLINE static bool isOptimizationEnabled()					{ return s_IsOptimizationEnabled; }
+
+private:
+	bool loadCacheFile(const std::string& filepath, bool mergeShapes, const SourceFileInfo& source);
+	bool loadArchivedCacheFile(const std::string& filepath, bool mergeShapes);
+	void setCacheData(const uint8_t* pFileData, const void* pCacheHeader);
+	bool importOBJ(const std::string& filepath, bool mergeShapes, std::vector<tinyobj::material_t>& materials);
+	bool writeCacheFile(const std::string& filepath, bool mergeShapes, const SourceFileInfo& source, uint64_t sourceHash, const std::string& materialLibrary) const;
+	bool loadMaterials(const std::string& filepath, std::vector<tinyobj::material_t>& materials) const;
+
+	//Hashes the source file and finds the name of its material library
+	static bool readSource(const std::string& filepath, uint64_t& hash, std::string& materialLibrary);
+
+private:
+	MappedFile m_File;
+	AssetView m_ArchivedFile;
+	std::string m_MaterialLibrary;
+
+	//Only used when the OBJ had to be imported
+	std::vector<MeshCacheShape> m_ImportedShapes;
+	std::vector<Vertex> m_ImportedVertices;
+	std::vector<uint32_t> m_ImportedIndices;
+	std::vector<Meshlet> m_ImportedMeshlets;
+
+	const MeshCacheShape* m_pShapes;
+	const Vertex* m_pVertices;
+	const uint32_t* m_pIndices;
+	const Meshlet* m_pMeshlets;
+	uint32_t m_ShapeCount;
+	uint32_t m_VertexCount;
+	uint32_t m_IndexCount;
+	uint32_t m_MeshletCount;
+
+	static bool s_IsOptimizationEnabled;
+};
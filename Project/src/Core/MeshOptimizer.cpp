@@ -0,0 +1,397 @@
+#include "MeshOptimizer.h"
+
+#include <cmath>
+#include <cstring>
+
+//Scoring constants from Forsyth, "Linear-Speed Vertex Cache Optimisation"
+#define FORSYTH_CACHE_DECAY_POWER	1.5f
+#define FORSYTH_LAST_TRIANGLE_SCORE	0.75f
+#define FORSYTH_VALENCE_BOOST_SCALE	2.0f
+#define FORSYTH_VALENCE_BOOST_POWER	0.5f
+
+//Vertices that do not have any triangles left are never part of a candidate, so their score does not matter
+static float scoreVertex(int32_t cachePosition, uint32_t remainingTriangles)
+{
+	if (remainingTriangles == 0)
+	{
+		return -1.0f;
+	}
+
+	float score = 0.0f;
+	if (cachePosition >= 0)
+	{
+		//The vertices of the last triangle get a fixed score, so that the next triangle does not just reuse the same edge
+		if (cachePosition < 3)
+		{
+			score = FORSYTH_LAST_TRIANGLE_SCORE;
+		}
+		else
+		{
+			const float scale = 1.0f / float(MESH_OPTIMIZER_LRU_CACHE_SIZE - 3);
+			score = powf(1.0f - float(cachePosition - 3) * scale, FORSYTH_CACHE_DECAY_POWER);
+		}
+	}
+
+	//Vertices with few triangles left are finished first, so that they do not have to be transformed again later
+	return score + FORSYTH_VALENCE_BOOST_SCALE * powf(float(remainingTriangles), -FORSYTH_VALENCE_BOOST_POWER);
+}
+
+//Emulates a FIFO cache with timestamps, a vertex is in the cache if it was inserted less than the cache size insertions ago
+static uint32_t updateCache(const uint32_t* pTriangle, std::vector<uint32_t>& timestamps, uint32_t& timestamp)
+{
+	uint32_t misses = 0;
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		const uint32_t vertex = pTriangle[i];
+		if (timestamp - timestamps[vertex] > MESH_OPTIMIZER_FIFO_CACHE_SIZE)
+		{
+			timestamps[vertex] = timestamp++;
+			misses++;
+		}
+	}
+
+	return misses;
+}
+
+//Empties the emulated cache
+static void flushCache(uint32_t& timestamp)
+{
+	timestamp += MESH_OPTIMIZER_FIFO_CACHE_SIZE + 1;
+}
+
+void MeshOptimizer::optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, VertexCacheStatistics& before, VertexCacheStatistics& after)
+{
+	before = analyzeVertexCache(indices, uint32_t(vertices.size()));
+
+	optimizeVertexCache(indices, uint32_t(vertices.size()));
+	optimizeOverdraw(indices, vertices, MESH_OPTIMIZER_OVERDRAW_THRESHOLD);
+	optimizeVertexFetch(vertices, indices);
+
+	after = analyzeVertexCache(indices, uint32_t(vertices.size()));
+}
+
+void MeshOptimizer::optimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount)
+{
+	const uint32_t triangleCount = uint32_t(indices.size() / 3);
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	//The triangles that use each vertex, the triangles that are left are kept at the front of each list
+	std::vector<uint32_t> triangleOffsets(size_t(vertexCount) + 1, 0);
+	for (uint32_t index : indices)
+	{
+		triangleOffsets[size_t(index) + 1]++;
+	}
+
+	std::vector<uint32_t> remainingTriangles(vertexCount);
+	for (uint32_t v = 0; v < vertexCount; v++)
+	{
+		remainingTriangles[v]		= triangleOffsets[size_t(v) + 1];
+		triangleOffsets[size_t(v) + 1] += triangleOffsets[v];
+	}
+
+	std::vector<uint32_t> vertexTriangles(indices.size());
+	std::vector<uint32_t> fillOffsets(triangleOffsets.begin(), triangleOffsets.end() - 1);
+	for (uint32_t t = 0; t < triangleCount; t++)
+	{
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			vertexTriangles[fillOffsets[indices[size_t(t) * 3 + i]]++] = t;
+		}
+	}
+
+	std::vector<int32_t> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (uint32_t v = 0; v < vertexCount; v++)
+	{
+		vertexScores[v] = scoreVertex(-1, remainingTriangles[v]);
+	}
+
+	std::vector<float> triangleScores(triangleCount);
+	std::vector<uint8_t> isEmitted(triangleCount, 0);
+	for (uint32_t t = 0; t < triangleCount; t++)
+	{
+		const uint32_t* pTriangle = &indices[size_t(t) * 3];
+		triangleScores[t] = vertexScores[pTriangle[0]] + vertexScores[pTriangle[1]] + vertexScores[pTriangle[2]];
+	}
+
+	//The three extra entries hold the vertices that the last triangle pushed out of the cache
+	uint32_t cache[MESH_OPTIMIZER_LRU_CACHE_SIZE + 3];
+	uint32_t newCache[MESH_OPTIMIZER_LRU_CACHE_SIZE + 3];
+	uint32_t cacheSize = 0;
+
+	std::vector<uint32_t> optimizedIndices;
+	optimizedIndices.reserve(indices.size());
+
+	//Used when no triangle in the cache is left, the next triangle in the original order that has not been emitted is taken instead
+	uint32_t nextUnemitted	= 0;
+	uint32_t bestTriangle	= 0;
+	for (uint32_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+	{
+		if (bestTriangle == UINT32_MAX)
+		{
+			while (isEmitted[nextUnemitted])
+			{
+				nextUnemitted++;
+			}
+
+			bestTriangle = nextUnemitted;
+		}
+
+		const uint32_t* pTriangle = &indices[size_t(bestTriangle) * 3];
+		optimizedIndices.insert(optimizedIndices.end(), pTriangle, pTriangle + 3);
+		isEmitted[bestTriangle] = 1;
+
+		//Remove the triangle from the lists of its vertices
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			const uint32_t vertex = pTriangle[i];
+			uint32_t* pTriangles = &vertexTriangles[triangleOffsets[vertex]];
+			uint32_t* pLast = pTriangles + remainingTriangles[vertex] - 1;
+
+			while (*pTriangles != bestTriangle)
+			{
+				pTriangles++;
+			}
+
+			std::swap(*pTriangles, *pLast);
+			remainingTriangles[vertex]--;
+		}
+
+		//Move the vertices of the triangle to the front of the cache
+		uint32_t newCacheSize = 0;
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			newCache[newCacheSize++] = pTriangle[i];
+		}
+
+		for (uint32_t i = 0; i < cacheSize; i++)
+		{
+			const uint32_t vertex = cache[i];
+			if (vertex != pTriangle[0] && vertex != pTriangle[1] && vertex != pTriangle[2])
+			{
+				newCache[newCacheSize++] = vertex;
+			}
+		}
+
+		memcpy(cache, newCache, sizeof(uint32_t) * newCacheSize);
+		cacheSize = std::min(newCacheSize, MESH_OPTIMIZER_LRU_CACHE_SIZE);
+
+		//Rescore everything that moved in the cache, including the vertices that just fell out of it
+		for (uint32_t i = 0; i < newCacheSize; i++)
+		{
+			const uint32_t vertex = cache[i];
+			cachePositions[vertex] = (i < cacheSize) ? int32_t(i) : -1;
+
+			const float score = scoreVertex(cachePositions[vertex], remainingTriangles[vertex]);
+			const float scoreDelta = score - vertexScores[vertex];
+			vertexScores[vertex] = score;
+
+			const uint32_t* pTriangles = &vertexTriangles[triangleOffsets[vertex]];
+			for (uint32_t t = 0; t < remainingTriangles[vertex]; t++)
+			{
+				triangleScores[pTriangles[t]] += scoreDelta;
+			}
+		}
+
+		//The next triangle is the best one that uses a vertex in the cache
+		float bestScore = -1.0f;
+		bestTriangle = UINT32_MAX;
+		for (uint32_t i = 0; i < cacheSize; i++)
+		{
+			const uint32_t vertex = cache[i];
+			const uint32_t* pTriangles = &vertexTriangles[triangleOffsets[vertex]];
+			for (uint32_t t = 0; t < remainingTriangles[vertex]; t++)
+			{
+				if (triangleScores[pTriangles[t]] > bestScore)
+				{
+					bestScore		= triangleScores[pTriangles[t]];
+					bestTriangle	= pTriangles[t];
+				}
+			}
+		}
+	}
+
+	indices.swap(optimizedIndices);
+}
+
+void MeshOptimizer::optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float threshold)
+{
+	const uint32_t triangleCount = uint32_t(indices.size() / 3);
+	if (triangleCount < 2)
+	{
+		return;
+	}
+
+	std::vector<uint32_t> timestamps(vertices.size(), 0);
+	uint32_t timestamp = MESH_OPTIMIZER_FIFO_CACHE_SIZE + 1;
+
+	//Hard boundaries are where the cache optimised order already starts over with three new vertices
+	std::vector<uint32_t> hardBoundaries(1, 0);
+	updateCache(indices.data(), timestamps, timestamp);
+	for (uint32_t t = 1; t < triangleCount; t++)
+	{
+		if (updateCache(&indices[size_t(t) * 3], timestamps, timestamp) == 3)
+		{
+			hardBoundaries.push_back(t);
+		}
+	}
+	hardBoundaries.push_back(triangleCount);
+
+	//Hard clusters are split further as soon as a cluster has reached the ACMR of the whole hard cluster within the threshold.
+	//The cache is flushed at every split since the clusters are drawn in a different order later
+	std::vector<uint32_t> clusterStarts;
+	for (size_t c = 0; c + 1 < hardBoundaries.size(); c++)
+	{
+		const uint32_t start	= hardBoundaries[c];
+		const uint32_t end		= hardBoundaries[c + 1];
+
+		flushCache(timestamp);
+		uint32_t clusterMisses = 0;
+		for (uint32_t t = start; t < end; t++)
+		{
+			clusterMisses += updateCache(&indices[size_t(t) * 3], timestamps, timestamp);
+		}
+
+		const float clusterThreshold = threshold * float(clusterMisses) / float(end - start);
+		clusterStarts.push_back(start);
+
+		flushCache(timestamp);
+		uint32_t runningMisses		= 0;
+		uint32_t runningTriangles	= 0;
+		for (uint32_t t = start; t < end; t++)
+		{
+			runningMisses += updateCache(&indices[size_t(t) * 3], timestamps, timestamp);
+			runningTriangles++;
+
+			if (float(runningMisses) / float(runningTriangles) <= clusterThreshold && t + 1 < end)
+			{
+				clusterStarts.push_back(t + 1);
+				flushCache(timestamp);
+				runningMisses		= 0;
+				runningTriangles	= 0;
+			}
+		}
+	}
+	clusterStarts.push_back(triangleCount);
+
+	//Clusters that face away from the center of the mesh are likely to be in front of the rest of it, so they are drawn first
+	struct Cluster
+	{
+		uint32_t Start;
+		uint32_t End;
+		float SortKey;
+	};
+
+	const uint32_t clusterCount = uint32_t(clusterStarts.size() - 1);
+	std::vector<Cluster> clusters(clusterCount);
+	std::vector<glm::vec3> clusterCentroids(clusterCount);
+	std::vector<glm::vec3> clusterNormals(clusterCount);
+
+	glm::vec3 meshCentroid	= glm::vec3(0.0f);
+	float meshArea			= 0.0f;
+	for (uint32_t c = 0; c < clusterCount; c++)
+	{
+		glm::vec3 centroid	= glm::vec3(0.0f);
+		glm::vec3 normal	= glm::vec3(0.0f);
+		float area			= 0.0f;
+		for (uint32_t t = clusterStarts[c]; t < clusterStarts[size_t(c) + 1]; t++)
+		{
+			const glm::vec3& p0 = vertices[indices[size_t(t) * 3 + 0]].Position;
+			const glm::vec3& p1 = vertices[indices[size_t(t) * 3 + 1]].Position;
+			const glm::vec3& p2 = vertices[indices[size_t(t) * 3 + 2]].Position;
+
+			//The length of the cross product is twice the area, so the sum of them is an area weighted normal
+			const glm::vec3 triangleNormal	= glm::cross(p1 - p0, p2 - p0);
+			const float triangleArea		= glm::length(triangleNormal);
+
+			centroid	+= (p0 + p1 + p2) * (triangleArea / 3.0f);
+			normal		+= triangleNormal;
+			area		+= triangleArea;
+		}
+
+		meshCentroid	+= centroid;
+		meshArea		+= area;
+
+		clusters[c].Start		= clusterStarts[c];
+		clusters[c].End			= clusterStarts[size_t(c) + 1];
+		clusterCentroids[c]		= (area > 0.0f) ? centroid / area : centroid;
+		clusterNormals[c]		= normal;
+	}
+
+	if (meshArea > 0.0f)
+	{
+		meshCentroid /= meshArea;
+	}
+
+	for (uint32_t c = 0; c < clusterCount; c++)
+	{
+		const float normalLength = glm::length(clusterNormals[c]);
+		clusters[c].SortKey = (normalLength > 0.0f) ? glm::dot(clusterCentroids[c] - meshCentroid, clusterNormals[c] / normalLength) : 0.0f;
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.SortKey > b.SortKey; });
+
+	std::vector<uint32_t> sortedIndices;
+	sortedIndices.reserve(indices.size());
+	for (const Cluster& cluster : clusters)
+	{
+		sortedIndices.insert(sortedIndices.end(), indices.begin() + size_t(cluster.Start) * 3, indices.begin() + size_t(cluster.End) * 3);
+	}
+
+	indices.swap(sortedIndices);
+}
+
+void MeshOptimizer::optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+	std::vector<Vertex> fetchOrdered;
+	fetchOrdered.reserve(vertices.size());
+
+	for (uint32_t& index : indices)
+	{
+		if (remap[index] == UINT32_MAX)
+		{
+			remap[index] = uint32_t(fetchOrdered.size());
+			fetchOrdered.push_back(vertices[index]);
+		}
+
+		index = remap[index];
+	}
+
+	vertices.swap(fetchOrdered);
+}
+
+VertexCacheStatistics MeshOptimizer::analyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount)
+{
+	VertexCacheStatistics statistics = {};
+	const uint32_t triangleCount = uint32_t(indices.size() / 3);
+	if (triangleCount == 0)
+	{
+		return statistics;
+	}
+
+	std::vector<uint32_t> timestamps(vertexCount, 0);
+	uint32_t timestamp = MESH_OPTIMIZER_FIFO_CACHE_SIZE + 1;
+
+	uint32_t misses = 0;
+	for (uint32_t t = 0; t < triangleCount; t++)
+	{
+		misses += updateCache(&indices[size_t(t) * 3], timestamps, timestamp);
+	}
+
+	//Only the vertices that are used count towards the ATVR
+	uint32_t usedVertexCount = 0;
+	std::vector<uint8_t> isUsed(vertexCount, 0);
+	for (uint32_t index : indices)
+	{
+		usedVertexCount += 1U - isUsed[index];
+		isUsed[index] = 1;
+	}
+
+	statistics.ACMR = float(misses) / float(triangleCount);
+	statistics.ATVR = float(misses) / float(usedVertexCount);
+	return statistics;
+}
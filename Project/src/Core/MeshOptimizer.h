@@ -0,0 +1,41 @@
+#pragma once
+#include "Core.h"
+
+#include <vector>
+
+//Size of the FIFO post-transform cache that the statistics are measured with
+#define MESH_OPTIMIZER_FIFO_CACHE_SIZE		16U
+//Size of the LRU cache that the vertex cache ordering scores vertices with
+#define MESH_OPTIMIZER_LRU_CACHE_SIZE		32U
+//A cluster is allowed to have this much worse ACMR than the cache optimised order before it is split for the overdraw ordering
+#define MESH_OPTIMIZER_OVERDRAW_THRESHOLD	1.05f
+
+//How well an index buffer uses the post-transform cache
+struct VertexCacheStatistics
+{
+	//Average cache miss ratio, transformed vertices per triangle. 0.5 is the best possible for a large regular mesh, 3.0 the worst
+	float ACMR;
+	//Average transform to vertex ratio, transformed vertices per unique vertex. 1.0 is the best possible
+	float ATVR;
+};
+
+//Reorders the triangles and vertices of an indexed triangle list so that the GPU transforms, shades and fetches as little as possible.
+//The passes are meant to run in the order optimize runs them, each of them keeps the mesh the same apart from the order
+class MeshOptimizer
+{
+public:
+	DECL_STATIC_CLASS(MeshOptimizer);
+
+	//Runs all passes on the welded mesh, before and after receive the statistics of the original and the optimised index buffer
+	static void optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, VertexCacheStatistics& before, VertexCacheStatistics& after);
+
+	//Orders the triangles for the post-transform cache with Forsyth's linear-speed algorithm
+	static void optimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount);
+	//Splits the cache optimised triangles into clusters at the points where the cache is cold anyway and draws the outward facing clusters first,
+	//which lowers overdraw from most view directions while losing at most threshold in ACMR (Sander et al., "Fast triangle reordering")
+	static void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float threshold);
+	//Orders the vertices in the order the triangles first use them and remaps the indices. Vertices that no triangle uses are removed
+	static void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+	static VertexCacheStatistics analyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount);
+};
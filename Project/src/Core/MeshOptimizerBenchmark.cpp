@@ -0,0 +1,122 @@
+#include "MeshOptimizerBenchmark.h"
+#include "MeshOptimizer.h"
+#include "VertexWelder.h"
+
+#include <chrono>
+#include <vector>
+#include <tinyobjloader/tiny_obj_loader.h>
+
+#define OPTIMIZER_BENCHMARK_RUNS 3U
+
+struct BenchmarkMesh
+{
+	std::vector<Vertex> Vertices;
+	std::vector<uint32_t> Indices;
+};
+
+//Welds every shape of the OBJ into one mesh in the original triangle order, the same order MeshCache imported meshes in before MeshOptimizer
+static bool loadMesh(const char* pFilepath, BenchmarkMesh& mesh)
+{
+	tinyobj::attrib_t attributes;
+	std::vector<tinyobj::shape_t> shapes;
+	std::vector<tinyobj::material_t> materials;
+	std::string warn, err;
+
+	if (!tinyobj::LoadObj(&attributes, &shapes, &materials, &warn, &err, pFilepath, nullptr, true, false))
+	{
+		return false;
+	}
+
+	size_t indexCount = 0;
+	for (const tinyobj::shape_t& shape : shapes)
+	{
+		indexCount += shape.mesh.indices.size();
+	}
+
+	VertexWelder welder;
+	welder.reset(uint32_t(indexCount));
+	mesh.Indices.reserve(indexCount);
+
+	for (const tinyobj::shape_t& shape : shapes)
+	{
+		for (const tinyobj::index_t& index : shape.mesh.indices)
+		{
+			Vertex vertex = {};
+			vertex.Position = glm::vec3(attributes.vertices[3 * (size_t)index.vertex_index + 0], attributes.vertices[3 * (size_t)index.vertex_index + 1], attributes.vertices[3 * (size_t)index.vertex_index + 2]);
+
+			if (index.normal_index >= 0)
+			{
+				vertex.Normal = glm::vec3(attributes.normals[3 * (size_t)index.normal_index + 0], attributes.normals[3 * (size_t)index.normal_index + 1], attributes.normals[3 * (size_t)index.normal_index + 2]);
+			}
+
+			if (index.texcoord_index >= 0)
+			{
+				vertex.TexCoord = glm::vec2(attributes.texcoords[2 * (size_t)index.texcoord_index + 0], 1.0f - attributes.texcoords[2 * (size_t)index.texcoord_index + 1]);
+			}
+
+			mesh.Indices.push_back(welder.weld(vertex, mesh.Vertices));
+		}
+	}
+
+	return !mesh.Indices.empty();
+}
+
+//Returns the best time out of OPTIMIZER_BENCHMARK_RUNS in milliseconds, every run starts from a copy of source and the result of the last run is kept
+template<typename PassFunction>
+static double measure(const BenchmarkMesh& source, PassFunction pass, BenchmarkMesh& result)
+{
+	double bestTime = 0.0;
+	for (uint32_t run = 0; run < OPTIMIZER_BENCHMARK_RUNS; run++)
+	{
+		result = source;
+
+		auto startTime = std::chrono::high_resolution_clock::now();
+		pass(result);
+		std::chrono::duration<double, std::milli> time = std::chrono::high_resolution_clock::now() - startTime;
+
+		if (run == 0 || time.count() < bestTime)
+		{
+			bestTime = time.count();
+		}
+	}
+
+	return bestTime;
+}
+
+void MeshOptimizerBenchmark::run()
+{
+	const char* filepaths[] =
+	{
+		"assets/meshes/gun.obj",
+		"assets/meshes/sphere.obj",
+		"assets/sponza/sponza.obj",
+	};
+
+	LOG("MeshOptimizerBenchmark: FIFO cache of %u vertices, best of %u runs", MESH_OPTIMIZER_FIFO_CACHE_SIZE, OPTIMIZER_BENCHMARK_RUNS);
+	LOG("%-28s | %-10s | %-15s | %-15s | %-15s | %-10s | %-10s | %-10s", "File", "Triangles", "ACMR", "ACMR cache", "ATVR", "Cache ms", "Overdraw ms", "Fetch ms");
+
+	for (const char* pFilepath : filepaths)
+	{
+		BenchmarkMesh original;
+		if (!loadMesh(pFilepath, original))
+		{
+			LOG("%-28s | Failed to load, skipped", pFilepath);
+			continue;
+		}
+
+		BenchmarkMesh cacheOptimized;
+		BenchmarkMesh overdrawOptimized;
+		BenchmarkMesh fetchOptimized;
+		const double cacheTime		= measure(original,			[](BenchmarkMesh& mesh) { MeshOptimizer::optimizeVertexCache(mesh.Indices, uint32_t(mesh.Vertices.size())); }, cacheOptimized);
+		const double overdrawTime	= measure(cacheOptimized,	[](BenchmarkMesh& mesh) { MeshOptimizer::optimizeOverdraw(mesh.Indices, mesh.Vertices, MESH_OPTIMIZER_OVERDRAW_THRESHOLD); }, overdrawOptimized);
+		const double fetchTime		= measure(overdrawOptimized,	[](BenchmarkMesh& mesh) { MeshOptimizer::optimizeVertexFetch(mesh.Vertices, mesh.Indices); }, fetchOptimized);
+
+		//The overdraw ordering trades a little of the cache ordering for less overdraw, so both are reported
+		const VertexCacheStatistics before		= MeshOptimizer::analyzeVertexCache(original.Indices, uint32_t(original.Vertices.size()));
+		const VertexCacheStatistics cacheOnly	= MeshOptimizer::analyzeVertexCache(cacheOptimized.Indices, uint32_t(cacheOptimized.Vertices.size()));
+		const VertexCacheStatistics after		= MeshOptimizer::analyzeVertexCache(fetchOptimized.Indices, uint32_t(fetchOptimized.Vertices.size()));
+
+		LOG("%-28s | %-10u | %.3f -> %.3f  | %-15.3f | %.3f -> %.3f  | %-10.3f | %-10.3f | %-10.3f", pFilepath, uint32_t(original.Indices.size() / 3),
+			before.ACMR, after.ACMR, cacheOnly.ACMR, before.ATVR, after.ATVR, cacheTime, overdrawTime, fetchTime);
+	}
+}
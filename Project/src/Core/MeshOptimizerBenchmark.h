@@ -0,0 +1,13 @@
+#pragma once
+#include "Core.h"
+
+//Reports the post-transform cache statistics of the OBJ files in assets before and after MeshOptimizer, together with the time each pass takes.
+//The GPU side is measured by running the application test once normally and once with --no-mesh-optimization and comparing the geometry pass
+class MeshOptimizerBenchmark
+{
+public:
+	DECL_STATIC_CLASS(MeshOptimizerBenchmark);
+
+	//Files that can not be loaded are skipped
+	static void run();
+};
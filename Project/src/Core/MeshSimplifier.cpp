@@ -0,0 +1,370 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+
+#include <cmath>
+#include <numeric>
+#include <algorithm>
+
+//A collapse is rejected if it turns a triangle further than this, as the cosine of the angle between its normal before and after
+#define MESH_SIMPLIFIER_MAX_NORMAL_CHANGE	0.25
+
+//Sum of the squared distances to a set of planes, p^T A p + 2 b^T p + c, weighted by the area of the triangles the planes come from
+struct Quadric
+{
+	double A00, A01, A02, A11, A12, A22;
+	double B0, B1, B2;
+	double C;
+	double Weight;
+};
+
+struct Collapse
+{
+	uint32_t Vertex;
+	uint32_t Target;
+	double Cost;
+};
+
+static void addPlane(Quadric& quadric, const glm::dvec3& normal, double distance, double weight)
+{
+	quadric.A00		+= weight * normal.x * normal.x;
+	quadric.A01		+= weight * normal.x * normal.y;
+	quadric.A02		+= weight * normal.x * normal.z;
+	quadric.A11		+= weight * normal.y * normal.y;
+	quadric.A12		+= weight * normal.y * normal.z;
+	quadric.A22		+= weight * normal.z * normal.z;
+	quadric.B0		+= weight * normal.x * distance;
+	quadric.B1		+= weight * normal.y * distance;
+	quadric.B2		+= weight * normal.z * distance;
+	quadric.C		+= weight * distance * distance;
+	quadric.Weight	+= weight;
+}
+
+static void addQuadric(Quadric& quadric, const Quadric& other)
+{
+	quadric.A00		+= other.A00;
+	quadric.A01		+= other.A01;
+	quadric.A02		+= other.A02;
+	quadric.A11		+= other.A11;
+	quadric.A12		+= other.A12;
+	quadric.A22		+= other.A22;
+	quadric.B0		+= other.B0;
+	quadric.B1		+= other.B1;
+	quadric.B2		+= other.B2;
+	quadric.C		+= other.C;
+	quadric.Weight	+= other.Weight;
+}
+
+//Returns the mean squared distance from the position to the planes
+static double evaluateQuadric(const Quadric& quadric, const glm::dvec3& position)
+{
+	if (quadric.Weight <= 0.0)
+	{
+		return 0.0;
+	}
+
+	const double x = position.x;
+	const double y = position.y;
+	const double z = position.z;
+
+	const double error =
+		quadric.A00 * x * x + quadric.A11 * y * y + quadric.A22 * z * z +
+		2.0 * (quadric.A01 * x * y + quadric.A02 * x * z + quadric.A12 * y * z) +
+		2.0 * (quadric.B0 * x + quadric.B1 * y + quadric.B2 * z) +
+		quadric.C;
+
+	return std::max(error / quadric.Weight, 0.0);
+}
+
+uint32_t MeshSimplifier::generateLODs(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, MeshLOD* pLODs, bool optimizeVertexCache)
+{
+	pLODs[0].FirstIndex	= 0;
+	pLODs[0].IndexCount	= uint32_t(indices.size());
+	pLODs[0].Error		= 0.0f;
+
+	uint32_t lodCount = 1;
+	std::vector<uint32_t> lodIndices;
+	while (lodCount < MESH_MAX_LOD_COUNT)
+	{
+		const MeshLOD previous = pLODs[lodCount - 1];
+		const uint32_t targetIndexCount = uint32_t(float(previous.IndexCount / 3) * MESH_LOD_REDUCTION) * 3;
+
+		//Every level is simplified from the level before it, so its error is at most the sum of the errors on the way there
+		const float error = simplify(vertices, indices.data() + previous.FirstIndex, previous.IndexCount, targetIndexCount, MESH_LOD_MAX_ERROR - previous.Error, lodIndices);
+		if (lodIndices.empty() || float(lodIndices.size()) > float(previous.IndexCount) * (1.0f - MESH_LOD_MIN_REDUCTION))
+		{
+			break;
+		}
+
+		if (optimizeVertexCache)
+		{
+			MeshOptimizer::optimizeVertexCache(lodIndices, uint32_t(vertices.size()));
+		}
+
+		MeshLOD& lod = pLODs[lodCount++];
+		lod.FirstIndex	= uint32_t(indices.size());
+		lod.IndexCount	= uint32_t(lodIndices.size());
+		lod.Error		= previous.Error + error;
+
+		indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+	}
+
+	return lodCount;
+}
+
+float MeshSimplifier::simplify(const std::vector<Vertex>& vertices, const uint32_t* pIndices, uint32_t indexCount, uint32_t targetIndexCount, float maxError, std::vector<uint32_t>& result)
+{
+	result.assign(pIndices, pIndices + indexCount);
+
+	const uint32_t vertexCount = uint32_t(vertices.size());
+	if (indexCount <= targetIndexCount || vertexCount == 0 || maxError <= 0.0f)
+	{
+		return 0.0f;
+	}
+
+	//Vertices that only differ in their attributes share a position ID, positions with more than one vertex lie on a seam
+	std::vector<uint32_t> positionOrder(vertexCount);
+	std::iota(positionOrder.begin(), positionOrder.end(), 0);
+	std::sort(positionOrder.begin(), positionOrder.end(), [&vertices](uint32_t first, uint32_t second)
+		{
+			const glm::vec3& a = vertices[first].Position;
+			const glm::vec3& b = vertices[second].Position;
+			return (a.x != b.x) ? (a.x < b.x) : ((a.y != b.y) ? (a.y < b.y) : (a.z < b.z));
+		});
+
+	std::vector<uint32_t> positionIDs(vertexCount);
+	std::vector<uint8_t> isLocked;
+	for (uint32_t i = 0; i < vertexCount; i++)
+	{
+		const uint32_t vertex = positionOrder[i];
+		if (i > 0 && vertices[vertex].Position == vertices[positionOrder[i - 1]].Position)
+		{
+			positionIDs[vertex]		= positionIDs[positionOrder[i - 1]];
+			isLocked.back()			= 1;
+		}
+		else
+		{
+			positionIDs[vertex] = uint32_t(isLocked.size());
+			isLocked.push_back(0);
+		}
+	}
+
+	const uint32_t positionCount = uint32_t(isLocked.size());
+
+	glm::vec3 boundsMin = vertices[0].Position;
+	glm::vec3 boundsMax = vertices[0].Position;
+	for (const Vertex& vertex : vertices)
+	{
+		boundsMin = glm::min(boundsMin, vertex.Position);
+		boundsMax = glm::max(boundsMax, vertex.Position);
+	}
+
+	const double radius = 0.5 * double(glm::length(boundsMax - boundsMin));
+	if (radius <= 0.0)
+	{
+		return 0.0f;
+	}
+
+	//An edge that is only used in one direction lies on an open border
+	std::vector<uint64_t> edges;
+	edges.reserve(indexCount);
+	for (uint32_t i = 0; i < indexCount; i += 3)
+	{
+		for (uint32_t corner = 0; corner < 3; corner++)
+		{
+			const uint64_t from	= positionIDs[result[(size_t)i + corner]];
+			const uint64_t to	= positionIDs[result[(size_t)i + (corner + 1) % 3]];
+			edges.push_back((from << 32) | to);
+		}
+	}
+
+	std::sort(edges.begin(), edges.end());
+	for (uint64_t edge : edges)
+	{
+		const uint64_t reversed = (edge << 32) | (edge >> 32);
+		if (!std::binary_search(edges.begin(), edges.end(), reversed))
+		{
+			isLocked[uint32_t(edge >> 32)]			= 1;
+			isLocked[uint32_t(edge & 0xffffffff)]	= 1;
+		}
+	}
+
+	std::vector<Quadric> quadrics(positionCount, Quadric());
+	for (uint32_t i = 0; i < indexCount; i += 3)
+	{
+		const glm::dvec3 p0 = vertices[result[(size_t)i + 0]].Position;
+		const glm::dvec3 p1 = vertices[result[(size_t)i + 1]].Position;
+		const glm::dvec3 p2 = vertices[result[(size_t)i + 2]].Position;
+
+		glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+		const double doubleArea = glm::length(normal);
+		if (doubleArea <= 0.0)
+		{
+			continue;
+		}
+
+		normal /= doubleArea;
+		const double distance = -glm::dot(normal, p0);
+		for (uint32_t corner = 0; corner < 3; corner++)
+		{
+			addPlane(quadrics[positionIDs[result[(size_t)i + corner]]], normal, distance, 0.5 * doubleArea);
+		}
+	}
+
+	const double maxCost = double(maxError) * double(maxError) * radius * radius;
+	double resultCost = 0.0;
+
+	std::vector<uint32_t> triangleOffsets(vertexCount + 1);
+	std::vector<uint32_t> vertexTriangles;
+	std::vector<uint32_t> collapseTargets(vertexCount);
+	std::vector<uint8_t> isTouched(positionCount);
+	std::vector<Collapse> collapses;
+
+	//Every pass collapses the cheapest edges that do not share any triangles with each other, so that the costs and the flip tests of a pass stay valid
+	while (result.size() > targetIndexCount)
+	{
+		const uint32_t triangleCount = uint32_t(result.size() / 3);
+
+		std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+		for (uint32_t index : result)
+		{
+			triangleOffsets[(size_t)index + 1]++;
+		}
+
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			triangleOffsets[(size_t)v + 1] += triangleOffsets[v];
+		}
+
+		vertexTriangles.resize(result.size());
+		for (uint32_t i = 0; i < result.size(); i++)
+		{
+			vertexTriangles[triangleOffsets[result[i]]++] = i / 3;
+		}
+
+		//Filling moved every offset to the start of the next vertex
+		for (uint32_t v = vertexCount; v > 0; v--)
+		{
+			triangleOffsets[v] = triangleOffsets[(size_t)v - 1];
+		}
+		triangleOffsets[0] = 0;
+
+		//Interior edges are used by two triangles in opposite directions, so every half edge only has to be collapsed in its own direction
+		collapses.clear();
+		for (uint32_t i = 0; i < result.size(); i++)
+		{
+			const uint32_t vertex = result[i];
+			const uint32_t target = result[(size_t)(i - i % 3) + (i % 3 + 1) % 3];
+			if (isLocked[positionIDs[vertex]])
+			{
+				continue;
+			}
+
+			const double cost = evaluateQuadric(quadrics[positionIDs[vertex]], vertices[target].Position);
+			if (cost <= maxCost)
+			{
+				collapses.push_back({ vertex, target, cost });
+			}
+		}
+
+		if (collapses.empty())
+		{
+			break;
+		}
+
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& first, const Collapse& second) { return first.Cost < second.Cost; });
+
+		std::iota(collapseTargets.begin(), collapseTargets.end(), 0);
+		std::fill(isTouched.begin(), isTouched.end(), uint8_t(0));
+
+		uint32_t removedTriangles = 0;
+		for (const Collapse& collapse : collapses)
+		{
+			if ((triangleCount - removedTriangles) * 3 <= targetIndexCount)
+			{
+				break;
+			}
+
+			const uint32_t vertexPosition = positionIDs[collapse.Vertex];
+			const uint32_t targetPosition = positionIDs[collapse.Target];
+			if (isTouched[vertexPosition] || isTouched[targetPosition])
+			{
+				continue;
+			}
+
+			const glm::dvec3 from	= vertices[collapse.Vertex].Position;
+			const glm::dvec3 to		= vertices[collapse.Target].Position;
+
+			uint32_t collapsedTriangles = 0;
+			bool isValid = true;
+			for (uint32_t t = triangleOffsets[collapse.Vertex]; t < triangleOffsets[(size_t)collapse.Vertex + 1] && isValid; t++)
+			{
+				const uint32_t* pTriangle = &result[(size_t)vertexTriangles[t] * 3];
+				const uint32_t corner = (pTriangle[0] == collapse.Vertex) ? 0 : ((pTriangle[1] == collapse.Vertex) ? 1 : 2);
+				const uint32_t a = pTriangle[(corner + 1) % 3];
+				const uint32_t b = pTriangle[(corner + 2) % 3];
+
+				//The triangles on the edge disappear, they have to use the same target vertex or the attributes would change on one side of the edge
+				if (positionIDs[a] == targetPosition || positionIDs[b] == targetPosition)
+				{
+					isValid = (a == collapse.Target || b == collapse.Target);
+					collapsedTriangles++;
+					continue;
+				}
+
+				const glm::dvec3 positionA = vertices[a].Position;
+				const glm::dvec3 positionB = vertices[b].Position;
+				const glm::dvec3 normalBefore	= glm::cross(positionA - from, positionB - from);
+				const glm::dvec3 normalAfter	= glm::cross(positionA - to, positionB - to);
+				isValid = glm::dot(normalBefore, normalAfter) > MESH_SIMPLIFIER_MAX_NORMAL_CHANGE * glm::length(normalBefore) * glm::length(normalAfter);
+			}
+
+			//Edges that are not shared by exactly two triangles are non-manifold, collapsing them can tear the surface
+			if (!isValid || collapsedTriangles != 2)
+			{
+				continue;
+			}
+
+			collapseTargets[collapse.Vertex] = collapse.Target;
+			removedTriangles += collapsedTriangles;
+
+			isTouched[vertexPosition] = 1;
+			isTouched[targetPosition] = 1;
+			for (uint32_t t = triangleOffsets[collapse.Vertex]; t < triangleOffsets[(size_t)collapse.Vertex + 1]; t++)
+			{
+				const uint32_t* pTriangle = &result[(size_t)vertexTriangles[t] * 3];
+				isTouched[positionIDs[pTriangle[0]]] = 1;
+				isTouched[positionIDs[pTriangle[1]]] = 1;
+				isTouched[positionIDs[pTriangle[2]]] = 1;
+			}
+
+			addQuadric(quadrics[targetPosition], quadrics[vertexPosition]);
+			resultCost = std::max(resultCost, collapse.Cost);
+		}
+
+		if (removedTriangles == 0)
+		{
+			break;
+		}
+
+		//Remove the triangles that lost an edge
+		size_t writeIndex = 0;
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			const uint32_t i0 = collapseTargets[result[i + 0]];
+			const uint32_t i1 = collapseTargets[result[i + 1]];
+			const uint32_t i2 = collapseTargets[result[i + 2]];
+			if (positionIDs[i0] == positionIDs[i1] || positionIDs[i1] == positionIDs[i2] || positionIDs[i0] == positionIDs[i2])
+			{
+				continue;
+			}
+
+			result[writeIndex++] = i0;
+			result[writeIndex++] = i1;
+			result[writeIndex++] = i2;
+		}
+
+		result.resize(writeIndex);
+	}
+
+	return float(std::sqrt(resultCost) / radius);
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "Core.h"
+
+#include <vector>
+
+//Detail levels generated per mesh, including the full detail level
+#define MESH_MAX_LOD_COUNT			4U
+//Every level aims for this fraction of the triangles of the level before it
+#define MESH_LOD_REDUCTION			0.5f
+//A level is dropped if it could not remove more than this fraction of the triangles of the level before it
+#define MESH_LOD_MIN_REDUCTION		0.15f
+//Largest RMS error a level may have, relative to the radius of the mesh
+#define MESH_LOD_MAX_ERROR			0.05f
+
+//Range of one detail level in the index buffer of a mesh, all levels index the same vertices
+struct MeshLOD
+{
+	uint32_t FirstIndex;
+	uint32_t IndexCount;
+	//Root mean square distance of the collapsed vertices from the planes of the original triangles around them, relative to the radius of the mesh.
+	//The quadrics only hold the mean, so single points of the surface can move a few times further than this
+	float Error;
+};
+
+//Simplifies indexed triangle lists with edge collapses ordered by the quadric error metric (Garland and Heckbert, "Surface Simplification Using Quadric Error Metrics").
+//A vertex is only ever collapsed onto one of its neighbours, which keeps the vertex buffer the same so that every level can share it.
+//Vertices on open borders and on attribute seams are never removed, which keeps the outline and the texture mapping intact
+class MeshSimplifier
+{
+public:
+	DECL_STATIC_CLASS(MeshSimplifier);
+
+	//Appends the simplified levels to indices, which has to contain the full detail level. pLODs receives the ranges of all levels and has room for MESH_MAX_LOD_COUNT of them.
+	//Returns the number of levels, which is smaller than MESH_MAX_LOD_COUNT if the mesh could not be simplified further within MESH_LOD_MAX_ERROR.
+	//With optimizeVertexCache the simplified levels are ordered for the post-transform cache like the full detail level
+	static uint32_t generateLODs(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, MeshLOD* pLODs, bool optimizeVertexCache);
+
+	//Collapses edges until result has at most targetIndexCount indices or every collapse left would have a larger RMS error than maxError, relative to the radius of the mesh.
+	//Returns the largest RMS error of the collapses that were made
+	static float simplify(const std::vector<Vertex>& vertices, const uint32_t* pIndices, uint32_t indexCount, uint32_t targetIndexCount, float maxError, std::vector<uint32_t>& result);
+};
@@ -0,0 +1,117 @@
+#include "Meshlet.h"
+
+#include <cmath>
+#include <algorithm>
+
+static void finishMeshlet(const std::vector<Vertex>& vertices, const uint32_t* pIndices, Meshlet& meshlet)
+{
+	const uint32_t* pMeshletIndices = pIndices + meshlet.FirstIndex;
+
+	glm::vec3 boundsMin = vertices[pMeshletIndices[0]].Position;
+	glm::vec3 boundsMax = boundsMin;
+	for (uint32_t i = 1; i < meshlet.IndexCount; i++)
+	{
+		boundsMin = glm::min(boundsMin, vertices[pMeshletIndices[i]].Position);
+		boundsMax = glm::max(boundsMax, vertices[pMeshletIndices[i]].Position);
+	}
+
+	meshlet.Center = (boundsMin + boundsMax) * 0.5f;
+	meshlet.Radius = 0.0f;
+	for (uint32_t i = 0; i < meshlet.IndexCount; i++)
+	{
+		meshlet.Radius = std::max(meshlet.Radius, glm::length(vertices[pMeshletIndices[i]].Position - meshlet.Center));
+	}
+
+	//The normals are the ones the rasterizer culls with, so they come from the winding and not from the vertex normals
+	std::vector<glm::vec3> normals;
+	normals.reserve(meshlet.IndexCount / 3);
+
+	glm::vec3 axis(0.0f);
+	for (uint32_t i = 0; i < meshlet.IndexCount; i += 3)
+	{
+		const glm::vec3& p0 = vertices[pMeshletIndices[i + 0]].Position;
+		const glm::vec3& p1 = vertices[pMeshletIndices[i + 1]].Position;
+		const glm::vec3& p2 = vertices[pMeshletIndices[i + 2]].Position;
+
+		const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+		const float length = glm::length(normal);
+		if (length > 0.0f)
+		{
+			normals.push_back(normal / length);
+			axis += normals.back();
+		}
+	}
+
+	meshlet.ConeAxis	= glm::vec3(0.0f);
+	meshlet.ConeCutoff	= 1.0f;
+
+	const float axisLength = glm::length(axis);
+	if (normals.empty() || axisLength <= 0.0f)
+	{
+		return;
+	}
+
+	axis /= axisLength;
+
+	float minDot = 1.0f;
+	for (const glm::vec3& normal : normals)
+	{
+		minDot = std::min(minDot, glm::dot(normal, axis));
+	}
+
+	if (minDot > MESHLET_MIN_CONE_SPREAD)
+	{
+		meshlet.ConeAxis	= axis;
+		meshlet.ConeCutoff	= std::sqrt(1.0f - minDot * minDot);
+	}
+}
+
+void MeshletBuilder::build(const std::vector<Vertex>& vertices, const uint32_t* pIndices, uint32_t indexCount, std::vector<Meshlet>& meshlets)
+{
+	meshlets.clear();
+	if (indexCount == 0)
+	{
+		return;
+	}
+
+	//The meshlet that last used each vertex, so that the unique vertices of a meshlet can be counted without clearing anything
+	std::vector<uint32_t> vertexMeshlets(vertices.size(), UINT32_MAX);
+
+	Meshlet meshlet = {};
+	uint32_t vertexCount = 0;
+	for (uint32_t i = 0; i < indexCount; i += 3)
+	{
+		uint32_t newVertices = 0;
+		for (uint32_t corner = 0; corner < 3; corner++)
+		{
+			newVertices += (vertexMeshlets[pIndices[i + corner]] != uint32_t(meshlets.size())) ? 1 : 0;
+		}
+
+		//Corners that repeat a vertex are counted twice, which only ends the meshlet a triangle early
+		if (meshlet.IndexCount > 0 && (vertexCount + newVertices > MESHLET_MAX_VERTICES || meshlet.IndexCount / 3 >= MESHLET_MAX_TRIANGLES))
+		{
+			finishMeshlet(vertices, pIndices, meshlet);
+			meshlets.push_back(meshlet);
+
+			meshlet				= {};
+			meshlet.FirstIndex	= i;
+			vertexCount			= 0;
+		}
+
+		const uint32_t meshletIndex = uint32_t(meshlets.size());
+		for (uint32_t corner = 0; corner < 3; corner++)
+		{
+			uint32_t& vertexMeshlet = vertexMeshlets[pIndices[i + corner]];
+			if (vertexMeshlet != meshletIndex)
+			{
+				vertexMeshlet = meshletIndex;
+				vertexCount++;
+			}
+		}
+
+		meshlet.IndexCount += 3;
+	}
+
+	finishMeshlet(vertices, pIndices, meshlet);
+	meshlets.push_back(meshlet);
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "Core.h"
+
+#include <vector>
+
+//Limits of a meshlet, small enough that a cluster covers a small part of a large mesh and large enough that culling them stays cheap
+#define MESHLET_MAX_VERTICES	64U
+#define MESHLET_MAX_TRIANGLES	124U
+//Meshlets whose normals spread further than this, as the smallest cosine to the average normal, never count as back facing
+#define MESHLET_MIN_CONE_SPREAD	0.1f
+
+//A cluster of neighbouring triangles that is culled as a whole. The triangles are a range of the full detail level of the mesh
+struct Meshlet
+{
+	//Bounding sphere of the vertices
+	glm::vec3 Center;
+	float Radius;
+	//Cone that contains the normals of all triangles, ConeCutoff is the sine of its half angle. The axis is zero if the cone is too wide to ever cull the meshlet
+	glm::vec3 ConeAxis;
+	float ConeCutoff;
+	uint32_t FirstIndex;
+	uint32_t IndexCount;
+};
+
+//Splits indexed triangle lists into meshlets in the order of the triangles, so that every meshlet is a contiguous range of the index buffer.
+//The triangles are expected to be ordered for the vertex cache already, which keeps neighbouring triangles close to each other
+class MeshletBuilder
+{
+public:
+	DECL_STATIC_CLASS(MeshletBuilder);
+
+	static void build(const std::vector<Vertex>& vertices, const uint32_t* pIndices, uint32_t indexCount, std::vector<Meshlet>& meshlets);
+
+	//Returns true if every triangle of the meshlet faces away from a viewer at the position
+	FORCEINLINE static bool isBackFacing(const Meshlet& meshlet, const glm::vec3& viewerPosition)
+	{
+		const glm::vec3 toCenter = meshlet.Center - viewerPosition;
+		return glm::dot(toCenter, meshlet.ConeAxis) >= meshlet.ConeCutoff * glm::length(toCenter) + meshlet.Radius;
+	}
+
+	//Returns true if every triangle of the meshlet faces away from a viewer looking along the direction, eg. a directional light
+	FORCEINLINE static bool isBackFacingDirectional(const Meshlet& meshlet, const glm::vec3& viewDirection)
+	{
+		return glm::dot(viewDirection, meshlet.ConeAxis) >= meshlet.ConeCutoff;
+	}
+};
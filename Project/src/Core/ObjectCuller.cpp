@@ -0,0 +1,122 @@
+#include "ObjectCuller.h"
+
+ObjectCuller::ObjectCuller()
+	: m_CenterX(),
+	m_CenterY(),
+	m_CenterZ(),
+	m_Radius(),
+	m_ExtentX(),
+	m_ExtentY(),
+	m_ExtentZ(),
+	m_ObjectCount(0)
+{
+}
+
+uint32_t ObjectCuller::addObject(const glm::vec3& boundsMin, const glm::vec3& boundsMax, float boundingRadius, const glm::mat4& transform)
+{
+	const uint32_t index		= m_ObjectCount++;
+	const size_t paddedCount	= (size_t(m_ObjectCount) + 3) & ~size_t(3);
+
+	m_CenterX.resize(paddedCount, 0.0f);
+	m_CenterY.resize(paddedCount, 0.0f);
+	m_CenterZ.resize(paddedCount, 0.0f);
+	m_Radius.resize(paddedCount, 0.0f);
+	m_ExtentX.resize(paddedCount, 0.0f);
+	m_ExtentY.resize(paddedCount, 0.0f);
+	m_ExtentZ.resize(paddedCount, 0.0f);
+
+	updateObject(index, boundsMin, boundsMax, boundingRadius, transform);
+	return index;
+}
+
+void ObjectCuller::updateObject(uint32_t index, const glm::vec3& boundsMin, const glm::vec3& boundsMax, float boundingRadius, const glm::mat4& transform)
+{
+	const glm::vec3 center = glm::vec3(transform * glm::vec4((boundsMin + boundsMax) * 0.5f, 1.0f));
+	const glm::vec3 extent = (boundsMax - boundsMin) * 0.5f;
+
+	//Every world axis of the box gets the absolute sum of the axes of the transformed box along it (Arvo, "Transforming Axis-Aligned Bounding Boxes")
+	const glm::mat3 absTransform = glm::mat3(glm::abs(glm::vec3(transform[0])), glm::abs(glm::vec3(transform[1])), glm::abs(glm::vec3(transform[2])));
+	const glm::vec3 worldExtent = absTransform * extent;
+
+	//The sphere is scaled by the largest scale of the transform
+	const float scale = std::sqrt(std::max(glm::dot(transform[0], transform[0]), std::max(glm::dot(transform[1], transform[1]), glm::dot(transform[2], transform[2]))));
+
+	m_CenterX[index]	= center.x;
+	m_CenterY[index]	= center.y;
+	m_CenterZ[index]	= center.z;
+	m_Radius[index]		= boundingRadius * scale;
+	m_ExtentX[index]	= worldExtent.x;
+	m_ExtentY[index]	= worldExtent.y;
+	m_ExtentZ[index]	= worldExtent.z;
+}
+
+void ObjectCuller::cull(const Frustum& frustum, std::vector<uint32_t>& visibleObjects) const
+{
+	visibleObjects.clear();
+
+	uint32_t first = 0;
+
+#ifdef SSE_ENABLED
+	__m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+	__m128 absPlaneX[6], absPlaneY[6], absPlaneZ[6];
+	for (uint32_t p = 0; p < 6; p++)
+	{
+		const glm::vec4& plane = frustum.getPlane(p);
+		planeX[p]		= _mm_set1_ps(plane.x);
+		planeY[p]		= _mm_set1_ps(plane.y);
+		planeZ[p]		= _mm_set1_ps(plane.z);
+		planeW[p]		= _mm_set1_ps(plane.w);
+		absPlaneX[p]	= _mm_set1_ps(std::abs(plane.x));
+		absPlaneY[p]	= _mm_set1_ps(std::abs(plane.y));
+		absPlaneZ[p]	= _mm_set1_ps(std::abs(plane.z));
+	}
+
+	const __m128 zero = _mm_setzero_ps();
+	for (; first < m_ObjectCount; first += 4)
+	{
+		const __m128 centerX	= _mm_loadu_ps(m_CenterX.data() + first);
+		const __m128 centerY	= _mm_loadu_ps(m_CenterY.data() + first);
+		const __m128 centerZ	= _mm_loadu_ps(m_CenterZ.data() + first);
+		const __m128 radius		= _mm_loadu_ps(m_Radius.data() + first);
+		const __m128 extentX	= _mm_loadu_ps(m_ExtentX.data() + first);
+		const __m128 extentY	= _mm_loadu_ps(m_ExtentY.data() + first);
+		const __m128 extentZ	= _mm_loadu_ps(m_ExtentZ.data() + first);
+
+		__m128 isOutside = _mm_setzero_ps();
+		for (uint32_t p = 0; p < 6; p++)
+		{
+			const __m128 distance	= _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], centerX), _mm_mul_ps(planeY[p], centerY)), _mm_add_ps(_mm_mul_ps(planeZ[p], centerZ), planeW[p]));
+			const __m128 boxRadius	= _mm_add_ps(_mm_add_ps(_mm_mul_ps(absPlaneX[p], extentX), _mm_mul_ps(absPlaneY[p], extentY)), _mm_mul_ps(absPlaneZ[p], extentZ));
+			isOutside = _mm_or_ps(isOutside, _mm_cmplt_ps(_mm_add_ps(distance, _mm_min_ps(boxRadius, radius)), zero));
+		}
+
+		//The lanes past the last object are padding
+		const uint32_t laneCount	= std::min(4U, m_ObjectCount - first);
+		const uint32_t visibleMask	= ~uint32_t(_mm_movemask_ps(isOutside)) & ((1U << laneCount) - 1U);
+		for (uint32_t lane = 0; lane < laneCount; lane++)
+		{
+			if (visibleMask & (1U << lane))
+			{
+				visibleObjects.push_back(first + lane);
+			}
+		}
+	}
+#endif
+
+	for (; first < m_ObjectCount; first++)
+	{
+		bool isOutside = false;
+		for (uint32_t p = 0; p < 6 && !isOutside; p++)
+		{
+			const glm::vec4& plane	= frustum.getPlane(p);
+			const float distance	= plane.x * m_CenterX[first] + plane.y * m_CenterY[first] + plane.z * m_CenterZ[first] + plane.w;
+			const float boxRadius	= std::abs(plane.x) * m_ExtentX[first] + std::abs(plane.y) * m_ExtentY[first] + std::abs(plane.z) * m_ExtentZ[first];
+			isOutside = distance + std::min(boxRadius, m_Radius[first]) < 0.0f;
+		}
+
+		if (!isOutside)
+		{
+			visibleObjects.push_back(first);
+		}
+	}
+}
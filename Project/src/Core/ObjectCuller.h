@@ -0,0 +1,41 @@
+#pragma once
+#include "Core.h"
+#include "Frustum.h"
+
+#include <vector>
+
+//World space bounds of a set of objects, kept as a structure of arrays so that the culling loop tests four objects per SSE register.
+//Every object has an axis aligned box and a sphere around the same center, a plane culls the object when either of them is behind it
+class ObjectCuller
+{
+public:
+	ObjectCuller();
+	~ObjectCuller() = default;
+
+	DECL_NO_COPY(ObjectCuller);
+
+	//The bounds are given in object space and moved into world space with the transform, returns the index of the object
+	uint32_t addObject(const glm::vec3& boundsMin, const glm::vec3& boundsMax, float boundingRadius, const glm::mat4& transform);
+	void updateObject(uint32_t index, const glm::vec3& boundsMin, const glm::vec3& boundsMax, float boundingRadius, const glm::mat4& transform);
+
+	//Replaces the contents of visibleObjects with the indices of the objects that are not completely outside of the frustum, in increasing order
+	void cull(const Frustum& frustum, std::vector<uint32_t>& visibleObjects) const;
+
+	FORCEINLINE uint32_t	getObjectCount() const			{ return m_ObjectCount; }
+	FORCEINLINE glm::vec3	getCenter(uint32_t index) const	{ return glm::vec3(m_CenterX[index], m_CenterY[index], m_CenterZ[index]); }
+	FORCEINLINE float		getRadius(uint32_t index) const	{ return m_Radius[index]; }
+	FORCEINLINE glm::vec3	getBoundsMin(uint32_t index) const	{ return getCenter(index) - glm::vec3(m_ExtentX[index], m_ExtentY[index], m_ExtentZ[index]); }
+	FORCEINLINE glm::vec3	getBoundsMax(uint32_t index) const	{ return getCenter(index) + glm::vec3(m_ExtentX[index], m_ExtentY[index], m_ExtentZ[index]); }
+
+private:
+	//The arrays are padded to a multiple of four so that the last objects can be loaded as a whole register
+	std::vector<float> m_CenterX;
+	std::vector<float> m_CenterY;
+	std::vector<float> m_CenterZ;
+	std::vector<float> m_Radius;
+	//Half the size of the world space box
+	std::vector<float> m_ExtentX;
+	std::vector<float> m_ExtentY;
+	std::vector<float> m_ExtentZ;
+	uint32_t m_ObjectCount;
+};
@@ -0,0 +1,83 @@
+#include "PackedVertex.h"
+
+#include <glm/gtc/packing.hpp>
+
+#define TANGENT_COMPONENT_BITS	15U
+#define TANGENT_COMPONENT_MAX	((1U << TANGENT_COMPONENT_BITS) - 1U)
+#define TANGENT_SIGN_BIT		(1U << 31U)
+
+//Projects the direction onto an octahedron and folds the lower half over the upper half, the result is in [-1, 1]
+static glm::vec2 encodeOctahedral(const glm::vec3& direction)
+{
+	const float length = glm::abs(direction.x) + glm::abs(direction.y) + glm::abs(direction.z);
+	if (length <= 0.0f)
+	{
+		return glm::vec2(0.0f);
+	}
+
+	const glm::vec3 projected = direction / length;
+	if (projected.z >= 0.0f)
+	{
+		return glm::vec2(projected.x, projected.y);
+	}
+
+	return glm::vec2(
+		(1.0f - glm::abs(projected.y)) * (projected.x >= 0.0f ? 1.0f : -1.0f),
+		(1.0f - glm::abs(projected.x)) * (projected.y >= 0.0f ? 1.0f : -1.0f));
+}
+
+static glm::vec3 decodeOctahedral(const glm::vec2& encoded)
+{
+	glm::vec3 direction = glm::vec3(encoded.x, encoded.y, 1.0f - glm::abs(encoded.x) - glm::abs(encoded.y));
+
+	const float fold = glm::max(-direction.z, 0.0f);
+	direction.x += (direction.x >= 0.0f) ? -fold : fold;
+	direction.y += (direction.y >= 0.0f) ? -fold : fold;
+	return glm::normalize(direction);
+}
+
+PackedVertex VertexPacker::pack(const Vertex& vertex)
+{
+	PackedVertex packedVertex = {};
+	packedVertex.Position	= vertex.Position;
+	packedVertex.Normal		= glm::packSnorm2x16(encodeOctahedral(vertex.Normal));
+	packedVertex.TexCoord	= glm::packHalf2x16(vertex.TexCoord);
+
+	const glm::vec2 tangent = encodeOctahedral(vertex.Tangent) * 0.5f + 0.5f;
+	const uint32_t x = uint32_t(glm::round(glm::clamp(tangent.x, 0.0f, 1.0f) * float(TANGENT_COMPONENT_MAX)));
+	const uint32_t y = uint32_t(glm::round(glm::clamp(tangent.y, 0.0f, 1.0f) * float(TANGENT_COMPONENT_MAX)));
+	packedVertex.Tangent = x | (y << TANGENT_COMPONENT_BITS) | ((vertex.BitangentSign < 0.0f) ? TANGENT_SIGN_BIT : 0U);
+	return packedVertex;
+}
+
+void VertexPacker::pack(const Vertex* pVertices, uint32_t vertexCount, PackedVertex* pPackedVertices)
+{
+	for (uint32_t i = 0; i < vertexCount; i++)
+	{
+		pPackedVertices[i] = pack(pVertices[i]);
+	}
+}
+
+Vertex VertexPacker::unpack(const PackedVertex& packedVertex)
+{
+	const float x = float(packedVertex.Tangent & TANGENT_COMPONENT_MAX);
+	const float y = float((packedVertex.Tangent >> TANGENT_COMPONENT_BITS) & TANGENT_COMPONENT_MAX);
+
+	Vertex vertex = {};
+	vertex.Position			= packedVertex.Position;
+	vertex.Normal			= decodeOctahedral(glm::unpackSnorm2x16(packedVertex.Normal));
+	vertex.Tangent			= decodeOctahedral(glm::vec2(x, y) * (2.0f / float(TANGENT_COMPONENT_MAX)) - 1.0f);
+	vertex.TexCoord			= glm::unpackHalf2x16(packedVertex.TexCoord);
+	vertex.BitangentSign	= (packedVertex.Tangent & TANGENT_SIGN_BIT) ? -1.0f : 1.0f;
+	return vertex;
+}
+
+uint32_t VertexPacker::getStride(EVertexFormat format)
+{
+	return (format == EVertexFormat::PACKED) ? uint32_t(sizeof(PackedVertex)) : uint32_t(sizeof(Vertex));
+}
+
+const char* VertexPacker::getName(EVertexFormat format)
+{
+	return (format == EVertexFormat::PACKED) ? "packed" : "standard";
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "Core.h"
+
+//Has to match the VERTEX_FORMAT_* defines in assets/shaders/vertexFormat.glsl
+enum class EVertexFormat : uint32_t
+{
+	STANDARD	= 0,
+	PACKED		= 1,
+};
+
+//24 byte version of Vertex. The position stays a float so that acceleration structures can be built straight from the vertex buffer
+struct PackedVertex
+{
+	glm::vec3 Position;
+	//Octahedral encoding in two snorm16
+	uint32_t Normal;
+	//Octahedral encoding with 15 bits per component, the top bit is set when the bitangent is flipped
+	uint32_t Tangent;
+	//Two half floats
+	uint32_t TexCoord;
+};
+
+static_assert(sizeof(PackedVertex) == 24, "PackedVertex has to match loadVertex in vertexFormat.glsl");
+
+class VertexPacker
+{
+public:
+	DECL_STATIC_CLASS(VertexPacker);
+
+	//The handedness of the tangent frame goes into the top bit of the tangent, which loadVertex turns back into the sign of the bitangent
+	static PackedVertex pack(const Vertex& vertex);
+	static void pack(const Vertex* pVertices, uint32_t vertexCount, PackedVertex* pPackedVertices);
+	//Only meant for tests and tools, the shaders decode the packed vertices
+	static Vertex unpack(const PackedVertex& packedVertex);
+
+	static uint32_t getStride(EVertexFormat format);
+	static const char* getName(EVertexFormat format);
+};
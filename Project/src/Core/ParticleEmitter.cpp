@@ -4,6 +4,7 @@
 
 #include "Common/IBuffer.h"
 #include "Common/IMesh.h"
+#include "Core/TaskDispatcher.h"
 
 #include <algorithm>
 #include <math.h>
@@ -212,13 +213,14 @@ void ParticleEmitter::moveParticles(float dt)
     std::vector<glm::vec4>& velocities = m_ParticleStorage.velocities;
     std::vector<float>& ages = m_ParticleStorage.ages;
 
-    size_t particleCount = getParticleCount();
+    uint32_t particleCount = getParticleCount();
 
-    for (size_t particleIdx = 0; particleIdx < particleCount; particleIdx++) {
+    // Particles are independent of each other, small emitters are run inline by parallelFor
+    TaskDispatcher::parallelFor(0, particleCount, 2048, [&](uint32_t particleIdx) {
         positions[particleIdx] += velocities[particleIdx] * dt;
         velocities[particleIdx].y -= 9.82f * dt;
         ages[particleIdx] += dt;
-    }
+    });
 }
 
 void ParticleEmitter::respawnOldParticles()
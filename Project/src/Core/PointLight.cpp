@@ -15,3 +15,9 @@ void PointLight::setPosition(const glm::vec3& position)
 {
 	m_Position = glm::vec4(position, 0.0f);
 }
+
+float PointLight::getInfluenceRadius() const
+{
+	const float brightness = std::max(m_Color.r, std::max(m_Color.g, m_Color.b));
+	return std::sqrt(std::max(brightness, 0.0f) / POINT_LIGHT_MIN_RADIANCE);
+}
@@ -1,6 +1,9 @@
 #pragma once
 #include "Core.h"
 
+//Radiance below which a point light no longer lights anything, the lights fall off with the square of the distance without a cutoff
+#define POINT_LIGHT_MIN_RADIANCE	(1.0f / 256.0f)
+
 class PointLight
 {
 public:
@@ -12,6 +15,8 @@ public:
 
 	const glm::vec4& getColor() const		{ return m_Color; }
 	glm::vec3		 getPosition() const	{ return m_Position; }
+	//Distance at which the brightest channel of the light has fallen off to POINT_LIGHT_MIN_RADIANCE
+	float			 getInfluenceRadius() const;
 
 protected:
 	glm::vec4 m_Color;
@@ -0,0 +1,53 @@
+#include "RadixSort.h"
+
+#include <utility>
+
+#define RADIX_SORT_PASS_COUNT	8U
+#define RADIX_SORT_BUCKET_COUNT	256U
+
+void RadixSort::sort(std::vector<RadixSortItem>& items, std::vector<RadixSortItem>& scratch)
+{
+	const size_t itemCount = items.size();
+	if (itemCount < 2)
+	{
+		return;
+	}
+
+	scratch.resize(itemCount);
+
+	uint32_t histograms[RADIX_SORT_PASS_COUNT][RADIX_SORT_BUCKET_COUNT] = {};
+	for (const RadixSortItem& item : items)
+	{
+		for (uint32_t pass = 0; pass < RADIX_SORT_PASS_COUNT; pass++)
+		{
+			histograms[pass][(item.Key >> (pass * 8)) & 0xFF]++;
+		}
+	}
+
+	for (uint32_t pass = 0; pass < RADIX_SORT_PASS_COUNT; pass++)
+	{
+		uint32_t* pHistogram	= histograms[pass];
+		const uint32_t shift	= pass * 8;
+
+		//Every key has the same byte, so the pass would not move anything
+		if (pHistogram[(items[0].Key >> shift) & 0xFF] == itemCount)
+		{
+			continue;
+		}
+
+		uint32_t offset = 0;
+		for (uint32_t bucket = 0; bucket < RADIX_SORT_BUCKET_COUNT; bucket++)
+		{
+			const uint32_t count = pHistogram[bucket];
+			pHistogram[bucket] = offset;
+			offset += count;
+		}
+
+		for (const RadixSortItem& item : items)
+		{
+			scratch[pHistogram[(item.Key >> shift) & 0xFF]++] = item;
+		}
+
+		std::swap(items, scratch);
+	}
+}
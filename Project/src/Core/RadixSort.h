@@ -0,0 +1,21 @@
+#pragma once
+#include "Core.h"
+
+#include <vector>
+
+struct RadixSortItem
+{
+	uint64_t Key;
+	uint32_t Value;
+};
+
+//Least significant digit radix sort of 64 bit keys, one byte per pass. All eight histograms are counted in a single pass over the items
+//and the bytes that are the same in every key are skipped, so keys that only use a few of their bits take few passes
+class RadixSort
+{
+public:
+	DECL_STATIC_CLASS(RadixSort);
+
+	//Sorts the items by increasing key, items with the same key keep their order. The scratch is resized to the size of the items
+	static void sort(std::vector<RadixSortItem>& items, std::vector<RadixSortItem>& scratch);
+};
@@ -0,0 +1,52 @@
+#include "SourceFile.h"
+#include "Hash.h"
+#include "MappedFile.h"
+
+#include <filesystem>
+
+bool SourceFile::getInfo(const std::string& filepath, SourceFileInfo& info)
+{
+	std::error_code error;
+	const auto timestamp = std::filesystem::last_write_time(filepath, error);
+	if (error)
+	{
+		return false;
+	}
+
+	const uintmax_t sizeInBytes = std::filesystem::file_size(filepath, error);
+	if (error)
+	{
+		return false;
+	}
+
+	info.Timestamp		= uint64_t(timestamp.time_since_epoch().count());
+	info.SizeInBytes	= uint64_t(sizeInBytes);
+	return true;
+}
+
+bool SourceFile::hash(const std::string& filepath, uint64_t& hash)
+{
+	MappedFile file;
+	if (!file.open(filepath))
+	{
+		return false;
+	}
+
+	hash = hashMemory(file.getData(), size_t(file.getSizeInBytes()));
+	return true;
+}
+
+bool SourceFile::isUnchanged(const std::string& filepath, const SourceFileInfo& current, const SourceFileInfo& cached, uint64_t cachedHash)
+{
+	if (current.SizeInBytes != cached.SizeInBytes)
+	{
+		return false;
+	}
+	else if (current.Timestamp == cached.Timestamp)
+	{
+		return true;
+	}
+
+	uint64_t currentHash = 0;
+	return hash(filepath, currentHash) && currentHash == cachedHash;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "Core.h"
+
+#include <string>
+
+//Identifies the version of a source asset that a cache file was built from
+struct SourceFileInfo
+{
+	uint64_t Timestamp;
+	uint64_t SizeInBytes;
+};
+
+class SourceFile
+{
+public:
+	DECL_STATIC_CLASS(SourceFile);
+
+	static bool getInfo(const std::string& filepath, SourceFileInfo& info);
+	static bool hash(const std::string& filepath, uint64_t& hash);
+
+	//True if the source is still the file that the cache was built from. The content is only hashed when the timestamp has changed,
+	//which happens when a file is copied or checked out again without being modified
+	static bool isUnchanged(const std::string& filepath, const SourceFileInfo& current, const SourceFileInfo& cached, uint64_t cachedHash);
+};
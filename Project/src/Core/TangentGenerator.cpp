@@ -0,0 +1,295 @@
+#include "TangentGenerator.h"
+#include "TaskDispatcher.h"
+
+#include <cmath>
+
+//Triangles per chunk that the range of vertex indices is measured for
+#define TANGENT_GENERATOR_CHUNK_SIZE			1024U
+//Meshes where the chunks would be processed more than this many times on average, because their vertex ranges are too wide, are run serially
+#define TANGENT_GENERATOR_MAX_OVERLAP			1.5f
+
+//A tangent shorter than this, relative to the length it had before it was made orthogonal to the normal, was parallel to the normal
+#define TANGENT_GENERATOR_MIN_RELATIVE_LENGTH	1.0e-3f
+
+//Padded to 16 bytes per vector so that the SSE path can store whole registers
+struct alignas(16) TriangleBasis
+{
+	glm::vec4 Tangent;
+	glm::vec4 Bitangent;
+};
+
+static FORCEINLINE void computeTriangleBasis(const Vertex& v0, const Vertex& v1, const Vertex& v2, glm::vec3& tangent, glm::vec3& bitangent)
+{
+	const glm::vec3 edge1		= v1.Position - v0.Position;
+	const glm::vec3 edge2		= v2.Position - v0.Position;
+	const glm::vec2 deltaUV1	= v1.TexCoord - v0.TexCoord;
+	const glm::vec2 deltaUV2	= v2.TexCoord - v0.TexCoord;
+
+	const float determinant = deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y;
+	if (std::abs(determinant) < TANGENT_GENERATOR_MIN_UV_AREA)
+	{
+		tangent		= glm::vec3(0.0f);
+		bitangent	= glm::vec3(0.0f);
+		return;
+	}
+
+	//Not normalized, so that triangles that stretch the texture further weigh more in the sum of a vertex
+	const float r = 1.0f / determinant;
+	tangent		= (edge1 * deltaUV2.y - edge2 * deltaUV1.y) * r;
+	bitangent	= (edge2 * deltaUV1.x - edge1 * deltaUV2.x) * r;
+}
+
+static FORCEINLINE bool isUsable(const glm::vec3& direction, float lengthBeforeSquared)
+{
+	const float lengthSquared = glm::dot(direction, direction);
+	return lengthSquared > 0.0f && lengthSquared > lengthBeforeSquared * (TANGENT_GENERATOR_MIN_RELATIVE_LENGTH * TANGENT_GENERATOR_MIN_RELATIVE_LENGTH);
+}
+
+//Any unit vector orthogonal to the normal (Duff et al., "Building an Orthonormal Basis, Revisited")
+static FORCEINLINE glm::vec3 anyOrthogonal(const glm::vec3& normal)
+{
+	const float sign	= std::copysign(1.0f, normal.z);
+	const float a		= -1.0f / (sign + normal.z);
+	const float b		= normal.x * normal.y * a;
+	return glm::vec3(1.0f + sign * normal.x * normal.x * a, sign * b, -sign * normal.x);
+}
+
+static FORCEINLINE glm::vec3 orthonormalize(const glm::vec3& vertexNormal, const glm::vec3& tangent, const glm::vec3& bitangent)
+{
+	//OBJ files do not have to contain normals, a zero normal leaves the tangent as it is
+	const float normalLengthSquared	= glm::dot(vertexNormal, vertexNormal);
+	const glm::vec3 normal			= (normalLengthSquared > 0.0f) ? vertexNormal / std::sqrt(normalLengthSquared) : glm::vec3(0.0f);
+
+	//Gram-Schmidt, the normal is kept and the tangent is moved into the plane orthogonal to it
+	const glm::vec3 orthogonalTangent = tangent - normal * glm::dot(normal, tangent);
+	if (isUsable(orthogonalTangent, glm::dot(tangent, tangent)))
+	{
+		return glm::normalize(orthogonalTangent);
+	}
+
+	//The shaders build the bitangent as cross(normal, tangent), so cross(bitangent, normal) points along the tangent
+	const glm::vec3 crossedBitangent = glm::cross(bitangent, normal);
+	if (isUsable(crossedBitangent, glm::dot(bitangent, bitangent)))
+	{
+		return glm::normalize(crossedBitangent);
+	}
+
+	return (normalLengthSquared > 0.0f) ? anyOrthogonal(normal) : glm::vec3(1.0f, 0.0f, 0.0f);
+}
+
+//The summed bitangent is only used for its side of the plane spanned by the normal and the tangent, vertices without one are right handed
+static FORCEINLINE float computeBitangentSign(const glm::vec3& normal, const glm::vec3& tangent, const glm::vec3& bitangent)
+{
+	return (glm::dot(glm::cross(normal, tangent), bitangent) < 0.0f) ? -1.0f : 1.0f;
+}
+
+//Smallest and largest vertex index that a chunk of triangles uses
+struct ChunkBounds
+{
+	uint32_t MinVertex;
+	uint32_t MaxVertex;
+};
+
+#ifdef SSE_ENABLED
+//Computes the bases of four triangles at once, the registers hold one component of one corner with a lane per triangle.
+//Position and TexCoord are both aligned to 16 bytes in Vertex, so a whole register can be loaded from each of them and transposed
+static FORCEINLINE void computeTriangleBases4(const Vertex* pVertices, const uint32_t* pIndices, TriangleBasis* pBases)
+{
+	const __m128 signMask	= _mm_set1_ps(-0.0f);
+	const __m128 minUVArea	= _mm_set1_ps(TANGENT_GENERATOR_MIN_UV_AREA);
+	const __m128 one		= _mm_set1_ps(1.0f);
+
+	__m128 x[3], y[3], z[3], u[3], v[3];
+	for (uint32_t corner = 0; corner < 3; corner++)
+	{
+		const Vertex& vertex0 = pVertices[pIndices[0 + corner]];
+		const Vertex& vertex1 = pVertices[pIndices[3 + corner]];
+		const Vertex& vertex2 = pVertices[pIndices[6 + corner]];
+		const Vertex& vertex3 = pVertices[pIndices[9 + corner]];
+
+		__m128 row0 = _mm_loadu_ps(&vertex0.Position.x);
+		__m128 row1 = _mm_loadu_ps(&vertex1.Position.x);
+		__m128 row2 = _mm_loadu_ps(&vertex2.Position.x);
+		__m128 row3 = _mm_loadu_ps(&vertex3.Position.x);
+		_MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+		x[corner] = row0;
+		y[corner] = row1;
+		z[corner] = row2;
+
+		row0 = _mm_loadu_ps(&vertex0.TexCoord.x);
+		row1 = _mm_loadu_ps(&vertex1.TexCoord.x);
+		row2 = _mm_loadu_ps(&vertex2.TexCoord.x);
+		row3 = _mm_loadu_ps(&vertex3.TexCoord.x);
+		_MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+		u[corner] = row0;
+		v[corner] = row1;
+	}
+
+	const __m128 edge1X		= _mm_sub_ps(x[1], x[0]);
+	const __m128 edge1Y		= _mm_sub_ps(y[1], y[0]);
+	const __m128 edge1Z		= _mm_sub_ps(z[1], z[0]);
+	const __m128 edge2X		= _mm_sub_ps(x[2], x[0]);
+	const __m128 edge2Y		= _mm_sub_ps(y[2], y[0]);
+	const __m128 edge2Z		= _mm_sub_ps(z[2], z[0]);
+	const __m128 deltaU1	= _mm_sub_ps(u[1], u[0]);
+	const __m128 deltaV1	= _mm_sub_ps(v[1], v[0]);
+	const __m128 deltaU2	= _mm_sub_ps(u[2], u[0]);
+	const __m128 deltaV2	= _mm_sub_ps(v[2], v[0]);
+
+	//Lanes with degenerate texture coordinates get a reciprocal of zero, which zeroes both of their vectors
+	const __m128 determinant	= _mm_sub_ps(_mm_mul_ps(deltaU1, deltaV2), _mm_mul_ps(deltaU2, deltaV1));
+	const __m128 isUsableMask	= _mm_cmpge_ps(_mm_andnot_ps(signMask, determinant), minUVArea);
+	const __m128 r				= _mm_and_ps(_mm_div_ps(one, determinant), isUsableMask);
+
+	__m128 tangentX		= _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(edge1X, deltaV2), _mm_mul_ps(edge2X, deltaV1)), r);
+	__m128 tangentY		= _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(edge1Y, deltaV2), _mm_mul_ps(edge2Y, deltaV1)), r);
+	__m128 tangentZ		= _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(edge1Z, deltaV2), _mm_mul_ps(edge2Z, deltaV1)), r);
+	__m128 tangentW		= _mm_setzero_ps();
+	__m128 bitangentX	= _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(edge2X, deltaU1), _mm_mul_ps(edge1X, deltaU2)), r);
+	__m128 bitangentY	= _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(edge2Y, deltaU1), _mm_mul_ps(edge1Y, deltaU2)), r);
+	__m128 bitangentZ	= _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(edge2Z, deltaU1), _mm_mul_ps(edge1Z, deltaU2)), r);
+	__m128 bitangentW	= _mm_setzero_ps();
+
+	//Back to one register per triangle
+	_MM_TRANSPOSE4_PS(tangentX, tangentY, tangentZ, tangentW);
+	_MM_TRANSPOSE4_PS(bitangentX, bitangentY, bitangentZ, bitangentW);
+
+	_mm_store_ps(&pBases[0].Tangent.x, tangentX);
+	_mm_store_ps(&pBases[1].Tangent.x, tangentY);
+	_mm_store_ps(&pBases[2].Tangent.x, tangentZ);
+	_mm_store_ps(&pBases[3].Tangent.x, tangentW);
+	_mm_store_ps(&pBases[0].Bitangent.x, bitangentX);
+	_mm_store_ps(&pBases[1].Bitangent.x, bitangentY);
+	_mm_store_ps(&pBases[2].Bitangent.x, bitangentZ);
+	_mm_store_ps(&pBases[3].Bitangent.x, bitangentW);
+}
+#endif
+
+//Adds the bases of the triangles in [begin, end) to the sums of the corners that lie in [firstVertex, firstVertex + sums.size())
+static void accumulateTriangles(const Vertex* pVertices, const uint32_t* pIndices, uint32_t begin, uint32_t end, uint32_t firstVertex, std::vector<TriangleBasis>& sums)
+{
+	const uint32_t vertexCount = uint32_t(sums.size());
+
+	TriangleBasis bases[4];
+	uint32_t triangle = begin;
+	while (triangle < end)
+	{
+		const uint32_t* pTriangles = pIndices + 3 * (size_t)triangle;
+
+#ifdef SSE_ENABLED
+		const uint32_t batchSize = (triangle + 4 <= end) ? 4 : 1;
+		if (batchSize == 4)
+		{
+			computeTriangleBases4(pVertices, pTriangles, bases);
+		}
+		else
+#else
+		const uint32_t batchSize = 1;
+#endif
+		{
+			glm::vec3 tangent;
+			glm::vec3 bitangent;
+			computeTriangleBasis(pVertices[pTriangles[0]], pVertices[pTriangles[1]], pVertices[pTriangles[2]], tangent, bitangent);
+			bases[0].Tangent	= glm::vec4(tangent, 0.0f);
+			bases[0].Bitangent	= glm::vec4(bitangent, 0.0f);
+		}
+
+		//Unsigned wrap around makes indices below firstVertex fail the test as well
+		for (uint32_t i = 0; i < 3 * batchSize; i++)
+		{
+			const uint32_t vertex = pTriangles[i] - firstVertex;
+			if (vertex < vertexCount)
+			{
+				sums[vertex].Tangent	+= bases[i / 3].Tangent;
+				sums[vertex].Bitangent	+= bases[i / 3].Bitangent;
+			}
+		}
+
+		triangle += batchSize;
+	}
+}
+
+void TangentGenerator::generate(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+{
+	const uint32_t vertexCount		= uint32_t(vertices.size());
+	const uint32_t triangleCount	= uint32_t(indices.size() / 3);
+	const uint32_t chunkCount		= (triangleCount + TANGENT_GENERATOR_CHUNK_SIZE - 1) / TANGENT_GENERATOR_CHUNK_SIZE;
+
+	std::vector<ChunkBounds> chunkBounds(chunkCount);
+	TaskDispatcher::parallelFor(0, chunkCount, 0, [&](uint32_t chunk)
+		{
+			const uint32_t begin	= 3 * chunk * TANGENT_GENERATOR_CHUNK_SIZE;
+			const uint32_t end		= 3 * std::min((chunk + 1) * TANGENT_GENERATOR_CHUNK_SIZE, triangleCount);
+
+			ChunkBounds bounds = { UINT32_MAX, 0 };
+			for (uint32_t i = begin; i < end; i++)
+			{
+				bounds.MinVertex = std::min(bounds.MinVertex, indices[i]);
+				bounds.MaxVertex = std::max(bounds.MaxVertex, indices[i]);
+			}
+
+			chunkBounds[chunk] = bounds;
+		});
+
+	//Every task owns a range of vertices and goes through the chunks that touch it, which needs the triangles to be roughly in the order of their vertices.
+	//Welded meshes are, since the welder adds the vertices in the order the triangles first use them
+	uint64_t processedTriangles = 0;
+	for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+	{
+		const uint32_t rangeCount		= chunkBounds[chunk].MaxVertex / TANGENT_GENERATOR_GRAIN_SIZE - chunkBounds[chunk].MinVertex / TANGENT_GENERATOR_GRAIN_SIZE + 1;
+		const uint32_t chunkTriangles	= std::min(TANGENT_GENERATOR_CHUNK_SIZE, triangleCount - chunk * TANGENT_GENERATOR_CHUNK_SIZE);
+		processedTriangles += uint64_t(rangeCount) * chunkTriangles;
+	}
+
+	if (float(processedTriangles) > TANGENT_GENERATOR_MAX_OVERLAP * float(triangleCount))
+	{
+		generateReference(vertices, indices);
+		return;
+	}
+
+	//The chunks and the triangles in them are visited in order, so every sum adds up in the same order as in generateReference
+	TaskDispatcher::parallelForRange(0, vertexCount, TANGENT_GENERATOR_GRAIN_SIZE, [&](uint32_t begin, uint32_t end)
+		{
+			std::vector<TriangleBasis> sums(end - begin);
+			for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+			{
+				if (chunkBounds[chunk].MaxVertex >= begin && chunkBounds[chunk].MinVertex < end)
+				{
+					const uint32_t firstTriangle = chunk * TANGENT_GENERATOR_CHUNK_SIZE;
+					accumulateTriangles(vertices.data(), indices.data(), firstTriangle, std::min(firstTriangle + TANGENT_GENERATOR_CHUNK_SIZE, triangleCount), begin, sums);
+				}
+			}
+
+			for (uint32_t v = begin; v < end; v++)
+			{
+				const TriangleBasis& sum = sums[v - begin];
+				vertices[v].Tangent			= orthonormalize(vertices[v].Normal, glm::vec3(sum.Tangent), glm::vec3(sum.Bitangent));
+				vertices[v].BitangentSign	= computeBitangentSign(vertices[v].Normal, vertices[v].Tangent, glm::vec3(sum.Bitangent));
+			}
+		});
+}
+
+void TangentGenerator::generateReference(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+{
+	std::vector<glm::vec3> tangents(vertices.size(), glm::vec3(0.0f));
+	std::vector<glm::vec3> bitangents(vertices.size(), glm::vec3(0.0f));
+
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		glm::vec3 tangent;
+		glm::vec3 bitangent;
+		computeTriangleBasis(vertices[indices[i + 0]], vertices[indices[i + 1]], vertices[indices[i + 2]], tangent, bitangent);
+
+		for (size_t corner = 0; corner < 3; corner++)
+		{
+			tangents[indices[i + corner]]	+= tangent;
+			bitangents[indices[i + corner]]	+= bitangent;
+		}
+	}
+
+	for (size_t v = 0; v < vertices.size(); v++)
+	{
+		vertices[v].Tangent			= orthonormalize(vertices[v].Normal, tangents[v], bitangents[v]);
+		vertices[v].BitangentSign	= computeBitangentSign(vertices[v].Normal, vertices[v].Tangent, bitangents[v]);
+	}
+}
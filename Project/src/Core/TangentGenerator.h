@@ -0,0 +1,24 @@
+#pragma once
+#include "Core.h"
+
+#include <vector>
+
+//Vertices per task when the work is split over the frame workers
+#define TANGENT_GENERATOR_GRAIN_SIZE		8192U
+//Triangles whose texture coordinates span less than this area, times two, have no usable texture space and add nothing to the tangents
+#define TANGENT_GENERATOR_MIN_UV_AREA		1.0e-12f
+
+//Generates per-vertex tangents for indexed triangle lists. The tangent and bitangent of every triangle (Lengyel, "Computing Tangent Space Basis Vectors")
+//are summed per vertex in triangle order and then made orthogonal to the normal, so the result does not depend on the order the work is done in.
+//Vertices without usable texture coordinates get the bitangent crossed with the normal, or any tangent that is orthogonal to the normal.
+//The handedness of every vertex is the side of cross(normal, tangent) that the summed bitangent lies on
+class TangentGenerator
+{
+public:
+	DECL_STATIC_CLASS(TangentGenerator);
+
+	//Splits the vertices into ranges that are summed in parallel on the frame workers, the triangle tangents are computed four at a time with SSE
+	static void generate(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+	//Scalar and serial version of generate, kept as the reference the fast path is checked against
+	static void generateReference(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+};
@@ -0,0 +1,166 @@
+#include "TangentGeneratorBenchmark.h"
+#include "TangentGenerator.h"
+#include "TaskDispatcher.h"
+#include "VertexWelder.h"
+
+#include <chrono>
+#include <vector>
+#include <tinyobjloader/tiny_obj_loader.h>
+
+#define TANGENT_BENCHMARK_RUNS		5U
+//Largest angle in degrees that a tangent of the parallel path may differ from the reference by
+#define TANGENT_BENCHMARK_MAX_ERROR	0.01f
+
+struct BenchmarkMesh
+{
+	std::vector<Vertex> Vertices;
+	std::vector<uint32_t> Indices;
+};
+
+//Welds every shape of the OBJ into one mesh, the same way MeshCache imports meshes before the tangents are generated
+static bool loadMesh(const char* pFilepath, BenchmarkMesh& mesh)
+{
+	tinyobj::attrib_t attributes;
+	std::vector<tinyobj::shape_t> shapes;
+	std::vector<tinyobj::material_t> materials;
+	std::string warn, err;
+
+	if (!tinyobj::LoadObj(&attributes, &shapes, &materials, &warn, &err, pFilepath, nullptr, true, false))
+	{
+		return false;
+	}
+
+	size_t indexCount = 0;
+	for (const tinyobj::shape_t& shape : shapes)
+	{
+		indexCount += shape.mesh.indices.size();
+	}
+
+	VertexWelder welder;
+	welder.reset(uint32_t(indexCount));
+	mesh.Indices.reserve(indexCount);
+
+	for (const tinyobj::shape_t& shape : shapes)
+	{
+		for (const tinyobj::index_t& index : shape.mesh.indices)
+		{
+			Vertex vertex = {};
+			vertex.Position = glm::vec3(attributes.vertices[3 * (size_t)index.vertex_index + 0], attributes.vertices[3 * (size_t)index.vertex_index + 1], attributes.vertices[3 * (size_t)index.vertex_index + 2]);
+
+			if (index.normal_index >= 0)
+			{
+				vertex.Normal = glm::vec3(attributes.normals[3 * (size_t)index.normal_index + 0], attributes.normals[3 * (size_t)index.normal_index + 1], attributes.normals[3 * (size_t)index.normal_index + 2]);
+			}
+
+			if (index.texcoord_index >= 0)
+			{
+				vertex.TexCoord = glm::vec2(attributes.texcoords[2 * (size_t)index.texcoord_index + 0], 1.0f - attributes.texcoords[2 * (size_t)index.texcoord_index + 1]);
+			}
+
+			mesh.Indices.push_back(welder.weld(vertex, mesh.Vertices));
+		}
+	}
+
+	return !mesh.Indices.empty();
+}
+
+//The tangents MeshCache computed before TangentGenerator, every corner of a triangle overwrites the tangent of its vertex
+static void generateLegacy(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+{
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		for (size_t corner = 0; corner < 3; corner++)
+		{
+			Vertex& vertex			= vertices[indices[i + corner]];
+			const Vertex& vertex1	= vertices[indices[i + (corner + 1) % 3]];
+			const Vertex& vertex2	= vertices[indices[i + (corner + 2) % 3]];
+
+			const glm::vec3 edge1		= vertex1.Position - vertex.Position;
+			const glm::vec3 edge2		= vertex2.Position - vertex.Position;
+			const glm::vec2 deltaUV1	= vertex1.TexCoord - vertex.TexCoord;
+			const glm::vec2 deltaUV2	= vertex2.TexCoord - vertex.TexCoord;
+
+			const float f = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y);
+			vertex.Tangent = glm::normalize(f * (deltaUV2.y * edge1 - deltaUV1.y * edge2));
+		}
+	}
+}
+
+//Returns the best time out of TANGENT_BENCHMARK_RUNS in milliseconds, every run starts from a copy of source and the result of the last run is kept
+template<typename GenerateFunction>
+static double measure(const BenchmarkMesh& source, GenerateFunction generate, BenchmarkMesh& result)
+{
+	double bestTime = 0.0;
+	for (uint32_t run = 0; run < TANGENT_BENCHMARK_RUNS; run++)
+	{
+		result = source;
+
+		auto startTime = std::chrono::high_resolution_clock::now();
+		generate(result.Vertices, result.Indices);
+		std::chrono::duration<double, std::milli> time = std::chrono::high_resolution_clock::now() - startTime;
+
+		if (run == 0 || time.count() < bestTime)
+		{
+			bestTime = time.count();
+		}
+	}
+
+	return bestTime;
+}
+
+//Largest angle between the tangents of the two meshes in degrees, a vertex with the other handedness counts as 180 degrees
+static float findLargestError(const BenchmarkMesh& mesh, const BenchmarkMesh& reference)
+{
+	float smallestCosine = 1.0f;
+	for (size_t v = 0; v < mesh.Vertices.size(); v++)
+	{
+		const bool isSameHandedness = mesh.Vertices[v].BitangentSign == reference.Vertices[v].BitangentSign;
+		smallestCosine = std::min(smallestCosine, isSameHandedness ? glm::dot(mesh.Vertices[v].Tangent, reference.Vertices[v].Tangent) : -1.0f);
+	}
+
+	return glm::degrees(std::acos(glm::clamp(smallestCosine, -1.0f, 1.0f)));
+}
+
+void TangentGeneratorBenchmark::run()
+{
+	const char* filepaths[] =
+	{
+		"assets/meshes/gun.obj",
+		"assets/meshes/sphere.obj",
+		"assets/sponza/sponza.obj",
+	};
+
+	TaskDispatcher::init();
+
+	LOG("TangentGeneratorBenchmark: %u frame workers, best of %u runs", TaskDispatcher::getWorkerCount(), TANGENT_BENCHMARK_RUNS);
+	LOG("%-28s | %-10s | %-10s | %-12s | %-12s | %-12s | %-8s | %-10s", "File", "Triangles", "Vertices", "Legacy ms", "Reference ms", "Parallel ms", "Speedup", "Max error");
+
+	for (const char* pFilepath : filepaths)
+	{
+		BenchmarkMesh original;
+		if (!loadMesh(pFilepath, original))
+		{
+			LOG("%-28s | Failed to load, skipped", pFilepath);
+			continue;
+		}
+
+		BenchmarkMesh legacyResult;
+		BenchmarkMesh referenceResult;
+		BenchmarkMesh parallelResult;
+		const double legacyTime		= measure(original, generateLegacy, legacyResult);
+		const double referenceTime	= measure(original, TangentGenerator::generateReference, referenceResult);
+		const double parallelTime	= measure(original, TangentGenerator::generate, parallelResult);
+
+		//The vectors are summed in the same order by both, so any difference comes from the compiler contracting or reordering the arithmetic
+		const float largestError = findLargestError(parallelResult, referenceResult);
+		if (largestError > TANGENT_BENCHMARK_MAX_ERROR)
+		{
+			LOG("%-28s | Parallel tangents differ from the reference by up to %.4f degrees", pFilepath, largestError);
+		}
+
+		LOG("%-28s | %-10u | %-10u | %-12.3f | %-12.3f | %-12.3f | %-8.2f | %.4f", pFilepath, uint32_t(original.Indices.size() / 3), uint32_t(original.Vertices.size()),
+			legacyTime, referenceTime, parallelTime, (parallelTime > 0.0) ? referenceTime / parallelTime : 0.0, largestError);
+	}
+
+	TaskDispatcher::release();
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include "Core.h"
+
+//Compares TangentGenerator against its scalar reference and the per-triangle tangents it replaced, using the OBJ files in assets.
+//The parallel tangents are checked against the reference, which sums the same values in the same order
+class TangentGeneratorBenchmark
+{
+public:
+	DECL_STATIC_CLASS(TangentGeneratorBenchmark);
+
+	//Files that can not be loaded are skipped
+	static void run();
+};
@@ -1,70 +1,431 @@
 #include "TaskDispatcher.h"
 
+#include <chrono>
 #include <algorithm>
 
-std::vector<std::thread>			TaskDispatcher::s_Threads;
-std::mutex							TaskDispatcher::s_EventMutex;
-std::atomic<uint64_t>				TaskDispatcher::s_FinishedFence;
-std::condition_variable				TaskDispatcher::s_WakeCondition;
-std::queue<std::function<void()>>	TaskDispatcher::s_TaskQueue;
-uint64_t							TaskDispatcher::s_CurrentFence = 0;
-Spinlock							TaskDispatcher::s_QueueLock;
-bool								TaskDispatcher::s_RunWorkers = true;
+#if defined(_WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <Windows.h>
+#elif defined(__linux__)
+	#include <pthread.h>
+#endif
 
-bool TaskDispatcher::init()
+#define INVALID_WORKER_INDEX UINT32_MAX
+//Initial size of each worker's ring buffer, must be a power of two
+#define WORKER_QUEUE_CAPACITY 256U
+//Number of chunks per worker when parallelFor picks the grain size itself
+#define PARALLEL_FOR_CHUNKS_PER_WORKER 4U
+//Upper limit of the default background pool size, loading is mostly bound by disk and decoding a few files at once
+#define MAX_DEFAULT_BACKGROUND_THREADS 4U
+
+struct TaskDispatcher::ParallelForContext
 {
-	const uint32_t numThreads = std::min(std::max(1U, std::thread::hardware_concurrency()), MAX_THREADS);
+	void* pFunction;
+	void(*pInvoke)(void*, uint32_t, uint32_t);
+	ParallelForStats* pStats;
+	TaskPool* pPool;
+	TaskGroup Group;
+	Spinlock StatsLock;
+	uint32_t GrainSize;
+};
 
-	LOG("TaskManager: Starting up %u threads", numThreads);
+TaskDispatcher::TaskPool				TaskDispatcher::s_Pools[TASK_POOL_COUNT];
+thread_local TaskDispatcher::TaskPool*	TaskDispatcher::s_pWorkerPool = nullptr;
+thread_local uint32_t					TaskDispatcher::s_WorkerIndex = INVALID_WORKER_INDEX;
+std::atomic<uint64_t>					TaskDispatcher::s_FinishedFence(0);
+std::atomic<uint64_t>					TaskDispatcher::s_CurrentFence(0);
+std::atomic<bool>						TaskDispatcher::s_RunWorkers(true);
 
-	s_RunWorkers = true;
-	for (uint32_t i = 0; i < numThreads; i++)
+bool TaskDispatcher::init(uint32_t frameThreads, uint32_t backgroundThreads)
+{
+	const uint32_t hardwareThreads = std::max(1U, std::thread::hardware_concurrency());
+	if (backgroundThreads == 0)
 	{
-		s_Threads.emplace_back(taskThread);
+		backgroundThreads = std::min(std::max(1U, hardwareThreads / 4), MAX_DEFAULT_BACKGROUND_THREADS);
 	}
 
+	if (frameThreads == 0)
+	{
+		//Leave one hardware thread for the main thread, it records and submits the frame as well
+		frameThreads = (hardwareThreads > backgroundThreads + 1) ? hardwareThreads - backgroundThreads - 1 : 1;
+	}
+
+	s_RunWorkers = true;
+
+	//Frame workers are pinned so that loading or other processes cannot move them around between cores mid-frame
+	startPool(ETaskPool::FRAME,			"Frame",		frameThreads,		true);
+	startPool(ETaskPool::BACKGROUND,	"Background",	backgroundThreads,	false);
+
 	return true;
 }
 
 void TaskDispatcher::release()
 {
+	waitForTasks();
+
 	s_RunWorkers = false;
-	s_WakeCondition.notify_all();
+	for (TaskPool& pool : s_Pools)
+	{
+		stopPool(pool);
+	}
 
-	waitForTasks();
-	for (std::thread& thread : s_Threads)
+	JobAllocator::release();
+}
+
+void TaskDispatcher::execute(Job&& task, ETaskPool pool)
+{
+	pushTask(getPool(pool), std::move(task), nullptr);
+}
+
+TaskGroup& TaskDispatcher::execute(Job&& task, TaskGroup& group, ETaskPool pool)
+{
+	group.m_PendingTasks.fetch_add(1);
+	pushTask(getPool(pool), std::move(task), &group);
+
+	return group;
+}
+
+void TaskDispatcher::waitForTasks()
+{
+	Task task;
+	TaskPool* pTaskPool = nullptr;
+	while (!isFinished())
 	{
-		thread.join();
+		//Help out instead of idling, any task brings us closer to being finished
+		if (findTask(task, pTaskPool, nullptr))
+		{
+			runTask(*pTaskPool, task);
+		}
+		else
+		{
+			poll();
+		}
+	}
+}
+
+void TaskDispatcher::waitForGroup(TaskGroup& group)
+{
+	Task task;
+	TaskPool* pTaskPool = nullptr;
+	while (!group.isFinished())
+	{
+		//Only help with tasks from the same group so that an unrelated long task cannot stall the waiting thread
+		if (findTask(task, pTaskPool, &group))
+		{
+			runTask(*pTaskPool, task);
+		}
+		else
+		{
+			poll();
+		}
 	}
 }
 
-void TaskDispatcher::execute(const std::function<void()>& task)
+TaskPoolStats TaskDispatcher::getPoolStats(ETaskPool poolType)
 {
-	s_CurrentFence++;
+	TaskPool& pool = getPool(poolType);
 
+	TaskPoolStats stats = {};
+	stats.pName				= pool.pName;
+	stats.WorkerCount		= pool.WorkerCount;
+	stats.QueueDepth		= pool.PendingTasks.load(std::memory_order_relaxed);
+	stats.PeakQueueDepth	= pool.PeakPendingTasks.load(std::memory_order_relaxed);
+	stats.CompletedTasks	= pool.CompletedTasks.load(std::memory_order_relaxed);
+	return stats;
+}
+
+void TaskDispatcher::resetPeakQueueDepths()
+{
+	for (TaskPool& pool : s_Pools)
 	{
-		std::scoped_lock<Spinlock> lock(s_QueueLock);
-		s_TaskQueue.push(task);
-		s_WakeCondition.notify_one();
+		pool.PeakPendingTasks.store(pool.PendingTasks.load(std::memory_order_relaxed), std::memory_order_relaxed);
 	}
 }
 
-void TaskDispatcher::waitForTasks()
+void TaskDispatcher::parallelForRange(uint32_t begin, uint32_t end, uint32_t grainSize, void* pFunction, void(*pInvoke)(void*, uint32_t, uint32_t), ParallelForStats* pStats)
 {
-	while (!isFinished())
+	if (begin >= end)
+	{
+		return;
+	}
+
+	TaskPool& pool = s_pWorkerPool ? *s_pWorkerPool : getPool(ETaskPool::FRAME);
+
+	const uint32_t count = end - begin;
+	if (grainSize == 0)
+	{
+		grainSize = std::max(1U, count / (std::max(1U, pool.WorkerCount) * PARALLEL_FOR_CHUNKS_PER_WORKER));
+	}
+
+	ParallelForContext context;
+	context.pFunction	= pFunction;
+	context.pInvoke		= pInvoke;
+	context.pStats		= pStats;
+	context.pPool		= &pool;
+	context.GrainSize	= grainSize;
+
+	if (pStats)
+	{
+		*pStats = ParallelForStats();
+	}
+
+	//Not worth the overhead of a task, or there is nobody to hand the work to
+	if (count <= grainSize || pool.WorkerCount <= 1)
+	{
+		if (pStats)
+		{
+			pStats->RanInline = true;
+		}
+
+		runParallelForChunks(context, begin, end);
+		return;
+	}
+
+	runParallelForChunks(context, begin, end);
+	context.Group.wait();
+}
+
+void TaskDispatcher::runParallelForChunks(ParallelForContext& context, uint32_t begin, uint32_t end)
+{
+	TaskPool& pool = *context.pPool;
+	while (begin < end)
 	{
-		poll();
+		//Hand the upper half to another worker as long as there are workers without work, otherwise keep going here
+		if (end - begin >= context.GrainSize * 2 && pool.PendingTasks.load() < pool.WorkerCount && pool.WorkerCount > 1)
+		{
+			const uint32_t middle = begin + (end - begin) / 2;
+
+			context.Group.m_PendingTasks.fetch_add(1);
+			pushTask(pool, [&context, middle, end]
+				{
+					runParallelForChunks(context, middle, end);
+				}, &context.Group);
+
+			end = middle;
+			continue;
+		}
+
+		const uint32_t chunkEnd = std::min(begin + context.GrainSize, end);
+		if (context.pStats)
+		{
+			auto startTime = std::chrono::high_resolution_clock::now();
+			context.pInvoke(context.pFunction, begin, chunkEnd);
+			std::chrono::duration<double, std::milli> chunkTime = std::chrono::high_resolution_clock::now() - startTime;
+
+			std::scoped_lock<Spinlock> lock(context.StatsLock);
+			ParallelForStats& stats = *context.pStats;
+			stats.MinChunkTime		= (stats.ChunkCount == 0) ? chunkTime.count() : std::min(stats.MinChunkTime, chunkTime.count());
+			stats.MaxChunkTime		= std::max(stats.MaxChunkTime, chunkTime.count());
+			stats.TotalChunkTime	+= chunkTime.count();
+			stats.ChunkCount++;
+		}
+		else
+		{
+			context.pInvoke(context.pFunction, begin, chunkEnd);
+		}
+
+		begin = chunkEnd;
 	}
 }
 
-bool TaskDispatcher::poptask(std::function<void()>& task)
+void TaskDispatcher::pushTask(TaskPool& pool, Job&& function, TaskGroup* pGroup)
 {
-	std::scoped_lock<Spinlock> lock(s_QueueLock);
-	if (!s_TaskQueue.empty())
+	ASSERT(pool.WorkerCount > 0);
+
+	s_CurrentFence.fetch_add(1);
+
+	//Workers push onto their own queue so that nested tasks stay hot in cache, other threads spread their tasks out
+	uint32_t queueIndex = s_WorkerIndex;
+	if (s_pWorkerPool != &pool)
+	{
+		queueIndex = pool.NextQueue.fetch_add(1, std::memory_order_relaxed) % pool.WorkerCount;
+	}
+
+	WorkerQueue& queue = pool.Queues[queueIndex];
+	{
+		std::scoped_lock<Spinlock> lock(queue.Lock);
+		queue.pushBack({ std::move(function), pGroup });
+	}
+
+	const uint32_t pendingTasks = pool.PendingTasks.fetch_add(1) + 1;
+
+	uint32_t peakPendingTasks = pool.PeakPendingTasks.load(std::memory_order_relaxed);
+	while (pendingTasks > peakPendingTasks && !pool.PeakPendingTasks.compare_exchange_weak(peakPendingTasks, pendingTasks, std::memory_order_relaxed))
+	{
+	}
+
+	//Only take the mutex when someone is actually asleep
+	if (pool.SleepingWorkers.load() > 0)
 	{
-		task = s_TaskQueue.front();
-		s_TaskQueue.pop();
+		std::scoped_lock<std::mutex> lock(pool.EventMutex);
+		pool.WakeCondition.notify_one();
+	}
+}
+
+bool TaskDispatcher::popTask(TaskPool& pool, uint32_t workerIndex, Task& task)
+{
+	WorkerQueue& queue = pool.Queues[workerIndex];
 
+	std::scoped_lock<Spinlock> lock(queue.Lock);
+	if (!queue.empty())
+	{
+		queue.popBack(task);
+		return true;
+	}
+
+	return false;
+}
+
+bool TaskDispatcher::stealTask(TaskPool& pool, uint32_t thiefIndex, Task& task, const TaskGroup* pGroup)
+{
+	//Threads that are not workers in the pool start at the first queue, the thief's own queue is visited last
+	const uint32_t workerCount	= pool.WorkerCount;
+	const uint32_t startIndex	= (thiefIndex == INVALID_WORKER_INDEX) ? 0 : thiefIndex + 1;
+	for (uint32_t i = 0; i < workerCount; i++)
+	{
+		const uint32_t victimIndex = (startIndex + i) % workerCount;
+		if (victimIndex == thiefIndex && pGroup == nullptr)
+		{
+			continue;
+		}
+
+		//Do not wait on a contended victim, move on to the next one instead
+		WorkerQueue& victim = pool.Queues[victimIndex];
+		std::unique_lock<Spinlock> lock(victim.Lock, std::try_to_lock);
+		if (!lock.owns_lock() || victim.empty())
+		{
+			continue;
+		}
+
+		if (pGroup == nullptr)
+		{
+			victim.popFront(task);
+			return true;
+		}
+		else if (victim.popGroupTask(pGroup, task))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool TaskDispatcher::findTask(Task& task, TaskPool*& pTaskPool, const TaskGroup* pGroup)
+{
+	if (s_pWorkerPool)
+	{
+		pTaskPool = s_pWorkerPool;
+		if ((pGroup == nullptr && popTask(*s_pWorkerPool, s_WorkerIndex, task)) || stealTask(*s_pWorkerPool, s_WorkerIndex, task, pGroup))
+		{
+			return true;
+		}
+	}
+
+	for (TaskPool& pool : s_Pools)
+	{
+		if (&pool != s_pWorkerPool && stealTask(pool, INVALID_WORKER_INDEX, task, pGroup))
+		{
+			pTaskPool = &pool;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void TaskDispatcher::runTask(TaskPool& pool, Task& task)
+{
+	pool.PendingTasks.fetch_sub(1);
+
+	task.Function();
+	task.Function.reset();
+
+	if (task.pGroup)
+	{
+		task.pGroup->m_PendingTasks.fetch_sub(1);
+	}
+
+	pool.CompletedTasks.fetch_add(1, std::memory_order_relaxed);
+	s_FinishedFence.fetch_add(1);
+}
+
+void TaskDispatcher::WorkerQueue::reserve(uint32_t capacity)
+{
+	std::scoped_lock<Spinlock> lock(Lock);
+	if (Tasks.size() >= capacity)
+	{
+		return;
+	}
+
+	JobAllocator::trackHeapAllocation();
+
+	std::vector<Task> tasks(capacity);
+	for (uint32_t i = 0; i < Count; i++)
+	{
+		tasks[i] = std::move(Tasks[(Head + i) & (uint32_t(Tasks.size()) - 1)]);
+	}
+
+	Tasks.swap(tasks);
+	Head = 0;
+}
+
+void TaskDispatcher::WorkerQueue::pushBack(Task&& task)
+{
+	if (Count == Tasks.size())
+	{
+		//Grow while holding the lock, the queue is locked by the caller
+		JobAllocator::trackHeapAllocation();
+
+		std::vector<Task> tasks(std::max(WORKER_QUEUE_CAPACITY, uint32_t(Tasks.size()) * 2));
+		for (uint32_t i = 0; i < Count; i++)
+		{
+			tasks[i] = std::move(Tasks[(Head + i) & (uint32_t(Tasks.size()) - 1)]);
+		}
+
+		Tasks.swap(tasks);
+		Head = 0;
+	}
+
+	Tasks[(Head + Count) & (uint32_t(Tasks.size()) - 1)] = std::move(task);
+	Count++;
+}
+
+void TaskDispatcher::WorkerQueue::popBack(Task& task)
+{
+	task = std::move(back());
+	Count--;
+}
+
+void TaskDispatcher::WorkerQueue::popFront(Task& task)
+{
+	task = std::move(front());
+	Head = (Head + 1) & (uint32_t(Tasks.size()) - 1);
+	Count--;
+}
+
+bool TaskDispatcher::WorkerQueue::popGroupTask(const TaskGroup* pGroup, Task& task)
+{
+	//Searched from the back since the newest tasks are the most likely to belong to a group that is being waited on
+	const uint32_t mask = uint32_t(Tasks.size()) - 1;
+	for (uint32_t i = Count; i > 0; i--)
+	{
+		Task& candidate = Tasks[(Head + i - 1) & mask];
+		if (candidate.pGroup != pGroup)
+		{
+			continue;
+		}
+
+		task = std::move(candidate);
+
+		//Close the gap by moving the tasks behind it forward, so the remaining tasks keep their order
+		for (uint32_t j = i; j < Count; j++)
+		{
+			Tasks[(Head + j - 1) & mask] = std::move(Tasks[(Head + j) & mask]);
+		}
+
+		Count--;
 		return true;
 	}
 
@@ -73,26 +434,101 @@ bool TaskDispatcher::poptask(std::function<void()>& task)
 
 void TaskDispatcher::poll()
 {
-	s_WakeCondition.notify_one();
 	std::this_thread::yield();
 }
 
-void TaskDispatcher::taskThread()
+void TaskDispatcher::startPool(ETaskPool poolType, const char* pName, uint32_t numThreads, bool pinToCores)
 {
+	TaskPool& pool = getPool(poolType);
+	pool.pName			= pName;
+	pool.WorkerCount	= std::min(std::max(1U, numThreads), MAX_THREADS);
+
+	LOG("TaskManager: Starting up %u threads in the %s pool", pool.WorkerCount, pName);
+
+	const uint32_t hardwareThreads = std::max(1U, std::thread::hardware_concurrency());
+	for (uint32_t i = 0; i < pool.WorkerCount; i++)
+	{
+		pool.Queues[i].reserve(WORKER_QUEUE_CAPACITY);
+		pool.Threads.emplace_back(taskThread, &pool, i);
+
+		//Core zero is left to the main thread
+		if (pinToCores && !pinThreadToCore(pool.Threads.back(), (i + 1) % hardwareThreads))
+		{
+			LOG("TaskManager: Failed to pin worker %u in the %s pool to a core", i, pName);
+		}
+	}
+}
+
+void TaskDispatcher::stopPool(TaskPool& pool)
+{
+	{
+		std::scoped_lock<std::mutex> lock(pool.EventMutex);
+		pool.WakeCondition.notify_all();
+	}
+
+	for (std::thread& thread : pool.Threads)
+	{
+		thread.join();
+	}
+
+	pool.Threads.clear();
+	pool.WorkerCount = 0;
+}
+
+bool TaskDispatcher::pinThreadToCore(std::thread& thread, uint32_t coreIndex)
+{
+#if defined(_WIN32)
+	return SetThreadAffinityMask(thread.native_handle(), DWORD_PTR(1) << coreIndex) != 0;
+#elif defined(__linux__)
+	cpu_set_t cpuSet;
+	CPU_ZERO(&cpuSet);
+	CPU_SET(coreIndex, &cpuSet);
+	return pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t), &cpuSet) == 0;
+#else
+	//There is no way to set a hard affinity on macOS, the workers are left to the scheduler
+	UNREFERENCED_PARAMETER(thread);
+	UNREFERENCED_PARAMETER(coreIndex);
+	return true;
+#endif
+}
+
+void TaskDispatcher::taskThread(TaskPool* pPool, uint32_t workerIndex)
+{
+	TaskPool& pool = *pPool;
+	s_pWorkerPool	= pPool;
+	s_WorkerIndex	= workerIndex;
+
 	while (shouldRunWorker())
 	{
-		std::function<void()> task;
-		if (poptask(task))
+		Task task;
+		if (popTask(pool, workerIndex, task) || stealTask(pool, workerIndex, task))
 		{
-			task();
-			s_FinishedFence.fetch_add(1);
+			runTask(pool, task);
+		}
+		else if (pool.PendingTasks.load() == 0)
+		{
+			std::unique_lock<std::mutex> lock(pool.EventMutex);
+
+			pool.SleepingWorkers.fetch_add(1);
+			pool.WakeCondition.wait(lock, [&pool]
+			{
+				return pool.PendingTasks.load() > 0 || !shouldRunWorker();
+			});
+			pool.SleepingWorkers.fetch_sub(1);
 		}
 		else
 		{
-			std::unique_lock<std::mutex> lock(s_EventMutex);
-			s_WakeCondition.wait(lock);
+			//Tasks exist but are being taken by others, back off before trying to steal again
+			poll();
 		}
 	}
 
+	s_pWorkerPool	= nullptr;
+	s_WorkerIndex	= INVALID_WORKER_INDEX;
 	LOG("Shutting down worker");
 }
+
+void TaskGroup::wait()
+{
+	TaskDispatcher::waitForGroup(*this);
+}
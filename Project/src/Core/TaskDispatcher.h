@@ -1,7 +1,6 @@
 #pragma once
-#include "Spinlock.h"
+#include "Job.h"
 
-#include <queue>
 #include <mutex>
 #include <vector>
 #include <atomic>
@@ -11,47 +10,214 @@
 
 #define MAX_THREADS 16U
 
+//Pools are separate sets of workers, tasks only run on the pool they were submitted to unless a waiting thread helps out
+enum class ETaskPool : uint8_t
+{
+	//Work that a frame waits on, the workers are pinned to their own cores
+	FRAME		= 0,
+	//Asset loading and other long running or I/O bound work that nothing waits on within a frame
+	BACKGROUND	= 1,
+};
+
+#define TASK_POOL_COUNT 2U
+
+struct TaskPoolStats
+{
+	const char* pName;
+	uint32_t WorkerCount;
+	//Tasks that are queued or running right now
+	uint32_t QueueDepth;
+	//Highest queue depth since the last call to resetPeakQueueDepths
+	uint32_t PeakQueueDepth;
+	uint64_t CompletedTasks;
+};
+
+//Counts the unfinished tasks that were submitted with it, lets a caller wait for its own tasks only
+class TaskGroup
+{
+	friend class TaskDispatcher;
+
+public:
+	TaskGroup()
+		: m_PendingTasks(0)
+	{
+	}
+
+	~TaskGroup()
+	{
+		ASSERT(isFinished());
+	}
+
+	DECL_NO_COPY(TaskGroup);
+
+	//Blocks until all tasks in the group are done, the calling thread runs tasks from the group meanwhile
+	void wait();
+
+	FORCEINLINE bool isFinished() const
+	{
+		return m_PendingTasks.load() == 0;
+	}
+
+	FORCEINLINE uint32_t getPendingTaskCount() const
+	{
+		return m_PendingTasks.load();
+	}
+
+private:
+	std::atomic<uint32_t> m_PendingTasks;
+};
+
+//Timing of the chunks that a parallelFor was split into, times are in milliseconds
+struct ParallelForStats
+{
+	uint32_t ChunkCount		= 0;
+	bool RanInline			= false;
+	double MinChunkTime		= 0.0;
+	double MaxChunkTime		= 0.0;
+	double TotalChunkTime	= 0.0;
+};
+
 class TaskDispatcher
 {
+	struct ParallelForContext;
+
+	struct Task
+	{
+		Job Function;
+		TaskGroup* pGroup;
+	};
+
+	//Each worker owns a ring buffer, the owner pushes and pops at the back (LIFO) while other workers steal from the front (FIFO).
+	//The buffer only reallocates when it has to grow, so pushing and popping does not touch the heap
+	struct alignas(64) WorkerQueue
+	{
+		void reserve(uint32_t capacity);
+		void pushBack(Task&& task);
+		void popBack(Task& task);
+		void popFront(Task& task);
+		//Takes the newest task that belongs to the group from anywhere in the queue
+		bool popGroupTask(const TaskGroup* pGroup, Task& task);
+
+		FORCEINLINE Task&	front()			{ return Tasks[Head]; }
+		FORCEINLINE Task&	back()			{ return Tasks[(Head + Count - 1) & (uint32_t(Tasks.size()) - 1)]; }
+		FORCEINLINE bool	empty() const	{ return Count == 0; }
+
+		//Capacity is always a power of two
+		std::vector<Task> Tasks;
+		uint32_t Head	= 0;
+		uint32_t Count	= 0;
+		Spinlock Lock;
+	};
+
+	struct TaskPool
+	{
+		WorkerQueue Queues[MAX_THREADS];
+		std::vector<std::thread> Threads;
+		const char* pName;
+		uint32_t WorkerCount = 0;
+
+		//Round robin queue selection for tasks submitted from threads that are not workers in the pool
+		std::atomic<uint32_t> NextQueue			= 0;
+		std::atomic<uint32_t> PendingTasks		= 0;
+		std::atomic<uint32_t> PeakPendingTasks	= 0;
+		std::atomic<uint32_t> SleepingWorkers	= 0;
+		std::atomic<uint64_t> CompletedTasks	= 0;
+
+		std::mutex EventMutex;
+		std::condition_variable WakeCondition;
+	};
+
 public:
 	DECL_STATIC_CLASS(TaskDispatcher);
 
-	static bool init();
+	//Starts the worker pools, a count of zero picks one from the number of hardware threads. Counts are clamped to MAX_THREADS
+	static bool init(uint32_t frameThreads = 0, uint32_t backgroundThreads = 0);
 	static void release();
 
 	//Excutes a task in a seperate thread
-	static void execute(const std::function<void()>& task);
-	//Makes sure that all queued up tasks have been completed
+	static void execute(Job&& task, ETaskPool pool = ETaskPool::FRAME);
+	//Excutes a task in a seperate thread and adds it to group, returns the group so that it can be waited on
+	static TaskGroup& execute(Job&& task, TaskGroup& group, ETaskPool pool = ETaskPool::FRAME);
+	//Makes sure that all queued up tasks have been completed, including tasks that belong to groups
 	static void waitForTasks();
+	//Makes sure that all tasks in the group have been completed
+	static void waitForGroup(TaskGroup& group);
+
+	//Calls function(i) for every i in [begin, end). The range is split into chunks of grainSize elements while there are idle workers,
+	//a grainSize of zero picks one based on the worker count. Small ranges run inline on the calling thread.
+	//Chunks run on the pool of the calling worker, or on the frame pool when called from any other thread
+	template<typename Func>
+	static void parallelFor(uint32_t begin, uint32_t end, uint32_t grainSize, Func function, ParallelForStats* pStats = nullptr)
+	{
+		parallelForRange(begin, end, grainSize, [&function](uint32_t chunkBegin, uint32_t chunkEnd)
+			{
+				for (uint32_t i = chunkBegin; i < chunkEnd; i++)
+				{
+					function(i);
+				}
+			}, pStats);
+	}
+
+	//Same as parallelFor but function(chunkBegin, chunkEnd) is called once per chunk
+	template<typename Func>
+	static void parallelForRange(uint32_t begin, uint32_t end, uint32_t grainSize, Func function, ParallelForStats* pStats = nullptr)
+	{
+		//The function is only referenced while the loop runs, so it is passed along without being copied or type-erased into a heap object
+		parallelForRange(begin, end, grainSize, &function, [](void* pFunction, uint32_t chunkBegin, uint32_t chunkEnd)
+			{
+				(*reinterpret_cast<Func*>(pFunction))(chunkBegin, chunkEnd);
+			}, pStats);
+	}
 
 	static FORCEINLINE bool isFinished()
 	{
-		return (s_CurrentFence <= s_FinishedFence.load());
+		return (s_CurrentFence.load() <= s_FinishedFence.load());
 	}
 
 	static FORCEINLINE bool shouldRunWorker()
 	{
-		return s_RunWorkers;
+		return s_RunWorkers.load(std::memory_order_relaxed);
+	}
+
+	static FORCEINLINE uint32_t getWorkerCount(ETaskPool pool = ETaskPool::FRAME)
+	{
+		return s_Pools[uint32_t(pool)].WorkerCount;
 	}
 
+	static TaskPoolStats getPoolStats(ETaskPool pool);
+	static void resetPeakQueueDepths();
+
 private:
-	static bool poptask(std::function<void()>& task);
+	static FORCEINLINE TaskPool& getPool(ETaskPool pool)
+	{
+		return s_Pools[uint32_t(pool)];
+	}
+
+	static void pushTask(TaskPool& pool, Job&& function, TaskGroup* pGroup);
+	static bool popTask(TaskPool& pool, uint32_t workerIndex, Task& task);
+	//Steals from the front of the other workers' queues. If pGroup is not null only tasks from that group are taken, they are searched for
+	//through the whole of every queue including the thief's own, since a group task buried under other tasks could otherwise never be reached by its waiter
+	static bool stealTask(TaskPool& pool, uint32_t thiefIndex, Task& task, const TaskGroup* pGroup = nullptr);
+	//Used by waiting threads, looks in the calling worker's own pool first and then in the other pools
+	static bool findTask(Task& task, TaskPool*& pTaskPool, const TaskGroup* pGroup);
+	static void runTask(TaskPool& pool, Task& task);
+	static void parallelForRange(uint32_t begin, uint32_t end, uint32_t grainSize, void* pFunction, void(*pInvoke)(void*, uint32_t, uint32_t), ParallelForStats* pStats);
+	static void runParallelForChunks(ParallelForContext& context, uint32_t begin, uint32_t end);
 	static void poll();
 
-	static void taskThread();
+	static void startPool(ETaskPool poolType, const char* pName, uint32_t numThreads, bool pinToCores);
+	static void stopPool(TaskPool& pool);
+	static bool pinThreadToCore(std::thread& thread, uint32_t coreIndex);
+	static void taskThread(TaskPool* pPool, uint32_t workerIndex);
 
 private:
-	static std::vector<std::thread> s_Threads;
-
-	static std::queue<std::function<void()>> s_TaskQueue;
-	static Spinlock s_QueueLock;
-	
-	static std::mutex s_EventMutex;
-	static std::condition_variable s_WakeCondition;
-	
+	static TaskPool s_Pools[TASK_POOL_COUNT];
+	//The pool and queue of the calling thread, null and INVALID_WORKER_INDEX on threads that are not workers
+	static thread_local TaskPool* s_pWorkerPool;
+	static thread_local uint32_t s_WorkerIndex;
+
 	static std::atomic<uint64_t> s_FinishedFence;
-	static uint64_t s_CurrentFence;
-	
-	static bool s_RunWorkers;
-};
+	static std::atomic<uint64_t> s_CurrentFence;
 
+	static std::atomic<bool> s_RunWorkers;
+};
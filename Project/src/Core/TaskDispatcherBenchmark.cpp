@@ -0,0 +1,239 @@
+#include "TaskDispatcherBenchmark.h"
+#include "TaskDispatcher.h"
+
+#include <queue>
+#include <chrono>
+
+#define TINY_TASK_COUNT			100000U
+#define TINY_TASK_ITERATIONS	16U
+#define LARGE_TASK_COUNT		256U
+#define LARGE_TASK_ITERATIONS	200000U
+#define NESTED_ROOT_COUNT		64U
+#define NESTED_CHILD_COUNT		512U
+#define BENCHMARK_RUNS			3U
+
+//Copy of the previous TaskDispatcher (one global queue behind a spinlock) kept as a reference point.
+//The fence is atomic here so that the nested workload does not race, otherwise it behaves like the original
+class LockedQueueDispatcher
+{
+public:
+	DECL_STATIC_CLASS(LockedQueueDispatcher);
+
+	static void init(uint32_t numThreads)
+	{
+		s_RunWorkers = true;
+		for (uint32_t i = 0; i < numThreads; i++)
+		{
+			s_Threads.emplace_back(taskThread);
+		}
+	}
+
+	static void release()
+	{
+		waitForTasks();
+
+		s_RunWorkers = false;
+		s_WakeCondition.notify_all();
+		for (std::thread& thread : s_Threads)
+		{
+			thread.join();
+		}
+
+		s_Threads.clear();
+	}
+
+	static void execute(const std::function<void()>& task)
+	{
+		s_CurrentFence.fetch_add(1);
+
+		std::scoped_lock<Spinlock> lock(s_QueueLock);
+		s_TaskQueue.push(task);
+		s_WakeCondition.notify_one();
+	}
+
+	static void waitForTasks()
+	{
+		while (s_CurrentFence.load() > s_FinishedFence.load())
+		{
+			s_WakeCondition.notify_one();
+			std::this_thread::yield();
+		}
+	}
+
+private:
+	static void taskThread()
+	{
+		while (s_RunWorkers)
+		{
+			std::function<void()> task;
+			bool hasTask = false;
+			{
+				std::scoped_lock<Spinlock> lock(s_QueueLock);
+				if (!s_TaskQueue.empty())
+				{
+					task = s_TaskQueue.front();
+					s_TaskQueue.pop();
+					hasTask = true;
+				}
+			}
+
+			if (hasTask)
+			{
+				task();
+				s_FinishedFence.fetch_add(1);
+			}
+			else
+			{
+				//The timeout avoids the lost wakeup on shutdown that the original could run into
+				std::unique_lock<std::mutex> lock(s_EventMutex);
+				s_WakeCondition.wait_for(lock, std::chrono::milliseconds(1));
+			}
+		}
+	}
+
+private:
+	static std::vector<std::thread> s_Threads;
+	static std::queue<std::function<void()>> s_TaskQueue;
+	static Spinlock s_QueueLock;
+	static std::mutex s_EventMutex;
+	static std::condition_variable s_WakeCondition;
+	static std::atomic<uint64_t> s_FinishedFence;
+	static std::atomic<uint64_t> s_CurrentFence;
+	static std::atomic<bool> s_RunWorkers;
+};
+
+std::vector<std::thread>			LockedQueueDispatcher::s_Threads;
+std::queue<std::function<void()>>	LockedQueueDispatcher::s_TaskQueue;
+Spinlock							LockedQueueDispatcher::s_QueueLock;
+std::mutex							LockedQueueDispatcher::s_EventMutex;
+std::condition_variable				LockedQueueDispatcher::s_WakeCondition;
+std::atomic<uint64_t>				LockedQueueDispatcher::s_FinishedFence(0);
+std::atomic<uint64_t>				LockedQueueDispatcher::s_CurrentFence(0);
+std::atomic<bool>					LockedQueueDispatcher::s_RunWorkers(true);
+
+static std::atomic<uint64_t> g_BenchmarkSink(0);
+
+static void spin(uint32_t iterations)
+{
+	uint64_t value = iterations;
+	for (uint32_t i = 0; i < iterations; i++)
+	{
+		value = value * 6364136223846793005ULL + 1442695040888963407ULL;
+	}
+
+	g_BenchmarkSink.fetch_add(value, std::memory_order_relaxed);
+}
+
+template<typename Dispatcher>
+static void runTiny()
+{
+	for (uint32_t i = 0; i < TINY_TASK_COUNT; i++)
+	{
+		Dispatcher::execute([] { spin(TINY_TASK_ITERATIONS); });
+	}
+
+	Dispatcher::waitForTasks();
+}
+
+template<typename Dispatcher>
+static void runLarge()
+{
+	for (uint32_t i = 0; i < LARGE_TASK_COUNT; i++)
+	{
+		Dispatcher::execute([] { spin(LARGE_TASK_ITERATIONS); });
+	}
+
+	Dispatcher::waitForTasks();
+}
+
+//Tasks that fan out into more tasks, this is where submitting from the workers themselves matters
+template<typename Dispatcher>
+static void runNested()
+{
+	for (uint32_t i = 0; i < NESTED_ROOT_COUNT; i++)
+	{
+		Dispatcher::execute([]
+		{
+			for (uint32_t j = 0; j < NESTED_CHILD_COUNT; j++)
+			{
+				Dispatcher::execute([] { spin(TINY_TASK_ITERATIONS); });
+			}
+		});
+	}
+
+	Dispatcher::waitForTasks();
+}
+
+//Returns the best time out of BENCHMARK_RUNS in milliseconds
+template<typename Workload>
+static double measure(Workload workload)
+{
+	double bestTime = 0.0;
+	for (uint32_t run = 0; run < BENCHMARK_RUNS; run++)
+	{
+		auto startTime = std::chrono::high_resolution_clock::now();
+		workload();
+		std::chrono::duration<double, std::milli> time = std::chrono::high_resolution_clock::now() - startTime;
+
+		if (run == 0 || time.count() < bestTime)
+		{
+			bestTime = time.count();
+		}
+	}
+
+	return bestTime;
+}
+
+struct WorkStealingDispatcher
+{
+	static void init(uint32_t numThreads)					{ TaskDispatcher::init(numThreads); }
+	static void release()									{ TaskDispatcher::release(); }
+	static void execute(const std::function<void()>& task)	{ TaskDispatcher::execute(task); }
+	static void waitForTasks()								{ TaskDispatcher::waitForTasks(); }
+};
+
+struct BenchmarkResult
+{
+	double Tiny;
+	double Large;
+	double Nested;
+};
+
+template<typename Dispatcher>
+static BenchmarkResult benchmarkDispatcher(uint32_t numThreads)
+{
+	Dispatcher::init(numThreads);
+
+	BenchmarkResult result = {};
+	result.Tiny		= measure(runTiny<Dispatcher>);
+	result.Large	= measure(runLarge<Dispatcher>);
+	result.Nested	= measure(runNested<Dispatcher>);
+
+	Dispatcher::release();
+	return result;
+}
+
+void TaskDispatcherBenchmark::run()
+{
+	LOG("TaskDispatcherBenchmark: tiny=%u tasks, large=%u tasks, nested=%ux%u tasks, best of %u runs",
+		TINY_TASK_COUNT, LARGE_TASK_COUNT, NESTED_ROOT_COUNT, NESTED_CHILD_COUNT, BENCHMARK_RUNS);
+
+	BenchmarkResult results[2][MAX_THREADS + 1] = {};
+	std::vector<uint32_t> threadCounts;
+	for (uint32_t numThreads = 1; numThreads <= MAX_THREADS; numThreads *= 2)
+	{
+		threadCounts.push_back(numThreads);
+		results[0][numThreads] = benchmarkDispatcher<LockedQueueDispatcher>(numThreads);
+		results[1][numThreads] = benchmarkDispatcher<WorkStealingDispatcher>(numThreads);
+	}
+
+	LOG("%-8s | %-24s | %-24s | %-24s", "Workers", "Tiny ms (locked/steal)", "Large ms (locked/steal)", "Nested ms (locked/steal)");
+	for (uint32_t numThreads : threadCounts)
+	{
+		const BenchmarkResult& locked	= results[0][numThreads];
+		const BenchmarkResult& stealing	= results[1][numThreads];
+
+		LOG("%-8u | %10.2f / %-11.2f | %10.2f / %-11.2f | %10.2f / %-11.2f", numThreads,
+			locked.Tiny, stealing.Tiny, locked.Large, stealing.Large, locked.Nested, stealing.Nested);
+	}
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include "Core.h"
+
+//Measures how TaskDispatcher scales from 1 to MAX_THREADS workers and compares it against the old single locked queue
+class TaskDispatcherBenchmark
+{
+public:
+	DECL_STATIC_CLASS(TaskDispatcherBenchmark);
+
+	//Must be called while TaskDispatcher is not initialized, the dispatcher is started and released once per worker count
+	static void run();
+};
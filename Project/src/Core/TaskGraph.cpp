@@ -0,0 +1,149 @@
+#include "TaskGraph.h"
+
+#define INVALID_NODE_INDEX UINT32_MAX
+
+TaskGraph::TaskGraph()
+	: m_Nodes(),
+	m_Group(),
+	m_StartTime(),
+	m_NodeCount(0),
+	m_TotalTime(0.0),
+	m_CriticalPathTime(0.0)
+{
+}
+
+void TaskGraph::reset()
+{
+	ASSERT(m_Group.isFinished());
+
+	for (uint32_t i = 0; i < m_NodeCount; i++)
+	{
+		m_Nodes[i].Task.reset();
+	}
+
+	m_NodeCount = 0;
+}
+
+uint32_t TaskGraph::addNode(const char* pName, Job&& task, uint64_t inputs, uint64_t outputs)
+{
+	ASSERT(m_NodeCount < MAX_TASK_GRAPH_NODES);
+
+	const uint32_t nodeIndex = m_NodeCount++;
+	Node& node = m_Nodes[nodeIndex];
+	node.Task				= std::move(task);
+	node.pName				= pName;
+	node.Inputs				= inputs;
+	node.Outputs			= outputs;
+	node.DependentCount		= 0;
+	node.DependencyCount	= 0;
+	node.StartTime			= 0.0;
+	node.EndTime			= 0.0;
+	node.IsCritical			= false;
+
+	for (uint32_t i = 0; i < nodeIndex; i++)
+	{
+		Node& previous = m_Nodes[i];
+
+		//Read after write, write after write and write after read
+		const bool hasDependency = (previous.Outputs & inputs) || (previous.Outputs & outputs) || (previous.Inputs & outputs);
+		if (hasDependency)
+		{
+			previous.Dependents[previous.DependentCount++] = nodeIndex;
+			node.DependencyCount++;
+		}
+	}
+
+	return nodeIndex;
+}
+
+void TaskGraph::execute()
+{
+	if (m_NodeCount == 0)
+	{
+		return;
+	}
+
+	for (uint32_t i = 0; i < m_NodeCount; i++)
+	{
+		m_Nodes[i].RemainingDependencies	= m_Nodes[i].DependencyCount;
+		m_Nodes[i].CriticalDependency		= INVALID_NODE_INDEX;
+	}
+
+	m_StartTime = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < m_NodeCount; i++)
+	{
+		if (m_Nodes[i].DependencyCount == 0)
+		{
+			launchNode(i);
+		}
+	}
+
+	m_Group.wait();
+
+	std::chrono::duration<double, std::milli> totalTime = std::chrono::high_resolution_clock::now() - m_StartTime;
+	m_TotalTime = totalTime.count();
+
+	findCriticalPath();
+}
+
+void TaskGraph::launchNode(uint32_t nodeIndex)
+{
+	TaskDispatcher::execute([this, nodeIndex]
+		{
+			runNode(nodeIndex);
+		}, m_Group);
+}
+
+void TaskGraph::runNode(uint32_t nodeIndex)
+{
+	Node& node = m_Nodes[nodeIndex];
+
+	std::chrono::duration<double, std::milli> startTime = std::chrono::high_resolution_clock::now() - m_StartTime;
+	node.Task();
+	std::chrono::duration<double, std::milli> endTime = std::chrono::high_resolution_clock::now() - m_StartTime;
+
+	node.StartTime	= startTime.count();
+	node.EndTime	= endTime.count();
+
+	for (uint32_t i = 0; i < node.DependentCount; i++)
+	{
+		//The last dependency to finish is the one that starts the dependent
+		const uint32_t dependentIndex = node.Dependents[i];
+		if (m_Nodes[dependentIndex].RemainingDependencies.fetch_sub(1) == 1)
+		{
+			launchNode(dependentIndex);
+		}
+	}
+}
+
+void TaskGraph::findCriticalPath()
+{
+	//Nodes only depend on nodes added before them, so a single pass in order sees every dependency before its dependents
+	uint32_t lastNode = 0;
+	for (uint32_t i = 0; i < m_NodeCount; i++)
+	{
+		Node& node = m_Nodes[i];
+		node.IsCritical = false;
+
+		for (uint32_t j = 0; j < node.DependentCount; j++)
+		{
+			Node& dependent = m_Nodes[node.Dependents[j]];
+			if (dependent.CriticalDependency == INVALID_NODE_INDEX || m_Nodes[dependent.CriticalDependency].EndTime < node.EndTime)
+			{
+				dependent.CriticalDependency = i;
+			}
+		}
+
+		if (node.EndTime > m_Nodes[lastNode].EndTime)
+		{
+			lastNode = i;
+		}
+	}
+
+	m_CriticalPathTime = 0.0;
+	for (uint32_t nodeIndex = lastNode; nodeIndex != INVALID_NODE_INDEX; nodeIndex = m_Nodes[nodeIndex].CriticalDependency)
+	{
+		m_Nodes[nodeIndex].IsCritical = true;
+		m_CriticalPathTime += getNodeDuration(nodeIndex);
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "TaskDispatcher.h"
+
+#include <chrono>
+
+#define MAX_TASK_GRAPH_NODES 32U
+
+//Tasks ordered by the resources they read and write. Resources are bits in a 64-bit mask that the user of the graph defines.
+//A node depends on every earlier node that writes one of its inputs or reads or writes one of its outputs
+class TaskGraph
+{
+	struct Node
+	{
+		Job Task;
+		const char* pName;
+		uint64_t Inputs;
+		uint64_t Outputs;
+		uint32_t Dependents[MAX_TASK_GRAPH_NODES];
+		uint32_t DependentCount;
+		uint32_t DependencyCount;
+		std::atomic<uint32_t> RemainingDependencies;
+		//The dependency that finished last, used to trace the critical path
+		uint32_t CriticalDependency;
+		//Milliseconds since the graph started executing
+		double StartTime;
+		double EndTime;
+		bool IsCritical;
+	};
+
+public:
+	TaskGraph();
+	~TaskGraph() = default;
+
+	DECL_NO_COPY(TaskGraph);
+
+	//Removes all nodes, the results of the last execution are kept until the next execute
+	void reset();
+	//Nodes have to be added in the order they would run in serially, returns the index of the node
+	uint32_t addNode(const char* pName, Job&& task, uint64_t inputs, uint64_t outputs);
+	//Starts every node as soon as its dependencies are done and blocks until all nodes have finished
+	void execute();
+
+	FORCEINLINE uint32_t	getNodeCount() const							{ return m_NodeCount; }
+	FORCEINLINE const char*	getNodeName(uint32_t nodeIndex) const			{ return m_Nodes[nodeIndex].pName; }
+	FORCEINLINE double		getNodeStartTime(uint32_t nodeIndex) const		{ return m_Nodes[nodeIndex].StartTime; }
+	FORCEINLINE double		getNodeDuration(uint32_t nodeIndex) const		{ return m_Nodes[nodeIndex].EndTime - m_Nodes[nodeIndex].StartTime; }
+	FORCEINLINE bool		isOnCriticalPath(uint32_t nodeIndex) const		{ return m_Nodes[nodeIndex].IsCritical; }
+	//Wall time of the last execution in milliseconds
+	FORCEINLINE double		getTotalTime() const							{ return m_TotalTime; }
+	//Time spent running the nodes on the critical path, the rest of the total time is scheduling latency
+	FORCEINLINE double		getCriticalPathTime() const						{ return m_CriticalPathTime; }
+
+private:
+	void launchNode(uint32_t nodeIndex);
+	void runNode(uint32_t nodeIndex);
+	void findCriticalPath();
+
+private:
+	Node m_Nodes[MAX_TASK_GRAPH_NODES];
+	TaskGroup m_Group;
+	std::chrono::high_resolution_clock::time_point m_StartTime;
+	uint32_t m_NodeCount;
+	double m_TotalTime;
+	double m_CriticalPathTime;
+};
@@ -0,0 +1,430 @@
+#include "TextureCache.h"
+#include "TaskDispatcher.h"
+#include "BlockCompression.h"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+
+#include "stb_image.h"
+
+//"VBTX" in little endian
+#define TEXTURE_CACHE_MAGIC		0x58544256U
+//Has to be increased whenever the file layout, the mip filtering or the encoders change
+#define TEXTURE_CACHE_VERSION	1U
+#define TEXTURE_CACHE_ALIGNMENT	16U
+
+struct TextureCacheHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint64_t SourceTimestamp;
+	uint64_t SourceSizeInBytes;
+	uint64_t SourceHash;
+	uint32_t Compression;
+	uint32_t Format;
+	uint32_t Width;
+	uint32_t Height;
+	uint32_t MiplevelCount;
+	uint32_t Padding;
+	uint64_t DataOffset;
+	uint64_t DataSizeInBytes;
+	uint64_t MiplevelOffsets[TEXTURE_CACHE_MAX_MIPLEVELS];
+};
+
+std::atomic<uint32_t> TextureCache::s_TextureCount(0);
+std::atomic<uint64_t> TextureCache::s_CompressedSizeInBytes(0);
+std::atomic<uint64_t> TextureCache::s_UncompressedSizeInBytes(0);
+
+static uint32_t calculateMiplevelCount(uint32_t width, uint32_t height)
+{
+	return uint32_t(std::floor(std::log2(std::max(width, height)))) + 1u;
+}
+
+//Box filters an RGBA8 image to half its size. Normals are averaged as vectors and renormalized so that the lower miplevels do not flatten out
+static void downsample(const uint8_t* pSource, uint32_t width, uint32_t height, bool isNormalMap, std::vector<uint8_t>& destination)
+{
+	const uint32_t destinationWidth		= std::max(width / 2U, 1U);
+	const uint32_t destinationHeight	= std::max(height / 2U, 1U);
+	destination.resize(size_t(destinationWidth) * destinationHeight * 4);
+
+	for (uint32_t y = 0; y < destinationHeight; y++)
+	{
+		const uint32_t y0 = std::min(y * 2, height - 1);
+		const uint32_t y1 = std::min(y * 2 + 1, height - 1);
+		for (uint32_t x = 0; x < destinationWidth; x++)
+		{
+			const uint32_t x0 = std::min(x * 2, width - 1);
+			const uint32_t x1 = std::min(x * 2 + 1, width - 1);
+
+			const uint8_t* pTexels[4] =
+			{
+				pSource + (size_t(y0) * width + x0) * 4,
+				pSource + (size_t(y0) * width + x1) * 4,
+				pSource + (size_t(y1) * width + x0) * 4,
+				pSource + (size_t(y1) * width + x1) * 4
+			};
+
+			uint8_t* pDestination = destination.data() + (size_t(y) * destinationWidth + x) * 4;
+			if (isNormalMap)
+			{
+				glm::vec3 normal = glm::vec3(0.0f);
+				for (const uint8_t* pTexel : pTexels)
+				{
+					normal += glm::vec3(pTexel[0], pTexel[1], pTexel[2]) * (2.0f / 255.0f) - 1.0f;
+				}
+
+				const float length = glm::length(normal);
+				normal = (length > 1e-6f) ? (normal / length) : glm::vec3(0.0f, 0.0f, 1.0f);
+				normal = (normal * 0.5f + 0.5f) * 255.0f + 0.5f;
+
+				pDestination[0] = uint8_t(normal.x);
+				pDestination[1] = uint8_t(normal.y);
+				pDestination[2] = uint8_t(normal.z);
+				pDestination[3] = 255;
+			}
+			else
+			{
+				for (uint32_t c = 0; c < 4; c++)
+				{
+					pDestination[c] = uint8_t((uint32_t(pTexels[0][c]) + pTexels[1][c] + pTexels[2][c] + pTexels[3][c] + 2) / 4);
+				}
+			}
+		}
+	}
+}
+
+static uint64_t alignOffset(uint64_t offset)
+{
+	return (offset + TEXTURE_CACHE_ALIGNMENT - 1) & ~uint64_t(TEXTURE_CACHE_ALIGNMENT - 1);
+}
+
+TextureCache::TextureCache()
+	: m_File(),
+	m_ArchivedFile(),
+	m_ImportedData(),
+	m_pData(nullptr),
+	m_SizeInBytes(0),
+	m_MiplevelOffsets(),
+	m_MiplevelCount(0),
+	m_Width(0),
+	m_Height(0),
+	m_Format(ETextureFormat::FORMAT_NONE)
+{
+}
+
+bool TextureCache::load(const std::string& filepath, ETextureCompression compression)
+{
+	release();
+
+	if (compression == ETextureCompression::NONE)
+	{
+		LOG("-- TextureCache: '%s' has to be loaded with a compression", filepath.c_str());
+		return false;
+	}
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	//Archived caches were built from the images that were packed with them, so they are used without looking at the source
+	if (loadArchivedCacheFile(filepath, compression))
+	{
+		std::chrono::duration<double, std::milli> loadTime = std::chrono::high_resolution_clock::now() - startTime;
+		LOG("-- TextureCache: Loaded '%s' from archive in %.2f ms", filepath.c_str(), loadTime.count());
+		addToVRAMReport();
+		return true;
+	}
+
+	SourceFileInfo source = {};
+	const bool hasSourceFile = SourceFile::getInfo(filepath, source);
+	if (!hasSourceFile && !AssetArchive::contains(filepath))
+	{
+		LOG("-- TextureCache: Failed to find '%s'", filepath.c_str());
+		return false;
+	}
+
+	if (hasSourceFile && loadCacheFile(filepath, compression, source))
+	{
+		std::chrono::duration<double, std::milli> loadTime = std::chrono::high_resolution_clock::now() - startTime;
+		LOG("-- TextureCache: Loaded '%s' from cache in %.2f ms", filepath.c_str(), loadTime.count());
+		addToVRAMReport();
+		return true;
+	}
+
+	if (!importImage(filepath, compression))
+	{
+		return false;
+	}
+
+	std::chrono::duration<double, std::milli> importTime = std::chrono::high_resolution_clock::now() - startTime;
+	LOG("-- TextureCache: Imported '%s' in %.2f ms", filepath.c_str(), importTime.count());
+	addToVRAMReport();
+	return true;
+}
+
+void TextureCache::release()
+{
+	m_File.close();
+	m_ArchivedFile.release();
+	m_ImportedData.clear();
+
+	m_pData			= nullptr;
+	m_SizeInBytes	= 0;
+	m_MiplevelCount	= 0;
+	m_Width			= 0;
+	m_Height		= 0;
+	m_Format		= ETextureFormat::FORMAT_NONE;
+}
+
+ETextureFormat TextureCache::getCompressedFormat(ETextureCompression compression)
+{
+	switch (compression)
+	{
+	case ETextureCompression::COLOR:			return ETextureFormat::FORMAT_BC1_RGB_UNORM;
+	case ETextureCompression::NORMAL_MAP:		return ETextureFormat::FORMAT_BC5_UNORM;
+	case ETextureCompression::SINGLE_CHANNEL:	return ETextureFormat::FORMAT_BC4_UNORM;
+	}
+
+	return ETextureFormat::FORMAT_NONE;
+}
+
+std::string TextureCache::getCacheFilepath(const std::string& filepath)
+{
+	return filepath + TEXTURE_CACHE_EXTENSION;
+}
+
+void TextureCache::logVRAMReport()
+{
+	const double compressedMB	= double(s_CompressedSizeInBytes) / double(MB(1));
+	const double uncompressedMB	= double(s_UncompressedSizeInBytes) / double(MB(1));
+	LOG("-- TextureCache: %u textures use %.2f MB of VRAM instead of %.2f MB as RGBA8, %.2f MB saved", s_TextureCount.load(), compressedMB, uncompressedMB, uncompressedMB - compressedMB);
+}
+
+//Returns the header if the file is a valid cache file for compression
+static const TextureCacheHeader* getValidHeader(const uint8_t* pData, uint64_t fileSize, ETextureCompression compression)
+{
+	const TextureCacheHeader* pHeader = reinterpret_cast<const TextureCacheHeader*>(pData);
+	bool isValid = fileSize >= sizeof(TextureCacheHeader) &&
+		pHeader->Magic			== TEXTURE_CACHE_MAGIC &&
+		pHeader->Version		== TEXTURE_CACHE_VERSION &&
+		pHeader->Compression	== uint32_t(compression) &&
+		pHeader->Format			== uint32_t(TextureCache::getCompressedFormat(compression)) &&
+		pHeader->Width			> 0 &&
+		pHeader->Height			> 0 &&
+		pHeader->MiplevelCount	== calculateMiplevelCount(pHeader->Width, pHeader->Height) &&
+		pHeader->MiplevelCount	<= TEXTURE_CACHE_MAX_MIPLEVELS &&
+		pHeader->DataOffset		+ pHeader->DataSizeInBytes <= fileSize;
+
+	//Every miplevel has to fit inside the data
+	for (uint32_t i = 0; isValid && i < pHeader->MiplevelCount; i++)
+	{
+		const uint64_t miplevelSize = BlockCompression::getCompressedSize(ETextureFormat(pHeader->Format), std::max(pHeader->Width >> i, 1U), std::max(pHeader->Height >> i, 1U));
+		isValid = pHeader->MiplevelOffsets[i] + miplevelSize <= pHeader->DataSizeInBytes;
+	}
+
+	return isValid ? pHeader : nullptr;
+}
+
+bool TextureCache::loadCacheFile(const std::string& filepath, ETextureCompression compression, const SourceFileInfo& source)
+{
+	const std::string cacheFilepath = getCacheFilepath(filepath);
+	if (!m_File.open(cacheFilepath))
+	{
+		return false;
+	}
+
+	const uint8_t* pData = reinterpret_cast<const uint8_t*>(m_File.getData());
+	const TextureCacheHeader* pHeader = getValidHeader(pData, m_File.getSizeInBytes(), compression);
+	if (!pHeader)
+	{
+		LOG("-- TextureCache: '%s' is not a valid cache file, importing again", cacheFilepath.c_str());
+		m_File.close();
+		return false;
+	}
+
+	const SourceFileInfo cachedSource = { pHeader->SourceTimestamp, pHeader->SourceSizeInBytes };
+	if (!SourceFile::isUnchanged(filepath, source, cachedSource, pHeader->SourceHash))
+	{
+		LOG("-- TextureCache: '%s' is out of date", cacheFilepath.c_str());
+		m_File.close();
+		return false;
+	}
+
+	setCacheData(pData, pHeader);
+	return true;
+}
+
+bool TextureCache::loadArchivedCacheFile(const std::string& filepath, ETextureCompression compression)
+{
+	const std::string cacheFilepath = getCacheFilepath(filepath);
+	if (!AssetArchive::read(cacheFilepath, m_ArchivedFile))
+	{
+		return false;
+	}
+
+	const TextureCacheHeader* pHeader = getValidHeader(m_ArchivedFile.getData(), m_ArchivedFile.getSizeInBytes(), compression);
+	if (!pHeader)
+	{
+		LOG("-- TextureCache: '%s' in the archive is not a valid cache file", cacheFilepath.c_str());
+		m_ArchivedFile.release();
+		return false;
+	}
+
+	setCacheData(m_ArchivedFile.getData(), pHeader);
+	return true;
+}
+
+void TextureCache::setCacheData(const uint8_t* pFileData, const void* pCacheHeader)
+{
+	const TextureCacheHeader* pHeader = reinterpret_cast<const TextureCacheHeader*>(pCacheHeader);
+	m_pData			= pFileData + pHeader->DataOffset;
+	m_SizeInBytes	= pHeader->DataSizeInBytes;
+	m_MiplevelCount	= pHeader->MiplevelCount;
+	m_Width			= pHeader->Width;
+	m_Height		= pHeader->Height;
+	m_Format		= ETextureFormat(pHeader->Format);
+	memcpy(m_MiplevelOffsets, pHeader->MiplevelOffsets, sizeof(m_MiplevelOffsets));
+}
+
+bool TextureCache::importImage(const std::string& filepath, ETextureCompression compression)
+{
+	int width	= 0;
+	int height	= 0;
+	int bpp		= 0;
+
+	//Archived images are decoded straight from the archive
+	AssetView view;
+	uint8_t* pPixels = nullptr;
+	if (AssetArchive::read(filepath, view))
+	{
+		pPixels = stbi_load_from_memory(view.getData(), int(view.getSizeInBytes()), &width, &height, &bpp, STBI_rgb_alpha);
+	}
+	else
+	{
+		pPixels = stbi_load(filepath.c_str(), &width, &height, &bpp, STBI_rgb_alpha);
+	}
+
+	if (pPixels == nullptr)
+	{
+		LOG("-- TextureCache: Failed to load '%s'", filepath.c_str());
+		return false;
+	}
+
+	m_Width			= uint32_t(width);
+	m_Height		= uint32_t(height);
+	m_Format		= getCompressedFormat(compression);
+	m_MiplevelCount	= calculateMiplevelCount(m_Width, m_Height);
+	if (m_MiplevelCount > TEXTURE_CACHE_MAX_MIPLEVELS)
+	{
+		LOG("-- TextureCache: '%s' is too large", filepath.c_str());
+		stbi_image_free(pPixels);
+		return false;
+	}
+
+	uint64_t sizeInBytes = 0;
+	for (uint32_t i = 0; i < m_MiplevelCount; i++)
+	{
+		m_MiplevelOffsets[i] = sizeInBytes;
+		sizeInBytes = alignOffset(sizeInBytes + BlockCompression::getCompressedSize(m_Format, std::max(m_Width >> i, 1U), std::max(m_Height >> i, 1U)));
+	}
+
+	m_ImportedData.resize(size_t(sizeInBytes));
+	m_pData			= m_ImportedData.data();
+	m_SizeInBytes	= sizeInBytes;
+
+	//Each miplevel is filtered from the one above it and its block rows are compressed in parallel on the calling thread's pool
+	const bool isNormalMap = (compression == ETextureCompression::NORMAL_MAP);
+	std::vector<uint8_t> miplevels[2];
+	const uint8_t* pMiplevel = pPixels;
+	for (uint32_t i = 0; i < m_MiplevelCount; i++)
+	{
+		const uint32_t miplevelWidth	= std::max(m_Width >> i, 1U);
+		const uint32_t miplevelHeight	= std::max(m_Height >> i, 1U);
+		if (i > 0)
+		{
+			std::vector<uint8_t>& destination = miplevels[i % 2];
+			downsample(pMiplevel, std::max(m_Width >> (i - 1), 1U), std::max(m_Height >> (i - 1), 1U), isNormalMap, destination);
+			pMiplevel = destination.data();
+		}
+
+		uint8_t* pDestination = m_ImportedData.data() + m_MiplevelOffsets[i];
+		TaskDispatcher::parallelForRange(0, BlockCompression::getBlockRowCount(miplevelHeight), 0, [&](uint32_t begin, uint32_t end)
+			{
+				BlockCompression::compressBlockRows(pMiplevel, miplevelWidth, miplevelHeight, m_Format, begin, end, pDestination);
+			});
+	}
+
+	stbi_image_free(pPixels);
+
+	//Images that only exist in the archive are not cached, the archive should be packed after the caches have been built
+	SourceFileInfo source = {};
+	if (!SourceFile::getInfo(filepath, source))
+	{
+		return true;
+	}
+
+	//Not being able to write the cache only makes the next start slower
+	uint64_t sourceHash = 0;
+	if (!SourceFile::hash(filepath, sourceHash) || !writeCacheFile(filepath, compression, source, sourceHash))
+	{
+		LOG("-- TextureCache: Failed to write cache file for '%s'", filepath.c_str());
+	}
+
+	return true;
+}
+
+bool TextureCache::writeCacheFile(const std::string& filepath, ETextureCompression compression, const SourceFileInfo& source, uint64_t sourceHash) const
+{
+	TextureCacheHeader header = {};
+	header.Magic				= TEXTURE_CACHE_MAGIC;
+	header.Version				= TEXTURE_CACHE_VERSION;
+	header.SourceTimestamp		= source.Timestamp;
+	header.SourceSizeInBytes	= source.SizeInBytes;
+	header.SourceHash			= sourceHash;
+	header.Compression			= uint32_t(compression);
+	header.Format				= uint32_t(m_Format);
+	header.Width				= m_Width;
+	header.Height				= m_Height;
+	header.MiplevelCount		= m_MiplevelCount;
+	header.DataOffset			= alignOffset(sizeof(TextureCacheHeader));
+	header.DataSizeInBytes		= m_SizeInBytes;
+	memcpy(header.MiplevelOffsets, m_MiplevelOffsets, sizeof(m_MiplevelOffsets));
+
+	//Write to a temporary file first so that a cache file is never seen half written
+	const std::string cacheFilepath		= getCacheFilepath(filepath);
+	const std::string temporaryFilepath	= cacheFilepath + ".tmp";
+	{
+		std::ofstream file(temporaryFilepath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		const char padding[TEXTURE_CACHE_ALIGNMENT] = {};
+		file.write(reinterpret_cast<const char*>(&header), sizeof(TextureCacheHeader));
+		file.write(padding, std::streamsize(header.DataOffset - sizeof(TextureCacheHeader)));
+		file.write(reinterpret_cast<const char*>(m_pData), std::streamsize(m_SizeInBytes));
+
+		if (!file.good())
+		{
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporaryFilepath, cacheFilepath, error);
+	return !error;
+}
+
+void TextureCache::addToVRAMReport() const
+{
+	uint64_t uncompressedSizeInBytes = 0;
+	for (uint32_t i = 0; i < m_MiplevelCount; i++)
+	{
+		uncompressedSizeInBytes += uint64_t(std::max(m_Width >> i, 1U)) * std::max(m_Height >> i, 1U) * textureFormatStride(ETextureFormat::FORMAT_R8G8B8A8_UNORM);
+	}
+
+	s_TextureCount++;
+	s_CompressedSizeInBytes		+= m_SizeInBytes;
+	s_UncompressedSizeInBytes	+= uncompressedSizeInBytes;
+}
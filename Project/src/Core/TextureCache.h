@@ -0,0 +1,74 @@
+#pragma once
+#include "Core.h"
+#include "MappedFile.h"
+#include "AssetArchive.h"
+#include "SourceFile.h"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#define TEXTURE_CACHE_EXTENSION			".vbtex"
+#define TEXTURE_CACHE_MAX_MIPLEVELS		16U
+
+//Block compressed mip chain of an image file. The first load decodes and compresses the image and writes a cache file next to it,
+//later loads map the cache file so the miplevels can be uploaded without decoding anything on the CPU
+class TextureCache
+{
+public:
+	TextureCache();
+	~TextureCache() = default;
+
+	DECL_NO_COPY(TextureCache);
+
+	bool load(const std::string& filepath, ETextureCompression compression);
+	//Pointers returned by the getters are invalid after this
+	void release();
+
+	//The miplevels are stored one after another, the offsets are relative to getData()
+	FORCEINLINE const uint8_t*	getData() const								{ return m_pData; }
+	FORCEINLINE uint64_t		getSizeInBytes() const						{ return m_SizeInBytes; }
+	FORCEINLINE uint64_t		getMiplevelOffset(uint32_t miplevel) const	{ return m_MiplevelOffsets[miplevel]; }
+	FORCEINLINE const uint64_t*	getMiplevelOffsets() const					{ return m_MiplevelOffsets; }
+	FORCEINLINE uint32_t		getMiplevelCount() const					{ return m_MiplevelCount; }
+	//Size of the first miplevelCount miplevels
+	FORCEINLINE uint64_t		getMiplevelsSizeInBytes(uint32_t miplevelCount) const	{ return (miplevelCount < m_MiplevelCount) ? m_MiplevelOffsets[miplevelCount] : m_SizeInBytes; }
+	FORCEINLINE uint32_t		getWidth() const							{ return m_Width; }
+	FORCEINLINE uint32_t		getHeight() const							{ return m_Height; }
+	FORCEINLINE ETextureFormat	getFormat() const							{ return m_Format; }
+	FORCEINLINE bool			isLoadedFromCache() const					{ return m_File.isOpen() || m_ArchivedFile.isValid(); }
+
+	static ETextureFormat getCompressedFormat(ETextureCompression compression);
+	static std::string getCacheFilepath(const std::string& filepath);
+
+	//Logs the VRAM used by all textures loaded so far compared to storing them as RGBA8 with full mip chains
+	static void logVRAMReport();
+
+private:
+	bool loadCacheFile(const std::string& filepath, ETextureCompression compression, const SourceFileInfo& source);
+	bool loadArchivedCacheFile(const std::string& filepath, ETextureCompression compression);
+	void setCacheData(const uint8_t* pFileData, const void* pHeader);
+	bool importImage(const std::string& filepath, ETextureCompression compression);
+	bool writeCacheFile(const std::string& filepath, ETextureCompression compression, const SourceFileInfo& source, uint64_t sourceHash) const;
+
+	void addToVRAMReport() const;
+
+private:
+	MappedFile m_File;
+	AssetView m_ArchivedFile;
+
+	//Only used when the image had to be imported
+	std::vector<uint8_t> m_ImportedData;
+
+	const uint8_t* m_pData;
+	uint64_t m_SizeInBytes;
+	uint64_t m_MiplevelOffsets[TEXTURE_CACHE_MAX_MIPLEVELS];
+	uint32_t m_MiplevelCount;
+	uint32_t m_Width;
+	uint32_t m_Height;
+	ETextureFormat m_Format;
+
+	static std::atomic<uint32_t> s_TextureCount;
+	static std::atomic<uint64_t> s_CompressedSizeInBytes;
+	static std::atomic<uint64_t> s_UncompressedSizeInBytes;
+};
@@ -0,0 +1,134 @@
+#include "VertexWelder.h"
+#include "Hash.h"
+
+#include <cstring>
+#include <algorithm>
+
+#define EMPTY_SLOT UINT32_MAX
+#define MIN_WELDER_CAPACITY 64U
+
+//Number of 32-bit words in a vertex when the padding is left out
+#define PACKED_VERTEX_WORDS 11U
+
+static FORCEINLINE uint32_t floatBits(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(float));
+
+	//Vertex::operator== treats -0 and +0 as equal so they have to hash the same
+	return (bits == 0x80000000U) ? 0U : bits;
+}
+
+static FORCEINLINE uint32_t nextPowerOfTwo(uint32_t value)
+{
+	uint32_t powerOfTwo = 1;
+	while (powerOfTwo < value)
+	{
+		powerOfTwo <<= 1;
+	}
+
+	return powerOfTwo;
+}
+
+VertexWelder::VertexWelder()
+	: m_Slots(),
+	m_Mask(0),
+	m_VertexCount(0),
+	m_MaxVertexCount(0)
+{
+}
+
+void VertexWelder::reset(uint32_t maxVertexCount)
+{
+	//Keep the table at most half full so that probe sequences stay short
+	const uint32_t capacity = nextPowerOfTwo(std::max(MIN_WELDER_CAPACITY, maxVertexCount * 2));
+	if (m_Slots.size() < capacity)
+	{
+		m_Slots.resize(capacity);
+	}
+
+	//Only the part of the table that this mesh uses has to be cleared
+	std::fill(m_Slots.begin(), m_Slots.begin() + capacity, Slot{ 0, EMPTY_SLOT });
+
+	m_Mask				= capacity - 1;
+	m_VertexCount		= 0;
+	m_MaxVertexCount	= capacity / 2;
+}
+
+uint32_t VertexWelder::weld(const Vertex& vertex, std::vector<Vertex>& vertices)
+{
+	if (m_VertexCount >= m_MaxVertexCount)
+	{
+		grow();
+	}
+
+	const uint32_t vertexHash = uint32_t(hash(vertex));
+	for (uint32_t slotIndex = vertexHash & m_Mask; ; slotIndex = (slotIndex + 1) & m_Mask)
+	{
+		Slot& slot = m_Slots[slotIndex];
+		if (slot.VertexIndex == EMPTY_SLOT)
+		{
+			slot.Hash			= vertexHash;
+			slot.VertexIndex	= uint32_t(vertices.size());
+			vertices.push_back(vertex);
+
+			m_VertexCount++;
+			return slot.VertexIndex;
+		}
+		else if (slot.Hash == vertexHash && vertices[slot.VertexIndex] == vertex)
+		{
+			return slot.VertexIndex;
+		}
+	}
+}
+
+uint64_t VertexWelder::hash(const Vertex& vertex)
+{
+	const uint32_t words[PACKED_VERTEX_WORDS] =
+	{
+		floatBits(vertex.Position.x),	floatBits(vertex.Position.y),	floatBits(vertex.Position.z),
+		floatBits(vertex.Normal.x),		floatBits(vertex.Normal.y),		floatBits(vertex.Normal.z),
+		floatBits(vertex.Tangent.x),	floatBits(vertex.Tangent.y),	floatBits(vertex.Tangent.z),
+		floatBits(vertex.TexCoord.x),	floatBits(vertex.TexCoord.y)
+	};
+
+	return hashMemory(words, sizeof(words));
+}
+
+void VertexWelder::grow()
+{
+	//Only happens when reset was given too small a count, the stored hashes are enough to move the slots
+	const uint32_t oldCapacity = m_Mask + 1;
+	std::vector<Slot> oldSlots(m_Slots.begin(), m_Slots.begin() + oldCapacity);
+
+	const uint32_t capacity = oldCapacity * 2;
+	if (m_Slots.size() < capacity)
+	{
+		m_Slots.resize(capacity);
+	}
+
+	std::fill(m_Slots.begin(), m_Slots.begin() + capacity, Slot{ 0, EMPTY_SLOT });
+	m_Mask				= capacity - 1;
+	m_MaxVertexCount	= capacity / 2;
+
+	for (const Slot& oldSlot : oldSlots)
+	{
+		if (oldSlot.VertexIndex == EMPTY_SLOT)
+		{
+			continue;
+		}
+
+		uint32_t slotIndex = oldSlot.Hash & m_Mask;
+		while (m_Slots[slotIndex].VertexIndex != EMPTY_SLOT)
+		{
+			slotIndex = (slotIndex + 1) & m_Mask;
+		}
+
+		m_Slots[slotIndex] = oldSlot;
+	}
+}
+
+size_t std::hash<Vertex>::operator()(Vertex const& vertex) const
+{
+	return size_t(VertexWelder::hash(vertex));
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "Core.h"
+
+#include <vector>
+
+//Open addressing hash table that removes duplicate vertices while building an index buffer.
+//The table is a flat array that is kept between meshes, so welding one mesh after another does not allocate once it has grown to the largest mesh
+class VertexWelder
+{
+	struct Slot
+	{
+		uint32_t Hash;
+		uint32_t VertexIndex;
+	};
+
+public:
+	VertexWelder();
+	~VertexWelder() = default;
+
+	DECL_NO_COPY(VertexWelder);
+
+	//Forgets all welded vertices and sizes the table for a mesh with at most maxVertexCount unique vertices, usually the index count
+	void reset(uint32_t maxVertexCount);
+	//Returns the index of vertex in vertices, the vertex is appended if no equal vertex has been welded since the last reset
+	uint32_t weld(const Vertex& vertex, std::vector<Vertex>& vertices);
+
+	//Hash over the attribute bytes without the padding between them
+	static uint64_t hash(const Vertex& vertex);
+
+private:
+	void grow();
+
+private:
+	std::vector<Slot> m_Slots;
+	uint32_t m_Mask;
+	uint32_t m_VertexCount;
+	uint32_t m_MaxVertexCount;
+};
@@ -0,0 +1,150 @@
+#include "VertexWelderBenchmark.h"
+#include "VertexWelder.h"
+
+#include <chrono>
+#include <vector>
+#include <unordered_map>
+#include <tinyobjloader/tiny_obj_loader.h>
+
+#define WELDER_BENCHMARK_RUNS 5U
+
+//The hash that std::hash<Vertex> used before VertexWelder, it ignores the tangent and folds the glm hashes together with xor
+struct LegacyVertexHash
+{
+	size_t operator()(const Vertex& vertex) const
+	{
+		return
+			((std::hash<glm::vec3>()(vertex.Position) ^
+			(std::hash<glm::vec3>()(vertex.Normal) << 1)) >> 1) ^
+			(std::hash<glm::vec2>()(vertex.TexCoord) << 1);
+	}
+};
+
+struct WeldResult
+{
+	std::vector<Vertex> Vertices;
+	std::vector<uint32_t> Indices;
+};
+
+//Expands the OBJ into one vertex per index, the same way MeshVK::initFromFile builds its vertices before welding
+static bool loadVertexStream(const char* pFilepath, std::vector<Vertex>& vertexStream)
+{
+	tinyobj::attrib_t attributes;
+	std::vector<tinyobj::shape_t> shapes;
+	std::vector<tinyobj::material_t> materials;
+	std::string warn, err;
+
+	if (!tinyobj::LoadObj(&attributes, &shapes, &materials, &warn, &err, pFilepath, nullptr, true, false))
+	{
+		return false;
+	}
+
+	for (const tinyobj::shape_t& shape : shapes)
+	{
+		for (const tinyobj::index_t& index : shape.mesh.indices)
+		{
+			Vertex vertex = {};
+			vertex.Position = glm::vec3(attributes.vertices[3 * (size_t)index.vertex_index + 0], attributes.vertices[3 * (size_t)index.vertex_index + 1], attributes.vertices[3 * (size_t)index.vertex_index + 2]);
+
+			if (index.normal_index >= 0)
+			{
+				vertex.Normal = glm::vec3(attributes.normals[3 * (size_t)index.normal_index + 0], attributes.normals[3 * (size_t)index.normal_index + 1], attributes.normals[3 * (size_t)index.normal_index + 2]);
+			}
+
+			if (index.texcoord_index >= 0)
+			{
+				vertex.TexCoord = glm::vec2(attributes.texcoords[2 * (size_t)index.texcoord_index + 0], 1.0f - attributes.texcoords[2 * (size_t)index.texcoord_index + 1]);
+			}
+
+			vertexStream.push_back(vertex);
+		}
+	}
+
+	return true;
+}
+
+static void weldWithMap(const std::vector<Vertex>& vertexStream, WeldResult& result)
+{
+	std::unordered_map<Vertex, uint32_t, LegacyVertexHash> uniqueVertices = {};
+	for (const Vertex& vertex : vertexStream)
+	{
+		if (uniqueVertices.count(vertex) == 0)
+		{
+			uniqueVertices[vertex] = static_cast<uint32_t>(result.Vertices.size());
+			result.Vertices.push_back(vertex);
+		}
+
+		result.Indices.push_back(uniqueVertices[vertex]);
+	}
+}
+
+static void weldWithWelder(const std::vector<Vertex>& vertexStream, VertexWelder& welder, WeldResult& result)
+{
+	welder.reset(uint32_t(vertexStream.size()));
+	result.Indices.reserve(vertexStream.size());
+
+	for (const Vertex& vertex : vertexStream)
+	{
+		result.Indices.push_back(welder.weld(vertex, result.Vertices));
+	}
+}
+
+//Returns the best time out of WELDER_BENCHMARK_RUNS in milliseconds, the result of the last run is kept
+template<typename WeldFunction>
+static double measure(WeldFunction weld, WeldResult& result)
+{
+	double bestTime = 0.0;
+	for (uint32_t run = 0; run < WELDER_BENCHMARK_RUNS; run++)
+	{
+		result = WeldResult();
+
+		auto startTime = std::chrono::high_resolution_clock::now();
+		weld(result);
+		std::chrono::duration<double, std::milli> time = std::chrono::high_resolution_clock::now() - startTime;
+
+		if (run == 0 || time.count() < bestTime)
+		{
+			bestTime = time.count();
+		}
+	}
+
+	return bestTime;
+}
+
+void VertexWelderBenchmark::run()
+{
+	const char* filepaths[] =
+	{
+		"assets/meshes/gun.obj",
+		"assets/meshes/sphere.obj",
+		"assets/sponza/sponza.obj",
+	};
+
+	LOG("VertexWelderBenchmark: best of %u runs", WELDER_BENCHMARK_RUNS);
+	LOG("%-28s | %-10s | %-10s | %-12s | %-12s | %-8s", "File", "Indices", "Vertices", "Map ms", "Welder ms", "Speedup");
+
+	VertexWelder welder;
+	for (const char* pFilepath : filepaths)
+	{
+		std::vector<Vertex> vertexStream;
+		if (!loadVertexStream(pFilepath, vertexStream))
+		{
+			LOG("%-28s | Failed to load, skipped", pFilepath);
+			continue;
+		}
+
+		WeldResult mapResult;
+		WeldResult welderResult;
+		const double mapTime	= measure([&](WeldResult& result) { weldWithMap(vertexStream, result); }, mapResult);
+		const double welderTime	= measure([&](WeldResult& result) { weldWithWelder(vertexStream, welder, result); }, welderResult);
+
+		//Both keep the first occurrence of every vertex, so the output has to be identical
+		if (mapResult.Indices != welderResult.Indices || mapResult.Vertices.size() != welderResult.Vertices.size())
+		{
+			LOG("%-28s | Welder output differs from the map", pFilepath);
+		}
+
+		LOG("%-28s | %-10u | %-10u | %-12.3f | %-12.3f | %.2fx", pFilepath, uint32_t(vertexStream.size()), uint32_t(welderResult.Vertices.size()),
+			mapTime, welderTime, (welderTime > 0.0) ? mapTime / welderTime : 0.0);
+	}
+}
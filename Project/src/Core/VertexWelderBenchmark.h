@@ -0,0 +1,12 @@
+#pragma once
+#include "Core.h"
+
+//Compares VertexWelder against the std::unordered_map<Vertex, uint32_t> it replaced, using the OBJ files in assets
+class VertexWelderBenchmark
+{
+public:
+	DECL_STATIC_CLASS(VertexWelderBenchmark);
+
+	//Files that can not be loaded are skipped
+	static void run();
+};
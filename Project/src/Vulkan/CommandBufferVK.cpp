@@ -4,6 +4,10 @@
 
 #include "Ray Tracing/ShaderBindingTableVK.h"
 
+#ifdef max
+	#undef max
+#endif
+
 CommandBufferVK::CommandBufferVK(DeviceVK* pDevice, VkCommandBuffer commandBuffer)
 	: m_pDevice(pDevice),
 	m_pStagingBuffer(nullptr),
@@ -184,6 +188,25 @@ void CommandBufferVK::blitImage2D(ImageVK* pSource, uint32_t sourceMip, VkExtent
 	vkCmdBlitImage(m_CommandBuffer, pSource->getImage(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, pDestination->getImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
 }
 
+void CommandBufferVK::generateMips(ImageVK* pImage)
+{
+	const uint32_t miplevelCount = pImage->getMiplevelCount();
+
+	VkExtent2D destinationExtent = {};
+	VkExtent2D sourceExtent = { pImage->getExtent().width, pImage->getExtent().height };
+	for (uint32_t i = 1; i < miplevelCount; i++)
+	{
+		destinationExtent = { std::max(sourceExtent.width / 2U, 1u), std::max(sourceExtent.height / 2U, 1U) };
+
+		transitionImageLayout(pImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, i - 1, 1, 0, 1);
+		blitImage2D(pImage, i - 1, sourceExtent, pImage, i, destinationExtent);
+		sourceExtent = destinationExtent;
+	}
+
+	transitionImageLayout(pImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, miplevelCount - 1, 1, 0, 1);
+	transitionImageLayout(pImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 0, miplevelCount, 0, 1);
+}
+
 void CommandBufferVK::updateImage(const void* pPixelData, ImageVK* pImage, uint32_t width, uint32_t height, uint32_t pixelStride, uint32_t miplevel, uint32_t layer)
 {
 	uint32_t sizeInBytes = width * height * pixelStride;
@@ -212,6 +235,26 @@ void CommandBufferVK::copyBufferToImage(BufferVK* pSource, VkDeviceSize sourceOf
 	vkCmdCopyBufferToImage(m_CommandBuffer, pSource->getBuffer(), pImage->getImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
 }
 
+void CommandBufferVK::updateImageMiplevels(const void* pData, uint64_t sizeInBytes, const uint64_t* pMiplevelOffsets, uint32_t miplevelCount, ImageVK* pImage, uint32_t layer)
+{
+	//Copies of block compressed images have to start at a multiple of the block size
+	constexpr VkDeviceSize alignment = 16;
+
+	//The offset is read after allocating since a reallocation restarts the staging buffer at offset zero
+	uint8_t* pHostMemory = reinterpret_cast<uint8_t*>(m_pStagingBuffer->allocate(sizeInBytes + alignment));
+	VkDeviceSize offset = m_pStagingBuffer->getCurrentOffset() - (sizeInBytes + alignment);
+
+	const VkDeviceSize padding = ((offset + alignment - 1) & ~(alignment - 1)) - offset;
+	offset		+= padding;
+	pHostMemory	+= padding;
+	memcpy(pHostMemory, pData, sizeInBytes);
+
+	const VkExtent3D extent = pImage->getExtent();
+	for (uint32_t i = 0; i < miplevelCount; i++)
+	{
+		copyBufferToImage(m_pStagingBuffer->getBuffer(), offset + pMiplevelOffsets[i], pImage, std::max(extent.width >> i, 1U), std::max(extent.height >> i, 1U), i, layer);
+	}
+}
 
 void CommandBufferVK::transitionImageLayout(ImageVK* pImage, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t baseMiplevel, uint32_t miplevels, uint32_t baseLayer, uint32_t layerCount, VkImageAspectFlagBits aspectMask)
 {
@@ -352,6 +395,11 @@ void CommandBufferVK::traceRays(ShaderBindingTableVK* pShaderBindingTable, uint3
 		width, height, 1);
 }
 
+void CommandBufferVK::drawIndexedIndirectCount(const BufferVK* pCommands, VkDeviceSize offset, const BufferVK* pCount, VkDeviceSize countOffset, uint32_t maxDrawCount, uint32_t stride)
+{
+	m_pDevice->vkCmdDrawIndexedIndirectCountKHR(m_CommandBuffer, pCommands->getBuffer(), offset, pCount->getBuffer(), countOffset, maxDrawCount, stride);
+}
+
 void CommandBufferVK::setName(const char* pName)
 {
 	m_pDevice->setVulkanObjectName(pName, (uint64_t)m_CommandBuffer, VK_OBJECT_TYPE_COMMAND_BUFFER);
@@ -28,9 +28,13 @@ public:
 	void copyBuffer(BufferVK* pSource, uint64_t sourceOffset, BufferVK* pDestination, uint64_t destinationOffset, uint64_t sizeInBytes);
 
 	void blitImage2D(ImageVK* pSource, uint32_t sourceMip, VkExtent2D sourceExtent, ImageVK* pDestination, uint32_t destinationMip, VkExtent2D destinationExtent);
+	//Fills every miplevel from the first one, all miplevels have to be in TRANSFER_DST and end up in SHADER_READ_ONLY
+	void generateMips(ImageVK* pImage);
 
 	void updateImage(const void* pPixelData, ImageVK* pImage, uint32_t width, uint32_t height, uint32_t pixelStride, uint32_t miplevel, uint32_t layer);
 	void copyBufferToImage(BufferVK* pSource, VkDeviceSize sourceOffset, ImageVK* pImage, uint32_t width, uint32_t height, uint32_t miplevel, uint32_t layer);
+	//Copies miplevels [0, miplevelCount) that are stored one after another in pData, pMiplevelOffsets are relative to pData
+	void updateImageMiplevels(const void* pData, uint64_t sizeInBytes, const uint64_t* pMiplevelOffsets, uint32_t miplevelCount, ImageVK* pImage, uint32_t layer);
 
 	void releaseBufferOwnership(BufferVK* pBuffer, VkAccessFlags srcAccessMask, uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask);
 	void acquireBufferOwnership(BufferVK* pBuffer, VkAccessFlags dstAccessMask, uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask);
@@ -43,6 +47,8 @@ public:
 	void acquireImagesOwnership(ImageVK* const* ppImages, uint32_t count, VkAccessFlags dstAccessMask, uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask, VkImageAspectFlags aspectMask = VK_IMAGE_ASPECT_COLOR_BIT);
 
 	void traceRays(ShaderBindingTableVK* pShaderBindingTable, uint32_t width, uint32_t height, uint32_t raygenOffset);
+	//Needs VK_KHR_draw_indirect_count
+	void drawIndexedIndirectCount(const BufferVK* pCommands, VkDeviceSize offset, const BufferVK* pCount, VkDeviceSize countOffset, uint32_t maxDrawCount, uint32_t stride);
 
 	void setName(const char* pName);
 
@@ -156,6 +162,16 @@ public:
 		vkCmdDrawIndexed(m_CommandBuffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
 	}
 
+	FORCEINLINE void drawIndexedIndirect(const BufferVK* pCommands, VkDeviceSize offset, uint32_t drawCount, uint32_t stride)
+	{
+		vkCmdDrawIndexedIndirect(m_CommandBuffer, pCommands->getBuffer(), offset, drawCount, stride);
+	}
+
+	FORCEINLINE void fillBuffer(BufferVK* pDestination, VkDeviceSize offset, VkDeviceSize sizeInBytes, uint32_t data)
+	{
+		vkCmdFillBuffer(m_CommandBuffer, pDestination->getBuffer(), offset, sizeInBytes, data);
+	}
+
 	FORCEINLINE void executeSecondary(CommandBufferVK* pSecondary)
 	{
 		VkCommandBuffer secondaryBuffer = pSecondary->getCommandBuffer();
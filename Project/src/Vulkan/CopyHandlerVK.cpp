@@ -68,9 +68,10 @@ bool CopyHandlerVK::init()
 
 void CopyHandlerVK::updateBuffer(BufferVK* pDestination, uint64_t destinationOffset, const void* pSource, uint64_t sizeInBytes)
 {
-	CommandBufferVK* pCommandBuffer = getNextTransferBuffer();
+	const uint32_t bufferIndex = getNextTransferBufferIndex();
 	{
-		std::scoped_lock<Spinlock> lock(m_pTransferLocks[m_CurrentTransferBuffer]);
+		std::scoped_lock<Spinlock> lock(m_pTransferLocks[bufferIndex]);
+		CommandBufferVK* pCommandBuffer = m_pTransferBuffers[bufferIndex];
 
 		pCommandBuffer->reset(true);
 		pCommandBuffer->begin(nullptr, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
@@ -81,11 +82,41 @@ void CopyHandlerVK::updateBuffer(BufferVK* pDestination, uint64_t destinationOff
 	}
 }
 
+void CopyHandlerVK::updateBuffers(const BufferUpdateVK* pUpdates, uint32_t updateCount)
+{
+	uint32_t updateIndex = 0;
+	while (updateIndex < updateCount)
+	{
+		const uint32_t bufferIndex = getNextTransferBufferIndex();
+		{
+			std::scoped_lock<Spinlock> lock(m_pTransferLocks[bufferIndex]);
+			CommandBufferVK* pCommandBuffer = m_pTransferBuffers[bufferIndex];
+
+			pCommandBuffer->reset(true);
+			pCommandBuffer->begin(nullptr, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+			//Every batch gets at least one update, the staging buffer can grow to fit a single update that is larger than the batch size
+			uint64_t batchSizeInBytes = 0;
+			do
+			{
+				const BufferUpdateVK& update = pUpdates[updateIndex++];
+				pCommandBuffer->updateBuffer(update.pDestination, update.DestinationOffset, update.pSource, update.SizeInBytes);
+				batchSizeInBytes += update.SizeInBytes;
+			} while (updateIndex < updateCount && batchSizeInBytes + pUpdates[updateIndex].SizeInBytes <= COPY_BATCH_SIZE_IN_BYTES);
+
+			pCommandBuffer->end();
+
+			submitTransferBuffer(pCommandBuffer);
+		}
+	}
+}
+
 void CopyHandlerVK::copyBuffer(BufferVK* pSource, uint64_t sourceOffset, BufferVK* pDestination, uint64_t destinationOffset, uint64_t sizeInBytes)
 {
-	CommandBufferVK* pCommandBuffer = getNextTransferBuffer();
+	const uint32_t bufferIndex = getNextTransferBufferIndex();
 	{
-		std::scoped_lock<Spinlock> lock(m_pTransferLocks[m_CurrentTransferBuffer]);
+		std::scoped_lock<Spinlock> lock(m_pTransferLocks[bufferIndex]);
+		CommandBufferVK* pCommandBuffer = m_pTransferBuffers[bufferIndex];
 
 		pCommandBuffer->reset(true);
 		pCommandBuffer->begin(nullptr, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
@@ -98,9 +129,10 @@ void CopyHandlerVK::copyBuffer(BufferVK* pSource, uint64_t sourceOffset, BufferV
 
 void CopyHandlerVK::updateImage(const void* pPixelData, ImageVK* pImage, uint32_t width, uint32_t height, uint32_t pixelStride, VkImageLayout initalLayout, VkImageLayout finalLayout, uint32_t miplevel, uint32_t layer)
 {
-	CommandBufferVK* pCommandBuffer = getNextGraphicsBuffer();
+	const uint32_t bufferIndex = getNextGraphicsBufferIndex();
 	{
-		std::scoped_lock<Spinlock> lock(m_pGraphicsLocks[m_CurrentGraphicsBuffer]);
+		std::scoped_lock<Spinlock> lock(m_pGraphicsLocks[bufferIndex]);
+		CommandBufferVK* pCommandBuffer = m_pGraphicsBuffers[bufferIndex];
 
 		pCommandBuffer->reset(true);
 		pCommandBuffer->begin(nullptr, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
@@ -127,9 +159,10 @@ void CopyHandlerVK::updateImage(const void* pPixelData, ImageVK* pImage, uint32_
 
 void CopyHandlerVK::copyBufferToImage(BufferVK* pSource, VkDeviceSize sourceOffset, ImageVK* pImage, uint32_t width, uint32_t height, uint32_t miplevel, uint32_t layer)
 {
-	CommandBufferVK* pCommandBuffer = getNextGraphicsBuffer();
+	const uint32_t bufferIndex = getNextGraphicsBufferIndex();
 	{
-		std::scoped_lock<Spinlock> lock(m_pGraphicsLocks[m_CurrentGraphicsBuffer]);
+		std::scoped_lock<Spinlock> lock(m_pGraphicsLocks[bufferIndex]);
+		CommandBufferVK* pCommandBuffer = m_pGraphicsBuffers[bufferIndex];
 
 		pCommandBuffer->reset(true);
 		pCommandBuffer->begin(nullptr, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
@@ -140,52 +173,64 @@ void CopyHandlerVK::copyBufferToImage(BufferVK* pSource, VkDeviceSize sourceOffs
 	}
 }
 
-void CopyHandlerVK::generateMips(ImageVK* pImage)
+void CopyHandlerVK::updateImageMiplevels(const void* pData, uint64_t sizeInBytes, const uint64_t* pMiplevelOffsets, ImageVK* pImage, VkImageLayout initalLayout, VkImageLayout finalLayout, uint32_t layer)
 {
-	//D_LOG("CopyHandlerVK::generateMips");
-
-	CommandBufferVK* pCommandBuffer = getNextGraphicsBuffer();
+	const uint32_t bufferIndex = getNextGraphicsBufferIndex();
 	{
-		std::scoped_lock<Spinlock> lock(m_pGraphicsLocks[m_CurrentGraphicsBuffer]);
+		std::scoped_lock<Spinlock> lock(m_pGraphicsLocks[bufferIndex]);
+		CommandBufferVK* pCommandBuffer = m_pGraphicsBuffers[bufferIndex];
 
 		pCommandBuffer->reset(true);
 		pCommandBuffer->begin(nullptr, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
 
 		const uint32_t miplevelCount = pImage->getMiplevelCount();
-		pCommandBuffer->transitionImageLayout(pImage, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, miplevelCount, 0, 1);
-
-		VkExtent2D destinationExtent = {};
-		VkExtent2D sourceExtent = { pImage->getExtent().width, pImage->getExtent().height };
-		for (uint32_t i = 1; i < miplevelCount; i++)
+		if (initalLayout != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
 		{
-			destinationExtent = { std::max(sourceExtent.width / 2U, 1u), std::max(sourceExtent.height / 2U, 1U) };
+			pCommandBuffer->transitionImageLayout(pImage, initalLayout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, miplevelCount, layer, 1);
+		}
 
-			pCommandBuffer->transitionImageLayout(pImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, i - 1, 1, 0, 1);
-			pCommandBuffer->blitImage2D(pImage, i - 1, sourceExtent, pImage, i, destinationExtent);
-			sourceExtent = destinationExtent;
+		pCommandBuffer->updateImageMiplevels(pData, sizeInBytes, pMiplevelOffsets, miplevelCount, pImage, layer);
+
+		if (finalLayout != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
+		{
+			pCommandBuffer->transitionImageLayout(pImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, finalLayout, 0, miplevelCount, layer, 1);
 		}
 
-		pCommandBuffer->transitionImageLayout(pImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, miplevelCount - 1, 1, 0, 1);
-		pCommandBuffer->transitionImageLayout(pImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 0, miplevelCount, 0, 1);
 		pCommandBuffer->end();
 
 		submitGraphicsBuffer(pCommandBuffer);
 	}
 }
 
-CommandBufferVK* CopyHandlerVK::getNextTransferBuffer()
+void CopyHandlerVK::generateMips(ImageVK* pImage)
 {
-	CommandBufferVK* pCommandBuffer = m_pTransferBuffers[m_CurrentTransferBuffer];
-	m_CurrentTransferBuffer = (m_CurrentTransferBuffer+1) % MAX_COMMAND_BUFFERS;
+	//D_LOG("CopyHandlerVK::generateMips");
 
-	return pCommandBuffer;
+	const uint32_t bufferIndex = getNextGraphicsBufferIndex();
+	{
+		std::scoped_lock<Spinlock> lock(m_pGraphicsLocks[bufferIndex]);
+		CommandBufferVK* pCommandBuffer = m_pGraphicsBuffers[bufferIndex];
+
+		pCommandBuffer->reset(true);
+		pCommandBuffer->begin(nullptr, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+		pCommandBuffer->transitionImageLayout(pImage, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, pImage->getMiplevelCount(), 0, 1);
+		pCommandBuffer->generateMips(pImage);
+		pCommandBuffer->end();
+
+		submitGraphicsBuffer(pCommandBuffer);
+	}
+}
+
+uint32_t CopyHandlerVK::getNextTransferBufferIndex()
+{
+	//Several loading threads submit at the same time, so the index is taken atomically and the caller locks the buffer at that index
+	return m_CurrentTransferBuffer.fetch_add(1) % MAX_COMMAND_BUFFERS;
 }
 
-CommandBufferVK* CopyHandlerVK::getNextGraphicsBuffer()
+uint32_t CopyHandlerVK::getNextGraphicsBufferIndex()
 {
-	CommandBufferVK* pCommandBuffer = m_pGraphicsBuffers[m_CurrentGraphicsBuffer];
-	m_CurrentGraphicsBuffer = (m_CurrentGraphicsBuffer + 1) % MAX_COMMAND_BUFFERS;
-	return pCommandBuffer;
+	return m_CurrentGraphicsBuffer.fetch_add(1) % MAX_COMMAND_BUFFERS;
 }
 
 void CopyHandlerVK::submitTransferBuffer(CommandBufferVK* pCommandBuffer)
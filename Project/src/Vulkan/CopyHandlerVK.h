@@ -3,6 +3,8 @@
 
 #include "VulkanCommon.h"
 
+#include <atomic>
+
 class ImageVK;
 class DeviceVK;
 class BufferVK;
@@ -11,6 +13,16 @@ class CommandPoolVK;
 class CommandBufferVK;
 
 #define MAX_COMMAND_BUFFERS 16
+//Updates are recorded into the same command buffer until they add up to this size. Matches the initial size of a command buffer's staging buffer
+#define COPY_BATCH_SIZE_IN_BYTES MB(1)
+
+struct BufferUpdateVK
+{
+	BufferVK* pDestination;
+	uint64_t DestinationOffset;
+	const void* pSource;
+	uint64_t SizeInBytes;
+};
 
 class CopyHandlerVK
 {
@@ -21,16 +33,20 @@ public:
 	bool init();
 
 	void updateBuffer(BufferVK* pDestination, uint64_t destinationOffset, const void* pSource, uint64_t sizeInBytes);
+	//Records many small updates per submission instead of submitting each update on its own
+	void updateBuffers(const BufferUpdateVK* pUpdates, uint32_t updateCount);
 	void copyBuffer(BufferVK* pSource, uint64_t sourceOffset, BufferVK* pDestination, uint64_t destinationOffset, uint64_t sizeInBytes);
 
 	void updateImage(const void* pPixelData, ImageVK* pImage, uint32_t width, uint32_t height, uint32_t pixelStride, VkImageLayout initalLayout, VkImageLayout finalLayout, uint32_t miplevel, uint32_t layer);
 	void copyBufferToImage(BufferVK* pSource, VkDeviceSize sourceOffset, ImageVK* pImage, uint32_t width, uint32_t height, uint32_t miplevel, uint32_t layer);
+	//Uploads a complete mip chain that was built offline, pMiplevelOffsets are relative to pData
+	void updateImageMiplevels(const void* pData, uint64_t sizeInBytes, const uint64_t* pMiplevelOffsets, ImageVK* pImage, VkImageLayout initalLayout, VkImageLayout finalLayout, uint32_t layer);
 
 	void generateMips(ImageVK* pImage);
 
 private:
-	CommandBufferVK* getNextTransferBuffer();
-	CommandBufferVK* getNextGraphicsBuffer();
+	uint32_t getNextTransferBufferIndex();
+	uint32_t getNextGraphicsBufferIndex();
 	void submitTransferBuffer(CommandBufferVK* pCommandBuffer);
 	void submitGraphicsBuffer(CommandBufferVK* pCommandBuffer);
 
@@ -42,6 +58,6 @@ private:
 	CommandBufferVK* m_pGraphicsBuffers[MAX_COMMAND_BUFFERS];
 	Spinlock m_pTransferLocks[MAX_COMMAND_BUFFERS];
 	Spinlock m_pGraphicsLocks[MAX_COMMAND_BUFFERS];
-	uint32_t m_CurrentTransferBuffer;
-	uint32_t m_CurrentGraphicsBuffer;
+	std::atomic<uint32_t> m_CurrentTransferBuffer;
+	std::atomic<uint32_t> m_CurrentGraphicsBuffer;
 };
\ No newline at end of file
@@ -20,6 +20,9 @@ DeviceVK::DeviceVK()
 	m_TransferQueue(VK_NULL_HANDLE),
 	m_PresentQueue(VK_NULL_HANDLE),
 	m_DeviceLimits({}),
+	m_SupportsTextureCompressionBC(false),
+	m_SupportsMultiDrawIndirect(false),
+	m_SupportsDrawIndirectFirstInstance(false),
 	m_RayTracingProperties({}),
 	m_pCopyHandler(),
 	vkCreateAccelerationStructureNV(),
@@ -30,7 +33,8 @@ DeviceVK::DeviceVK()
 	vkCmdBuildAccelerationStructureNV(),
 	vkCreateRayTracingPipelinesNV(),
 	vkGetRayTracingShaderGroupHandlesNV(),
-	vkCmdTraceRaysNV()
+	vkCmdTraceRaysNV(),
+	vkCmdDrawIndexedIndirectCountKHR()
 {
 }
 
@@ -140,6 +144,9 @@ void DeviceVK::executeCommandBuffer(VkQueue queue, CommandBufferVK* pCommandBuff
 
 void DeviceVK::wait()
 {
+	//Streaming threads submit uploads while frames are rendered, waiting for the device requires access to every queue
+	std::scoped_lock<Spinlock, Spinlock, Spinlock> lock(m_GraphicsLock, m_ComputeLock, m_TransferLock);
+
 	VkResult result = vkDeviceWaitIdle(m_Device);
 	if (result != VK_SUCCESS) 
 	{ 
@@ -243,10 +250,21 @@ bool DeviceVK::initLogicalDevice()
 		queueCreateInfos.push_back(queueCreateInfo);
 	}
 
+	//Textures fall back to uncompressed formats if BCn is not supported
+	VkPhysicalDeviceFeatures supportedFeatures;
+	vkGetPhysicalDeviceFeatures(m_PhysicalDevice, &supportedFeatures);
+	m_SupportsTextureCompressionBC = (supportedFeatures.textureCompressionBC == VK_TRUE);
+	//Without it every indirect draw is recorded on its own
+	m_SupportsMultiDrawIndirect = (supportedFeatures.multiDrawIndirect == VK_TRUE);
+	m_SupportsDrawIndirectFirstInstance = (supportedFeatures.drawIndirectFirstInstance == VK_TRUE);
+
 	VkPhysicalDeviceFeatures deviceFeatures = {};
 	deviceFeatures.fillModeNonSolid = true;
 	deviceFeatures.vertexPipelineStoresAndAtomics = true;
 	deviceFeatures.fragmentStoresAndAtomics = true;
+	deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+	deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+	deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
 
 	VkDeviceCreateInfo createInfo = {};
 	createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -417,6 +435,11 @@ void DeviceVK::registerExtensionFunctions()
 	{
 		std::cerr << "--- Device: Failed to intialize [ VK_NV_ray_tracing ] function pointers!" << std::endl;
 	}
+
+	if (m_ExtensionsStatus[VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME])
+	{
+		GET_DEVICE_PROC_ADDR(m_Device, vkCmdDrawIndexedIndirectCountKHR);
+	}
 }
 
 uint32_t DeviceVK::getQueueFamilyIndex(VkQueueFlagBits queueFlags, const std::vector<VkQueueFamilyProperties>& queueFamilies)
@@ -65,6 +65,10 @@ public:
 
 	const VkPhysicalDeviceRayTracingPropertiesNV& getRayTracingProperties() const { return m_RayTracingProperties; }
 	bool supportsRayTracing() const { return m_ExtensionsStatus.at(VK_NV_RAY_TRACING_EXTENSION_NAME); }
+	bool supportsTextureCompressionBC() const { return m_SupportsTextureCompressionBC; }
+	bool supportsMultiDrawIndirect() const { return m_SupportsMultiDrawIndirect; }
+	bool supportsDrawIndirectFirstInstance() const { return m_SupportsDrawIndirectFirstInstance; }
+	bool supportsDrawIndirectCount() const { return m_ExtensionsStatus.at(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME); }
 
 private:
 	bool initPhysicalDevice();
@@ -108,6 +112,9 @@ private:
 	CopyHandlerVK* m_pCopyHandler;
 
 	VkPhysicalDeviceLimits m_DeviceLimits;
+	bool m_SupportsTextureCompressionBC;
+	bool m_SupportsMultiDrawIndirect;
+	bool m_SupportsDrawIndirectFirstInstance;
 
 	//Extensions
 	VkPhysicalDeviceRayTracingPropertiesNV m_RayTracingProperties;
@@ -123,5 +130,6 @@ public:
 	PFN_vkCreateRayTracingPipelinesNV					vkCreateRayTracingPipelinesNV;
 	PFN_vkGetRayTracingShaderGroupHandlesNV				vkGetRayTracingShaderGroupHandlesNV;
 	PFN_vkCmdTraceRaysNV								vkCmdTraceRaysNV;
+	PFN_vkCmdDrawIndexedIndirectCountKHR				vkCmdDrawIndexedIndirectCountKHR;
 };
 
@@ -0,0 +1,252 @@
+#include "DrawQueueVK.h"
+#include "BufferVK.h"
+#include "CommandBufferVK.h"
+#include "MeshVK.h"
+#include "PipelineLayoutVK.h"
+#include "PipelineVK.h"
+#include "SceneVK.h"
+
+#include "Core/Material.h"
+
+#include <algorithm>
+
+DrawQueueVK::DrawQueueVK(VkShaderStageFlags pushConstantStages, uint32_t pushConstantCount)
+	: m_Packets(),
+	m_SortItems(),
+	m_SortScratch(),
+	m_Pipelines(),
+	m_DrawCounter(),
+	m_InstanceCounter(),
+	m_PipelineBindCounter(),
+	m_DescriptorSetBindCounter(),
+	m_IndexBufferBindCounter(),
+	m_PushConstantStages(pushConstantStages),
+	m_PushConstantCount(std::min<uint32_t>(pushConstantCount, DRAW_QUEUE_MAX_PUSH_CONSTANTS))
+{
+}
+
+void DrawQueueVK::initCounters(ProfilerVK* pProfiler)
+{
+	pProfiler->initCounter(&m_DrawCounter, "Draws");
+	pProfiler->initCounter(&m_InstanceCounter, "Instances");
+	pProfiler->initCounter(&m_PipelineBindCounter, "Pipeline binds");
+	pProfiler->initCounter(&m_DescriptorSetBindCounter, "Descriptor set binds");
+	pProfiler->initCounter(&m_IndexBufferBindCounter, "Index buffer binds");
+}
+
+void DrawQueueVK::reset()
+{
+	m_Packets.clear();
+	m_SortItems.clear();
+
+	m_DrawCounter.value					= 0;
+	m_InstanceCounter.value				= 0;
+	m_PipelineBindCounter.value			= 0;
+	m_DescriptorSetBindCounter.value	= 0;
+	m_IndexBufferBindCounter.value		= 0;
+}
+
+void DrawQueueVK::push(PipelineVK* pPipeline, const MeshVK* pMesh, const Material* pMaterial, const IndexRangeVK& indexRange, uint32_t instanceIndex, const uint32_t* pPushConstants, float depth)
+{
+	ASSERT(pMesh != nullptr);
+
+	DrawPacketVK packet = {};
+	packet.pPipeline		= pPipeline;
+	packet.pMesh			= pMesh;
+	packet.pMaterial		= pMaterial;
+	packet.pIndexBuffer		= indexRange.pIndexBuffer;
+	packet.FirstIndex		= indexRange.FirstIndex;
+	packet.IndexCount		= indexRange.IndexCount;
+	packet.InstanceIndex	= instanceIndex;
+	for (uint32_t i = 0; i < m_PushConstantCount; i++)
+	{
+		packet.PushConstants[i] = pPushConstants[i];
+	}
+
+	m_SortItems.push_back({ createSortKey(packet, depth), uint32_t(m_Packets.size()) });
+	m_Packets.push_back(packet);
+}
+
+void DrawQueueVK::submit(CommandBufferVK* pCommandBuffer, PipelineLayoutVK* pPipelineLayout, SceneVK* pScene, uint32_t frameIndex, uint32_t pass)
+{
+	prepare(pScene);
+
+	DrawQueueStatsVK stats = {};
+	submitRange(pCommandBuffer, pPipelineLayout, pScene, frameIndex, pass, 0, uint32_t(m_SortItems.size()), stats);
+	addStats(stats);
+}
+
+void DrawQueueVK::prepare(SceneVK* pScene)
+{
+	RadixSort::sort(m_SortItems, m_SortScratch);
+
+	//The sort puts the packets with the same mesh and material next to each other, so most of them reuse the set of the packet before
+	const MeshVK* pCurrentMesh			= nullptr;
+	const Material* pCurrentMaterial	= nullptr;
+	DescriptorSetVK* pDescriptorSet		= nullptr;
+	for (const RadixSortItem& item : m_SortItems)
+	{
+		DrawPacketVK& packet = m_Packets[item.Value];
+		if (packet.pMesh != pCurrentMesh || packet.pMaterial != pCurrentMaterial)
+		{
+			pCurrentMesh		= packet.pMesh;
+			pCurrentMaterial	= packet.pMaterial;
+			pDescriptorSet		= pScene->getDescriptorSetFromMeshAndMaterial(packet.pMesh, packet.pMaterial);
+		}
+
+		packet.pDescriptorSet = pDescriptorSet;
+	}
+}
+
+uint32_t DrawQueueVK::split(uint32_t maxChunkCount, uint32_t* pChunkStarts) const
+{
+	const uint32_t packetCount	= uint32_t(m_SortItems.size());
+	const uint32_t chunkCount	= std::max(1U, std::min(maxChunkCount, packetCount / DRAW_QUEUE_MIN_PACKETS_PER_CHUNK));
+
+	pChunkStarts[0] = 0;
+	for (uint32_t chunk = 1; chunk < chunkCount; chunk++)
+	{
+		//Moving the start past the end of the instanced draw can leave a chunk empty, which is still recorded and executed
+		uint32_t start = std::max(pChunkStarts[chunk - 1], uint32_t((uint64_t(packetCount) * chunk) / chunkCount));
+		while (start > 0 && start < packetCount && canInstance(m_Packets[m_SortItems[start - 1].Value], m_Packets[m_SortItems[start].Value]))
+		{
+			start++;
+		}
+
+		pChunkStarts[chunk] = start;
+	}
+
+	pChunkStarts[chunkCount] = packetCount;
+	return chunkCount;
+}
+
+void DrawQueueVK::submitRange(CommandBufferVK* pCommandBuffer, PipelineLayoutVK* pPipelineLayout, SceneVK* pScene, uint32_t frameIndex, uint32_t pass, uint32_t begin, uint32_t end, DrawQueueStatsVK& stats) const
+{
+	uint32_t* pInstanceIndices		= pScene->getInstanceIndices(frameIndex, pass);
+	const uint32_t firstInstance	= pScene->getFirstInstance(frameIndex, pass);
+
+	PipelineVK* pBoundPipeline				= nullptr;
+	DescriptorSetVK* pBoundDescriptorSet	= nullptr;
+	const BufferVK* pBoundIndexBuffer		= nullptr;
+
+	//Push constants are undefined until they have been pushed once after the pipeline was bound
+	uint32_t pushedConstants[DRAW_QUEUE_MAX_PUSH_CONSTANTS] = {};
+	bool hasPushedConstants = false;
+
+	uint32_t instanceCount = 0;
+	for (uint32_t first = begin; first < end; first += instanceCount)
+	{
+		const DrawPacketVK& packet = m_Packets[m_SortItems[first].Value];
+
+		//The sort puts the draws that can be instanced next to each other
+		instanceCount = 1;
+		while (first + instanceCount < end && canInstance(packet, m_Packets[m_SortItems[first + instanceCount].Value]))
+		{
+			instanceCount++;
+		}
+
+		for (uint32_t i = 0; i < instanceCount; i++)
+		{
+			pInstanceIndices[first + i] = m_Packets[m_SortItems[first + i].Value].InstanceIndex;
+		}
+
+		if (packet.pPipeline != pBoundPipeline)
+		{
+			pCommandBuffer->bindPipeline(packet.pPipeline);
+			pBoundPipeline = packet.pPipeline;
+			stats.PipelineBindCount++;
+		}
+
+		if (packet.pDescriptorSet != pBoundDescriptorSet)
+		{
+			DescriptorSetVK* pDescriptorSet = packet.pDescriptorSet;
+			pCommandBuffer->bindDescriptorSet(VK_PIPELINE_BIND_POINT_GRAPHICS, pPipelineLayout, 0, 1, &pDescriptorSet, 0, nullptr);
+			pBoundDescriptorSet = pDescriptorSet;
+			stats.DescriptorSetBindCount++;
+		}
+
+		if (packet.pIndexBuffer != pBoundIndexBuffer)
+		{
+			pCommandBuffer->bindIndexBuffer(packet.pIndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+			pBoundIndexBuffer = packet.pIndexBuffer;
+			stats.IndexBufferBindCount++;
+		}
+
+		if (m_PushConstantCount > 0)
+		{
+			if (!hasPushedConstants || memcmp(pushedConstants, packet.PushConstants, sizeof(uint32_t) * m_PushConstantCount) != 0)
+			{
+				pCommandBuffer->pushConstants(pPipelineLayout, m_PushConstantStages, 0, sizeof(uint32_t) * m_PushConstantCount, packet.PushConstants);
+				memcpy(pushedConstants, packet.PushConstants, sizeof(uint32_t) * m_PushConstantCount);
+				hasPushedConstants = true;
+			}
+		}
+
+		pCommandBuffer->drawIndexInstanced(packet.IndexCount, instanceCount, packet.FirstIndex, 0, firstInstance + first);
+		stats.DrawCount++;
+		stats.InstanceCount += instanceCount;
+	}
+}
+
+void DrawQueueVK::addStats(const DrawQueueStatsVK& stats)
+{
+	m_DrawCounter.value					+= stats.DrawCount;
+	m_InstanceCounter.value				+= stats.InstanceCount;
+	m_PipelineBindCounter.value			+= stats.PipelineBindCount;
+	m_DescriptorSetBindCounter.value	+= stats.DescriptorSetBindCount;
+	m_IndexBufferBindCounter.value		+= stats.IndexBufferBindCount;
+}
+
+uint64_t DrawQueueVK::createSortKey(const DrawPacketVK& packet, float depth)
+{
+	const uint64_t pipelineSlot	= std::min<uint64_t>(getPipelineSlot(packet.pPipeline), (1ULL << DRAW_KEY_PIPELINE_BITS) - 1);
+	const uint64_t meshID		= uint64_t(packet.pMesh->getMeshID()) & ((1ULL << DRAW_KEY_MESH_BITS) - 1);
+	const uint64_t materialID	= (packet.pMaterial != nullptr) ? (uint64_t(packet.pMaterial->getMaterialID()) & ((1ULL << DRAW_KEY_MATERIAL_BITS) - 1)) : 0;
+
+	//Ranges of the buffer of the mesh are told apart by their detail level, ranges that were culled into a shared buffer are all different and come last
+	uint64_t range = (1ULL << DRAW_KEY_RANGE_BITS) - 1;
+	if (packet.pIndexBuffer == reinterpret_cast<BufferVK*>(packet.pMesh->getIndexBuffer()))
+	{
+		for (uint32_t lod = 0; lod < packet.pMesh->getLODCount(); lod++)
+		{
+			if (packet.pMesh->getLOD(lod).FirstIndex == packet.FirstIndex)
+			{
+				range = lod;
+				break;
+			}
+		}
+	}
+
+	//Flipping the sign bit of positive floats and every bit of negative floats makes their bits sort like the floats do
+	uint32_t depthBits = 0;
+	memcpy(&depthBits, &depth, sizeof(float));
+	depthBits ^= (depthBits & 0x80000000U) ? 0xFFFFFFFFU : 0x80000000U;
+
+	uint64_t key = pipelineSlot;
+	key = (key << DRAW_KEY_MESH_BITS)			| meshID;
+	key = (key << DRAW_KEY_MATERIAL_BITS)		| materialID;
+	key = (key << DRAW_KEY_RANGE_BITS)			| range;
+	key = (key << DRAW_KEY_DEPTH_BITS)			| (depthBits >> (32U - DRAW_KEY_DEPTH_BITS));
+	return key;
+}
+
+uint32_t DrawQueueVK::getPipelineSlot(PipelineVK* pPipeline)
+{
+	for (uint32_t i = 0; i < uint32_t(m_Pipelines.size()); i++)
+	{
+		if (m_Pipelines[i] == pPipeline)
+		{
+			return i;
+		}
+	}
+
+	m_Pipelines.push_back(pPipeline);
+	return uint32_t(m_Pipelines.size()) - 1;
+}
+
+bool DrawQueueVK::canInstance(const DrawPacketVK& first, const DrawPacketVK& other) const
+{
+	return first.pPipeline == other.pPipeline && first.pMesh == other.pMesh && first.pMaterial == other.pMaterial && first.pIndexBuffer == other.pIndexBuffer &&
+		first.FirstIndex == other.FirstIndex && first.IndexCount == other.IndexCount &&
+		memcmp(first.PushConstants, other.PushConstants, sizeof(uint32_t) * m_PushConstantCount) == 0;
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include "Core/RadixSort.h"
+
+#include "MeshletCullerVK.h"
+#include "ProfilerVK.h"
+#include "VulkanCommon.h"
+
+#include <vector>
+
+class BufferVK;
+class CommandBufferVK;
+class DescriptorSetVK;
+class Material;
+class MeshVK;
+class PipelineLayoutVK;
+class PipelineVK;
+class SceneVK;
+
+#define DRAW_QUEUE_MAX_PUSH_CONSTANTS 2
+
+//Bits of the sort key, from the most significant. The pipeline is changed the least, then the descriptor set, which is picked by the mesh and the material,
+//then the index range, which is the detail level of the mesh or a range that was culled into a shared buffer. Draws with the same state are sorted front to back.
+//IDs that do not fit in their bits only cost redundant binds and split instances
+#define DRAW_KEY_PIPELINE_BITS		4U
+#define DRAW_KEY_MESH_BITS			16U
+#define DRAW_KEY_MATERIAL_BITS		14U
+#define DRAW_KEY_RANGE_BITS			5U
+#define DRAW_KEY_DEPTH_BITS			25U
+
+//Chunks of a parallel submit get at least this many packets, beginning a secondary buffer and binding its state costs about as much as a few draws
+#define DRAW_QUEUE_MIN_PACKETS_PER_CHUNK	64U
+
+struct DrawPacketVK
+{
+	PipelineVK*		pPipeline;
+	const MeshVK*	pMesh;
+	const Material* pMaterial;
+	BufferVK*		pIndexBuffer;
+	uint32_t		FirstIndex;
+	uint32_t		IndexCount;
+	//Index of the transform of the object, written to the instance index buffer
+	uint32_t		InstanceIndex;
+	uint32_t		PushConstants[DRAW_QUEUE_MAX_PUSH_CONSTANTS];
+	//Looked up by prepare, the scene creates the sets on first use and can not do that from several threads
+	DescriptorSetVK* pDescriptorSet;
+};
+
+//Binds and draws recorded by one submit, kept apart from the profiler counters so that chunks can be submitted in parallel
+struct DrawQueueStatsVK
+{
+	uint32_t DrawCount				= 0;
+	uint32_t InstanceCount			= 0;
+	uint32_t PipelineBindCount		= 0;
+	uint32_t DescriptorSetBindCount	= 0;
+	uint32_t IndexBufferBindCount	= 0;
+};
+
+//Collects the draws of a pass during the frame and records them sorted by state, so that a bind is only recorded when the state actually changes.
+//Neighbouring draws of the same mesh, material and index range are merged into one instanced draw, the shaders find the transform of an instance
+//through the instance indices that the scene holds for the pass
+class DrawQueueVK
+{
+public:
+	DrawQueueVK(VkShaderStageFlags pushConstantStages, uint32_t pushConstantCount);
+	~DrawQueueVK() = default;
+
+	DECL_NO_COPY(DrawQueueVK);
+
+	void initCounters(ProfilerVK* pProfiler);
+
+	void reset();
+	//Depth is only used to order draws with the same state, smaller depths are drawn first
+	void push(PipelineVK* pPipeline, const MeshVK* pMesh, const Material* pMaterial, const IndexRangeVK& indexRange, uint32_t instanceIndex, const uint32_t* pPushConstants, float depth);
+	//The descriptor set of every mesh and material is bound to set zero of the layout. Pass is one of the INSTANCE_INDICES_PASS_ regions of the scene
+	void submit(CommandBufferVK* pCommandBuffer, PipelineLayoutVK* pPipelineLayout, SceneVK* pScene, uint32_t frameIndex, uint32_t pass);
+
+	//Parallel submits call prepare once, then submitRange for every range of sorted packets from split, from any thread, and then addStats for every range
+	void prepare(SceneVK* pScene);
+	//Splits the sorted packets into at most maxChunkCount ranges that do not cut through an instanced draw, pChunkStarts gets the chunk count plus one entries.
+	//Returns the number of chunks, which is at least one
+	uint32_t split(uint32_t maxChunkCount, uint32_t* pChunkStarts) const;
+	//Every range starts without any bound state. The instance indices of the range are written to the same place as a submit of every packet would have
+	void submitRange(CommandBufferVK* pCommandBuffer, PipelineLayoutVK* pPipelineLayout, SceneVK* pScene, uint32_t frameIndex, uint32_t pass, uint32_t begin, uint32_t end, DrawQueueStatsVK& stats) const;
+	void addStats(const DrawQueueStatsVK& stats);
+
+	FORCEINLINE uint32_t getPacketCount() const { return uint32_t(m_Packets.size()); }
+
+private:
+	uint64_t createSortKey(const DrawPacketVK& packet, float depth);
+	bool canInstance(const DrawPacketVK& first, const DrawPacketVK& other) const;
+	uint32_t getPipelineSlot(PipelineVK* pPipeline);
+
+private:
+	std::vector<DrawPacketVK> m_Packets;
+	std::vector<RadixSortItem> m_SortItems;
+	std::vector<RadixSortItem> m_SortScratch;
+	//Pipelines in the order they were first pushed, the index is the slot in the sort key
+	std::vector<PipelineVK*> m_Pipelines;
+
+	ProfilerCounter m_DrawCounter;
+	ProfilerCounter m_InstanceCounter;
+	ProfilerCounter m_PipelineBindCounter;
+	ProfilerCounter m_DescriptorSetBindCounter;
+	ProfilerCounter m_IndexBufferBindCounter;
+
+	VkShaderStageFlags m_PushConstantStages;
+	uint32_t m_PushConstantCount;
+};
@@ -0,0 +1,472 @@
+#include "GPUCullerVK.h"
+#include "BufferVK.h"
+#include "CommandBufferVK.h"
+#include "DescriptorPoolVK.h"
+#include "DescriptorSetLayoutVK.h"
+#include "DescriptorSetVK.h"
+#include "DeviceVK.h"
+#include "GraphicsContextVK.h"
+#include "HiZPyramidVK.h"
+#include "MeshVK.h"
+#include "PipelineLayoutVK.h"
+#include "PipelineVK.h"
+#include "SceneVK.h"
+
+#include "Common/IShader.h"
+#include "Core/Camera.h"
+#include "Core/Material.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+//Buffers grow to at least this many objects and batches, which avoids recreating them while a scene is loaded
+#define GPU_CULLER_MIN_OBJECT_CAPACITY	1024U
+#define GPU_CULLER_MIN_BATCH_CAPACITY	64U
+
+GPUCullerVK::GPUCullerVK(GraphicsContextVK* pContext, HiZPyramidVK* pHiZPyramid)
+	: m_pContext(pContext),
+	m_pHiZPyramid(pHiZPyramid),
+	m_pPipeline(nullptr),
+	m_pPipelineLayout(nullptr),
+	m_pDescriptorSetLayout(nullptr),
+	m_pDescriptorPool(nullptr),
+	m_Batches(),
+	m_ObjectBatches(),
+	m_ObjectDrawIndices(),
+	m_BatchCounter(),
+	m_CurrentFrame(0),
+	m_ObjectCount(0),
+	m_IsCompacted(false),
+	m_IsOcclusionEnabled(false)
+{
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+	{
+		m_ppDescriptorSets[i]	= nullptr;
+		m_ppParamsBuffers[i]	= nullptr;
+		m_ppMappedParams[i]		= nullptr;
+		m_ppObjectBuffers[i]	= nullptr;
+		m_ppMappedObjects[i]	= nullptr;
+		m_ppCommandBuffers[i]	= nullptr;
+		m_ppCountBuffers[i]		= nullptr;
+		m_ppOccludedBuffers[i]	= nullptr;
+		m_ObjectCapacities[i]	= 0;
+		m_BatchCapacities[i]	= 0;
+	}
+}
+
+GPUCullerVK::~GPUCullerVK()
+{
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+	{
+		SAFEDELETE(m_ppParamsBuffers[i]);
+		SAFEDELETE(m_ppObjectBuffers[i]);
+		SAFEDELETE(m_ppCommandBuffers[i]);
+		SAFEDELETE(m_ppCountBuffers[i]);
+		SAFEDELETE(m_ppOccludedBuffers[i]);
+	}
+
+	m_pHiZPyramid = nullptr;
+
+	SAFEDELETE(m_pPipeline);
+	SAFEDELETE(m_pPipelineLayout);
+	SAFEDELETE(m_pDescriptorPool);
+	SAFEDELETE(m_pDescriptorSetLayout);
+
+	m_pContext = nullptr;
+}
+
+bool GPUCullerVK::init()
+{
+	DeviceVK* pDevice = m_pContext->getDevice();
+
+	m_pDescriptorSetLayout = DBG_NEW DescriptorSetLayoutVK(pDevice);
+	m_pDescriptorSetLayout->addBindingStorageBuffer(VK_SHADER_STAGE_COMPUTE_BIT, 0, 1);
+	m_pDescriptorSetLayout->addBindingStorageBuffer(VK_SHADER_STAGE_COMPUTE_BIT, 1, 1);
+	m_pDescriptorSetLayout->addBindingStorageBuffer(VK_SHADER_STAGE_COMPUTE_BIT, 2, 1);
+	m_pDescriptorSetLayout->addBindingStorageBuffer(VK_SHADER_STAGE_COMPUTE_BIT, 3, 1);
+	m_pDescriptorSetLayout->addBindingStorageBuffer(VK_SHADER_STAGE_COMPUTE_BIT, 4, 1);
+	m_pDescriptorSetLayout->addBindingUniformBuffer(VK_SHADER_STAGE_COMPUTE_BIT, 5, 1);
+	m_pDescriptorSetLayout->addBindingCombinedImage(VK_SHADER_STAGE_COMPUTE_BIT, nullptr, 6, 1);
+	if (!m_pDescriptorSetLayout->finalize())
+	{
+		LOG("-- GPUCullerVK: Failed to create descriptor set layout");
+		return false;
+	}
+
+	DescriptorCounts descriptorCounts	= {};
+	descriptorCounts.m_StorageBuffers	= 5 * MAX_FRAMES_IN_FLIGHT + 1;
+	descriptorCounts.m_UniformBuffers	= MAX_FRAMES_IN_FLIGHT + 1;
+	descriptorCounts.m_SampledImages	= MAX_FRAMES_IN_FLIGHT + 1;
+
+	m_pDescriptorPool = DBG_NEW DescriptorPoolVK(pDevice);
+	if (!m_pDescriptorPool->init(descriptorCounts, MAX_FRAMES_IN_FLIGHT))
+	{
+		LOG("-- GPUCullerVK: Failed to create descriptor pool");
+		return false;
+	}
+
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+	{
+		m_ppDescriptorSets[i] = m_pDescriptorPool->allocDescriptorSet(m_pDescriptorSetLayout);
+		if (m_ppDescriptorSets[i] == nullptr)
+		{
+			LOG("-- GPUCullerVK: Failed to allocate descriptor set");
+			return false;
+		}
+
+		BufferParams paramsBufferParams = {};
+		paramsBufferParams.Usage			= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+		paramsBufferParams.SizeInBytes		= sizeof(CullingParams);
+		paramsBufferParams.MemoryProperty	= VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+		paramsBufferParams.IsExclusive		= true;
+
+		m_ppParamsBuffers[i] = DBG_NEW BufferVK(pDevice);
+		if (!m_ppParamsBuffers[i]->init(paramsBufferParams))
+		{
+			LOG("-- GPUCullerVK: Failed to create parameter buffer");
+			return false;
+		}
+
+		void* pMappedParams = nullptr;
+		m_ppParamsBuffers[i]->map(&pMappedParams);
+		m_ppMappedParams[i] = reinterpret_cast<CullingParams*>(pMappedParams);
+	}
+
+	return createPipeline();
+}
+
+void GPUCullerVK::initCounters(ProfilerVK* pProfiler)
+{
+	pProfiler->initCounter(&m_BatchCounter, "Indirect batches");
+}
+
+bool GPUCullerVK::isSupported() const
+{
+	return m_pContext->getDevice()->supportsDrawIndirectFirstInstance();
+}
+
+bool GPUCullerVK::beginFrame(uint32_t frameIndex, SceneVK* pScene, const CameraBuffer& cameraBuffer, uint32_t firstInstance, uint32_t firstLateInstance)
+{
+	m_CurrentFrame = frameIndex;
+
+	const std::vector<GraphicsObjectVK>& graphicsObjects = pScene->getGraphicsObjects();
+	m_ObjectCount = uint32_t(graphicsObjects.size());
+	if (m_ObjectBatches.size() != m_ObjectCount)
+	{
+		createBatches(pScene);
+	}
+
+	if (!reserveObjects(m_ObjectCount, uint32_t(m_Batches.size())))
+	{
+		m_ObjectCount = 0;
+		return false;
+	}
+
+	const ObjectCuller& objectCuller = pScene->getObjectCuller();
+	GPUCullObject* pObjects = m_ppMappedObjects[m_CurrentFrame];
+	for (uint32_t i = 0; i < m_ObjectCount; i++)
+	{
+		const GraphicsObjectVK& graphicsObject	= graphicsObjects[i];
+		const MeshLOD& meshLOD					= graphicsObject.pMesh->getLOD(graphicsObject.LOD);
+		const uint32_t batchIndex				= m_ObjectBatches[i];
+
+		GPUCullObject& object = pObjects[i];
+		object.CenterRadius	= glm::vec4(objectCuller.getCenter(i), objectCuller.getRadius(i));
+		object.Extent		= objectCuller.getBoundsMax(i) - objectCuller.getCenter(i);
+		object.BatchIndex	= batchIndex;
+		object.FirstIndex	= meshLOD.FirstIndex;
+		object.IndexCount	= meshLOD.IndexCount;
+		object.FirstDraw	= m_Batches[batchIndex].FirstDraw;
+		object.DrawIndex	= m_ObjectDrawIndices[i];
+	}
+
+	m_IsCompacted			= m_pContext->getDevice()->supportsDrawIndirectCount();
+	m_IsOcclusionEnabled	= pScene->isOcclusionCullingEnabled() && m_pHiZPyramid->isValid();
+
+	CullingParams* pParams = m_ppMappedParams[m_CurrentFrame];
+	const Frustum& frustum = pScene->getCamera().getFrustum();
+	for (uint32_t p = 0; p < 6; p++)
+	{
+		pParams->FrustumPlanes[p] = frustum.getPlane(p);
+	}
+
+	pParams->ViewProjection		= cameraBuffer.Projection * cameraBuffer.View;
+	pParams->LastViewProjection	= cameraBuffer.LastProjection * cameraBuffer.LastView;
+	pParams->HiZSize			= m_pHiZPyramid->getSize();
+	pParams->HiZLevelCount		= m_pHiZPyramid->getLevelCount();
+	pParams->ObjectCount		= m_ObjectCount;
+	pParams->FirstInstance		= firstInstance;
+	pParams->FirstLateInstance	= firstLateInstance;
+	pParams->IsCompacted		= m_IsCompacted ? 1 : 0;
+	pParams->IsOcclusionEnabled	= m_IsOcclusionEnabled ? 1 : 0;
+	pParams->LateCommandOffset	= m_ObjectCapacities[m_CurrentFrame];
+	pParams->LateCountOffset	= m_BatchCapacities[m_CurrentFrame];
+
+	//The instance index buffer of the scene is recreated when it grows and the pyramid when the window is resized, so the set is written every frame.
+	//The fence of the frame has been waited for
+	const ImageViewVK* pHiZImageView	= m_pHiZPyramid->getImageView();
+	const SamplerVK* pHiZSampler		= m_pHiZPyramid->getSampler();
+
+	DescriptorSetVK* pDescriptorSet = m_ppDescriptorSets[m_CurrentFrame];
+	pDescriptorSet->writeStorageBufferDescriptor(m_ppObjectBuffers[m_CurrentFrame], 0);
+	pDescriptorSet->writeStorageBufferDescriptor(m_ppCommandBuffers[m_CurrentFrame], 1);
+	pDescriptorSet->writeStorageBufferDescriptor(m_ppCountBuffers[m_CurrentFrame], 2);
+	pDescriptorSet->writeStorageBufferDescriptor(pScene->getInstanceIndicesBuffer(), 3);
+	pDescriptorSet->writeStorageBufferDescriptor(m_ppOccludedBuffers[m_CurrentFrame], 4);
+	pDescriptorSet->writeUniformBufferDescriptor(m_ppParamsBuffers[m_CurrentFrame], 5);
+	pDescriptorSet->writeCombinedImageDescriptors(&pHiZImageView, &pHiZSampler, 1, 6);
+
+	m_BatchCounter.value = m_Batches.size();
+	return true;
+}
+
+void GPUCullerVK::dispatch(CommandBufferVK* pCommandBuffer, uint32_t phase)
+{
+	if (m_ObjectCount == 0)
+	{
+		return;
+	}
+
+	//Only the counts of the phase are cleared, the late phase runs after the early draws have read theirs
+	BufferVK* pCountBuffer				= m_ppCountBuffers[m_CurrentFrame];
+	const uint32_t batchCapacity		= m_BatchCapacities[m_CurrentFrame];
+	const VkDeviceSize countOffset		= sizeof(uint32_t) * batchCapacity * phase;
+	const VkDeviceSize countSize		= sizeof(uint32_t) * batchCapacity;
+	pCommandBuffer->fillBuffer(pCountBuffer, countOffset, countSize, 0);
+
+	VkBufferMemoryBarrier countBarrier = {};
+	countBarrier.sType					= VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	countBarrier.srcAccessMask			= VK_ACCESS_TRANSFER_WRITE_BIT;
+	countBarrier.dstAccessMask			= VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	countBarrier.srcQueueFamilyIndex	= VK_QUEUE_FAMILY_IGNORED;
+	countBarrier.dstQueueFamilyIndex	= VK_QUEUE_FAMILY_IGNORED;
+	countBarrier.buffer					= pCountBuffer->getBuffer();
+	countBarrier.offset					= countOffset;
+	countBarrier.size					= countSize;
+	pCommandBuffer->bufferMemoryBarrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 1, &countBarrier);
+
+	pCommandBuffer->bindPipeline(m_pPipeline);
+	pCommandBuffer->bindDescriptorSet(VK_PIPELINE_BIND_POINT_COMPUTE, m_pPipelineLayout, 0, 1, &m_ppDescriptorSets[m_CurrentFrame], 0, nullptr);
+	pCommandBuffer->pushConstants(m_pPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t), &phase);
+	pCommandBuffer->dispatch((m_ObjectCount + GPU_CULLING_GROUP_SIZE - 1) / GPU_CULLING_GROUP_SIZE, 1, 1);
+
+	//The commands and counts are read by the indirect draws, the instance indices by the vertex shader and the occlusion marks by the late phase
+	VkMemoryBarrier drawBarrier = {};
+	drawBarrier.sType			= VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	drawBarrier.srcAccessMask	= VK_ACCESS_SHADER_WRITE_BIT;
+	drawBarrier.dstAccessMask	= VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+	pCommandBuffer->pipelineBarrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &drawBarrier, 0, nullptr, 0, nullptr);
+}
+
+void GPUCullerVK::draw(CommandBufferVK* pCommandBuffer, PipelineVK* pPipeline, PipelineLayoutVK* pPipelineLayout, SceneVK* pScene, uint32_t phase)
+{
+	if (m_ObjectCount == 0)
+	{
+		return;
+	}
+
+	DeviceVK* pDevice = m_pContext->getDevice();
+	const bool supportsMultiDraw = pDevice->supportsMultiDrawIndirect();
+
+	const BufferVK* pCommands	= m_ppCommandBuffers[m_CurrentFrame];
+	const BufferVK* pCounts		= m_ppCountBuffers[m_CurrentFrame];
+	constexpr uint32_t stride	= sizeof(VkDrawIndexedIndirectCommand);
+
+	const uint32_t firstCommand	= (phase == GPU_CULLING_PHASE_LATE) ? m_ObjectCapacities[m_CurrentFrame] : 0;
+	const uint32_t firstCount	= (phase == GPU_CULLING_PHASE_LATE) ? m_BatchCapacities[m_CurrentFrame] : 0;
+
+	pCommandBuffer->bindPipeline(pPipeline);
+	for (uint32_t batchIndex = 0; batchIndex < m_Batches.size(); batchIndex++)
+	{
+		const IndirectBatchVK& batch = m_Batches[batchIndex];
+
+		DescriptorSetVK* pDescriptorSet = pScene->getDescriptorSetFromMeshAndMaterial(batch.pMesh, batch.pMaterial);
+		pCommandBuffer->bindDescriptorSet(VK_PIPELINE_BIND_POINT_GRAPHICS, pPipelineLayout, 0, 1, &pDescriptorSet, 0, nullptr);
+		pCommandBuffer->bindIndexBuffer(reinterpret_cast<BufferVK*>(batch.pMesh->getIndexBuffer()), 0, VK_INDEX_TYPE_UINT32);
+		pCommandBuffer->pushConstants(pPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(uint32_t), &batch.MaterialIndex);
+
+		const VkDeviceSize offset = VkDeviceSize(firstCommand + batch.FirstDraw) * stride;
+		if (m_IsCompacted)
+		{
+			pCommandBuffer->drawIndexedIndirectCount(pCommands, offset, pCounts, sizeof(uint32_t) * (firstCount + batchIndex), batch.MaxDrawCount, stride);
+		}
+		else if (supportsMultiDraw)
+		{
+			pCommandBuffer->drawIndexedIndirect(pCommands, offset, batch.MaxDrawCount, stride);
+		}
+		else
+		{
+			for (uint32_t i = 0; i < batch.MaxDrawCount; i++)
+			{
+				pCommandBuffer->drawIndexedIndirect(pCommands, offset + VkDeviceSize(i) * stride, 1, stride);
+			}
+		}
+	}
+}
+
+bool GPUCullerVK::createPipeline()
+{
+	DeviceVK* pDevice = m_pContext->getDevice();
+
+	IShader* pComputeShader = m_pContext->createShader();
+	pComputeShader->initFromFile(EShader::COMPUTE_SHADER, "main", "assets/shaders/objectCullingCompute.spv");
+	if (!pComputeShader->finalize())
+	{
+		LOG("-- GPUCullerVK: Failed to create compute shader");
+		SAFEDELETE(pComputeShader);
+		return false;
+	}
+
+	VkPushConstantRange pushConstantRange = {};
+	pushConstantRange.stageFlags	= VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset		= 0;
+	pushConstantRange.size			= sizeof(uint32_t);
+
+	m_pPipelineLayout = DBG_NEW PipelineLayoutVK(pDevice);
+	if (!m_pPipelineLayout->init({ m_pDescriptorSetLayout }, { pushConstantRange }))
+	{
+		LOG("-- GPUCullerVK: Failed to create pipeline layout");
+		SAFEDELETE(pComputeShader);
+		return false;
+	}
+
+	m_pPipeline = DBG_NEW PipelineVK(pDevice);
+	const bool result = m_pPipeline->finalizeCompute(pComputeShader, m_pPipelineLayout);
+	if (!result)
+	{
+		LOG("-- GPUCullerVK: Failed to create pipeline");
+	}
+
+	SAFEDELETE(pComputeShader);
+	return result;
+}
+
+bool GPUCullerVK::reserveObjects(uint32_t objectCount, uint32_t batchCount)
+{
+	DeviceVK* pDevice = m_pContext->getDevice();
+
+	if (m_ObjectCapacities[m_CurrentFrame] < objectCount)
+	{
+		//The fence of the frame has been waited for, so the old buffers are no longer in use
+		SAFEDELETE(m_ppObjectBuffers[m_CurrentFrame]);
+		SAFEDELETE(m_ppCommandBuffers[m_CurrentFrame]);
+		SAFEDELETE(m_ppOccludedBuffers[m_CurrentFrame]);
+		m_ppMappedObjects[m_CurrentFrame]	= nullptr;
+		m_ObjectCapacities[m_CurrentFrame]	= 0;
+
+		const uint32_t capacity = std::max(objectCount + objectCount / 2, GPU_CULLER_MIN_OBJECT_CAPACITY);
+
+		BufferParams objectBufferParams = {};
+		objectBufferParams.Usage			= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+		objectBufferParams.SizeInBytes		= sizeof(GPUCullObject) * capacity;
+		objectBufferParams.MemoryProperty	= VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+		objectBufferParams.IsExclusive		= true;
+
+		BufferParams commandBufferParams = {};
+		commandBufferParams.Usage			= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+		commandBufferParams.SizeInBytes		= sizeof(VkDrawIndexedIndirectCommand) * capacity * GPU_CULLING_PHASE_COUNT;
+		commandBufferParams.MemoryProperty	= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		commandBufferParams.IsExclusive		= true;
+
+		BufferParams occludedBufferParams = {};
+		occludedBufferParams.Usage			= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+		occludedBufferParams.SizeInBytes	= sizeof(uint32_t) * capacity;
+		occludedBufferParams.MemoryProperty	= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		occludedBufferParams.IsExclusive	= true;
+
+		m_ppObjectBuffers[m_CurrentFrame]	= DBG_NEW BufferVK(pDevice);
+		m_ppCommandBuffers[m_CurrentFrame]	= DBG_NEW BufferVK(pDevice);
+		m_ppOccludedBuffers[m_CurrentFrame]	= DBG_NEW BufferVK(pDevice);
+		if (!m_ppObjectBuffers[m_CurrentFrame]->init(objectBufferParams) || !m_ppCommandBuffers[m_CurrentFrame]->init(commandBufferParams) || !m_ppOccludedBuffers[m_CurrentFrame]->init(occludedBufferParams))
+		{
+			LOG("-- GPUCullerVK: Failed to create buffers for %u objects", capacity);
+			SAFEDELETE(m_ppObjectBuffers[m_CurrentFrame]);
+			SAFEDELETE(m_ppCommandBuffers[m_CurrentFrame]);
+			SAFEDELETE(m_ppOccludedBuffers[m_CurrentFrame]);
+			return false;
+		}
+
+		void* pMappedObjects = nullptr;
+		m_ppObjectBuffers[m_CurrentFrame]->map(&pMappedObjects);
+
+		m_ppMappedObjects[m_CurrentFrame]	= reinterpret_cast<GPUCullObject*>(pMappedObjects);
+		m_ObjectCapacities[m_CurrentFrame]	= capacity;
+	}
+
+	if (m_BatchCapacities[m_CurrentFrame] < batchCount)
+	{
+		SAFEDELETE(m_ppCountBuffers[m_CurrentFrame]);
+		m_BatchCapacities[m_CurrentFrame] = 0;
+
+		const uint32_t capacity = std::max(batchCount + batchCount / 2, GPU_CULLER_MIN_BATCH_CAPACITY);
+
+		BufferParams countBufferParams = {};
+		countBufferParams.Usage				= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		countBufferParams.SizeInBytes		= sizeof(uint32_t) * capacity * GPU_CULLING_PHASE_COUNT;
+		countBufferParams.MemoryProperty	= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		countBufferParams.IsExclusive		= true;
+
+		m_ppCountBuffers[m_CurrentFrame] = DBG_NEW BufferVK(pDevice);
+		if (!m_ppCountBuffers[m_CurrentFrame]->init(countBufferParams))
+		{
+			LOG("-- GPUCullerVK: Failed to create count buffer for %u batches", capacity);
+			SAFEDELETE(m_ppCountBuffers[m_CurrentFrame]);
+			return false;
+		}
+
+		m_BatchCapacities[m_CurrentFrame] = capacity;
+	}
+
+	return true;
+}
+
+void GPUCullerVK::createBatches(SceneVK* pScene)
+{
+	const std::vector<GraphicsObjectVK>& graphicsObjects = pScene->getGraphicsObjects();
+	const uint32_t objectCount = uint32_t(graphicsObjects.size());
+
+	m_Batches.clear();
+	m_ObjectBatches.resize(objectCount);
+	m_ObjectDrawIndices.resize(objectCount);
+
+	//Objects with the same mesh and material share a descriptor set, the material index is pushed once for the batch
+	std::unordered_map<MeshFilter, uint32_t> batchTable;
+	for (uint32_t i = 0; i < objectCount; i++)
+	{
+		const GraphicsObjectVK& graphicsObject = graphicsObjects[i];
+
+		MeshFilter filter = {};
+		filter.pMesh		= graphicsObject.pMesh;
+		filter.pMaterial	= graphicsObject.pMaterial;
+
+		auto batch = batchTable.find(filter);
+		if (batch == batchTable.end())
+		{
+			IndirectBatchVK newBatch = {};
+			newBatch.pMesh			= graphicsObject.pMesh;
+			newBatch.pMaterial		= graphicsObject.pMaterial;
+			newBatch.MaterialIndex	= graphicsObject.MaterialParametersIndex;
+			newBatch.FirstDraw		= 0;
+			newBatch.MaxDrawCount	= 0;
+
+			batch = batchTable.insert({ filter, uint32_t(m_Batches.size()) }).first;
+			m_Batches.push_back(newBatch);
+		}
+
+		//The rank of the object within its batch, made into a command index once the batches have been laid out
+		m_ObjectBatches[i]		= batch->second;
+		m_ObjectDrawIndices[i]	= m_Batches[batch->second].MaxDrawCount++;
+	}
+
+	uint32_t firstDraw = 0;
+	for (IndirectBatchVK& batch : m_Batches)
+	{
+		batch.FirstDraw	= firstDraw;
+		firstDraw		+= batch.MaxDrawCount;
+	}
+
+	for (uint32_t i = 0; i < objectCount; i++)
+	{
+		m_ObjectDrawIndices[i] += m_Batches[m_ObjectBatches[i]].FirstDraw;
+	}
+}
@@ -0,0 +1,146 @@
+#pragma once
+#include "VulkanCommon.h"
+
+#include "Vulkan/ProfilerVK.h"
+
+#include <vector>
+
+class BufferVK;
+class CommandBufferVK;
+class DescriptorPoolVK;
+class DescriptorSetLayoutVK;
+class DescriptorSetVK;
+class GraphicsContextVK;
+class HiZPyramidVK;
+class Material;
+class MeshVK;
+class PipelineLayoutVK;
+class PipelineVK;
+class SceneVK;
+struct CameraBuffer;
+
+//Scenes with at least this many objects cull the geometry pass on the GPU when it is enabled, below that recording the draws on the CPU is cheap enough
+#define GPU_CULLING_MIN_OBJECT_COUNT	1024U
+//Has to match local_size_x of objectCullingCompute.glsl
+#define GPU_CULLING_GROUP_SIZE			64U
+
+//The early phase draws the objects that were not hidden by the depth of the last frame, the late phase draws the ones among them that the depth of the
+//early phase no longer hides. Has to match objectCullingCompute.glsl
+#define GPU_CULLING_PHASE_EARLY			0U
+#define GPU_CULLING_PHASE_LATE			1U
+#define GPU_CULLING_PHASE_COUNT			2U
+
+//Bounds and draw arguments of a graphics object, laid out like the objects of the culling shader
+struct GPUCullObject
+{
+	glm::vec4 CenterRadius;
+	glm::vec3 Extent;
+	uint32_t BatchIndex;
+	uint32_t FirstIndex;
+	uint32_t IndexCount;
+	//First command of the batch, the shader appends to it when the commands are compacted
+	uint32_t FirstDraw;
+	//Fixed command of the object, used when they are not
+	uint32_t DrawIndex;
+};
+
+//Objects that are drawn with the same descriptor set, they share one indirect draw call
+struct IndirectBatchVK
+{
+	const MeshVK* pMesh;
+	const Material* pMaterial;
+	uint32_t MaterialIndex;
+	uint32_t FirstDraw;
+	uint32_t MaxDrawCount;
+};
+
+//Frustum and occlusion culls the objects of a scene in a compute shader, which writes a VkDrawIndexedIndirectCommand and an instance index for every object
+//that is left. The objects are grouped by mesh and material, and every group is drawn with one indirect call, so the CPU cost of the geometry pass depends on
+//the number of groups instead of the number of objects. With VK_KHR_draw_indirect_count the commands of a group are compacted and counted, without it every
+//object keeps its own command and culled objects get zero instances.
+//Occlusion is culled in two phases against a depth pyramid (Haar and Aaltonen, "GPU-Driven Rendering Pipelines", SIGGRAPH 2015). The early phase reprojects
+//the objects with the matrices of the last frame and tests them against the pyramid of that frame. The pyramid is then built from the depth of the early phase,
+//and the late phase tests the objects that the early phase found occluded against it, which draws the objects that came into view without a frame of delay.
+//Only the geometry pass is culled here, the shadow map pass is still culled on the CPU
+class GPUCullerVK
+{
+	//Laid out like the std140 parameters of the culling shader, which is why there are no arrays of scalars
+	struct CullingParams
+	{
+		glm::vec4 FrustumPlanes[6];
+		glm::mat4 ViewProjection;
+		glm::mat4 LastViewProjection;
+		glm::vec2 HiZSize;
+		uint32_t HiZLevelCount;
+		uint32_t ObjectCount;
+		uint32_t FirstInstance;
+		uint32_t FirstLateInstance;
+		uint32_t IsCompacted;
+		uint32_t IsOcclusionEnabled;
+		uint32_t LateCommandOffset;
+		uint32_t LateCountOffset;
+		uint32_t Padding[2];
+	};
+
+public:
+	GPUCullerVK(GraphicsContextVK* pContext, HiZPyramidVK* pHiZPyramid);
+	~GPUCullerVK();
+
+	DECL_NO_COPY(GPUCullerVK);
+
+	bool init();
+	void initCounters(ProfilerVK* pProfiler);
+
+	//The commands of the culling shader start at other instances than zero, which needs drawIndirectFirstInstance
+	bool isSupported() const;
+
+	//Writes the bounds and the detail level of every object for the frame. The instance indices of each phase are written from its first instance in the
+	//buffer of the scene. The last matrices of the camera buffer have to be the ones that the depth pyramid was built with
+	bool beginFrame(uint32_t frameIndex, SceneVK* pScene, const CameraBuffer& cameraBuffer, uint32_t firstInstance, uint32_t firstLateInstance);
+	//Has to be recorded outside of a render pass, before the draws of the phase are executed. The late phase has to come after the pyramid has been built
+	void dispatch(CommandBufferVK* pCommandBuffer, uint32_t phase);
+	//Records one indirect draw for each group of objects
+	void draw(CommandBufferVK* pCommandBuffer, PipelineVK* pPipeline, PipelineLayoutVK* pPipelineLayout, SceneVK* pScene, uint32_t phase);
+
+	//The late phase only has objects to draw when the early phase tested them against a pyramid
+	FORCEINLINE bool hasLatePhase() const { return m_IsOcclusionEnabled; }
+
+private:
+	bool createPipeline();
+	bool reserveObjects(uint32_t objectCount, uint32_t batchCount);
+	void createBatches(SceneVK* pScene);
+
+private:
+	GraphicsContextVK* m_pContext;
+	HiZPyramidVK* m_pHiZPyramid;
+
+	PipelineVK* m_pPipeline;
+	PipelineLayoutVK* m_pPipelineLayout;
+	DescriptorSetLayoutVK* m_pDescriptorSetLayout;
+	DescriptorPoolVK* m_pDescriptorPool;
+	DescriptorSetVK* m_ppDescriptorSets[MAX_FRAMES_IN_FLIGHT];
+
+	//Written by the CPU every frame
+	BufferVK* m_ppParamsBuffers[MAX_FRAMES_IN_FLIGHT];
+	CullingParams* m_ppMappedParams[MAX_FRAMES_IN_FLIGHT];
+	BufferVK* m_ppObjectBuffers[MAX_FRAMES_IN_FLIGHT];
+	GPUCullObject* m_ppMappedObjects[MAX_FRAMES_IN_FLIGHT];
+	//Written by the culling shader, the commands and counts of the late phase follow the ones of the early phase
+	BufferVK* m_ppCommandBuffers[MAX_FRAMES_IN_FLIGHT];
+	BufferVK* m_ppCountBuffers[MAX_FRAMES_IN_FLIGHT];
+	//Marks the objects that the early phase found occluded, which are the only ones that the late phase tests
+	BufferVK* m_ppOccludedBuffers[MAX_FRAMES_IN_FLIGHT];
+	uint32_t m_ObjectCapacities[MAX_FRAMES_IN_FLIGHT];
+	uint32_t m_BatchCapacities[MAX_FRAMES_IN_FLIGHT];
+
+	//The batch of every object and its command within the batch, built again when objects are added to the scene
+	std::vector<IndirectBatchVK> m_Batches;
+	std::vector<uint32_t> m_ObjectBatches;
+	std::vector<uint32_t> m_ObjectDrawIndices;
+
+	ProfilerCounter m_BatchCounter;
+	uint32_t m_CurrentFrame;
+	uint32_t m_ObjectCount;
+	bool m_IsCompacted;
+	bool m_IsOcclusionEnabled;
+};
@@ -68,6 +68,7 @@ void GraphicsContextVK::init()
 	m_Device.addOptionalExtension(VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME);
 	//m_Device.addOptionalExtension(VK_KHR_MAINTENANCE3_EXTENSION_NAME);
 	m_Device.addOptionalExtension(VK_NV_RAY_TRACING_EXTENSION_NAME);
+	m_Device.addOptionalExtension(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
 
 	m_Device.finalize(&m_Instance);
 
@@ -0,0 +1,312 @@
+#include "HiZPyramidVK.h"
+#include "CommandBufferVK.h"
+#include "DescriptorPoolVK.h"
+#include "DescriptorSetLayoutVK.h"
+#include "DescriptorSetVK.h"
+#include "DeviceVK.h"
+#include "GBufferVK.h"
+#include "GraphicsContextVK.h"
+#include "ImageVK.h"
+#include "ImageViewVK.h"
+#include "PipelineLayoutVK.h"
+#include "PipelineVK.h"
+#include "SamplerVK.h"
+
+#include "Common/IShader.h"
+
+#include <algorithm>
+
+HiZPyramidVK::HiZPyramidVK(GraphicsContextVK* pContext)
+	: m_pContext(pContext),
+	m_pPipeline(nullptr),
+	m_pPipelineLayout(nullptr),
+	m_pDescriptorSetLayout(nullptr),
+	m_pDescriptorPool(nullptr),
+	m_pSampler(nullptr),
+	m_pDepthImage(nullptr),
+	m_pImage(nullptr),
+	m_pImageView(nullptr),
+	m_LevelViews(),
+	m_LevelDescriptorSets(),
+	m_Width(0),
+	m_Height(0),
+	m_LevelCount(0),
+	m_IsValid(false)
+{
+}
+
+HiZPyramidVK::~HiZPyramidVK()
+{
+	releasePyramid();
+
+	SAFEDELETE(m_pPipeline);
+	SAFEDELETE(m_pPipelineLayout);
+	SAFEDELETE(m_pDescriptorPool);
+	SAFEDELETE(m_pDescriptorSetLayout);
+	SAFEDELETE(m_pSampler);
+
+	m_pContext = nullptr;
+}
+
+bool HiZPyramidVK::init(GBufferVK* pGBuffer)
+{
+	DeviceVK* pDevice = m_pContext->getDevice();
+
+	SamplerParams samplerParams = {};
+	samplerParams.MinFilter = VK_FILTER_NEAREST;
+	samplerParams.MagFilter = VK_FILTER_NEAREST;
+	samplerParams.WrapModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerParams.WrapModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerParams.WrapModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+
+	m_pSampler = DBG_NEW SamplerVK(pDevice);
+	if (!m_pSampler->init(samplerParams))
+	{
+		LOG("-- HiZPyramidVK: Failed to create sampler");
+		return false;
+	}
+
+	//The depth of the G-buffer is only read by the first level, the others read the level below as a storage image
+	m_pDescriptorSetLayout = DBG_NEW DescriptorSetLayoutVK(pDevice);
+	m_pDescriptorSetLayout->addBindingCombinedImage(VK_SHADER_STAGE_COMPUTE_BIT, nullptr, 0, 1);
+	m_pDescriptorSetLayout->addBindingStorageImage(VK_SHADER_STAGE_COMPUTE_BIT, 1, 1);
+	m_pDescriptorSetLayout->addBindingStorageImage(VK_SHADER_STAGE_COMPUTE_BIT, 2, 1);
+	if (!m_pDescriptorSetLayout->finalize())
+	{
+		LOG("-- HiZPyramidVK: Failed to create descriptor set layout");
+		return false;
+	}
+
+	//The pool sizes are taken in order, so the buffer counts can not be left at zero
+	DescriptorCounts descriptorCounts	= {};
+	descriptorCounts.m_StorageBuffers	= 1;
+	descriptorCounts.m_UniformBuffers	= 1;
+	descriptorCounts.m_SampledImages	= HIZ_MAX_LEVEL_COUNT + 1;
+	descriptorCounts.m_StorageImages	= 2 * HIZ_MAX_LEVEL_COUNT + 1;
+
+	m_pDescriptorPool = DBG_NEW DescriptorPoolVK(pDevice);
+	if (!m_pDescriptorPool->init(descriptorCounts, HIZ_MAX_LEVEL_COUNT))
+	{
+		LOG("-- HiZPyramidVK: Failed to create descriptor pool");
+		return false;
+	}
+
+	for (uint32_t i = 0; i < HIZ_MAX_LEVEL_COUNT; i++)
+	{
+		DescriptorSetVK* pDescriptorSet = m_pDescriptorPool->allocDescriptorSet(m_pDescriptorSetLayout);
+		if (pDescriptorSet == nullptr)
+		{
+			LOG("-- HiZPyramidVK: Failed to allocate descriptor set");
+			return false;
+		}
+
+		m_LevelDescriptorSets.push_back(pDescriptorSet);
+	}
+
+	return createPipeline() && createPyramid(pGBuffer);
+}
+
+bool HiZPyramidVK::onWindowResize(GBufferVK* pGBuffer)
+{
+	releasePyramid();
+	return createPyramid(pGBuffer);
+}
+
+void HiZPyramidVK::build(CommandBufferVK* pCommandBuffer)
+{
+	VkImageMemoryBarrier pyramidBarrier = {};
+	pyramidBarrier.sType							= VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	pyramidBarrier.srcQueueFamilyIndex				= VK_QUEUE_FAMILY_IGNORED;
+	pyramidBarrier.dstQueueFamilyIndex				= VK_QUEUE_FAMILY_IGNORED;
+	pyramidBarrier.image							= m_pImage->getImage();
+	pyramidBarrier.subresourceRange.aspectMask		= VK_IMAGE_ASPECT_COLOR_BIT;
+	pyramidBarrier.subresourceRange.baseMipLevel	= 0;
+	pyramidBarrier.subresourceRange.levelCount		= m_LevelCount;
+	pyramidBarrier.subresourceRange.baseArrayLayer	= 0;
+	pyramidBarrier.subresourceRange.layerCount		= 1;
+
+	//The culling shader may have read the last pyramid earlier in the frame, its contents are thrown away
+	VkImageMemoryBarrier barriers[2] = { pyramidBarrier, pyramidBarrier };
+	barriers[0].srcAccessMask	= VK_ACCESS_SHADER_READ_BIT;
+	barriers[0].dstAccessMask	= VK_ACCESS_SHADER_WRITE_BIT;
+	barriers[0].oldLayout		= VK_IMAGE_LAYOUT_UNDEFINED;
+	barriers[0].newLayout		= VK_IMAGE_LAYOUT_GENERAL;
+
+	//The geometry pass leaves the depth readable by shaders
+	barriers[1].srcAccessMask						= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	barriers[1].dstAccessMask						= VK_ACCESS_SHADER_READ_BIT;
+	barriers[1].oldLayout							= VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	barriers[1].newLayout							= VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	barriers[1].image								= m_pDepthImage->getImage();
+	barriers[1].subresourceRange.aspectMask			= VK_IMAGE_ASPECT_DEPTH_BIT;
+	barriers[1].subresourceRange.levelCount			= 1;
+	pCommandBuffer->imageMemoryBarrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 2, barriers);
+
+	pCommandBuffer->bindPipeline(m_pPipeline);
+
+	PushConstants pushConstants = {};
+	pushConstants.SourceSize = glm::ivec2(int32_t(m_Width), int32_t(m_Height));
+	for (uint32_t level = 0; level < m_LevelCount; level++)
+	{
+		pushConstants.DestinationSize	= glm::max(glm::ivec2(int32_t(m_Width >> level), int32_t(m_Height >> level)), glm::ivec2(1));
+		pushConstants.IsFirstLevel		= (level == 0) ? 1 : 0;
+
+		pCommandBuffer->bindDescriptorSet(VK_PIPELINE_BIND_POINT_COMPUTE, m_pPipelineLayout, 0, 1, &m_LevelDescriptorSets[level], 0, nullptr);
+		pCommandBuffer->pushConstants(m_pPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &pushConstants);
+		pCommandBuffer->dispatch((pushConstants.DestinationSize.x + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, (pushConstants.DestinationSize.y + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, 1);
+
+		//The next level reads this one
+		VkImageMemoryBarrier levelBarrier = pyramidBarrier;
+		levelBarrier.srcAccessMask						= VK_ACCESS_SHADER_WRITE_BIT;
+		levelBarrier.dstAccessMask						= VK_ACCESS_SHADER_READ_BIT;
+		levelBarrier.oldLayout							= VK_IMAGE_LAYOUT_GENERAL;
+		levelBarrier.newLayout							= VK_IMAGE_LAYOUT_GENERAL;
+		levelBarrier.subresourceRange.baseMipLevel		= level;
+		levelBarrier.subresourceRange.levelCount		= 1;
+		pCommandBuffer->imageMemoryBarrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 1, &levelBarrier);
+
+		pushConstants.SourceSize = pushConstants.DestinationSize;
+	}
+
+	//Every level has been made visible to compute shaders above, only the layout is left
+	VkImageMemoryBarrier readBarrier = pyramidBarrier;
+	readBarrier.srcAccessMask	= VK_ACCESS_SHADER_READ_BIT;
+	readBarrier.dstAccessMask	= VK_ACCESS_SHADER_READ_BIT;
+	readBarrier.oldLayout		= VK_IMAGE_LAYOUT_GENERAL;
+	readBarrier.newLayout		= VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	pCommandBuffer->imageMemoryBarrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 1, &readBarrier);
+
+	m_IsValid = true;
+}
+
+bool HiZPyramidVK::createPipeline()
+{
+	DeviceVK* pDevice = m_pContext->getDevice();
+
+	IShader* pComputeShader = m_pContext->createShader();
+	pComputeShader->initFromFile(EShader::COMPUTE_SHADER, "main", "assets/shaders/hiZBuildCompute.spv");
+	if (!pComputeShader->finalize())
+	{
+		LOG("-- HiZPyramidVK: Failed to create compute shader");
+		SAFEDELETE(pComputeShader);
+		return false;
+	}
+
+	VkPushConstantRange pushConstantRange = {};
+	pushConstantRange.stageFlags	= VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset		= 0;
+	pushConstantRange.size			= sizeof(PushConstants);
+
+	m_pPipelineLayout = DBG_NEW PipelineLayoutVK(pDevice);
+	if (!m_pPipelineLayout->init({ m_pDescriptorSetLayout }, { pushConstantRange }))
+	{
+		LOG("-- HiZPyramidVK: Failed to create pipeline layout");
+		SAFEDELETE(pComputeShader);
+		return false;
+	}
+
+	m_pPipeline = DBG_NEW PipelineVK(pDevice);
+	const bool result = m_pPipeline->finalizeCompute(pComputeShader, m_pPipelineLayout);
+	if (!result)
+	{
+		LOG("-- HiZPyramidVK: Failed to create pipeline");
+	}
+
+	SAFEDELETE(pComputeShader);
+	return result;
+}
+
+bool HiZPyramidVK::createPyramid(GBufferVK* pGBuffer)
+{
+	DeviceVK* pDevice = m_pContext->getDevice();
+
+	const VkExtent2D extent = pGBuffer->getExtent();
+	m_pDepthImage	= pGBuffer->getDepthImage();
+	m_Width			= std::max(extent.width, 1U);
+	m_Height		= std::max(extent.height, 1U);
+
+	m_LevelCount = 1;
+	while ((std::max(m_Width, m_Height) >> m_LevelCount) > 0)
+	{
+		m_LevelCount++;
+	}
+	m_LevelCount = std::min(m_LevelCount, HIZ_MAX_LEVEL_COUNT);
+
+	ImageParams imageParams = {};
+	imageParams.Type			= VK_IMAGE_TYPE_2D;
+	imageParams.Samples			= VK_SAMPLE_COUNT_1_BIT;
+	imageParams.Usage			= VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	imageParams.MemoryProperty	= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	imageParams.Format			= VK_FORMAT_R32_SFLOAT;
+	imageParams.Extent			= { m_Width, m_Height, 1 };
+	imageParams.MipLevels		= m_LevelCount;
+	imageParams.ArrayLayers		= 1;
+
+	m_pImage = DBG_NEW ImageVK(pDevice);
+	if (!m_pImage->init(imageParams))
+	{
+		LOG("-- HiZPyramidVK: Failed to create image of size %ux%u", m_Width, m_Height);
+		return false;
+	}
+
+	ImageViewParams imageViewParams = {};
+	imageViewParams.Type			= VK_IMAGE_VIEW_TYPE_2D;
+	imageViewParams.AspectFlags		= VK_IMAGE_ASPECT_COLOR_BIT;
+	imageViewParams.LayerCount		= 1;
+	imageViewParams.FirstLayer		= 0;
+	imageViewParams.MipLevels		= m_LevelCount;
+	imageViewParams.FirstMipLevel	= 0;
+
+	m_pImageView = DBG_NEW ImageViewVK(pDevice, m_pImage);
+	if (!m_pImageView->init(imageViewParams))
+	{
+		LOG("-- HiZPyramidVK: Failed to create image view");
+		return false;
+	}
+
+	imageViewParams.MipLevels = 1;
+	for (uint32_t level = 0; level < m_LevelCount; level++)
+	{
+		imageViewParams.FirstMipLevel = level;
+
+		ImageViewVK* pLevelView = DBG_NEW ImageViewVK(pDevice, m_pImage);
+		if (!pLevelView->init(imageViewParams))
+		{
+			LOG("-- HiZPyramidVK: Failed to create image view of level %u", level);
+			SAFEDELETE(pLevelView);
+			return false;
+		}
+
+		m_LevelViews.push_back(pLevelView);
+	}
+
+	//The first level does not read a level below it, but the binding still has to be valid
+	const ImageViewVK* pDepthImageView	= pGBuffer->getDepthImageView();
+	const SamplerVK* pSampler			= m_pSampler;
+	for (uint32_t level = 0; level < m_LevelCount; level++)
+	{
+		DescriptorSetVK* pDescriptorSet = m_LevelDescriptorSets[level];
+		pDescriptorSet->writeCombinedImageDescriptors(&pDepthImageView, &pSampler, 1, 0);
+		pDescriptorSet->writeStorageImageDescriptor(m_LevelViews[(level > 0) ? level - 1 : 0], 1);
+		pDescriptorSet->writeStorageImageDescriptor(m_LevelViews[level], 2);
+	}
+
+	m_IsValid = false;
+	return true;
+}
+
+void HiZPyramidVK::releasePyramid()
+{
+	for (ImageViewVK* pLevelView : m_LevelViews)
+	{
+		SAFEDELETE(pLevelView);
+	}
+	m_LevelViews.clear();
+
+	SAFEDELETE(m_pImageView);
+	SAFEDELETE(m_pImage);
+
+	m_pDepthImage	= nullptr;
+	m_LevelCount	= 0;
+	m_IsValid		= false;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include "VulkanCommon.h"
+
+#include <vector>
+
+class CommandBufferVK;
+class DescriptorPoolVK;
+class DescriptorSetLayoutVK;
+class DescriptorSetVK;
+class GBufferVK;
+class GraphicsContextVK;
+class ImageVK;
+class ImageViewVK;
+class PipelineLayoutVK;
+class PipelineVK;
+class SamplerVK;
+
+//Has to match local_size_x and local_size_y of hiZBuildCompute.glsl
+#define HIZ_GROUP_SIZE			8U
+//Deepest pyramid that the descriptor pool has sets for, enough for a 16384 texel wide G-buffer
+#define HIZ_MAX_LEVEL_COUNT		15U
+
+//Depth pyramid built from the depth of the G-buffer, where every texel holds the farthest depth of the texels it covers one level below.
+//The first level has the size of the G-buffer and the levels of odd sizes also take in the last row and column, so that a texel never misses any of the
+//depth it covers. A box whose nearest depth lies behind the depth of the texels that it covers on screen is occluded
+class HiZPyramidVK
+{
+	struct PushConstants
+	{
+		glm::ivec2 SourceSize;
+		glm::ivec2 DestinationSize;
+		uint32_t IsFirstLevel;
+	};
+
+public:
+	HiZPyramidVK(GraphicsContextVK* pContext);
+	~HiZPyramidVK();
+
+	DECL_NO_COPY(HiZPyramidVK);
+
+	bool init(GBufferVK* pGBuffer);
+	//The G-buffer has to have been resized first
+	bool onWindowResize(GBufferVK* pGBuffer);
+
+	//Has to be recorded outside of a render pass, after the depth of the G-buffer has been written. The pyramid is left readable by compute shaders
+	void build(CommandBufferVK* pCommandBuffer);
+	//The pyramid no longer matches the last frame, e.g. when a frame was drawn without it
+	FORCEINLINE void invalidate() { m_IsValid = false; }
+
+	FORCEINLINE bool			isValid() const			{ return m_IsValid; }
+	FORCEINLINE ImageViewVK*	getImageView() const	{ return m_pImageView; }
+	FORCEINLINE SamplerVK*		getSampler() const		{ return m_pSampler; }
+	FORCEINLINE glm::vec2		getSize() const			{ return glm::vec2(float(m_Width), float(m_Height)); }
+	FORCEINLINE uint32_t		getLevelCount() const	{ return m_LevelCount; }
+
+private:
+	bool createPipeline();
+	bool createPyramid(GBufferVK* pGBuffer);
+	void releasePyramid();
+
+private:
+	GraphicsContextVK* m_pContext;
+
+	PipelineVK* m_pPipeline;
+	PipelineLayoutVK* m_pPipelineLayout;
+	DescriptorSetLayoutVK* m_pDescriptorSetLayout;
+	DescriptorPoolVK* m_pDescriptorPool;
+	SamplerVK* m_pSampler;
+
+	ImageVK* m_pDepthImage;
+	ImageVK* m_pImage;
+	//View of every level, which the culling shader reads
+	ImageViewVK* m_pImageView;
+	//One view and descriptor set per level, every level is built from the one below it
+	std::vector<ImageViewVK*> m_LevelViews;
+	std::vector<DescriptorSetVK*> m_LevelDescriptorSets;
+
+	uint32_t m_Width;
+	uint32_t m_Height;
+	uint32_t m_LevelCount;
+	bool m_IsValid;
+};
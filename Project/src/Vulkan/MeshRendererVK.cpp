@@ -18,6 +18,8 @@
 #include "ImageVK.h"
 #include "ShaderVK.h"
 #include "GBufferVK.h"
+#include "GPUCullerVK.h"
+#include "ParallelRecorderVK.h"
 #include "TextureCubeVK.h"
 #include "FrameBufferVK.h"
 #include "ImageViewVK.h"
@@ -34,6 +36,8 @@ MeshRendererVK::MeshRendererVK(GraphicsContextVK* pContext, RenderingHandlerVK*
 	m_pRenderingHandler(pRenderingHandler),
 	m_ppGeometryPassPools(),
 	m_ppGeometryPassBuffers(),
+	m_pGeometryRecorder(nullptr),
+	m_GeometryInheritanceInfo(),
 	m_pSkyboxPipeline(nullptr),
 	m_pLightDescriptorSet(nullptr),
 	m_pGBufferSampler(nullptr),
@@ -47,6 +51,7 @@ MeshRendererVK::MeshRendererVK(GraphicsContextVK* pContext, RenderingHandlerVK*
 	m_pIntegrationLUT(nullptr),
 	m_pGPassProfiler(nullptr),
 	m_pLightPassProfiler(nullptr),
+	m_DrawQueue(VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 1),
 	m_ClearColor(),
 	m_ClearDepth(),
 	m_Viewport(),
@@ -67,6 +72,8 @@ MeshRendererVK::~MeshRendererVK()
 		SAFEDELETE(m_ppLightPassPools[i]);
 	}
 
+	SAFEDELETE(m_pGeometryRecorder);
+
 	SAFEDELETE(m_pGPassProfiler);
 	SAFEDELETE(m_pLightPassProfiler);
 
@@ -156,6 +163,10 @@ void MeshRendererVK::beginFrame(IScene* pScene)
 
 	m_CurrentFrame = (m_CurrentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
 
+	m_TriangleCounter.value				= 0;
+	m_FullDetailTriangleCounter.value	= 0;
+	m_DrawQueue.reset();
+
 	m_ppGeometryPassBuffers[m_CurrentFrame]->reset(false);
 	m_ppGeometryPassPools[m_CurrentFrame]->reset();
 
@@ -163,15 +174,15 @@ void MeshRendererVK::beginFrame(IScene* pScene)
 	RenderPassVK*	pGeometryRenderPass	= m_pRenderingHandler->getGeometryRenderPass();
 	FrameBufferVK*	pFramebuffer		= m_pRenderingHandler->getGBuffer()->getFrameBuffer();
 
-	VkCommandBufferInheritanceInfo inheritanceInfo = {};
-	inheritanceInfo.sType		= VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
-	inheritanceInfo.pNext		= nullptr;
-	inheritanceInfo.renderPass	= pGeometryRenderPass->getRenderPass();
+	m_GeometryInheritanceInfo = {};
+	m_GeometryInheritanceInfo.sType			= VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	m_GeometryInheritanceInfo.pNext			= nullptr;
+	m_GeometryInheritanceInfo.renderPass	= pGeometryRenderPass->getRenderPass();
 	//TODO: Not use subpass zero all the time?
-	inheritanceInfo.subpass		= 0;
-	inheritanceInfo.framebuffer = pFramebuffer->getFrameBuffer();
+	m_GeometryInheritanceInfo.subpass		= 0;
+	m_GeometryInheritanceInfo.framebuffer	= pFramebuffer->getFrameBuffer();
 
-	m_ppGeometryPassBuffers[m_CurrentFrame]->begin(&inheritanceInfo, VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT);
+	m_ppGeometryPassBuffers[m_CurrentFrame]->begin(&m_GeometryInheritanceInfo, VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT);
 	m_pGPassProfiler->beginFrame(m_ppGeometryPassBuffers[m_CurrentFrame]);
 
 	// Begin geometrypass
@@ -183,13 +194,38 @@ void MeshRendererVK::endFrame(IScene* pScene)
 {
 	UNREFERENCED_PARAMETER(pScene);
 
-	m_pGPassProfiler->endFrame();
+	m_ppGeometryPassBuffers[m_CurrentFrame]->end();
 
-	m_ppGeometryPassBuffers[m_CurrentFrame]->bindPipeline(m_pSkyboxPipeline);
-	m_ppGeometryPassBuffers[m_CurrentFrame]->bindDescriptorSet(VK_PIPELINE_BIND_POINT_GRAPHICS, m_pSkyboxPipelineLayout, 0, 1, &m_pSkyboxDescriptorSet, 0, nullptr);
-	m_ppGeometryPassBuffers[m_CurrentFrame]->drawInstanced(36, 1, 0, 0);
+	//The sorted draws are split into chunks that the frame workers record into their own secondary buffers
+	m_DrawQueue.prepare(m_pScene);
 
-	m_ppGeometryPassBuffers[m_CurrentFrame]->end();
+	uint32_t chunkStarts[PARALLEL_RECORDER_MAX_CHUNKS + 1];
+	const uint32_t chunkCount = m_DrawQueue.split(m_pGeometryRecorder->getChunkCapacity(), chunkStarts);
+
+	DrawQueueStatsVK chunkStats[PARALLEL_RECORDER_MAX_CHUNKS];
+	m_pGeometryRecorder->record(uint32_t(m_CurrentFrame), chunkCount, &m_GeometryInheritanceInfo, [&](CommandBufferVK* pCommandBuffer, uint32_t chunk)
+		{
+			pCommandBuffer->setViewports(&m_Viewport, 1);
+			pCommandBuffer->setScissorRects(&m_ScissorRect, 1);
+
+			m_DrawQueue.submitRange(pCommandBuffer, m_pScene->getGeometryPipelineLayout(), m_pScene, uint32_t(m_CurrentFrame), INSTANCE_INDICES_PASS_GEOMETRY, chunkStarts[chunk], chunkStarts[chunk + 1], chunkStats[chunk]);
+
+			//The last chunk is executed last, so it ends the timestamps of the pass and draws the skybox
+			if (chunk == chunkCount - 1)
+			{
+				m_pGPassProfiler->setProfiledCommandBuffer(pCommandBuffer);
+				m_pGPassProfiler->endFrame();
+
+				pCommandBuffer->bindPipeline(m_pSkyboxPipeline);
+				pCommandBuffer->bindDescriptorSet(VK_PIPELINE_BIND_POINT_GRAPHICS, m_pSkyboxPipelineLayout, 0, 1, &m_pSkyboxDescriptorSet, 0, nullptr);
+				pCommandBuffer->drawInstanced(36, 1, 0, 0);
+			}
+		});
+
+	for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+	{
+		m_DrawQueue.addStats(chunkStats[chunk]);
+	}
 }
 
 void MeshRendererVK::renderUI()
@@ -257,24 +293,37 @@ void MeshRendererVK::setRayTracingResultImages(ImageViewVK* pRadianceImageView,
 	m_pLightDescriptorSet->writeCombinedImageDescriptors(&pGlossyImageView, &m_pRTSampler, 1, LP_GLOSSY_BINDING);
 }
 
-void MeshRendererVK::submitMesh(const MeshVK* pMesh, const Material* pMaterial, uint32_t materialIndex, uint32_t transformsIndex)
+void MeshRendererVK::submitMesh(const MeshVK* pMesh, const Material* pMaterial, uint32_t materialIndex, uint32_t transformsIndex, const IndexRangeVK& indexRange, float depth)
 {
 	ASSERT(pMesh != nullptr);
 
-	m_ppGeometryPassBuffers[m_CurrentFrame]->bindPipeline(m_pGeometryPipeline);
+	m_FullDetailTriangleCounter.value += pMesh->getIndexCount() / 3;
+	if (indexRange.IndexCount == 0)
+	{
+		return;
+	}
 
-	PipelineLayoutVK* pGeometryPassLayout = m_pScene->getGeometryPipelineLayout();
+	m_DrawQueue.push(m_pGeometryPipeline, pMesh, pMaterial, indexRange, transformsIndex, &materialIndex, depth);
+	m_TriangleCounter.value += indexRange.IndexCount / 3;
+}
 
-	uint32_t pushConstants[2] = { materialIndex, transformsIndex };
-	m_ppGeometryPassBuffers[m_CurrentFrame]->pushConstants(pGeometryPassLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(uint32_t) * 2, &pushConstants);
+void MeshRendererVK::submitIndirect(GPUCullerVK* pGPUCuller)
+{
+	pGPUCuller->draw(m_ppGeometryPassBuffers[m_CurrentFrame], m_pGeometryPipeline, m_pScene->getGeometryPipelineLayout(), m_pScene, GPU_CULLING_PHASE_EARLY);
+}
 
-	BufferVK* pIndexBuffer = reinterpret_cast<BufferVK*>(pMesh->getIndexBuffer());
-	m_ppGeometryPassBuffers[m_CurrentFrame]->bindIndexBuffer(pIndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+void MeshRendererVK::drawLateGeometry(CommandBufferVK* pCommandBuffer, GPUCullerVK* pGPUCuller)
+{
+	pCommandBuffer->setViewports(&m_Viewport, 1);
+	pCommandBuffer->setScissorRects(&m_ScissorRect, 1);
 
-	DescriptorSetVK* pDescriptorSet = m_pScene->getDescriptorSetFromMeshAndMaterial(pMesh, pMaterial);
-	m_ppGeometryPassBuffers[m_CurrentFrame]->bindDescriptorSet(VK_PIPELINE_BIND_POINT_GRAPHICS, pGeometryPassLayout, 0, 1, &pDescriptorSet, 0, nullptr);
+	pGPUCuller->draw(pCommandBuffer, m_pGeometryPipeline, m_pScene->getGeometryPipelineLayout(), m_pScene, GPU_CULLING_PHASE_LATE);
+}
 
-	m_ppGeometryPassBuffers[m_CurrentFrame]->drawIndexInstanced(pMesh->getIndexCount(), 1, 0, 0, 0);
+void MeshRendererVK::executeGeometryPass(CommandBufferVK* pPrimaryBuffer)
+{
+	pPrimaryBuffer->executeSecondary(m_ppGeometryPassBuffers[m_CurrentFrame]);
+	m_pGeometryRecorder->execute(pPrimaryBuffer, uint32_t(m_CurrentFrame));
 }
 
 void MeshRendererVK::buildLightPass(RenderPassVK* pRenderPass, FrameBufferVK* pFramebuffer)
@@ -435,6 +484,12 @@ bool MeshRendererVK::createCommandPoolAndBuffers()
 		m_ppLightPassBuffers[i]->setName(name.c_str());
 	}
 
+	m_pGeometryRecorder = DBG_NEW ParallelRecorderVK(pDevice);
+	if (!m_pGeometryRecorder->init(graphicsQueueIndex, "GeometryPass"))
+	{
+		return false;
+	}
+
 	return true;
 }
 
@@ -443,6 +498,8 @@ bool MeshRendererVK::createPipelines()
 	RenderPassVK* pGeometryRenderPass	= m_pRenderingHandler->getGeometryRenderPass();
 	RenderPassVK* pBackbufferRenderPass = m_pRenderingHandler->getBackBufferRenderPass();
 
+	SceneVK* pScene = reinterpret_cast<SceneVK*>(m_pRenderingHandler->getScene());
+
 	//Geometry Pass
 	IShader* pVertexShader = m_pContext->createShader();
 	pVertexShader->initFromFile(EShader::VERTEX_SHADER, "main", "assets/shaders/geometryVertex.spv");
@@ -450,6 +507,7 @@ bool MeshRendererVK::createPipelines()
 	{
 		return false;
 	}
+	reinterpret_cast<ShaderVK*>(pVertexShader)->setSpecializationConstant<uint32_t>(0, uint32_t(pScene->getVertexFormat()));
 
 	IShader* pPixelShader = m_pContext->createShader();
 	pPixelShader->initFromFile(EShader::PIXEL_SHADER, "main", "assets/shaders/geometryFragment.spv");
@@ -482,8 +540,6 @@ bool MeshRendererVK::createPipelines()
 	depthStencilState.stencilTestEnable = VK_FALSE;
 	m_pGeometryPipeline->setDepthStencilState(depthStencilState);
 
-	SceneVK* pScene = reinterpret_cast<SceneVK*>(m_pRenderingHandler->getScene());
-
 	std::vector<const IShader*> shaders = { pVertexShader, pPixelShader };
 	if (!m_pGeometryPipeline->finalizeGraphics(shaders, pGeometryRenderPass, pScene->getGeometryPipelineLayout()))
 	{
@@ -719,4 +775,7 @@ void MeshRendererVK::createProfiler()
 	m_pGPassProfiler		= DBG_NEW ProfilerVK("Mesh Renderer: Geometry Pass", m_pContext->getDevice());
 	m_pLightPassProfiler	= DBG_NEW ProfilerVK("Mesh Renderer: Light Pass", m_pContext->getDevice());
 	//m_pGPassProfiler->initTimestamp(&m_TimestampGeometry, "Draw indexed");
+	m_pGPassProfiler->initCounter(&m_TriangleCounter, "Triangles");
+	m_pGPassProfiler->initCounter(&m_FullDetailTriangleCounter, "Triangles without LODs");
+	m_DrawQueue.initCounters(m_pGPassProfiler);
 }
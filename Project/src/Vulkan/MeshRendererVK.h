@@ -3,7 +3,9 @@
 #include "Common/IRenderer.h"
 #include "Core/Material.h"
 
+#include "DrawQueueVK.h"
 #include "MeshVK.h"
+#include "MeshletCullerVK.h"
 #include "ProfilerVK.h"
 
 #include <unordered_map>
@@ -16,6 +18,8 @@ class DescriptorSetVK;
 class DescriptorPoolVK;
 class FrameBufferVK;
 class GBufferVK;
+class GPUCullerVK;
+class ParallelRecorderVK;
 class SamplerVK;
 class PipelineVK;
 class Texture2DVK;
@@ -64,7 +68,14 @@ public:
 	void setSkybox(TextureCubeVK* pSkybox, TextureCubeVK* pIrradiance, TextureCubeVK* pEnvironmentMap);
 	void setRayTracingResultImages(ImageViewVK* pRadianceImageView, ImageViewVK* pGlossyImageView);
 
-	void submitMesh(const MeshVK* pMesh, const Material* pMaterial, uint32_t materialIndex, uint32_t transformsIndex);
+	void submitMesh(const MeshVK* pMesh, const Material* pMaterial, uint32_t materialIndex, uint32_t transformsIndex, const IndexRangeVK& indexRange, float depth);
+	//Draws the objects that the GPU culler has culled this frame, instead of the ones submitted one at a time
+	void submitIndirect(GPUCullerVK* pGPUCuller);
+	//Records the late phase of the GPU culler into a render pass of the primary buffer that loads the G-buffer
+	void drawLateGeometry(CommandBufferVK* pCommandBuffer, GPUCullerVK* pGPUCuller);
+
+	//Executes the geometry buffer followed by the chunks of draws that were recorded in parallel
+	void executeGeometryPass(CommandBufferVK* pPrimaryBuffer);
 
 	void buildLightPass(RenderPassVK* pRenderPass, FrameBufferVK* pFramebuffer);
 
@@ -80,7 +91,9 @@ public:
 	FORCEINLINE ProfilerVK*			getLightProfiler() const			{ return m_pLightPassProfiler; }
 	FORCEINLINE ProfilerVK*			getGeometryProfiler() const			{ return m_pGPassProfiler; }
 	FORCEINLINE CommandBufferVK*	getGeometryCommandBuffer() const	{ return m_ppGeometryPassBuffers[m_CurrentFrame]; }
+	FORCEINLINE ParallelRecorderVK*	getGeometryRecorder() const			{ return m_pGeometryRecorder; }
 	FORCEINLINE CommandBufferVK*	getLightCommandBuffer() const		{ return m_ppLightPassBuffers[m_CurrentFrame]; }
+	FORCEINLINE uint32_t			getCurrentFrame() const				{ return uint32_t(m_CurrentFrame); }
 
 private:
 	bool generateBRDFLookUp();
@@ -102,12 +115,20 @@ private:
 	RenderingHandlerVK* m_pRenderingHandler;
 	ProfilerVK*			m_pGPassProfiler;
 	ProfilerVK*			m_pLightPassProfiler;
+	//Triangles drawn in the geometry pass, and how many it would have been without detail levels
+	ProfilerCounter		m_TriangleCounter;
+	ProfilerCounter		m_FullDetailTriangleCounter;
+	//Draws of the geometry pass, recorded sorted by state when the frame ends
+	DrawQueueVK			m_DrawQueue;
 
 	// Per frame
 	SceneVK* m_pScene;
 
+	//Holds the commands before the draws of the queue, which are recorded into the chunks of the recorder
 	CommandPoolVK*		m_ppGeometryPassPools[MAX_FRAMES_IN_FLIGHT];
 	CommandBufferVK*	m_ppGeometryPassBuffers[MAX_FRAMES_IN_FLIGHT];
+	ParallelRecorderVK*	m_pGeometryRecorder;
+	VkCommandBufferInheritanceInfo m_GeometryInheritanceInfo;
 
 	CommandPoolVK*		m_ppLightPassPools[MAX_FRAMES_IN_FLIGHT];
 	CommandBufferVK*	m_ppLightPassBuffers[MAX_FRAMES_IN_FLIGHT];
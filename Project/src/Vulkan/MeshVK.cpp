@@ -5,7 +5,8 @@
 #include "CommandPoolVK.h"
 #include "CommandBufferVK.h"
 
-#include <tinyobjloader/tiny_obj_loader.h>
+#include "Core/MeshCache.h"
+
 #include <array>
 
 uint32_t MeshVK::s_ID = 0;
@@ -14,8 +15,15 @@ MeshVK::MeshVK(DeviceVK* pDevice)
 	: m_pDevice(pDevice),
 	m_pVertexBuffer(nullptr),
 	m_pIndexBuffer(nullptr),
-	m_IndexCount(0),
 	m_VertexCount(0),
+	m_LODs(),
+	m_LODCount(0),
+	m_BoundsMin(0.0f),
+	m_BoundsMax(0.0f),
+	m_BoundingRadius(0.0f),
+	m_Meshlets(),
+	m_CPUIndices(),
+	m_VertexFormat(EVertexFormat::STANDARD),
 	m_ID(s_ID++)
 {
 }
@@ -28,87 +36,84 @@ MeshVK::~MeshVK()
 	m_pDevice = 0;
 }
 
-bool MeshVK::initFromFile(const std::string& filepath)
+bool MeshVK::initFromFile(const std::string& filepath, EVertexFormat vertexFormat)
 {
-	tinyobj::attrib_t attributes;
-	std::vector<tinyobj::shape_t> shapes;
-	std::vector<tinyobj::material_t> materials;
-	std::string warn, err;
-
-	if (!tinyobj::LoadObj(&attributes, &shapes, &materials, &warn, &err, filepath.c_str(), nullptr, true, false)) 
+	//All shapes are welded into one mesh
+	MeshCache meshCache;
+	if (!meshCache.load(filepath, true, nullptr))
 	{
-		LOG("Failed to load mesh '%s'. Warning: %s Error: %s", filepath.c_str(), warn.c_str(), err.c_str());
+		LOG("Failed to load mesh '%s'", filepath.c_str());
 		return false;
 	}
 
-	std::vector<Vertex> vertices = {};
-	std::vector<uint32_t> indices = {};
-	std::unordered_map<Vertex, uint32_t> uniqueVertices = {};
+	//TODO: Calculate normals
 
-	for (const tinyobj::shape_t& shape : shapes) 
+	LOG("-- LOADED MESH: %s", filepath.c_str());
+	const MeshCacheShape& shape = meshCache.getShape(0);
+	if (vertexFormat == EVertexFormat::STANDARD)
 	{
-		for (const tinyobj::index_t& index : shape.mesh.indices) 
+		if (!initFromMemory(meshCache.getVertices(), sizeof(Vertex), meshCache.getVertexCount(), meshCache.getIndices(), meshCache.getIndexCount()))
 		{
-			Vertex vertex = {};
-
-			//Normals and texcoords are optional, while positions are required
-			ASSERT(index.vertex_index >= 0);
-			
-			vertex.Position = 
-			{
-				attributes.vertices[3 * index.vertex_index + 0],
-				attributes.vertices[3 * index.vertex_index + 1],
-				attributes.vertices[3 * index.vertex_index + 2]
-			};
-
-			if (index.normal_index >= 0)
-			{
-				vertex.Normal =
-				{
-					attributes.normals[3 * index.normal_index + 0],
-					attributes.normals[3 * index.normal_index + 1],
-					attributes.normals[3 * index.normal_index + 2]
-				};
-			}
-			
-			if (index.texcoord_index >= 0)
-			{
-				vertex.TexCoord = 
-				{
-					attributes.texcoords[2 * index.texcoord_index + 0],
-					1.0f -	attributes.texcoords[2 * index.texcoord_index + 1]
-				};
-			}
-
-			if (uniqueVertices.count(vertex) == 0) 
-			{
-				uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-				vertices.push_back(vertex);
-			}
-			 
-			indices.push_back(uniqueVertices[vertex]);
+			return false;
 		}
+
+		setLODs(shape.LODs, shape.LODCount);
+		setMeshlets(meshCache.getMeshlets() + shape.FirstMeshlet, shape.MeshletCount, meshCache.getIndices());
+		return true;
 	}
 
-	//Calculate tangents
-	for (uint32_t index = 0; index < indices.size(); index += 3)
-	{
-		Vertex& v0 = vertices[indices[index + 0]];
-		Vertex& v1 = vertices[indices[index + 1]];
-		Vertex& v2 = vertices[indices[index + 2]];
+	std::vector<PackedVertex> packedVertices(meshCache.getVertexCount());
+	VertexPacker::pack(meshCache.getVertices(), meshCache.getVertexCount(), packedVertices.data());
 
-		v0.calculateTangent(v1, v2);
-		v1.calculateTangent(v2, v0);
-		v2.calculateTangent(v0, v1);
+	if (!initBuffers(sizeof(PackedVertex), meshCache.getVertexCount(), meshCache.getIndexCount(), vertexFormat))
+	{
+		return false;
 	}
 
-	//TODO: Calculate normals
+	setLODs(shape.LODs, shape.LODCount);
+	setBounds(shape.BoundsMin, shape.BoundsMax, shape.BoundingRadius);
+	setMeshlets(meshCache.getMeshlets() + shape.FirstMeshlet, shape.MeshletCount, meshCache.getIndices());
 
-	LOG("-- LOADED MESH: %s", filepath.c_str());
-	return initFromMemory(vertices.data(), sizeof(Vertex), uint32_t(vertices.size()), indices.data(), uint32_t(indices.size()));
+	CopyHandlerVK* pCopyHandler = m_pDevice->getCopyHandler();
+	pCopyHandler->updateBuffer(m_pVertexBuffer, 0, packedVertices.data(), m_pVertexBuffer->getSizeInBytes());
+	pCopyHandler->updateBuffer(m_pIndexBuffer, 0, meshCache.getIndices(), m_pIndexBuffer->getSizeInBytes());
+	return true;
 }
 
 bool MeshVK::initFromMemory(const void* pVertices, size_t vertexSize, uint32_t vertexCount, const uint32_t* pIndices, uint32_t indexCount)
+{
+	if (!initBuffers(vertexSize, vertexCount, indexCount, EVertexFormat::STANDARD))
+	{
+		return false;
+	}
+
+	//Both vertex formats start with the position
+	const uint8_t* pVertexData = reinterpret_cast<const uint8_t*>(pVertices);
+	glm::vec3 boundsMin(0.0f);
+	glm::vec3 boundsMax(0.0f);
+	for (uint32_t v = 0; v < vertexCount; v++)
+	{
+		const glm::vec3& position = *reinterpret_cast<const glm::vec3*>(pVertexData + vertexSize * v);
+		boundsMin = (v == 0) ? position : glm::min(boundsMin, position);
+		boundsMax = (v == 0) ? position : glm::max(boundsMax, position);
+	}
+
+	const glm::vec3 center	= (boundsMin + boundsMax) * 0.5f;
+	float radiusSquared		= 0.0f;
+	for (uint32_t v = 0; v < vertexCount; v++)
+	{
+		const glm::vec3 offset = *reinterpret_cast<const glm::vec3*>(pVertexData + vertexSize * v) - center;
+		radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+	}
+	setBounds(boundsMin, boundsMax, std::sqrt(radiusSquared));
+
+	CopyHandlerVK* pCopyHandler = m_pDevice->getCopyHandler();
+	pCopyHandler->updateBuffer(m_pVertexBuffer, 0, pVertices, m_pVertexBuffer->getSizeInBytes());
+	pCopyHandler->updateBuffer(m_pIndexBuffer, 0, pIndices, m_pIndexBuffer->getSizeInBytes());
+	return true;
+}
+
+bool MeshVK::initBuffers(size_t vertexSize, uint32_t vertexCount, uint32_t indexCount, EVertexFormat vertexFormat)
 {
 	BufferParams vertexBufferParams = {};
 	vertexBufferParams.Usage			= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
@@ -134,15 +139,51 @@ bool MeshVK::initFromMemory(const void* pVertices, size_t vertexSize, uint32_t v
 		return false;
 	}
 
-	CopyHandlerVK* pCopyHandler = m_pDevice->getCopyHandler();
-	pCopyHandler->updateBuffer(m_pVertexBuffer, 0, pVertices, vertexBufferParams.SizeInBytes);
-	pCopyHandler->updateBuffer(m_pIndexBuffer, 0, pIndices, indexBufferParams.SizeInBytes);
-
 	m_VertexCount	= vertexCount;
-	m_IndexCount	= indexCount;
+	m_VertexFormat	= vertexFormat;
+
+	const MeshLOD lod = { 0, indexCount, 0.0f };
+	setLODs(&lod, 1);
 	return true;
 }
 
+void MeshVK::getBufferUpdates(BufferUpdateVK& vertexUpdate, BufferUpdateVK& indexUpdate, const void* pVertices, const uint32_t* pIndices) const
+{
+	vertexUpdate.pDestination		= m_pVertexBuffer;
+	vertexUpdate.DestinationOffset	= 0;
+	vertexUpdate.pSource			= pVertices;
+	vertexUpdate.SizeInBytes		= m_pVertexBuffer->getSizeInBytes();
+
+	indexUpdate.pDestination		= m_pIndexBuffer;
+	indexUpdate.DestinationOffset	= 0;
+	indexUpdate.pSource				= pIndices;
+	indexUpdate.SizeInBytes			= m_pIndexBuffer->getSizeInBytes();
+}
+
+void MeshVK::setLODs(const MeshLOD* pLODs, uint32_t lodCount)
+{
+	ASSERT(lodCount > 0 && lodCount <= MESH_MAX_LOD_COUNT);
+
+	m_LODCount = lodCount;
+	for (uint32_t l = 0; l < lodCount; l++)
+	{
+		m_LODs[l] = pLODs[l];
+	}
+}
+
+void MeshVK::setBounds(const glm::vec3& boundsMin, const glm::vec3& boundsMax, float boundingRadius)
+{
+	m_BoundsMin			= boundsMin;
+	m_BoundsMax			= boundsMax;
+	m_BoundingRadius	= boundingRadius;
+}
+
+void MeshVK::setMeshlets(const Meshlet* pMeshlets, uint32_t meshletCount, const uint32_t* pIndices)
+{
+	m_Meshlets.assign(pMeshlets, pMeshlets + meshletCount);
+	m_CPUIndices.assign(pIndices, pIndices + m_LODs[0].IndexCount);
+}
+
 bool MeshVK::initAsSphere(uint32_t subDivisions)
 {
 	const float X = 0.525731112119133606f;
@@ -275,7 +316,7 @@ IBuffer* MeshVK::getIndexBuffer() const
 
 uint32_t MeshVK::getIndexCount() const
 {
-	return m_IndexCount;
+	return m_LODs[0].IndexCount;
 }
 
 uint32_t MeshVK::getVertexCount() const
@@ -288,6 +329,11 @@ uint32_t MeshVK::getMeshID() const
 	return m_ID;
 }
 
+EVertexFormat MeshVK::getVertexFormat() const
+{
+	return m_VertexFormat;
+}
+
 uint32_t MeshVK::vertexForEdge(std::map<std::pair<uint32_t, uint32_t>, uint32_t>& lookup, std::vector<glm::vec3>& vertices, uint32_t first, uint32_t second)
 {
 	std::map<std::pair<uint32_t, uint32_t>, uint32_t>::key_type key(first, second);
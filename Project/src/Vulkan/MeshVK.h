@@ -1,10 +1,13 @@
 #pragma once
 #include "Common/IMesh.h"
+#include "Core/MeshSimplifier.h"
+#include "Core/Meshlet.h"
 
 #include <map>
 
 class BufferVK;
 class DeviceVK;
+struct BufferUpdateVK;
 
 class MeshVK : public IMesh
 {
@@ -17,7 +20,7 @@ public:
 	MeshVK(DeviceVK* pDevice);
 	~MeshVK();
 
-	virtual bool initFromFile(const std::string& filepath) override;
+	virtual bool initFromFile(const std::string& filepath, EVertexFormat vertexFormat = EVertexFormat::STANDARD) override;
 	virtual bool initFromMemory(const void* pVertices, size_t vertexSize, uint32_t vertexCount, const uint32_t* pIndices, uint32_t indexCount) override;
 	virtual bool initAsSphere(uint32_t subDivisions) override;
 	virtual bool initAsCube() override;
@@ -25,10 +28,30 @@ public:
 	virtual IBuffer* getVertexBuffer() const override;
 	virtual IBuffer* getIndexBuffer() const override;
 
+	//Index count of the full detail level, the index buffer also contains the other levels after it
 	virtual uint32_t getIndexCount() const override;
 	virtual uint32_t getVertexCount() const override;
 
 	virtual uint32_t getMeshID() const override;
+	virtual EVertexFormat getVertexFormat() const override;
+
+	//Creates the buffers without filling them, used when the data is uploaded in a batch together with other meshes
+	bool initBuffers(size_t vertexSize, uint32_t vertexCount, uint32_t indexCount, EVertexFormat vertexFormat);
+	void getBufferUpdates(BufferUpdateVK& vertexUpdate, BufferUpdateVK& indexUpdate, const void* pVertices, const uint32_t* pIndices) const;
+	//Meshes have a single detail level covering the whole index buffer unless the levels are set
+	void setLODs(const MeshLOD* pLODs, uint32_t lodCount);
+	//The radius is measured from the center of the bounds and is usually a lot tighter than half the diagonal
+	void setBounds(const glm::vec3& boundsMin, const glm::vec3& boundsMax, float boundingRadius);
+	//Keeps a copy of the meshlets and the full detail indices on the CPU, which the meshlet culling compacts the visible indices from
+	void setMeshlets(const Meshlet* pMeshlets, uint32_t meshletCount, const uint32_t* pIndices);
+
+	FORCEINLINE uint32_t			getLODCount() const				{ return m_LODCount; }
+	FORCEINLINE const MeshLOD&		getLOD(uint32_t lod) const		{ return m_LODs[lod]; }
+	FORCEINLINE const glm::vec3&	getBoundsMin() const			{ return m_BoundsMin; }
+	FORCEINLINE const glm::vec3&	getBoundsMax() const			{ return m_BoundsMax; }
+	FORCEINLINE float				getBoundingRadius() const		{ return m_BoundingRadius; }
+	FORCEINLINE const std::vector<Meshlet>&		getMeshlets() const		{ return m_Meshlets; }
+	FORCEINLINE const std::vector<uint32_t>&	getCPUIndices() const	{ return m_CPUIndices; }
 
 private:
 	uint32_t vertexForEdge(std::map<std::pair<uint32_t, uint32_t>, uint32_t>& lookup, std::vector<glm::vec3>& vertices, uint32_t first, uint32_t second);
@@ -39,7 +62,14 @@ private:
 	BufferVK* m_pVertexBuffer;
 	BufferVK* m_pIndexBuffer;
 	uint32_t m_VertexCount;
-	uint32_t m_IndexCount;
+	MeshLOD m_LODs[MESH_MAX_LOD_COUNT];
+	uint32_t m_LODCount;
+	glm::vec3 m_BoundsMin;
+	glm::vec3 m_BoundsMax;
+	float m_BoundingRadius;
+	std::vector<Meshlet> m_Meshlets;
+	std::vector<uint32_t> m_CPUIndices;
+	EVertexFormat m_VertexFormat;
 	const uint32_t m_ID;
 
 	static uint32_t s_ID;
@@ -0,0 +1,237 @@
+#include "MeshletCullerVK.h"
+#include "BufferVK.h"
+#include "DeviceVK.h"
+#include "MeshVK.h"
+#include "SceneVK.h"
+
+#include "Core/DirectionalLight.h"
+#include "Core/Meshlet.h"
+
+#include <algorithm>
+
+static uint64_t getInstanceKey(const MeshVK* pMesh, const Material* pMaterial)
+{
+	return (uint64_t(pMesh->getMeshID()) << 32) | uint64_t(pMaterial->getMaterialID());
+}
+
+MeshletCullerVK::MeshletCullerVK(DeviceVK* pDevice)
+	: m_pDevice(pDevice),
+	m_GeometryPass(),
+	m_ShadowPass(),
+	m_CurrentFrame(0)
+{
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+	{
+		m_GeometryPass.ppIndexBuffers[i]	= nullptr;
+		m_GeometryPass.ppMappedIndices[i]	= nullptr;
+		m_GeometryPass.IndexCapacities[i]	= 0;
+		m_ShadowPass.ppIndexBuffers[i]		= nullptr;
+		m_ShadowPass.ppMappedIndices[i]		= nullptr;
+		m_ShadowPass.IndexCapacities[i]		= 0;
+	}
+}
+
+MeshletCullerVK::~MeshletCullerVK()
+{
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+	{
+		SAFEDELETE(m_GeometryPass.ppIndexBuffers[i]);
+		SAFEDELETE(m_ShadowPass.ppIndexBuffers[i]);
+	}
+
+	m_pDevice = nullptr;
+}
+
+void MeshletCullerVK::initGeometryCounters(ProfilerVK* pProfiler)
+{
+	pProfiler->initCounter(&m_GeometryPass.DrawnCounter, "Meshlets drawn");
+	pProfiler->initCounter(&m_GeometryPass.FrustumCulledCounter, "Meshlets culled by frustum");
+	pProfiler->initCounter(&m_GeometryPass.ConeCulledCounter, "Meshlets culled by cone");
+}
+
+void MeshletCullerVK::initShadowCounters(ProfilerVK* pProfiler)
+{
+	pProfiler->initCounter(&m_ShadowPass.DrawnCounter, "Meshlets drawn");
+	pProfiler->initCounter(&m_ShadowPass.FrustumCulledCounter, "Meshlets culled by frustum");
+	pProfiler->initCounter(&m_ShadowPass.ConeCulledCounter, "Meshlets culled by cone");
+}
+
+bool MeshletCullerVK::beginFrame(uint32_t frameIndex, SceneVK* pScene)
+{
+	m_CurrentFrame = frameIndex;
+
+	CullingPass* ppPasses[] = { &m_GeometryPass, &m_ShadowPass };
+	for (CullingPass* pPass : ppPasses)
+	{
+		pPass->IndexCount					= 0;
+		pPass->DrawnCounter.value			= 0;
+		pPass->FrustumCulledCounter.value	= 0;
+		pPass->ConeCulledCounter.value		= 0;
+	}
+
+	const bool isEnabled = pScene->isMeshletCullingEnabled();
+
+	const Camera& camera = pScene->getCamera();
+	m_GeometryPass.ViewFrustum		= camera.getFrustum();
+	m_GeometryPass.Viewer			= camera.getPosition();
+	m_GeometryPass.IsDirectional	= false;
+	m_GeometryPass.IsEnabled		= isEnabled;
+
+	//The shadow pass culls front faces, so a meshlet is culled when all of its triangles face the light
+	LightSetup& lightSetup = pScene->getLightSetup();
+	if (lightSetup.hasDirectionalLight())
+	{
+		const DirectionalLight* pDirectionalLight = lightSetup.getDirectionalLight();
+
+		m_ShadowPass.ViewFrustum	= pDirectionalLight->getFrustum();
+		m_ShadowPass.Viewer			= -glm::normalize(pDirectionalLight->getDirection());
+		m_ShadowPass.IsDirectional	= true;
+		m_ShadowPass.IsEnabled		= isEnabled;
+	}
+	else
+	{
+		m_ShadowPass.IsEnabled = false;
+	}
+
+	//Every object could end up drawn at full detail with nothing culled
+	uint32_t indexCount = 0;
+	for (const GraphicsObjectVK& graphicsObject : pScene->getGraphicsObjects())
+	{
+		if (!graphicsObject.pMesh->getMeshlets().empty())
+		{
+			indexCount += graphicsObject.pMesh->getLOD(0).IndexCount;
+		}
+	}
+
+	return reserveIndices(m_GeometryPass, indexCount) && reserveIndices(m_ShadowPass, indexCount);
+}
+
+void MeshletCullerVK::countGeometryInstances(const std::vector<GraphicsObjectVK>& graphicsObjects, const std::vector<uint32_t>& visibleObjects)
+{
+	m_GeometryPass.InstanceCounts.clear();
+	if (m_GeometryPass.IsEnabled)
+	{
+		for (uint32_t i : visibleObjects)
+		{
+			const GraphicsObjectVK& graphicsObject = graphicsObjects[i];
+			if (graphicsObject.LOD == 0)
+			{
+				m_GeometryPass.InstanceCounts[getInstanceKey(graphicsObject.pMesh, graphicsObject.pMaterial)]++;
+			}
+		}
+	}
+}
+
+void MeshletCullerVK::countShadowInstances(const std::vector<GraphicsObjectVK>& graphicsObjects, const std::vector<uint32_t>& visibleObjects)
+{
+	m_ShadowPass.InstanceCounts.clear();
+	if (m_ShadowPass.IsEnabled)
+	{
+		for (uint32_t i : visibleObjects)
+		{
+			const GraphicsObjectVK& graphicsObject = graphicsObjects[i];
+			if (graphicsObject.ShadowLOD == 0)
+			{
+				m_ShadowPass.InstanceCounts[getInstanceKey(graphicsObject.pMesh, graphicsObject.pMaterial)]++;
+			}
+		}
+	}
+}
+
+IndexRangeVK MeshletCullerVK::cullGeometry(const GraphicsObjectVK& graphicsObject, const glm::mat4& transform)
+{
+	return cull(m_GeometryPass, graphicsObject.pMesh, graphicsObject.pMaterial, graphicsObject.LOD, transform);
+}
+
+IndexRangeVK MeshletCullerVK::cullShadow(const GraphicsObjectVK& graphicsObject, const glm::mat4& transform)
+{
+	return cull(m_ShadowPass, graphicsObject.pMesh, graphicsObject.pMaterial, graphicsObject.ShadowLOD, transform);
+}
+
+bool MeshletCullerVK::reserveIndices(CullingPass& pass, uint32_t indexCount)
+{
+	if (pass.IndexCapacities[m_CurrentFrame] >= indexCount)
+	{
+		return true;
+	}
+
+	//The fence of the frame has been waited for, so the old buffer is no longer in use
+	SAFEDELETE(pass.ppIndexBuffers[m_CurrentFrame]);
+	pass.ppMappedIndices[m_CurrentFrame]	= nullptr;
+	pass.IndexCapacities[m_CurrentFrame]	= 0;
+
+	const uint32_t capacity = std::max(indexCount + indexCount / 2, MESHLET_CULLER_MIN_INDEX_COUNT);
+
+	BufferParams indexBufferParams = {};
+	indexBufferParams.Usage				= VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+	indexBufferParams.SizeInBytes		= sizeof(uint32_t) * capacity;
+	indexBufferParams.MemoryProperty	= VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+	indexBufferParams.IsExclusive		= true;
+
+	BufferVK* pIndexBuffer = DBG_NEW BufferVK(m_pDevice);
+	if (!pIndexBuffer->init(indexBufferParams))
+	{
+		LOG("-- MeshletCullerVK: Failed to create index buffer for %u indices", capacity);
+		SAFEDELETE(pIndexBuffer);
+		return false;
+	}
+
+	void* pMappedIndices = nullptr;
+	pIndexBuffer->map(&pMappedIndices);
+
+	pass.ppIndexBuffers[m_CurrentFrame]		= pIndexBuffer;
+	pass.ppMappedIndices[m_CurrentFrame]	= reinterpret_cast<uint32_t*>(pMappedIndices);
+	pass.IndexCapacities[m_CurrentFrame]	= capacity;
+	return true;
+}
+
+IndexRangeVK MeshletCullerVK::cull(CullingPass& pass, const MeshVK* pMesh, const Material* pMaterial, uint32_t lod, const glm::mat4& transform)
+{
+	//Meshes that are drawn more than once are left whole, one instanced draw is cheaper than a draw per object even though no meshlets are culled
+	const std::vector<Meshlet>& meshlets = pMesh->getMeshlets();
+	if (!pass.IsEnabled || lod > 0 || meshlets.empty() || pass.ppMappedIndices[m_CurrentFrame] == nullptr || pass.InstanceCounts[getInstanceKey(pMesh, pMaterial)] > 1)
+	{
+		const MeshLOD& meshLOD = pMesh->getLOD(lod);
+		return { reinterpret_cast<BufferVK*>(pMesh->getIndexBuffer()), meshLOD.FirstIndex, meshLOD.IndexCount };
+	}
+
+	//The meshlets are tested in object space, which moves the frustum and the viewer instead of every bounding sphere and cone
+	const glm::mat4 inverseTransform	= glm::inverse(transform);
+	const Frustum frustum				= pass.ViewFrustum.transformed(transform);
+
+	glm::vec3 viewer;
+	if (pass.IsDirectional)
+	{
+		viewer = glm::normalize(glm::vec3(inverseTransform * glm::vec4(pass.Viewer, 0.0f)));
+	}
+	else
+	{
+		viewer = glm::vec3(inverseTransform * glm::vec4(pass.Viewer, 1.0f));
+	}
+
+	const uint32_t* pSourceIndices	= pMesh->getCPUIndices().data();
+	uint32_t* pIndices				= pass.ppMappedIndices[m_CurrentFrame];
+
+	const uint32_t firstIndex = pass.IndexCount;
+	for (const Meshlet& meshlet : meshlets)
+	{
+		if (!frustum.intersectsSphere(meshlet.Center, meshlet.Radius))
+		{
+			pass.FrustumCulledCounter.value++;
+			continue;
+		}
+
+		const bool isBackFacing = pass.IsDirectional ? MeshletBuilder::isBackFacingDirectional(meshlet, viewer) : MeshletBuilder::isBackFacing(meshlet, viewer);
+		if (isBackFacing)
+		{
+			pass.ConeCulledCounter.value++;
+			continue;
+		}
+
+		memcpy(pIndices + pass.IndexCount, pSourceIndices + meshlet.FirstIndex, sizeof(uint32_t) * meshlet.IndexCount);
+		pass.IndexCount += meshlet.IndexCount;
+		pass.DrawnCounter.value++;
+	}
+
+	return { pass.ppIndexBuffers[m_CurrentFrame], firstIndex, pass.IndexCount - firstIndex };
+}
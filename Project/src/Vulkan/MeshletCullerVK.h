@@ -0,0 +1,81 @@
+#pragma once
+#include "VulkanCommon.h"
+
+#include "Core/Frustum.h"
+#include "Vulkan/ProfilerVK.h"
+
+#include <vector>
+#include <unordered_map>
+
+class BufferVK;
+class DeviceVK;
+class Material;
+class MeshVK;
+class SceneVK;
+struct GraphicsObjectVK;
+
+//Index buffers grow to at least this many indices, which avoids recreating them for small scenes
+#define MESHLET_CULLER_MIN_INDEX_COUNT	65536U
+
+//Indices that a mesh is drawn with
+struct IndexRangeVK
+{
+	BufferVK* pIndexBuffer;
+	uint32_t FirstIndex;
+	uint32_t IndexCount;
+};
+
+//Culls the meshlets of the objects in a scene on the CPU, against the view frustum and with the normal cones of the meshlets.
+//The indices of the meshlets that are left are copied into an index buffer that is written for each frame in flight.
+//Only the full detail level of a mesh is split into meshlets, objects drawn at a coarser level are drawn whole.
+//Each culled object gets an index range of its own, so meshes that are drawn more than once in a pass are left whole and can be drawn instanced
+class MeshletCullerVK
+{
+	//The state of either the geometry pass or the shadow pass
+	struct CullingPass
+	{
+		BufferVK* ppIndexBuffers[MAX_FRAMES_IN_FLIGHT];
+		uint32_t* ppMappedIndices[MAX_FRAMES_IN_FLIGHT];
+		uint32_t IndexCapacities[MAX_FRAMES_IN_FLIGHT];
+		uint32_t IndexCount;
+		Frustum ViewFrustum;
+		//The position of the camera, or the direction that a directional viewer looks along
+		glm::vec3 Viewer;
+		bool IsDirectional;
+		bool IsEnabled;
+		//Objects drawn at full detail per mesh and material, keyed by both IDs
+		std::unordered_map<uint64_t, uint32_t> InstanceCounts;
+		ProfilerCounter DrawnCounter;
+		ProfilerCounter FrustumCulledCounter;
+		ProfilerCounter ConeCulledCounter;
+	};
+
+public:
+	MeshletCullerVK(DeviceVK* pDevice);
+	~MeshletCullerVK();
+
+	DECL_NO_COPY(MeshletCullerVK);
+
+	void initGeometryCounters(ProfilerVK* pProfiler);
+	void initShadowCounters(ProfilerVK* pProfiler);
+
+	//Builds the frustums of the frame and makes sure that the index buffers of the frame can hold the full detail level of every object
+	bool beginFrame(uint32_t frameIndex, SceneVK* pScene);
+
+	//Has to be called with the visible objects of the pass before they are culled
+	void countGeometryInstances(const std::vector<GraphicsObjectVK>& graphicsObjects, const std::vector<uint32_t>& visibleObjects);
+	void countShadowInstances(const std::vector<GraphicsObjectVK>& graphicsObjects, const std::vector<uint32_t>& visibleObjects);
+
+	IndexRangeVK cullGeometry(const GraphicsObjectVK& graphicsObject, const glm::mat4& transform);
+	IndexRangeVK cullShadow(const GraphicsObjectVK& graphicsObject, const glm::mat4& transform);
+
+private:
+	bool reserveIndices(CullingPass& pass, uint32_t indexCount);
+	IndexRangeVK cull(CullingPass& pass, const MeshVK* pMesh, const Material* pMaterial, uint32_t lod, const glm::mat4& transform);
+
+private:
+	DeviceVK* m_pDevice;
+	CullingPass m_GeometryPass;
+	CullingPass m_ShadowPass;
+	uint32_t m_CurrentFrame;
+};
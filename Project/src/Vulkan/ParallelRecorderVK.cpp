@@ -0,0 +1,102 @@
+#include "ParallelRecorderVK.h"
+#include "CommandBufferVK.h"
+#include "CommandPoolVK.h"
+#include "DeviceVK.h"
+
+#include "imgui/imgui.h"
+
+#include <algorithm>
+#include <string>
+
+ParallelRecorderVK::ParallelRecorderVK(DeviceVK* pDevice)
+	: m_pDevice(pDevice),
+	m_ppCommandPools(),
+	m_ppCommandBuffers(),
+	m_ChunkCounts(),
+	m_ChunkCapacity(0),
+	m_LastChunkCount(0),
+	m_ChunkTimes(),
+	m_RecordTime(0.0)
+{
+}
+
+ParallelRecorderVK::~ParallelRecorderVK()
+{
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+	{
+		for (uint32_t chunk = 0; chunk < PARALLEL_RECORDER_MAX_CHUNKS; chunk++)
+		{
+			SAFEDELETE(m_ppCommandPools[i][chunk]);
+		}
+	}
+
+	m_pDevice = nullptr;
+}
+
+bool ParallelRecorderVK::init(uint32_t queueFamilyIndex, const char* pName)
+{
+	//The thread that records the pass helps out while it waits, so there is no use in more chunks than frame workers
+	m_ChunkCapacity = std::max(1U, std::min(TaskDispatcher::getWorkerCount(), PARALLEL_RECORDER_MAX_CHUNKS));
+
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+	{
+		for (uint32_t chunk = 0; chunk < m_ChunkCapacity; chunk++)
+		{
+			m_ppCommandPools[i][chunk] = DBG_NEW CommandPoolVK(m_pDevice, queueFamilyIndex);
+			if (!m_ppCommandPools[i][chunk]->init())
+			{
+				return false;
+			}
+
+			m_ppCommandBuffers[i][chunk] = m_ppCommandPools[i][chunk]->allocateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+			if (m_ppCommandBuffers[i][chunk] == nullptr)
+			{
+				return false;
+			}
+
+			std::string name = std::string(pName) + " CommandBuffer[" + std::to_string(i) + "][" + std::to_string(chunk) + "]";
+			m_ppCommandBuffers[i][chunk]->setName(name.c_str());
+		}
+	}
+
+	LOG("-- ParallelRecorderVK: %s is recorded in up to %u chunks", pName, m_ChunkCapacity);
+	return true;
+}
+
+void ParallelRecorderVK::execute(CommandBufferVK* pPrimaryBuffer, uint32_t frameIndex) const
+{
+	for (uint32_t chunk = 0; chunk < m_ChunkCounts[frameIndex]; chunk++)
+	{
+		pPrimaryBuffer->executeSecondary(m_ppCommandBuffers[frameIndex][chunk]);
+	}
+}
+
+void ParallelRecorderVK::drawResults(const char* pName) const
+{
+	double totalTime = 0.0;
+	for (uint32_t chunk = 0; chunk < m_LastChunkCount; chunk++)
+	{
+		totalTime += m_ChunkTimes[chunk];
+	}
+
+	ImGui::Text("%s (CPU):\t%f ms, %u chunks, %f ms in total", pName, m_RecordTime, m_LastChunkCount, totalTime);
+	for (uint32_t chunk = 0; chunk < m_LastChunkCount; chunk++)
+	{
+		ImGui::Text("--Chunk %u:\t%f ms", chunk, m_ChunkTimes[chunk]);
+	}
+}
+
+CommandBufferVK* ParallelRecorderVK::beginChunk(uint32_t frameIndex, uint32_t chunk, VkCommandBufferInheritanceInfo* pInheritanceInfo)
+{
+	CommandBufferVK* pCommandBuffer = m_ppCommandBuffers[frameIndex][chunk];
+	pCommandBuffer->reset(false);
+	m_ppCommandPools[frameIndex][chunk]->reset();
+
+	pCommandBuffer->begin(pInheritanceInfo, VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT);
+	return pCommandBuffer;
+}
+
+void ParallelRecorderVK::endChunk(CommandBufferVK* pCommandBuffer)
+{
+	pCommandBuffer->end();
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include "VulkanCommon.h"
+
+#include "Core/TaskDispatcher.h"
+
+#include <chrono>
+
+class CommandBufferVK;
+class CommandPoolVK;
+class DeviceVK;
+
+//Most secondary buffers that one pass is split into, fewer are used when there are fewer frame workers
+#define PARALLEL_RECORDER_MAX_CHUNKS 8U
+
+//Records one pass into several secondary buffers at the same time. A command pool may only be used by one thread at a time,
+//so every chunk has its own pool for every frame in flight. The chunks are executed in order, which keeps the order of the draws
+class ParallelRecorderVK
+{
+public:
+	ParallelRecorderVK(DeviceVK* pDevice);
+	~ParallelRecorderVK();
+
+	DECL_NO_COPY(ParallelRecorderVK);
+
+	bool init(uint32_t queueFamilyIndex, const char* pName);
+
+	//Calls recordChunk(pCommandBuffer, chunk) for chunks [0, chunkCount) on the frame workers. The buffers are begun with the inheritance info before and ended after
+	template<typename Func>
+	void record(uint32_t frameIndex, uint32_t chunkCount, VkCommandBufferInheritanceInfo* pInheritanceInfo, Func recordChunk)
+	{
+		ASSERT(chunkCount > 0 && chunkCount <= m_ChunkCapacity);
+
+		const auto recordStart = std::chrono::high_resolution_clock::now();
+
+		TaskDispatcher::parallelFor(0, chunkCount, 1, [&](uint32_t chunk)
+			{
+				const auto chunkStart = std::chrono::high_resolution_clock::now();
+
+				CommandBufferVK* pCommandBuffer = beginChunk(frameIndex, chunk, pInheritanceInfo);
+				recordChunk(pCommandBuffer, chunk);
+				endChunk(pCommandBuffer);
+
+				m_ChunkTimes[chunk] = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - chunkStart).count();
+			});
+
+		m_ChunkCounts[frameIndex]	= chunkCount;
+		m_LastChunkCount			= chunkCount;
+		m_RecordTime				= std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - recordStart).count();
+	}
+
+	//Executes the chunks that were recorded for the frame, the primary buffer has to be inside of the render pass of the inheritance info
+	void execute(CommandBufferVK* pPrimaryBuffer, uint32_t frameIndex) const;
+	void drawResults(const char* pName) const;
+
+	FORCEINLINE uint32_t	getChunkCapacity() const			{ return m_ChunkCapacity; }
+	FORCEINLINE uint32_t	getLastChunkCount() const			{ return m_LastChunkCount; }
+	//CPU times of the last recording in milliseconds, the sum of the chunk times is what a single thread would have spent
+	FORCEINLINE double		getChunkTime(uint32_t chunk) const	{ return m_ChunkTimes[chunk]; }
+	FORCEINLINE double		getRecordTime() const				{ return m_RecordTime; }
+
+private:
+	CommandBufferVK* beginChunk(uint32_t frameIndex, uint32_t chunk, VkCommandBufferInheritanceInfo* pInheritanceInfo);
+	void endChunk(CommandBufferVK* pCommandBuffer);
+
+private:
+	DeviceVK* m_pDevice;
+	CommandPoolVK* m_ppCommandPools[MAX_FRAMES_IN_FLIGHT][PARALLEL_RECORDER_MAX_CHUNKS];
+	CommandBufferVK* m_ppCommandBuffers[MAX_FRAMES_IN_FLIGHT][PARALLEL_RECORDER_MAX_CHUNKS];
+	//Chunks recorded for each frame, zero until the frame has been recorded once
+	uint32_t m_ChunkCounts[MAX_FRAMES_IN_FLIGHT];
+	uint32_t m_ChunkCapacity;
+	uint32_t m_LastChunkCount;
+	double m_ChunkTimes[PARALLEL_RECORDER_MAX_CHUNKS];
+	double m_RecordTime;
+};
@@ -175,6 +175,13 @@ void ProfilerVK::drawResults()
         ImGui::Text("--%s%s:\t%s%f ms", indent.c_str(), pTimestamp->name.c_str(), whitespaceFill.c_str(), timeMs);
     }
 
+    for (ProfilerCounter* pCounter : m_Counters) {
+        fillLength = m_MaxTextWidth - (timestampPrefixWidth + (uint32_t)pCounter->name.size());
+        whitespaceFill = std::string(fillLength, ' ');
+
+        ImGui::Text("--%s%s:\t%s%llu", indent.c_str(), pCounter->name.c_str(), whitespaceFill.c_str(), (unsigned long long)pCounter->value);
+    }
+
     // Draw the child profilers' results
     for (ProfilerVK* pChild : m_Children) {
         pChild->drawResults();
@@ -194,6 +201,15 @@ void ProfilerVK::initTimestamp(Timestamp* pTimestamp, const std::string name)
     m_Timestamps.push_back(pTimestamp);
 }
 
+void ProfilerVK::initCounter(ProfilerCounter* pCounter, const std::string name)
+{
+    pCounter->name = name;
+    pCounter->value = 0;
+    m_Counters.push_back(pCounter);
+
+    findWidestText();
+}
+
 void ProfilerVK::beginTimestamp(Timestamp* pTimestamp)
 {
     QueryPoolVK* pCurrentQueryPool = m_ppQueryPools[m_CurrentFrame];
@@ -233,6 +249,10 @@ void ProfilerVK::findWidestText()
         maxTextWidthLocal = std::max(timestampPrefixWidth + (uint32_t)pTimestamp->name.size(), maxTextWidthLocal);
     }
 
+    for (ProfilerCounter* pCounter : m_Counters) {
+        maxTextWidthLocal = std::max(timestampPrefixWidth + (uint32_t)pCounter->name.size(), maxTextWidthLocal);
+    }
+
     m_MaxTextWidth = std::max(m_MaxTextWidth, maxTextWidthLocal);
 }
 
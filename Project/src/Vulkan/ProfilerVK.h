@@ -18,6 +18,12 @@ struct Timestamp {
     std::vector<uint32_t> queries;
 };
 
+// CPU-side statistic that is drawn together with the timestamps, the value is written by the owner of the profiler
+struct ProfilerCounter {
+    std::string name;
+    uint64_t value;
+};
+
 class ProfilerVK : public Profiler
 {
 public:
@@ -30,6 +36,8 @@ public:
     void reset(uint32_t currentFrame, CommandBufferVK* pResetCmdBuffer);
     void beginFrame(CommandBufferVK* pProfiledCmdBuffer);
     void endFrame();
+    // The end of the frame is written to this buffer instead, for passes that are recorded into several secondary buffers
+    void setProfiledCommandBuffer(CommandBufferVK* pProfiledCmdBuffer) { m_pProfiledCommandBuffer = pProfiledCmdBuffer; }
     void drawResults();
 
     void addChildProfiler(ProfilerVK* pChildProfiler);
@@ -38,6 +46,8 @@ public:
     void beginTimestamp(Timestamp* pTimestamp);
     void endTimestamp(Timestamp* pTimestamp);
 
+    void initCounter(ProfilerCounter* pCounter, const std::string name);
+
     uint32_t getRecurseDepth() const { return m_RecurseDepth; }
     // Returns the latest profiler results
     virtual double getElapsedTime() const override { return m_Time * m_TimestampToMillisec; }
@@ -62,6 +72,7 @@ private:
     uint32_t m_RecurseDepth;
 
     std::vector<Timestamp*> m_Timestamps;
+    std::vector<ProfilerCounter*> m_Counters;
 
     std::string m_Name;
     uint64_t m_Time;
@@ -630,6 +630,7 @@ bool RayTracingRendererVK::createPipelines()
 		pClosestHitShader->finalize();
 		pClosestHitShader->setSpecializationConstant<uint32_t>(0, MAX_RECURSIONS);
 		pClosestHitShader->setSpecializationConstant<uint32_t>(1, MAX_NUM_UNIQUE_MATERIALS);
+		pClosestHitShader->setSpecializationConstant<uint32_t>(3, uint32_t(m_pRenderingHandler->getScene()->getVertexFormat()));
 		hitGroupParams.pClosestHitShader = pClosestHitShader;
 
 		ShaderVK* pClosestHitShadowShader = reinterpret_cast<ShaderVK*>(m_pContext->createShader());
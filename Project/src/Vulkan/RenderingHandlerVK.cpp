@@ -16,6 +16,10 @@
 #include "ImageViewVK.h"
 #include "ImageVK.h"
 #include "ImguiVK.h"
+#include "MeshletCullerVK.h"
+#include "GPUCullerVK.h"
+#include "ParallelRecorderVK.h"
+#include "HiZPyramidVK.h"
 #include "MeshRendererVK.h"
 #include "PipelineVK.h"
 #include "RenderingHandlerVK.h"
@@ -33,12 +37,30 @@
 
 #include "VolumetricLight/VolumetricLightRendererVK.h"
 
+#include <chrono>
+
 #define MULTITHREADED 1
 
+//Resources that the steps in the frame graph read and write
+enum EFrameResource : uint64_t
+{
+	FRAME_RESOURCE_GEOMETRY_COMMANDS	= (1 << 0),
+	FRAME_RESOURCE_SHADOW_COMMANDS		= (1 << 1),
+	FRAME_RESOURCE_LIGHT_COMMANDS		= (1 << 2),
+	FRAME_RESOURCE_UI_COMMANDS			= (1 << 3),
+	FRAME_RESOURCE_PARTICLE_COMMANDS	= (1 << 4),
+	FRAME_RESOURCE_VOLUMETRIC_COMMANDS	= (1 << 5),
+	FRAME_RESOURCE_TRANSFER_SUBMITTED	= (1 << 6),
+	FRAME_RESOURCE_GEOMETRY_SUBMITTED	= (1 << 7),
+};
+
 RenderingHandlerVK::RenderingHandlerVK(GraphicsContextVK* pGraphicsContext)
 	:m_pGraphicsContext(pGraphicsContext),
 	m_pMeshRenderer(nullptr),
 	m_pShadowMapRenderer(nullptr),
+	m_pMeshletCuller(nullptr),
+	m_pGPUCuller(nullptr),
+	m_pHiZPyramid(nullptr),
 	m_pRayTracer(nullptr),
 	m_pVolumetricLightRenderer(nullptr),
 	m_pParticleRenderer(nullptr),
@@ -50,6 +72,7 @@ RenderingHandlerVK::RenderingHandlerVK(GraphicsContextVK* pGraphicsContext)
 	m_pGlossyImageView(nullptr),
 	m_pGBuffer(nullptr),
 	m_pGeometryRenderPass(nullptr),
+	m_pGeometryLateRenderPass(nullptr),
 	m_pShadowMapRenderPass(nullptr),
 	m_pBackBufferRenderPass(nullptr),
 	m_pParticleRenderPass(nullptr),
@@ -82,7 +105,15 @@ RenderingHandlerVK::RenderingHandlerVK(GraphicsContextVK* pGraphicsContext)
 	m_ClearDepth(),
 	m_Viewport(),
 	m_ScissorRect(),
-	m_RayTracingResolutionDenominator(1)
+	m_RayTracingResolutionDenominator(1),
+	m_FrameJobHeapAllocations(0),
+	m_VisibleObjects(),
+	m_VisibleShadowCasters(),
+	m_VisibleObjectsCounter(),
+	m_VisibleShadowCastersCounter(),
+	m_ObjectCullingTime(0.0),
+	m_IsGPUCulling(false),
+	m_IsOcclusionCulling(false)
 {
 	m_ClearDepth.depthStencil.depth = 1.0f;
 	m_ClearDepth.depthStencil.stencil = 0;
@@ -105,12 +136,16 @@ RenderingHandlerVK::~RenderingHandlerVK()
 	SAFEDELETE(m_pLightBufferGraphics);
 
 	SAFEDELETE(m_pGeometryRenderPass);
+	SAFEDELETE(m_pGeometryLateRenderPass);
 	SAFEDELETE(m_pShadowMapRenderPass);
 	SAFEDELETE(m_pBackBufferRenderPass);
 	SAFEDELETE(m_pParticleRenderPass);
 	SAFEDELETE(m_pUIRenderPass);
 
 	SAFEDELETE(m_pSkyboxRenderer);
+	SAFEDELETE(m_pMeshletCuller);
+	SAFEDELETE(m_pGPUCuller);
+	SAFEDELETE(m_pHiZPyramid);
 
 	SAFEDELETE(m_pRadianceImage);
 	SAFEDELETE(m_pRadianceImageView);
@@ -178,6 +213,8 @@ bool RenderingHandlerVK::initialize()
 		return false;
 	}
 
+	m_pMeshletCuller = DBG_NEW MeshletCullerVK(m_pGraphicsContext->getDevice());
+
 	if (!createRenderPasses())
 	{
 		return false;
@@ -188,6 +225,18 @@ bool RenderingHandlerVK::initialize()
 		return false;
 	}
 
+	m_pHiZPyramid = DBG_NEW HiZPyramidVK(m_pGraphicsContext);
+	if (!m_pHiZPyramid->init(m_pGBuffer))
+	{
+		return false;
+	}
+
+	m_pGPUCuller = DBG_NEW GPUCullerVK(m_pGraphicsContext, m_pHiZPyramid);
+	if (!m_pGPUCuller->init())
+	{
+		return false;
+	}
+
 	if (!createBackBuffers())
 	{
 		return false;
@@ -232,6 +281,8 @@ void RenderingHandlerVK::render(IScene* pScene)
 	SceneVK* pVulkanScene	= reinterpret_cast<SceneVK*>(pScene);
 	SwapChainVK* pSwapChain = m_pGraphicsContext->getSwapChain();
 
+	const uint64_t jobHeapAllocations = JobAllocator::getHeapAllocationCount();
+
 	pSwapChain->acquireNextImage(m_pImageAvailableSemaphores[m_CurrentFrame]);
 	m_BackBufferIndex = pSwapChain->getImageIndex();
 
@@ -253,308 +304,106 @@ void RenderingHandlerVK::render(IScene* pScene)
 	LightSetup& lightsetup	= pVulkanScene->getLightSetup();
 	updateBuffers(pVulkanScene, camera, lightsetup);
 
-	DeviceVK* pDevice = m_pGraphicsContext->getDevice();
 	m_ppTransferCommandBuffers[m_CurrentFrame]->end();
 
 	//Render all the meshes
 	FrameBufferVK*		pBackbuffer				= getCurrentBackBuffer();
 	FrameBufferVK*		pBackbufferWithDepth	= getCurrentBackBufferWithDepth();
-	CommandBufferVK*	pSecondaryCommandBuffer = m_ppCommandBuffersSecondary[m_CurrentFrame];
-	CommandPoolVK*		pSecondaryCommandPool	= m_ppCommandPoolsSecondary[m_CurrentFrame];
 
 	m_pMeshRenderer->setupFrame(m_ppGraphicsCommandBuffers[m_CurrentFrame]);
-#if MULTITHREADED
 	m_pMeshRenderer->beginFrame(pVulkanScene);
 	m_pShadowMapRenderer->beginFrame(pVulkanScene);
 
-	TaskDispatcher::execute([pVulkanScene, this]
-		{
-			auto& graphicsObjects = pVulkanScene->getGraphicsObjects();
-			for (uint32_t i = 0; i < graphicsObjects.size(); i++)
-			{
-				const GraphicsObjectVK& graphicsObject = graphicsObjects[i];
-				m_pMeshRenderer->submitMesh(graphicsObject.pMesh, graphicsObject.pMaterial, graphicsObject.MaterialParametersIndex, i);
-				m_pShadowMapRenderer->submitMesh(graphicsObject.pMesh, graphicsObject.pMaterial, i);
-			}
-			m_pMeshRenderer->endFrame(pVulkanScene);
-			m_pShadowMapRenderer->endFrame(pVulkanScene);
-		});
-	TaskDispatcher::execute([this]
-		{
-			m_pMeshRenderer->buildLightPass(m_pBackBufferRenderPass, getCurrentBackBuffer());
-		});
-
-	if (m_pImGuiRenderer)
+	if (m_pParticleRenderer)
 	{
-		TaskDispatcher::execute([&, this]
-			{
-				// Needed to begin a secondary buffer
-				VkCommandBufferInheritanceInfo inheritanceInfo = {};
-				inheritanceInfo.sType		= VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
-				inheritanceInfo.pNext		= nullptr;
-				inheritanceInfo.renderPass	= m_pBackBufferRenderPass->getRenderPass();
-				inheritanceInfo.subpass		= 0;
-				inheritanceInfo.framebuffer = pBackbuffer->getFrameBuffer();
-
-				pSecondaryCommandBuffer->reset(false);
-				pSecondaryCommandPool->reset();
-				pSecondaryCommandBuffer->begin(&inheritanceInfo, VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT);
-				m_pImGuiRenderer->render(pSecondaryCommandBuffer, m_CurrentFrame);
-				pSecondaryCommandBuffer->end();
-			});
+		m_pParticleRenderer->beginFrame(pVulkanScene);
+		transferParticleOwnership();
 	}
-#else
-	m_pMeshRenderer->beginFrame(pVulkanScene);
-	m_pShadowMapRenderer->beginFrame(pVulkanScene);
 
-	auto& graphicsObjects = pVulkanScene->getGraphicsObjects();
-	for (uint32_t i = 0; i < graphicsObjects.size(); i++)
+	//Volumetric light updates its buffers and resets its queries in the primary graphics buffer. This is done up front so that
+	//Geometry Submit is the only step that records into the primary buffer while the frame graph runs
+	if (m_pVolumetricLightRenderer)
 	{
-		const GraphicsObjectVK& graphicsObject = graphicsObjects[i];
-		m_pMeshRenderer->submitMesh(graphicsObject.pMesh, graphicsObject.pMaterial, graphicsObject.MaterialParametersIndex, i);
-		m_pShadowMapRenderer->submitMesh(graphicsObject.pMesh, graphicsObject.pMaterial, i);
+		m_pVolumetricLightRenderer->beginFrame(pVulkanScene);
+		m_pVolumetricLightRenderer->updateBuffers();
 	}
-	m_pMeshRenderer->endFrame(pVulkanScene);
-	m_pShadowMapRenderer->endFrame(pVulkanScene);
 
-	m_pMeshRenderer->buildLightPass(m_pBackBufferRenderPass, getCurrentBackBuffer());
+#if MULTITHREADED
+	//Each step declares what it reads and writes, steps without a path between them are recorded in parallel
+	m_FrameGraph.reset();
+	m_FrameGraph.addNode("Mesh Record", [pVulkanScene, this]
+		{
+			recordMeshes(pVulkanScene);
+		}, 0, FRAME_RESOURCE_GEOMETRY_COMMANDS | FRAME_RESOURCE_SHADOW_COMMANDS);
 
-	// Needed to begin a secondary buffer
-	VkCommandBufferInheritanceInfo inheritanceInfo = {};
-	inheritanceInfo.sType		= VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
-	inheritanceInfo.pNext		= nullptr;
-	inheritanceInfo.renderPass	= m_pBackBufferRenderPass->getRenderPass();
-	inheritanceInfo.subpass		= 0;
-	inheritanceInfo.framebuffer = pBackbuffer->getFrameBuffer();
+	m_FrameGraph.addNode("Light Pass Build", [pBackbuffer, this]
+		{
+			m_pMeshRenderer->buildLightPass(m_pBackBufferRenderPass, pBackbuffer);
+		}, 0, FRAME_RESOURCE_LIGHT_COMMANDS);
 
-	pSecondaryCommandBuffer->reset(false);
-	pSecondaryCommandPool->reset();
-	pSecondaryCommandBuffer->begin(&inheritanceInfo, VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT);
-	m_pImGuiRenderer->render(pSecondaryCommandBuffer, m_CurrentFrame);
-	pSecondaryCommandBuffer->end();
-#endif
+	if (m_pImGuiRenderer)
+	{
+		m_FrameGraph.addNode("ImGui Record", [pBackbuffer, this]
+			{
+				recordImGui(pBackbuffer);
+			}, 0, FRAME_RESOURCE_UI_COMMANDS);
+	}
 
 	if (m_pParticleRenderer)
 	{
-#if MULTITHREADED
-		m_pParticleRenderer->beginFrame(pVulkanScene);
-		TaskDispatcher::execute([pVulkanScene, this]
+		m_FrameGraph.addNode("Particles Record", [pVulkanScene, this]
 			{
 				submitParticles();
 				m_pParticleRenderer->endFrame(pVulkanScene);
-			});
-#else
-		m_pParticleRenderer->beginFrame(pVulkanScene);
-		submitParticles();
-		m_pParticleRenderer->endFrame(pVulkanScene);
-#endif
+			}, 0, FRAME_RESOURCE_PARTICLE_COMMANDS);
 	}
 
+	if (m_pVolumetricLightRenderer)
 	{
-		static bool firstFrame = true;
-
-		const uint32_t waitCount = firstFrame ? 0 : 2;
-		firstFrame = false;
-
-		VkSemaphore				transferWaitSemphores[]		= { m_TransferStartSemaphore, m_ComputeFinishedTransferSemaphore };
-		VkPipelineStageFlags	transferWaitStages[]		= { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT };
-		VkSemaphore				transferSignalSemaphores[]	= { m_TransferFinishedGraphicsSemaphore, m_TransferFinishedComputeSemaphore };
-
-		pDevice->executeTransfer(m_ppTransferCommandBuffers[m_CurrentFrame], transferWaitSemphores, transferWaitStages, waitCount, transferSignalSemaphores, 2);
-	}
-
-#if MULTITHREADED
-	TaskDispatcher::waitForTasks();
-#endif
-
-	//Start renderpass
-	VkClearValue clearValues[] = { m_ClearColor, m_ClearColor, m_ClearColor, m_ClearDepth };
-	m_ppGraphicsCommandBuffers[m_CurrentFrame]->beginRenderPass(m_pGeometryRenderPass, m_pGBuffer->getFrameBuffer(), (uint32_t)m_Viewport.width, (uint32_t)m_Viewport.height, clearValues, 4, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
-
-	m_ppGraphicsCommandBuffers[m_CurrentFrame]->executeSecondary(m_pMeshRenderer->getGeometryCommandBuffer());
-	m_ppGraphicsCommandBuffers[m_CurrentFrame]->endRenderPass();
-
-	if (lightsetup.hasDirectionalLight()) {
-		FrameBufferVK* pFrameBuffer = reinterpret_cast<FrameBufferVK*>(lightsetup.getDirectionalLight()->getFrameBuffer());
-		const VkViewport& viewport = m_pShadowMapRenderer->getViewport();
-
-		m_ppGraphicsCommandBuffers[m_CurrentFrame]->beginRenderPass(m_pShadowMapRenderPass, pFrameBuffer, (uint32_t)viewport.width, (uint32_t)viewport.height, &m_ClearDepth, 1, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
-		m_ppGraphicsCommandBuffers[m_CurrentFrame]->executeSecondary(m_pShadowMapRenderer->getCommandBuffer(m_CurrentFrame));
-		m_ppGraphicsCommandBuffers[m_CurrentFrame]->endRenderPass();
-	}
-
-	if (m_pVolumetricLightRenderer) {
-		m_pVolumetricLightRenderer->beginFrame(pScene);
-
-		m_pVolumetricLightRenderer->updateBuffers();
-		m_pVolumetricLightRenderer->renderLightBuffer();
-		m_pVolumetricLightRenderer->applyLightBuffer(m_pBackBufferRenderPass, pBackbuffer);
-
-		m_pVolumetricLightRenderer->endFrame(pScene);
+		m_FrameGraph.addNode("Volumetric Record", [pScene, pBackbuffer, this]
+			{
+				recordVolumetricLight(pScene, pBackbuffer);
+			}, 0, FRAME_RESOURCE_VOLUMETRIC_COMMANDS);
 	}
 
-	if (m_pRayTracer)
-	{
-		uint32_t computeQueueIndex	= pDevice->getQueueFamilyIndices().computeFamily.value();
-		uint32_t graphicsQueueIndex = pDevice->getQueueFamilyIndices().graphicsFamily.value();
-
-		constexpr uint32_t IMAGE_BARRIER_COUNT = 6;
-		VkImageMemoryBarrier imageBarriers[IMAGE_BARRIER_COUNT] =
-		{
-			createVkImageMemoryBarrier(m_pGBuffer->getDepthImage()->getImage(), VK_ACCESS_MEMORY_READ_BIT, 0, graphicsQueueIndex, computeQueueIndex,
-				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1, 1),
-			createVkImageMemoryBarrier(m_pGBuffer->getColorImage(0)->getImage(), VK_ACCESS_MEMORY_READ_BIT, 0, graphicsQueueIndex, computeQueueIndex,
-				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
-			createVkImageMemoryBarrier(m_pGBuffer->getColorImage(1)->getImage(), VK_ACCESS_MEMORY_READ_BIT, 0, graphicsQueueIndex, computeQueueIndex,
-				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
-			createVkImageMemoryBarrier(m_pGBuffer->getColorImage(2)->getImage(), VK_ACCESS_MEMORY_READ_BIT, 0, graphicsQueueIndex, computeQueueIndex,
-				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
-			createVkImageMemoryBarrier(m_pRadianceImage->getImage(), VK_ACCESS_MEMORY_READ_BIT, 0, graphicsQueueIndex, computeQueueIndex,
-				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
-			createVkImageMemoryBarrier(m_pGlossyImage->getImage(), VK_ACCESS_MEMORY_READ_BIT, 0, graphicsQueueIndex, computeQueueIndex,
-				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL,  VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
-		};
-
-		m_ppGraphicsCommandBuffers[m_CurrentFrame]->imageMemoryBarrier(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, IMAGE_BARRIER_COUNT, imageBarriers);
-		m_ppGraphicsCommandBuffers[m_CurrentFrame]->end();
-
-		{
-			VkSemaphore geometryWaitSemphores[] = { m_TransferFinishedGraphicsSemaphore };
-			VkPipelineStageFlags geometryWaitStages[] = { VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT };
-
-			VkSemaphore signalSemaphores[] = { m_GeometryFinishedSemaphore, m_TransferStartSemaphore };
-			pDevice->executeGraphics(m_ppGraphicsCommandBuffers[m_CurrentFrame], geometryWaitSemphores, geometryWaitStages, 1, signalSemaphores, 2);
-		}
-
-		//Prepare seconds graphics commandbuffer
-		m_ppGraphicsCommandBuffers2[m_CurrentFrame]->begin(nullptr, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
-
+	m_FrameGraph.addNode("Transfer Submit", [this]
 		{
-			VkImageMemoryBarrier imageBarriers[IMAGE_BARRIER_COUNT] =
-			{
-				createVkImageMemoryBarrier(m_pGBuffer->getDepthImage()->getImage(), 0, VK_ACCESS_MEMORY_READ_BIT, graphicsQueueIndex, computeQueueIndex,
-					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1, 1),
-				createVkImageMemoryBarrier(m_pGBuffer->getColorImage(0)->getImage(), 0, VK_ACCESS_MEMORY_READ_BIT, graphicsQueueIndex, computeQueueIndex,
-					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
-				createVkImageMemoryBarrier(m_pGBuffer->getColorImage(1)->getImage(), 0, VK_ACCESS_MEMORY_READ_BIT, graphicsQueueIndex, computeQueueIndex,
-					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
-				createVkImageMemoryBarrier(m_pGBuffer->getColorImage(2)->getImage(), 0, VK_ACCESS_MEMORY_READ_BIT, graphicsQueueIndex, computeQueueIndex,
-					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
-				createVkImageMemoryBarrier(m_pRadianceImage->getImage(), 0, VK_ACCESS_MEMORY_WRITE_BIT, graphicsQueueIndex, computeQueueIndex,
-					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
-				createVkImageMemoryBarrier(m_pGlossyImage->getImage(), 0, VK_ACCESS_MEMORY_WRITE_BIT, graphicsQueueIndex, computeQueueIndex,
-					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL,  VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
-			};
-			m_ppComputeCommandBuffers[m_CurrentFrame]->imageMemoryBarrier(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_NV, IMAGE_BARRIER_COUNT, imageBarriers);
-		}
-
-		m_pRayTracer->render(pScene);
-		m_ppComputeCommandBuffers[m_CurrentFrame]->executeSecondary(m_pRayTracer->getComputeCommandBuffer());
+			submitTransfer();
+		}, 0, FRAME_RESOURCE_TRANSFER_SUBMITTED);
 
+	m_FrameGraph.addNode("Geometry Submit", [pScene, this]
 		{
-			VkImageMemoryBarrier imageBarriers[IMAGE_BARRIER_COUNT] =
-			{
-				createVkImageMemoryBarrier(m_pGBuffer->getDepthImage()->getImage(), VK_ACCESS_MEMORY_READ_BIT, 0, computeQueueIndex, graphicsQueueIndex,
-					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1, 1),
-				createVkImageMemoryBarrier(m_pGBuffer->getColorImage(0)->getImage(), VK_ACCESS_MEMORY_READ_BIT, 0, computeQueueIndex, graphicsQueueIndex,
-					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
-				createVkImageMemoryBarrier(m_pGBuffer->getColorImage(1)->getImage(), VK_ACCESS_MEMORY_READ_BIT, 0, computeQueueIndex, graphicsQueueIndex,
-					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
-				createVkImageMemoryBarrier(m_pGBuffer->getColorImage(2)->getImage(), VK_ACCESS_MEMORY_READ_BIT, 0, computeQueueIndex, graphicsQueueIndex,
-					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
-				createVkImageMemoryBarrier(m_pRadianceImage->getImage(), VK_ACCESS_MEMORY_WRITE_BIT, 0, computeQueueIndex, graphicsQueueIndex,
-					VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
-				createVkImageMemoryBarrier(m_pGlossyImage->getImage(), VK_ACCESS_MEMORY_WRITE_BIT, 0, computeQueueIndex, graphicsQueueIndex,
-					VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,  VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
-			};
-			m_ppComputeCommandBuffers[m_CurrentFrame]->imageMemoryBarrier(VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_NV, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, IMAGE_BARRIER_COUNT, imageBarriers);
-		}
+			submitGeometry(pScene);
+		}, FRAME_RESOURCE_GEOMETRY_COMMANDS | FRAME_RESOURCE_SHADOW_COMMANDS | FRAME_RESOURCE_TRANSFER_SUBMITTED, FRAME_RESOURCE_GEOMETRY_SUBMITTED);
 
+	m_FrameGraph.addNode("Frame Submit", [pBackbuffer, pBackbufferWithDepth, this]
 		{
-			VkImageMemoryBarrier imageBarriers[IMAGE_BARRIER_COUNT] =
-			{
-				createVkImageMemoryBarrier(m_pGBuffer->getDepthImage()->getImage(), 0, VK_ACCESS_MEMORY_READ_BIT, computeQueueIndex, graphicsQueueIndex,
-					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1, 1),
-				createVkImageMemoryBarrier(m_pGBuffer->getColorImage(0)->getImage(), 0, VK_ACCESS_MEMORY_READ_BIT, computeQueueIndex, graphicsQueueIndex,
-					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
-				createVkImageMemoryBarrier(m_pGBuffer->getColorImage(1)->getImage(), 0, VK_ACCESS_MEMORY_READ_BIT, computeQueueIndex, graphicsQueueIndex,
-					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
-				createVkImageMemoryBarrier(m_pGBuffer->getColorImage(2)->getImage(), 0, VK_ACCESS_MEMORY_READ_BIT, computeQueueIndex, graphicsQueueIndex,
-					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
-				createVkImageMemoryBarrier(m_pRadianceImage->getImage(), 0, VK_ACCESS_MEMORY_READ_BIT, computeQueueIndex, graphicsQueueIndex,
-					VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
-				createVkImageMemoryBarrier(m_pGlossyImage->getImage(), 0, VK_ACCESS_MEMORY_READ_BIT, computeQueueIndex, graphicsQueueIndex,
-					VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,  VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
-			};
-			m_ppGraphicsCommandBuffers2[m_CurrentFrame]->imageMemoryBarrier(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, IMAGE_BARRIER_COUNT, imageBarriers);
-		}
-	}
-	else
-	{
-		m_ppGraphicsCommandBuffers[m_CurrentFrame]->end();
-		{
-			VkSemaphore geometryWaitSemphores[] = { m_TransferFinishedGraphicsSemaphore };
-			VkPipelineStageFlags geometryWaitStages[] = { VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT };
-
-			VkSemaphore signalSemaphores[] = { m_GeometryFinishedSemaphore, m_TransferStartSemaphore };
-			pDevice->executeGraphics(m_ppGraphicsCommandBuffers[m_CurrentFrame], geometryWaitSemphores, geometryWaitStages, 1, signalSemaphores, 2);
-		}
-		m_ppGraphicsCommandBuffers2[m_CurrentFrame]->begin(nullptr, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
-	}
-
-	if (m_pVolumetricLightRenderer) {
-		RenderPassVK* pLightBufferPass = m_pVolumetricLightRenderer->getLightBufferPass();
-		FrameBufferVK* pLightFrameBuffer = m_pVolumetricLightRenderer->getLightFrameBuffer();
-		const VkViewport& viewport = m_pVolumetricLightRenderer->getViewport();
-		VkClearValue clearValue = m_pVolumetricLightRenderer->getLightBufferClearColor();
-
-		m_ppGraphicsCommandBuffers2[m_CurrentFrame]->beginRenderPass(pLightBufferPass, pLightFrameBuffer, (uint32_t)viewport.width, (uint32_t)viewport.height, &clearValue, 1, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
-		m_ppGraphicsCommandBuffers2[m_CurrentFrame]->executeSecondary(m_pVolumetricLightRenderer->getCommandBufferBuildPass(m_CurrentFrame));
-		m_ppGraphicsCommandBuffers2[m_CurrentFrame]->endRenderPass();
-	}
-
-	//TODO: Combine these into one renderpass
-
-	//Gather all renderer's data and finalize the frame
-	m_ppGraphicsCommandBuffers2[m_CurrentFrame]->beginRenderPass(m_pBackBufferRenderPass, pBackbuffer, (uint32_t)m_Viewport.width, (uint32_t)m_Viewport.height, nullptr, 0, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
-
-	m_ppGraphicsCommandBuffers2[m_CurrentFrame]->executeSecondary(m_pMeshRenderer->getLightCommandBuffer());
-
-	if (m_pVolumetricLightRenderer) {
-		m_ppGraphicsCommandBuffers2[m_CurrentFrame]->executeSecondary(m_pVolumetricLightRenderer->getCommandBufferApplyPass(m_CurrentFrame));
-	}
+			submitFrame(pBackbuffer, pBackbufferWithDepth);
+		}, FRAME_RESOURCE_GEOMETRY_SUBMITTED | FRAME_RESOURCE_LIGHT_COMMANDS | FRAME_RESOURCE_UI_COMMANDS | FRAME_RESOURCE_PARTICLE_COMMANDS | FRAME_RESOURCE_VOLUMETRIC_COMMANDS, 0);
 
-	m_ppGraphicsCommandBuffers2[m_CurrentFrame]->endRenderPass();
+	m_FrameGraph.execute();
+#else
+	recordMeshes(pVulkanScene);
+	m_pMeshRenderer->buildLightPass(m_pBackBufferRenderPass, pBackbuffer);
+	recordImGui(pBackbuffer);
 
-	//Render particles
 	if (m_pParticleRenderer)
 	{
-		m_ppGraphicsCommandBuffers2[m_CurrentFrame]->beginRenderPass(m_pParticleRenderPass, pBackbufferWithDepth, (uint32_t)m_Viewport.width, (uint32_t)m_Viewport.height, nullptr, 0, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
-		m_ppGraphicsCommandBuffers2[m_CurrentFrame]->executeSecondary(m_pParticleRenderer->getCommandBuffer(m_CurrentFrame));
-		m_ppGraphicsCommandBuffers2[m_CurrentFrame]->endRenderPass();
+		submitParticles();
+		m_pParticleRenderer->endFrame(pVulkanScene);
 	}
 
-	//Render UI
-	m_ppGraphicsCommandBuffers2[m_CurrentFrame]->beginRenderPass(m_pUIRenderPass, pBackbuffer, (uint32_t)m_Viewport.width, (uint32_t)m_Viewport.height, nullptr, 0, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
-	m_ppGraphicsCommandBuffers2[m_CurrentFrame]->executeSecondary(pSecondaryCommandBuffer);
-	m_ppGraphicsCommandBuffers2[m_CurrentFrame]->endRenderPass();
-
-	m_ppGraphicsCommandBuffers2[m_CurrentFrame]->end();
-	m_ppComputeCommandBuffers[m_CurrentFrame]->end();
-
-	// Execute commandbuffer
+	if (m_pVolumetricLightRenderer)
 	{
-		VkSemaphore graphicsSignalSemaphores[]		= { m_pRenderFinishedSemaphores[m_CurrentFrame] };
-		VkSemaphore graphicsWaitSemaphores[]		= { m_pImageAvailableSemaphores[m_CurrentFrame], m_ComputeFinishedGraphicsSemaphore };
-		VkPipelineStageFlags graphicswaitStages[]	= { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT , VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT };
+		recordVolumetricLight(pScene, pBackbuffer);
+	}
 
-		VkSemaphore computeSignalSemaphores[]		= { m_ComputeFinishedGraphicsSemaphore, m_ComputeFinishedTransferSemaphore };
-		VkSemaphore computeWaitSemaphores[]			= { m_GeometryFinishedSemaphore, m_TransferFinishedComputeSemaphore };
-		VkPipelineStageFlags computeWaitStages[]	= { VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_NV, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_NV };
+	submitTransfer();
+	submitGeometry(pScene);
+	submitFrame(pBackbuffer, pBackbufferWithDepth);
+#endif
 
-		pDevice->executeCompute(m_ppComputeCommandBuffers[m_CurrentFrame], computeWaitSemaphores, computeWaitStages, 2, computeSignalSemaphores, 2);
-		pDevice->executeGraphics(m_ppGraphicsCommandBuffers2[m_CurrentFrame], graphicsWaitSemaphores, graphicswaitStages, 2, graphicsSignalSemaphores, 1);
-	}
+	m_FrameJobHeapAllocations = JobAllocator::getHeapAllocationCount() - jobHeapAllocations;
 
 	swapBuffers();
 }
@@ -567,6 +416,7 @@ void RenderingHandlerVK::onWindowResize(uint32_t width, uint32_t height)
 	m_pGraphicsContext->getSwapChain()->resize(width, height);
 
 	m_pGBuffer->resize(width, height);
+	m_pHiZPyramid->onWindowResize(m_pGBuffer);
 
 	createRayTracingRenderImages(width, height);
 
@@ -612,6 +462,21 @@ void RenderingHandlerVK::onSceneUpdated(IScene* pScene)
 	}
 }
 
+void RenderingHandlerVK::setMeshRenderer(IRenderer* pMeshRenderer)
+{
+	m_pMeshRenderer = reinterpret_cast<MeshRendererVK*>(pMeshRenderer);
+	m_pMeshletCuller->initGeometryCounters(m_pMeshRenderer->getGeometryProfiler());
+	m_pGPUCuller->initCounters(m_pMeshRenderer->getGeometryProfiler());
+	m_pMeshRenderer->getGeometryProfiler()->initCounter(&m_VisibleObjectsCounter, "Objects visible");
+}
+
+void RenderingHandlerVK::setShadowMapRenderer(IRenderer* pShadowMapRenderer)
+{
+	m_pShadowMapRenderer = reinterpret_cast<ShadowMapRendererVK*>(pShadowMapRenderer);
+	m_pMeshletCuller->initShadowCounters(m_pShadowMapRenderer->getProfiler());
+	m_pShadowMapRenderer->getProfiler()->initCounter(&m_VisibleShadowCastersCounter, "Objects visible");
+}
+
 void RenderingHandlerVK::setRayTracingResolutionDenominator(uint32_t denom)
 {
 	m_RayTracingResolutionDenominator = denom;
@@ -664,6 +529,25 @@ void RenderingHandlerVK::drawProfilerUI()
 	if (m_pVolumetricLightRenderer) {
 		m_pVolumetricLightRenderer->drawProfilerResults();
 	}
+
+	// CPU timings of the last frame's graph, steps on the critical path are marked with a '*'
+	ImGui::Text("Frame Graph (CPU):\t%f ms, critical path %f ms", m_FrameGraph.getTotalTime(), m_FrameGraph.getCriticalPathTime());
+	for (uint32_t i = 0; i < m_FrameGraph.getNodeCount(); i++) {
+		ImGui::Text("--%s%s:\t%f ms (start %f ms)", m_FrameGraph.isOnCriticalPath(i) ? "*" : "", m_FrameGraph.getNodeName(i), m_FrameGraph.getNodeDuration(i), m_FrameGraph.getNodeStartTime(i));
+	}
+
+	// Should stay at zero once the job pools have warmed up
+	ImGui::Text("Job heap allocations last frame: %llu", (unsigned long long)m_FrameJobHeapAllocations);
+	ImGui::Text("Object culling last frame: %f ms", m_ObjectCullingTime);
+
+	// Wall time of the parallel recording of each pass next to the time spent in every chunk
+	if (m_pMeshRenderer) {
+		m_pMeshRenderer->getGeometryRecorder()->drawResults("Geometry Record");
+	}
+
+	if (m_pShadowMapRenderer) {
+		m_pShadowMapRenderer->getRecorder()->drawResults("Shadow Record");
+	}
 }
 
 void RenderingHandlerVK::setClearColor(float r, float g, float b)
@@ -1033,13 +917,54 @@ bool RenderingHandlerVK::createRenderPasses()
 		return false;
 	}
 
-	// Shadow map pass
-	m_pShadowMapRenderPass = DBG_NEW RenderPassVK(m_pGraphicsContext->getDevice());
+	//Draws the objects that the GPU culler only finds in its late phase on top of the geometry pass, so every attachment is loaded
+	m_pGeometryLateRenderPass = DBG_NEW RenderPassVK(m_pGraphicsContext->getDevice());
 
-	// Depth, shadow map
-	description.format			= VK_FORMAT_D32_SFLOAT;
-	description.samples			= VK_SAMPLE_COUNT_1_BIT;
-	description.loadOp			= VK_ATTACHMENT_LOAD_OP_CLEAR;
+	const VkFormat geometryFormats[] = { VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_R16G16B16A16_SFLOAT, VK_FORMAT_R16G16B16A16_SFLOAT, VK_FORMAT_D32_SFLOAT };
+	for (VkFormat format : geometryFormats)
+	{
+		description.format			= format;
+		description.samples			= VK_SAMPLE_COUNT_1_BIT;
+		description.loadOp			= VK_ATTACHMENT_LOAD_OP_LOAD;
+		description.storeOp			= VK_ATTACHMENT_STORE_OP_STORE;
+		description.stencilLoadOp	= VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		description.stencilStoreOp	= VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		description.initialLayout	= VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		description.finalLayout		= VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		m_pGeometryLateRenderPass->addAttachment(description);
+	}
+
+	m_pGeometryLateRenderPass->addSubpass(colorAttachmentRefs, COLOR_REF_COUNT, &depthStencilAttachmentRef);
+
+	//The depth pyramid has been built from the depth attachment in between the passes
+	dependency.dependencyFlags	= VK_DEPENDENCY_BY_REGION_BIT;
+	dependency.srcSubpass		= VK_SUBPASS_EXTERNAL;
+	dependency.dstSubpass		= 0;
+	dependency.srcStageMask		= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	dependency.dstStageMask		= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+	dependency.srcAccessMask	= VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependency.dstAccessMask	= VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	m_pGeometryLateRenderPass->addSubpassDependency(dependency);
+
+	dependency.srcSubpass		= 0;
+	dependency.dstSubpass		= VK_SUBPASS_EXTERNAL;
+	dependency.srcStageMask		= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependency.dstStageMask		= VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+	dependency.srcAccessMask	= VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	dependency.dstAccessMask	= VK_ACCESS_MEMORY_READ_BIT;
+	m_pGeometryLateRenderPass->addSubpassDependency(dependency);
+
+	if (!m_pGeometryLateRenderPass->finalize()) {
+		return false;
+	}
+
+	// Shadow map pass
+	m_pShadowMapRenderPass = DBG_NEW RenderPassVK(m_pGraphicsContext->getDevice());
+
+	// Depth, shadow map
+	description.format			= VK_FORMAT_D32_SFLOAT;
+	description.samples			= VK_SAMPLE_COUNT_1_BIT;
+	description.loadOp			= VK_ATTACHMENT_LOAD_OP_CLEAR;
 	description.storeOp			= VK_ATTACHMENT_STORE_OP_STORE;
 	description.stencilLoadOp	= VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	description.stencilStoreOp	= VK_ATTACHMENT_STORE_OP_DONT_CARE;
@@ -1176,7 +1101,341 @@ void RenderingHandlerVK::updateBuffers(SceneVK* pScene, const Camera& camera, co
 	}
 }
 
-void RenderingHandlerVK::submitParticles()
+void RenderingHandlerVK::recordMeshes(SceneVK* pScene)
+{
+	m_pMeshletCuller->beginFrame(m_CurrentFrame, pScene);
+
+	//Objects outside of a frustum are skipped before any of their meshlets are looked at. Without a directional light there is no shadow map to draw
+	const auto cullingStart = std::chrono::high_resolution_clock::now();
+
+	//Large scenes leave the geometry pass to a compute shader, which culls every object and writes the indirect draws. Their meshlets are not culled
+	auto& graphicsObjects = pScene->getGraphicsObjects();
+	m_IsGPUCulling = pScene->isGPUCullingEnabled() && m_pGPUCuller->isSupported() && graphicsObjects.size() >= GPU_CULLING_MIN_OBJECT_COUNT;
+	if (m_IsGPUCulling)
+	{
+		const uint32_t firstInstance		= pScene->getFirstInstance(m_pMeshRenderer->getCurrentFrame(), INSTANCE_INDICES_PASS_GEOMETRY);
+		const uint32_t firstLateInstance	= pScene->getFirstInstance(m_pMeshRenderer->getCurrentFrame(), INSTANCE_INDICES_PASS_GEOMETRY_LATE);
+		m_IsGPUCulling = m_pGPUCuller->beginFrame(m_CurrentFrame, pScene, m_CameraBuffer, firstInstance, firstLateInstance);
+	}
+
+	//The depth pyramid is only reprojected from the frame right before, a frame drawn without it leaves it out of date
+	m_IsOcclusionCulling = m_IsGPUCulling && pScene->isOcclusionCullingEnabled();
+	if (!m_IsOcclusionCulling)
+	{
+		m_pHiZPyramid->invalidate();
+	}
+
+	if (m_IsGPUCulling)
+	{
+		m_VisibleObjects.clear();
+	}
+	else
+	{
+		pScene->cullGraphicsObjects(pScene->getCamera().getFrustum(), m_VisibleObjects);
+	}
+
+	//Shadow casters are culled on the CPU even when the geometry pass is not. The culler is built around the camera: it reads LOD instead of ShadowLOD,
+	//tests against the depth pyramid of the camera and draws with the push constants of the geometry pipeline layout
+	LightSetup& lightSetup = pScene->getLightSetup();
+	if (lightSetup.hasDirectionalLight())
+	{
+		pScene->cullGraphicsObjects(lightSetup.getDirectionalLight()->getFrustum(), m_VisibleShadowCasters);
+	}
+	else
+	{
+		m_VisibleShadowCasters.clear();
+	}
+
+	m_ObjectCullingTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - cullingStart).count();
+	m_VisibleObjectsCounter.value		= m_VisibleObjects.size();
+	m_VisibleShadowCastersCounter.value	= m_VisibleShadowCasters.size();
+
+	if (m_IsGPUCulling)
+	{
+		m_pMeshRenderer->submitIndirect(m_pGPUCuller);
+	}
+
+	m_pMeshletCuller->countGeometryInstances(graphicsObjects, m_VisibleObjects);
+	m_pMeshletCuller->countShadowInstances(graphicsObjects, m_VisibleShadowCasters);
+
+	//The renderers sort their draws by state and then by these depths, so that the draws that share state go front to back
+	const glm::vec3 cameraPosition = pScene->getCamera().getPosition();
+	for (uint32_t i : m_VisibleObjects)
+	{
+		const GraphicsObjectVK& graphicsObject = graphicsObjects[i];
+		const float depth = glm::distance(pScene->getObjectCenter(i), cameraPosition);
+		m_pMeshRenderer->submitMesh(graphicsObject.pMesh, graphicsObject.pMaterial, graphicsObject.MaterialParametersIndex, i, m_pMeshletCuller->cullGeometry(graphicsObject, pScene->getTransform(i)), depth);
+	}
+
+	if (!m_VisibleShadowCasters.empty())
+	{
+		const glm::vec3 lightDirection = glm::normalize(lightSetup.getDirectionalLight()->getDirection());
+		for (uint32_t i : m_VisibleShadowCasters)
+		{
+			const GraphicsObjectVK& graphicsObject = graphicsObjects[i];
+			const float depth = glm::dot(pScene->getObjectCenter(i), lightDirection);
+			m_pShadowMapRenderer->submitMesh(graphicsObject.pMesh, graphicsObject.pMaterial, i, m_pMeshletCuller->cullShadow(graphicsObject, pScene->getTransform(i)), depth);
+		}
+	}
+
+	m_pMeshRenderer->endFrame(pScene);
+	m_pShadowMapRenderer->endFrame(pScene);
+}
+
+void RenderingHandlerVK::recordImGui(FrameBufferVK* pBackbuffer)
+{
+	CommandBufferVK*	pSecondaryCommandBuffer = m_ppCommandBuffersSecondary[m_CurrentFrame];
+	CommandPoolVK*		pSecondaryCommandPool	= m_ppCommandPoolsSecondary[m_CurrentFrame];
+
+	// Needed to begin a secondary buffer
+	VkCommandBufferInheritanceInfo inheritanceInfo = {};
+	inheritanceInfo.sType		= VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritanceInfo.pNext		= nullptr;
+	inheritanceInfo.renderPass	= m_pBackBufferRenderPass->getRenderPass();
+	inheritanceInfo.subpass		= 0;
+	inheritanceInfo.framebuffer = pBackbuffer->getFrameBuffer();
+
+	pSecondaryCommandBuffer->reset(false);
+	pSecondaryCommandPool->reset();
+	pSecondaryCommandBuffer->begin(&inheritanceInfo, VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT);
+	m_pImGuiRenderer->render(pSecondaryCommandBuffer, m_CurrentFrame);
+	pSecondaryCommandBuffer->end();
+}
+
+void RenderingHandlerVK::recordVolumetricLight(IScene* pScene, FrameBufferVK* pBackbuffer)
+{
+	m_pVolumetricLightRenderer->renderLightBuffer();
+	m_pVolumetricLightRenderer->applyLightBuffer(m_pBackBufferRenderPass, pBackbuffer);
+
+	m_pVolumetricLightRenderer->endFrame(pScene);
+}
+
+void RenderingHandlerVK::submitTransfer()
+{
+	static bool firstFrame = true;
+
+	const uint32_t waitCount = firstFrame ? 0 : 2;
+	firstFrame = false;
+
+	VkSemaphore				transferWaitSemphores[]		= { m_TransferStartSemaphore, m_ComputeFinishedTransferSemaphore };
+	VkPipelineStageFlags	transferWaitStages[]		= { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT };
+	VkSemaphore				transferSignalSemaphores[]	= { m_TransferFinishedGraphicsSemaphore, m_TransferFinishedComputeSemaphore };
+
+	m_pGraphicsContext->getDevice()->executeTransfer(m_ppTransferCommandBuffers[m_CurrentFrame], transferWaitSemphores, transferWaitStages, waitCount, transferSignalSemaphores, 2);
+}
+
+void RenderingHandlerVK::submitGeometry(IScene* pScene)
+{
+	DeviceVK*	pDevice		= m_pGraphicsContext->getDevice();
+	LightSetup&	lightsetup	= pScene->getLightSetup();
+
+	if (m_IsGPUCulling)
+	{
+		m_pGPUCuller->dispatch(m_ppGraphicsCommandBuffers[m_CurrentFrame], GPU_CULLING_PHASE_EARLY);
+	}
+
+	//Start renderpass
+	VkClearValue clearValues[] = { m_ClearColor, m_ClearColor, m_ClearColor, m_ClearDepth };
+	m_ppGraphicsCommandBuffers[m_CurrentFrame]->beginRenderPass(m_pGeometryRenderPass, m_pGBuffer->getFrameBuffer(), (uint32_t)m_Viewport.width, (uint32_t)m_Viewport.height, clearValues, 4, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+	m_pMeshRenderer->executeGeometryPass(m_ppGraphicsCommandBuffers[m_CurrentFrame]);
+	m_ppGraphicsCommandBuffers[m_CurrentFrame]->endRenderPass();
+
+	//The pyramid is built from the objects drawn in the early phase, it is used by the late phase and reprojected by the early phase of the next frame
+	if (m_IsOcclusionCulling)
+	{
+		const bool hasLatePhase = m_pGPUCuller->hasLatePhase();
+		m_pHiZPyramid->build(m_ppGraphicsCommandBuffers[m_CurrentFrame]);
+
+		if (hasLatePhase)
+		{
+			m_pGPUCuller->dispatch(m_ppGraphicsCommandBuffers[m_CurrentFrame], GPU_CULLING_PHASE_LATE);
+
+			m_ppGraphicsCommandBuffers[m_CurrentFrame]->beginRenderPass(m_pGeometryLateRenderPass, m_pGBuffer->getFrameBuffer(), (uint32_t)m_Viewport.width, (uint32_t)m_Viewport.height, nullptr, 0, VK_SUBPASS_CONTENTS_INLINE);
+			m_pMeshRenderer->drawLateGeometry(m_ppGraphicsCommandBuffers[m_CurrentFrame], m_pGPUCuller);
+			m_ppGraphicsCommandBuffers[m_CurrentFrame]->endRenderPass();
+		}
+	}
+
+	if (lightsetup.hasDirectionalLight()) {
+		FrameBufferVK* pFrameBuffer = reinterpret_cast<FrameBufferVK*>(lightsetup.getDirectionalLight()->getFrameBuffer());
+		const VkViewport& viewport = m_pShadowMapRenderer->getViewport();
+
+		m_ppGraphicsCommandBuffers[m_CurrentFrame]->beginRenderPass(m_pShadowMapRenderPass, pFrameBuffer, (uint32_t)viewport.width, (uint32_t)viewport.height, &m_ClearDepth, 1, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		m_pShadowMapRenderer->executePass(m_ppGraphicsCommandBuffers[m_CurrentFrame], m_CurrentFrame);
+		m_ppGraphicsCommandBuffers[m_CurrentFrame]->endRenderPass();
+	}
+
+	if (m_pRayTracer)
+	{
+		uint32_t computeQueueIndex	= pDevice->getQueueFamilyIndices().computeFamily.value();
+		uint32_t graphicsQueueIndex = pDevice->getQueueFamilyIndices().graphicsFamily.value();
+
+		constexpr uint32_t IMAGE_BARRIER_COUNT = 6;
+		VkImageMemoryBarrier imageBarriers[IMAGE_BARRIER_COUNT] =
+		{
+			createVkImageMemoryBarrier(m_pGBuffer->getDepthImage()->getImage(), VK_ACCESS_MEMORY_READ_BIT, 0, graphicsQueueIndex, computeQueueIndex,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1, 1),
+			createVkImageMemoryBarrier(m_pGBuffer->getColorImage(0)->getImage(), VK_ACCESS_MEMORY_READ_BIT, 0, graphicsQueueIndex, computeQueueIndex,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
+			createVkImageMemoryBarrier(m_pGBuffer->getColorImage(1)->getImage(), VK_ACCESS_MEMORY_READ_BIT, 0, graphicsQueueIndex, computeQueueIndex,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
+			createVkImageMemoryBarrier(m_pGBuffer->getColorImage(2)->getImage(), VK_ACCESS_MEMORY_READ_BIT, 0, graphicsQueueIndex, computeQueueIndex,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
+			createVkImageMemoryBarrier(m_pRadianceImage->getImage(), VK_ACCESS_MEMORY_READ_BIT, 0, graphicsQueueIndex, computeQueueIndex,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
+			createVkImageMemoryBarrier(m_pGlossyImage->getImage(), VK_ACCESS_MEMORY_READ_BIT, 0, graphicsQueueIndex, computeQueueIndex,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL,  VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
+		};
+
+		m_ppGraphicsCommandBuffers[m_CurrentFrame]->imageMemoryBarrier(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, IMAGE_BARRIER_COUNT, imageBarriers);
+		m_ppGraphicsCommandBuffers[m_CurrentFrame]->end();
+
+		{
+			VkSemaphore geometryWaitSemphores[] = { m_TransferFinishedGraphicsSemaphore };
+			VkPipelineStageFlags geometryWaitStages[] = { VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT };
+
+			VkSemaphore signalSemaphores[] = { m_GeometryFinishedSemaphore, m_TransferStartSemaphore };
+			pDevice->executeGraphics(m_ppGraphicsCommandBuffers[m_CurrentFrame], geometryWaitSemphores, geometryWaitStages, 1, signalSemaphores, 2);
+		}
+
+		//Prepare seconds graphics commandbuffer
+		m_ppGraphicsCommandBuffers2[m_CurrentFrame]->begin(nullptr, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+		{
+			VkImageMemoryBarrier imageBarriers[IMAGE_BARRIER_COUNT] =
+			{
+				createVkImageMemoryBarrier(m_pGBuffer->getDepthImage()->getImage(), 0, VK_ACCESS_MEMORY_READ_BIT, graphicsQueueIndex, computeQueueIndex,
+					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1, 1),
+				createVkImageMemoryBarrier(m_pGBuffer->getColorImage(0)->getImage(), 0, VK_ACCESS_MEMORY_READ_BIT, graphicsQueueIndex, computeQueueIndex,
+					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
+				createVkImageMemoryBarrier(m_pGBuffer->getColorImage(1)->getImage(), 0, VK_ACCESS_MEMORY_READ_BIT, graphicsQueueIndex, computeQueueIndex,
+					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
+				createVkImageMemoryBarrier(m_pGBuffer->getColorImage(2)->getImage(), 0, VK_ACCESS_MEMORY_READ_BIT, graphicsQueueIndex, computeQueueIndex,
+					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
+				createVkImageMemoryBarrier(m_pRadianceImage->getImage(), 0, VK_ACCESS_MEMORY_WRITE_BIT, graphicsQueueIndex, computeQueueIndex,
+					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
+				createVkImageMemoryBarrier(m_pGlossyImage->getImage(), 0, VK_ACCESS_MEMORY_WRITE_BIT, graphicsQueueIndex, computeQueueIndex,
+					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL,  VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
+			};
+			m_ppComputeCommandBuffers[m_CurrentFrame]->imageMemoryBarrier(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_NV, IMAGE_BARRIER_COUNT, imageBarriers);
+		}
+
+		m_pRayTracer->render(pScene);
+		m_ppComputeCommandBuffers[m_CurrentFrame]->executeSecondary(m_pRayTracer->getComputeCommandBuffer());
+
+		{
+			VkImageMemoryBarrier imageBarriers[IMAGE_BARRIER_COUNT] =
+			{
+				createVkImageMemoryBarrier(m_pGBuffer->getDepthImage()->getImage(), VK_ACCESS_MEMORY_READ_BIT, 0, computeQueueIndex, graphicsQueueIndex,
+					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1, 1),
+				createVkImageMemoryBarrier(m_pGBuffer->getColorImage(0)->getImage(), VK_ACCESS_MEMORY_READ_BIT, 0, computeQueueIndex, graphicsQueueIndex,
+					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
+				createVkImageMemoryBarrier(m_pGBuffer->getColorImage(1)->getImage(), VK_ACCESS_MEMORY_READ_BIT, 0, computeQueueIndex, graphicsQueueIndex,
+					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
+				createVkImageMemoryBarrier(m_pGBuffer->getColorImage(2)->getImage(), VK_ACCESS_MEMORY_READ_BIT, 0, computeQueueIndex, graphicsQueueIndex,
+					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
+				createVkImageMemoryBarrier(m_pRadianceImage->getImage(), VK_ACCESS_MEMORY_WRITE_BIT, 0, computeQueueIndex, graphicsQueueIndex,
+					VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
+				createVkImageMemoryBarrier(m_pGlossyImage->getImage(), VK_ACCESS_MEMORY_WRITE_BIT, 0, computeQueueIndex, graphicsQueueIndex,
+					VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,  VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
+			};
+			m_ppComputeCommandBuffers[m_CurrentFrame]->imageMemoryBarrier(VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_NV, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, IMAGE_BARRIER_COUNT, imageBarriers);
+		}
+
+		{
+			VkImageMemoryBarrier imageBarriers[IMAGE_BARRIER_COUNT] =
+			{
+				createVkImageMemoryBarrier(m_pGBuffer->getDepthImage()->getImage(), 0, VK_ACCESS_MEMORY_READ_BIT, computeQueueIndex, graphicsQueueIndex,
+					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1, 1),
+				createVkImageMemoryBarrier(m_pGBuffer->getColorImage(0)->getImage(), 0, VK_ACCESS_MEMORY_READ_BIT, computeQueueIndex, graphicsQueueIndex,
+					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
+				createVkImageMemoryBarrier(m_pGBuffer->getColorImage(1)->getImage(), 0, VK_ACCESS_MEMORY_READ_BIT, computeQueueIndex, graphicsQueueIndex,
+					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
+				createVkImageMemoryBarrier(m_pGBuffer->getColorImage(2)->getImage(), 0, VK_ACCESS_MEMORY_READ_BIT, computeQueueIndex, graphicsQueueIndex,
+					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
+				createVkImageMemoryBarrier(m_pRadianceImage->getImage(), 0, VK_ACCESS_MEMORY_READ_BIT, computeQueueIndex, graphicsQueueIndex,
+					VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
+				createVkImageMemoryBarrier(m_pGlossyImage->getImage(), 0, VK_ACCESS_MEMORY_READ_BIT, computeQueueIndex, graphicsQueueIndex,
+					VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,  VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1, 1),
+			};
+			m_ppGraphicsCommandBuffers2[m_CurrentFrame]->imageMemoryBarrier(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, IMAGE_BARRIER_COUNT, imageBarriers);
+		}
+	}
+	else
+	{
+		m_ppGraphicsCommandBuffers[m_CurrentFrame]->end();
+		{
+			VkSemaphore geometryWaitSemphores[] = { m_TransferFinishedGraphicsSemaphore };
+			VkPipelineStageFlags geometryWaitStages[] = { VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT };
+
+			VkSemaphore signalSemaphores[] = { m_GeometryFinishedSemaphore, m_TransferStartSemaphore };
+			pDevice->executeGraphics(m_ppGraphicsCommandBuffers[m_CurrentFrame], geometryWaitSemphores, geometryWaitStages, 1, signalSemaphores, 2);
+		}
+		m_ppGraphicsCommandBuffers2[m_CurrentFrame]->begin(nullptr, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+	}
+}
+
+void RenderingHandlerVK::submitFrame(FrameBufferVK* pBackbuffer, FrameBufferVK* pBackbufferWithDepth)
+{
+	DeviceVK* pDevice = m_pGraphicsContext->getDevice();
+
+	if (m_pVolumetricLightRenderer) {
+		RenderPassVK* pLightBufferPass = m_pVolumetricLightRenderer->getLightBufferPass();
+		FrameBufferVK* pLightFrameBuffer = m_pVolumetricLightRenderer->getLightFrameBuffer();
+		const VkViewport& viewport = m_pVolumetricLightRenderer->getViewport();
+		VkClearValue clearValue = m_pVolumetricLightRenderer->getLightBufferClearColor();
+
+		m_ppGraphicsCommandBuffers2[m_CurrentFrame]->beginRenderPass(pLightBufferPass, pLightFrameBuffer, (uint32_t)viewport.width, (uint32_t)viewport.height, &clearValue, 1, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		m_ppGraphicsCommandBuffers2[m_CurrentFrame]->executeSecondary(m_pVolumetricLightRenderer->getCommandBufferBuildPass(m_CurrentFrame));
+		m_ppGraphicsCommandBuffers2[m_CurrentFrame]->endRenderPass();
+	}
+
+	//TODO: Combine these into one renderpass
+
+	//Gather all renderer's data and finalize the frame
+	m_ppGraphicsCommandBuffers2[m_CurrentFrame]->beginRenderPass(m_pBackBufferRenderPass, pBackbuffer, (uint32_t)m_Viewport.width, (uint32_t)m_Viewport.height, nullptr, 0, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+	m_ppGraphicsCommandBuffers2[m_CurrentFrame]->executeSecondary(m_pMeshRenderer->getLightCommandBuffer());
+
+	if (m_pVolumetricLightRenderer) {
+		m_ppGraphicsCommandBuffers2[m_CurrentFrame]->executeSecondary(m_pVolumetricLightRenderer->getCommandBufferApplyPass(m_CurrentFrame));
+	}
+
+	m_ppGraphicsCommandBuffers2[m_CurrentFrame]->endRenderPass();
+
+	//Render particles
+	if (m_pParticleRenderer)
+	{
+		m_ppGraphicsCommandBuffers2[m_CurrentFrame]->beginRenderPass(m_pParticleRenderPass, pBackbufferWithDepth, (uint32_t)m_Viewport.width, (uint32_t)m_Viewport.height, nullptr, 0, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		m_ppGraphicsCommandBuffers2[m_CurrentFrame]->executeSecondary(m_pParticleRenderer->getCommandBuffer(m_CurrentFrame));
+		m_ppGraphicsCommandBuffers2[m_CurrentFrame]->endRenderPass();
+	}
+
+	//Render UI
+	m_ppGraphicsCommandBuffers2[m_CurrentFrame]->beginRenderPass(m_pUIRenderPass, pBackbuffer, (uint32_t)m_Viewport.width, (uint32_t)m_Viewport.height, nullptr, 0, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+	m_ppGraphicsCommandBuffers2[m_CurrentFrame]->executeSecondary(m_ppCommandBuffersSecondary[m_CurrentFrame]);
+	m_ppGraphicsCommandBuffers2[m_CurrentFrame]->endRenderPass();
+
+	m_ppGraphicsCommandBuffers2[m_CurrentFrame]->end();
+	m_ppComputeCommandBuffers[m_CurrentFrame]->end();
+
+	// Execute commandbuffer
+	{
+		VkSemaphore graphicsSignalSemaphores[]		= { m_pRenderFinishedSemaphores[m_CurrentFrame] };
+		VkSemaphore graphicsWaitSemaphores[]		= { m_pImageAvailableSemaphores[m_CurrentFrame], m_ComputeFinishedGraphicsSemaphore };
+		VkPipelineStageFlags graphicswaitStages[]	= { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT , VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT };
+
+		VkSemaphore computeSignalSemaphores[]		= { m_ComputeFinishedGraphicsSemaphore, m_ComputeFinishedTransferSemaphore };
+		VkSemaphore computeWaitSemaphores[]			= { m_GeometryFinishedSemaphore, m_TransferFinishedComputeSemaphore };
+		VkPipelineStageFlags computeWaitStages[]	= { VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_NV, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_NV };
+
+		pDevice->executeCompute(m_ppComputeCommandBuffers[m_CurrentFrame], computeWaitSemaphores, computeWaitStages, 2, computeSignalSemaphores, 2);
+		pDevice->executeGraphics(m_ppGraphicsCommandBuffers2[m_CurrentFrame], graphicsWaitSemaphores, graphicswaitStages, 2, graphicsSignalSemaphores, 1);
+	}
+}
+
+void RenderingHandlerVK::transferParticleOwnership()
 {
 	ParticleEmitterHandlerVK* pEmitterHandler = reinterpret_cast<ParticleEmitterHandlerVK*>(m_pParticleEmitterHandler);
 
@@ -1208,7 +1467,11 @@ void RenderingHandlerVK::submitParticles()
 			VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
 			VK_IMAGE_ASPECT_DEPTH_BIT);
 	}
+}
 
+void RenderingHandlerVK::submitParticles()
+{
+	ParticleEmitterHandlerVK* pEmitterHandler = reinterpret_cast<ParticleEmitterHandlerVK*>(m_pParticleEmitterHandler);
 	for (ParticleEmitter* pEmitter : pEmitterHandler->getParticleEmitters()) {
 		m_pParticleRenderer->submitParticles(pEmitter);
 	}
@@ -1,10 +1,14 @@
 #pragma once
 #include "Common/RenderingHandler.hpp"
 #include "Core/Camera.h"
+#include "Core/TaskGraph.h"
 
 #include "Vulkan/ImguiVK.h"
+#include "Vulkan/ProfilerVK.h"
 #include "Vulkan/VulkanCommon.h"
 
+#include <vector>
+
 class BufferVK;
 class CommandBufferVK;
 class CommandPoolVK;
@@ -18,6 +22,9 @@ class ImguiVK;
 class IRenderer;
 class IScene;
 class MeshRendererVK;
+class MeshletCullerVK;
+class GPUCullerVK;
+class HiZPyramidVK;
 class MeshVK;
 class ParticleRendererVK;
 class PipelineVK;
@@ -45,8 +52,8 @@ public:
     virtual void drawProfilerUI() override;
 
     virtual void setImguiRenderer(IImgui* pImGui) override                                  { m_pImGuiRenderer = reinterpret_cast<ImguiVK*>(pImGui); }
-    virtual void setMeshRenderer(IRenderer* pMeshRenderer) override                         { m_pMeshRenderer = reinterpret_cast<MeshRendererVK*>(pMeshRenderer); }
-    virtual void setShadowMapRenderer(IRenderer* pShadowMapRenderer) override               { m_pShadowMapRenderer = reinterpret_cast<ShadowMapRendererVK*>(pShadowMapRenderer); }
+    virtual void setMeshRenderer(IRenderer* pMeshRenderer) override;
+    virtual void setShadowMapRenderer(IRenderer* pShadowMapRenderer) override;
 	virtual void setRayTracer(IRenderer* pRayTracer) override				                { m_pRayTracer = reinterpret_cast<RayTracingRendererVK*>(pRayTracer); }
     virtual void setVolumetricLightRenderer(IRenderer* pVolumetricLightRenderer) override   { m_pVolumetricLightRenderer = reinterpret_cast<VolumetricLightRendererVK*>(pVolumetricLightRenderer); }
     virtual void setParticleRenderer(IRenderer* pParticleRenderer) override                 { m_pParticleRenderer = reinterpret_cast<ParticleRendererVK*>(pParticleRenderer); }
@@ -90,16 +97,43 @@ private:
 
     void updateBuffers(SceneVK* pScene, const Camera& camera, const LightSetup& lightSetup);
 
+    void recordMeshes(SceneVK* pScene);
+    void recordImGui(FrameBufferVK* pBackbuffer);
+    void recordVolumetricLight(IScene* pScene, FrameBufferVK* pBackbuffer);
+    // Records the ownership transfers of the depth buffer and particle buffers into the primary buffer
+    void transferParticleOwnership();
     void submitParticles();
+    void submitTransfer();
+    // Records the geometry and shadow passes into the primary buffer and submits it
+    void submitGeometry(IScene* pScene);
+    // Records the second primary buffer, which composites the frame, and submits it along with the compute buffer
+    void submitFrame(FrameBufferVK* pBackbuffer, FrameBufferVK* pBackbufferWithDepth);
 
 private:
     CameraBuffer m_CameraBuffer;
+    TaskGraph m_FrameGraph;
+    // Heap allocations made by the job system while the last frame was recorded
+    uint64_t m_FrameJobHeapAllocations;
+    // Indices of the graphics objects that intersect the camera and the shadow map frustums, reused every frame
+    std::vector<uint32_t> m_VisibleObjects;
+    std::vector<uint32_t> m_VisibleShadowCasters;
+    ProfilerCounter m_VisibleObjectsCounter;
+    ProfilerCounter m_VisibleShadowCastersCounter;
+    // CPU time spent culling the graphics objects of the last frame
+    double m_ObjectCullingTime;
+    // Set when the geometry pass of the frame is culled and drawn by the GPU culler, whose dispatch then has to be recorded before the pass
+    bool m_IsGPUCulling;
+    // Set when the GPU culler also tests the objects against the depth pyramid, which is then built after the geometry pass
+    bool m_IsOcclusionCulling;
 
     GraphicsContextVK* m_pGraphicsContext;
 
     SkyboxRendererVK*       m_pSkyboxRenderer;
     MeshRendererVK*         m_pMeshRenderer;
     ShadowMapRendererVK*         m_pShadowMapRenderer;
+    MeshletCullerVK*        m_pMeshletCuller;
+    GPUCullerVK*            m_pGPUCuller;
+    HiZPyramidVK*           m_pHiZPyramid;
     ParticleRendererVK*     m_pParticleRenderer;
     RayTracingRendererVK*   m_pRayTracer;
     VolumetricLightRendererVK* m_pVolumetricLightRenderer;
@@ -127,6 +161,7 @@ private:
 	CommandBufferVK*    m_ppCommandBuffersSecondary[MAX_FRAMES_IN_FLIGHT];
 
 	RenderPassVK*   m_pGeometryRenderPass;
+	RenderPassVK*   m_pGeometryLateRenderPass;
 	RenderPassVK*   m_pShadowMapRenderPass;
     RenderPassVK*   m_pBackBufferRenderPass;
     RenderPassVK*   m_pParticleRenderPass;
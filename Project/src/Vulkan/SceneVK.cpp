@@ -11,12 +11,18 @@
 #include "Vulkan/RenderingHandlerVK.h"
 #include "Vulkan/SamplerVK.h"
 #include "Vulkan/Texture2DVK.h"
+#include "Vulkan/TextureLoaderVK.h"
 
 #include "Vulkan/CommandPoolVK.h"
 #include "Vulkan/CommandBufferVK.h"
+#include "Vulkan/CopyHandlerVK.h"
 
 #include "Core/TaskDispatcher.h"
+#include "Core/MeshCache.h"
+#include "Core/TextureCache.h"
 
+#include <mutex>
+#include <limits>
 #include <algorithm>
 #include <tinyobjloader/tiny_obj_loader.h>
 #include <imgui/imgui.h>
@@ -51,14 +57,36 @@ SceneVK::SceneVK(IGraphicsContext* pContext, const RenderingHandlerVK* pRenderin
 	m_pMaterialParametersBuffer(nullptr),
 	m_pTransformsBufferGraphics(nullptr),
 	m_pTransformsBufferCompute(nullptr),
+	m_pInstanceIndicesBuffer(nullptr),
+	m_pMappedInstanceIndices(nullptr),
+	m_InstanceIndexCapacity(0),
+	m_ObjectCuller(),
+	m_ObjectTree(),
+	m_ObjectLeaves(),
 	m_pGarbageTransformsBufferGraphics(nullptr),
 	m_pGarbageTransformsBufferCompute(nullptr),
+	m_pGarbageInstanceIndicesBuffer(nullptr),
 	m_DebugParametersDirty(false),
 	m_pProfiler(nullptr),
 	m_RayTracingEnabled(pContext->isRayTracingEnabled()),
 	m_pDescriptorPool(nullptr),
 	m_pGeometryPipelineLayout(nullptr),
-	m_pGeometryDescriptorSetLayout(nullptr)
+	m_pGeometryDescriptorSetLayout(nullptr),
+	m_RetiredDescriptorSets(),
+	m_FrameCounter(0),
+	m_pTextureLoader(nullptr),
+	m_StreamingLock(),
+	m_StreamingTextures(),
+	m_StreamingStartTime(),
+	m_StreamedTextureCount(0),
+	m_LoadedTextureCount(0),
+	m_FailedTextureCount(0),
+	m_VertexFormat(EVertexFormat::STANDARD),
+	m_LODBias(0),
+	m_ShadowLODBias(LOD_SHADOW_BIAS),
+	m_IsMeshletCullingEnabled(true),
+	m_IsGPUCullingEnabled(true),
+	m_IsOcclusionCullingEnabled(true)
 {
 	m_pDevice = reinterpret_cast<DeviceVK*>(m_pContext->getDevice());
 }
@@ -66,6 +94,8 @@ SceneVK::SceneVK(IGraphicsContext* pContext, const RenderingHandlerVK* pRenderin
 SceneVK::~SceneVK()
 {
 	SAFEDELETE(m_pProfiler);
+	//Waits for the reads and decodes that are still running on the background pool
+	SAFEDELETE(m_pTextureLoader);
 
 	if (m_pTempCommandBuffer != nullptr)
 	{
@@ -95,6 +125,8 @@ SceneVK::~SceneVK()
 	SAFEDELETE(m_pTransformsBufferCompute);
 	SAFEDELETE(m_pGarbageTransformsBufferGraphics);
 	SAFEDELETE(m_pGarbageTransformsBufferCompute);
+	SAFEDELETE(m_pInstanceIndicesBuffer);
+	SAFEDELETE(m_pGarbageInstanceIndicesBuffer);
 
 	for (auto& bottomLevelAccelerationStructurePerMesh : m_NewBottomLevelAccelerationStructures)
 	{
@@ -157,21 +189,21 @@ SceneVK::~SceneVK()
 
 bool SceneVK::loadFromFile(const std::string& dir, const std::string& fileName)
 {
-	tinyobj::attrib_t attributes;
-	std::vector<tinyobj::shape_t> shapes;
 	std::vector<tinyobj::material_t> materials;
-	std::string warn, err;
 
-	if (!tinyobj::LoadObj(&attributes, &shapes, &materials, &warn, &err, (dir + fileName).c_str(), dir.c_str(), true, false))
+	//Shapes are welded in parallel on the first import, later starts map the cached result
+	MeshCache meshCache;
+	if (!meshCache.load(dir + fileName, false, &materials))
 	{
-		LOG("Failed to load scene '%s'. Warning: %s Error: %s", (dir + fileName).c_str(), warn.c_str(), err.c_str());
+		LOG("Failed to load scene '%s'", (dir + fileName).c_str());
 		return false;
 	}
 
-	m_SceneMeshes.resize(shapes.size());
+	const uint32_t shapeCount = meshCache.getShapeCount();
+	m_SceneMeshes.resize(shapeCount);
 	m_SceneMaterials.resize(materials.size() + 1);
 
-	for (uint32_t i = 0; i < shapes.size(); i++)
+	for (uint32_t i = 0; i < shapeCount; i++)
 	{
 		m_SceneMeshes[i] = nullptr;
 	}
@@ -208,10 +240,7 @@ bool SceneVK::loadFromFile(const std::string& dir, const std::string& fileName)
 				ITexture2D* pAlbedoMap = m_pContext->createTexture2D();
 				m_SceneTextures[filename] = pAlbedoMap;
 
-				TaskDispatcher::execute([=]
-					{
-						pAlbedoMap->initFromFile(filename, ETextureFormat::FORMAT_R8G8B8A8_UNORM);
-					});
+				streamTexture(pAlbedoMap, filename, ETextureFormat::FORMAT_R8G8B8A8_UNORM, ETextureCompression::COLOR);
 				pMaterial->setAlbedoMap(pAlbedoMap);
 			}
 			else
@@ -228,10 +257,7 @@ bool SceneVK::loadFromFile(const std::string& dir, const std::string& fileName)
 				ITexture2D* pNormalMap = m_pContext->createTexture2D();
 				m_SceneTextures[filename] = pNormalMap;
 
-				TaskDispatcher::execute([=]
-					{
-						pNormalMap->initFromFile(filename, ETextureFormat::FORMAT_R8G8B8A8_UNORM);
-					});
+				streamTexture(pNormalMap, filename, ETextureFormat::FORMAT_R8G8B8A8_UNORM, ETextureCompression::NORMAL_MAP);
 				pMaterial->setNormalMap(pNormalMap);
 			}
 			else
@@ -248,10 +274,7 @@ bool SceneVK::loadFromFile(const std::string& dir, const std::string& fileName)
 				ITexture2D* pMetallicMap = m_pContext->createTexture2D();
 				m_SceneTextures[filename] = pMetallicMap;
 
-				TaskDispatcher::execute([=]
-					{
-						pMetallicMap->initFromFile(filename, ETextureFormat::FORMAT_R8G8B8A8_UNORM);
-					});
+				streamTexture(pMetallicMap, filename, ETextureFormat::FORMAT_R8G8B8A8_UNORM, ETextureCompression::SINGLE_CHANNEL);
 				pMaterial->setMetallicMap(pMetallicMap);
 			}
 			else
@@ -268,10 +291,7 @@ bool SceneVK::loadFromFile(const std::string& dir, const std::string& fileName)
 				ITexture2D* pRoughnessMap = m_pContext->createTexture2D();
 				m_SceneTextures[filename] = pRoughnessMap;
 
-				TaskDispatcher::execute([=]
-					{
-						pRoughnessMap->initFromFile(filename, ETextureFormat::FORMAT_R8G8B8A8_UNORM);
-					});
+				streamTexture(pRoughnessMap, filename, ETextureFormat::FORMAT_R8G8B8A8_UNORM, ETextureCompression::SINGLE_CHANNEL);
 				pMaterial->setRoughnessMap(pRoughnessMap);
 			}
 			else
@@ -288,84 +308,56 @@ bool SceneVK::loadFromFile(const std::string& dir, const std::string& fileName)
 		m_SceneMaterials[m] = pMaterial;
 	}
 
-	glm::mat4 transform = glm::scale(glm::mat4(1.0f), glm::vec3(0.005f));
-	for (uint32_t s = 0; s < shapes.size(); s++)
-	{
-		tinyobj::shape_t& shape = shapes[s];
-
-		std::vector<Vertex> vertices = {};
-		std::vector<uint32_t> indices = {};
-		std::unordered_map<Vertex, uint32_t> uniqueVertices = {};
-
-		for (const tinyobj::index_t& index : shape.mesh.indices)
-		{
-			Vertex vertex = {};
-
-			//Normals and texcoords are optional, while positions are required
-			ASSERT(index.vertex_index >= 0);
-
-			vertex.Position =
-			{
-				attributes.vertices[3 * (size_t)index.vertex_index + 0],
-				attributes.vertices[3 * (size_t)index.vertex_index + 1],
-				attributes.vertices[3 * (size_t)index.vertex_index + 2]
-			};
-
-			if (index.normal_index >= 0)
-			{
-				vertex.Normal =
-				{
-					attributes.normals[3 * (size_t)index.normal_index + 0],
-					attributes.normals[3 * (size_t)index.normal_index + 1],
-					attributes.normals[3 * (size_t)index.normal_index + 2]
-				};
-			}
-
-			if (index.texcoord_index >= 0)
-			{
-				vertex.TexCoord =
-				{
-					attributes.texcoords[2 * (size_t)index.texcoord_index + 0],
-					1.0f - attributes.texcoords[2 * (size_t)index.texcoord_index + 1]
-				};
-			}
+	//Meshes are created in shape order so that mesh IDs and the order of the graphics objects stay the same between runs.
+	//The uploads read straight from the cache, it is released once they have been recorded
+	std::vector<BufferUpdateVK> bufferUpdates((size_t)shapeCount * 2);
 
-			if (uniqueVertices.count(vertex) == 0)
-			{
-				uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-				vertices.push_back(vertex);
-			}
+	//Packed vertices are converted from the cache up front and kept until the uploads have been recorded
+	std::vector<PackedVertex> packedVertices;
+	if (m_VertexFormat == EVertexFormat::PACKED)
+	{
+		packedVertices.resize(meshCache.getVertexCount());
+		VertexPacker::pack(meshCache.getVertices(), meshCache.getVertexCount(), packedVertices.data());
+	}
 
-			indices.push_back(uniqueVertices[vertex]);
-		}
+	const uint32_t vertexStride = VertexPacker::getStride(m_VertexFormat);
 
-		//Calculate tangents
-		for (uint32_t index = 0; index < indices.size(); index += 3)
-		{
-			Vertex& v0 = vertices[indices[(size_t)index + 0]];
-			Vertex& v1 = vertices[indices[(size_t)index + 1]];
-			Vertex& v2 = vertices[indices[(size_t)index + 2]];
-
-			v0.calculateTangent(v1, v2);
-			v1.calculateTangent(v2, v0);
-			v2.calculateTangent(v0, v1);
-		}
+	glm::mat4 transform = glm::scale(glm::mat4(1.0f), glm::vec3(0.005f));
+	for (uint32_t s = 0; s < shapeCount; s++)
+	{
+		const MeshCacheShape& shape = meshCache.getShape(s);
 
 		MeshVK* pMesh = reinterpret_cast<MeshVK*>(m_pContext->createMesh());
-		pMesh->initFromMemory(vertices.data(), sizeof(Vertex), uint32_t(vertices.size()), indices.data(), uint32_t(indices.size()));
-		m_SceneMeshes[s]  = pMesh;
+		pMesh->initBuffers(vertexStride, shape.VertexCount, shape.IndexCount, m_VertexFormat);
+		pMesh->setLODs(shape.LODs, shape.LODCount);
+		pMesh->setBounds(shape.BoundsMin, shape.BoundsMax, shape.BoundingRadius);
+		pMesh->setMeshlets(meshCache.getMeshlets() + shape.FirstMeshlet, shape.MeshletCount, meshCache.getIndices() + shape.FirstIndex);
+
+		const void* pVertices = (m_VertexFormat == EVertexFormat::PACKED) ? (const void*)(packedVertices.data() + shape.FirstVertex) : (const void*)(meshCache.getVertices() + shape.FirstVertex);
+		pMesh->getBufferUpdates(bufferUpdates[2 * (size_t)s + 0], bufferUpdates[2 * (size_t)s + 1], pVertices, meshCache.getIndices() + shape.FirstIndex);
+		m_SceneMeshes[s] = pMesh;
 
-		uint32_t materialIndex = shape.mesh.material_ids[0] + 1;
+		uint32_t materialIndex = uint32_t(shape.MaterialID + 1);
 		Material* pMaterial = m_SceneMaterials[materialIndex];
 
 		submitGraphicsObject(pMesh, pMaterial, transform);
 	}
 
+	m_pDevice->getCopyHandler()->updateBuffers(bufferUpdates.data(), uint32_t(bufferUpdates.size()));
+
+	//Every vertex that the geometry and shadow passes transform is fetched with the stride, so the bandwidth scales with it as well
+	const uint32_t vertexCount = meshCache.getVertexCount();
+	LOG("-- SceneVK: %u vertices in the %s vertex format use %.2f MB, %u bytes per vertex fetch (%.2f MB and %u bytes in the standard format)",
+		vertexCount, VertexPacker::getName(m_VertexFormat), double(vertexCount) * vertexStride / double(MB(1)), vertexStride,
+		double(vertexCount) * sizeof(Vertex) / double(MB(1)), uint32_t(sizeof(Vertex)));
+
 	return true;
 }
 
-bool SceneVK::init()
+bool SceneVK::init(EVertexFormat vertexFormat)
 {
+	m_VertexFormat = vertexFormat;
+
 	if (!createGeometryPipelineLayout()) {
 		LOG("--- SceneVK: Failed to create geometry pipeline layout");
 		return false;
@@ -374,6 +366,13 @@ bool SceneVK::init()
 	createProfiler();
 	initBuffers();
 
+	m_pTextureLoader = DBG_NEW TextureLoaderVK(m_pDevice);
+	if (!m_pTextureLoader->init(TEXTURE_LOADER_STAGING_SIZE))
+	{
+		LOG("--- SceneVK: Failed to create texture loader");
+		return false;
+	}
+
 	return true;
 }
 
@@ -426,12 +425,17 @@ bool SceneVK::finalize()
 	updateMaterials();
 	updateTransformBuffer();
 
+	//The objects of the scene have all been submitted one at a time, so the tree is built again from all of them at once
+	m_ObjectTree.rebuild();
+
 	LOG("--- SceneVK: Successfully initialized Acceleration Table!");
 	return true;
 }
 
 void SceneVK::updateMeshesAndGraphicsObjects()
 {
+	selectLODs();
+
 	if (m_RayTracingEnabled)
 	{
 		if (!m_BottomLevelIsDirty)
@@ -449,6 +453,44 @@ void SceneVK::updateMeshesAndGraphicsObjects()
 	updateTransformBuffer();
 }
 
+static uint32_t applyLODBias(uint32_t lod, int32_t bias, uint32_t lodCount)
+{
+	return uint32_t(std::clamp(int32_t(lod) + bias, 0, int32_t(lodCount) - 1));
+}
+
+void SceneVK::selectLODs()
+{
+	//The projection scales a size at a distance of one to a size relative to half the height of the screen
+	const float projectionScale		= std::abs(m_Camera.getProjectionMat()[1][1]);
+	const glm::vec3& cameraPosition	= m_Camera.getPosition();
+
+	for (uint32_t i = 0; i < m_GraphicsObjects.size(); i++)
+	{
+		GraphicsObjectVK& graphicsObject	= m_GraphicsObjects[i];
+		const MeshVK* pMesh					= graphicsObject.pMesh;
+		const glm::mat4& transform			= m_SceneTransforms[i].Transform;
+
+		//Bounding sphere of the mesh in world space. The simplifier measures errors against half the diagonal of the bounds, not the tighter culling radius
+		const glm::vec3 center	= m_ObjectCuller.getCenter(i);
+		const float scale		= std::sqrt(std::max(glm::dot(transform[0], transform[0]), std::max(glm::dot(transform[1], transform[1]), glm::dot(transform[2], transform[2]))));
+		const float radius		= 0.5f * glm::length(pMesh->getBoundsMax() - pMesh->getBoundsMin()) * scale;
+
+		//Objects that contain the camera are drawn at full detail
+		const float distance	= glm::length(center - cameraPosition);
+		const float screenSize	= (distance > radius) ? (radius * projectionScale / distance) : std::numeric_limits<float>::max();
+
+		//The errors of the levels are relative to the radius, the coarsest level that stays below the screen error is picked
+		uint32_t lod = 0;
+		while (lod + 1 < pMesh->getLODCount() && pMesh->getLOD(lod + 1).Error * screenSize <= LOD_MAX_SCREEN_ERROR)
+		{
+			lod++;
+		}
+
+		graphicsObject.LOD			= applyLODBias(lod, m_LODBias, pMesh->getLODCount());
+		graphicsObject.ShadowLOD	= applyLODBias(lod, m_ShadowLODBias, pMesh->getLODCount());
+	}
+}
+
 void SceneVK::updateMaterials()
 {
 	if (m_RayTracingEnabled)
@@ -459,18 +501,18 @@ void SceneVK::updateMaterials()
 			{
 				const Material* pMaterial = m_Materials[i];
 
-				const Texture2DVK* pAlbedoMap = reinterpret_cast<const Texture2DVK*>(pMaterial->getAlbedoMap());
-				const Texture2DVK* pNormalMap = reinterpret_cast<const Texture2DVK*>(pMaterial->getNormalMap());
-				const Texture2DVK* pAOMap = reinterpret_cast<const Texture2DVK*>(pMaterial->getAmbientOcclusionMap());
-				const Texture2DVK* pMetallicMap = reinterpret_cast<const Texture2DVK*>(pMaterial->getMetallicMap());
-				const Texture2DVK* pRoughnessMap = reinterpret_cast<const Texture2DVK*>(pMaterial->getRoughnessMap());
+				const Texture2DVK* pAlbedoMap = getResidentTexture(pMaterial->getAlbedoMap(), m_pDefaultTexture);
+				const Texture2DVK* pNormalMap = getResidentTexture(pMaterial->getNormalMap(), m_pDefaultNormal);
+				const Texture2DVK* pAOMap = getResidentTexture(pMaterial->getAmbientOcclusionMap(), m_pDefaultTexture);
+				const Texture2DVK* pMetallicMap = getResidentTexture(pMaterial->getMetallicMap(), m_pDefaultTexture);
+				const Texture2DVK* pRoughnessMap = getResidentTexture(pMaterial->getRoughnessMap(), m_pDefaultTexture);
 				const SamplerVK* pSampler = reinterpret_cast<const SamplerVK*>(pMaterial->getSampler());
 
-				m_AlbedoMaps[i] = pAlbedoMap != nullptr ? pAlbedoMap->getImageView() : m_pDefaultTexture->getImageView();
-				m_NormalMaps[i] = pNormalMap != nullptr ? pNormalMap->getImageView() : m_pDefaultNormal->getImageView();
-				m_AOMaps[i] = pAOMap != nullptr ? pAOMap->getImageView() : m_pDefaultTexture->getImageView();
-				m_MetallicMaps[i] = pMetallicMap != nullptr ? pMetallicMap->getImageView() : m_pDefaultTexture->getImageView();
-				m_RoughnessMaps[i] = pRoughnessMap != nullptr ? pRoughnessMap->getImageView() : m_pDefaultTexture->getImageView();
+				m_AlbedoMaps[i] = pAlbedoMap->getImageView();
+				m_NormalMaps[i] = pNormalMap->getImageView();
+				m_AOMaps[i] = pAOMap->getImageView();
+				m_MetallicMaps[i] = pMetallicMap->getImageView();
+				m_RoughnessMaps[i] = pRoughnessMap->getImageView();
 				m_Samplers[i] = pSampler != nullptr ? pSampler : m_pDefaultSampler;
 				m_MaterialParameters[i] =
 				{
@@ -553,6 +595,12 @@ void SceneVK::updateCamera(const Camera& camera)
 uint32_t SceneVK::submitGraphicsObject(const IMesh* pMesh, const Material* pMaterial, const glm::mat4& transform, uint8_t customMask)
 {
 	const MeshVK* pVulkanMesh = reinterpret_cast<const MeshVK*>(pMesh);
+	if (pVulkanMesh != nullptr && pVulkanMesh->getVertexFormat() != m_VertexFormat)
+	{
+		LOG("--- SceneVK: submitGraphicsObject failed, the mesh uses the %s vertex format but the scene uses the %s vertex format",
+			VertexPacker::getName(pVulkanMesh->getVertexFormat()), VertexPacker::getName(m_VertexFormat));
+		return UINT32_MAX;
+	}
 
 	uint32_t materialIndex = 0;
 
@@ -583,8 +631,8 @@ uint32_t SceneVK::submitGraphicsObject(const IMesh* pMesh, const Material* pMate
 
 				pBottomLevelAccelerationStructure = createBLAS(pVulkanMesh, pMaterial);
 				m_AllMeshes.push_back(pVulkanMesh);
-				m_TotalNumberOfVertices += static_cast<uint32_t>(pVulkanMesh->getVertexBuffer()->getSizeInBytes() / sizeof(Vertex));
-				m_TotalNumberOfIndices += static_cast<uint32_t>(pVulkanMesh->getIndexBuffer()->getSizeInBytes() / sizeof(uint32_t));
+				m_TotalNumberOfVertices += pVulkanMesh->getVertexCount();
+				m_TotalNumberOfIndices += pVulkanMesh->getIndexCount();
 			}
 			else if (finalizedBLASPerMesh->second.find(pMaterial) == finalizedBLASPerMesh->second.end())
 			{
@@ -651,6 +699,8 @@ uint32_t SceneVK::submitGraphicsObject(const IMesh* pMesh, const Material* pMate
 
 	m_GraphicsObjects.push_back({ pVulkanMesh, pMaterial, materialIndex });
 	m_SceneTransforms.push_back({ transform, transform });
+	const uint32_t index = m_ObjectCuller.addObject(pVulkanMesh->getBoundsMin(), pVulkanMesh->getBoundsMax(), pVulkanMesh->getBoundingRadius(), transform);
+	m_ObjectLeaves.push_back(m_ObjectTree.insert(index, m_ObjectCuller.getBoundsMin(index), m_ObjectCuller.getBoundsMax(index)));
 
 	return uint32_t(m_GraphicsObjects.size()) - 1u;
 }
@@ -665,6 +715,27 @@ void SceneVK::updateGraphicsObjectTransform(uint32_t index, const glm::mat4& tra
 	GraphicsObjectTransforms& transforms = m_SceneTransforms[index];
 	transforms.PrevTransform	= transforms.Transform;
 	transforms.Transform		= transform;
+
+	const MeshVK* pMesh = m_GraphicsObjects[index].pMesh;
+	m_ObjectCuller.updateObject(index, pMesh->getBoundsMin(), pMesh->getBoundsMax(), pMesh->getBoundingRadius(), transform);
+	m_ObjectTree.move(m_ObjectLeaves[index], m_ObjectCuller.getBoundsMin(index), m_ObjectCuller.getBoundsMax(index));
+}
+
+void SceneVK::cullGraphicsObjects(const Frustum& frustum, std::vector<uint32_t>& objects) const
+{
+	if (m_ObjectCuller.getObjectCount() >= BVH_CULLING_MIN_OBJECT_COUNT)
+	{
+		m_ObjectTree.queryFrustum(frustum, objects);
+	}
+	else
+	{
+		m_ObjectCuller.cull(frustum, objects);
+	}
+}
+
+void SceneVK::queryGraphicsObjectsInSphere(const glm::vec3& center, float radius, std::vector<uint32_t>& objects) const
+{
+	m_ObjectTree.querySphere(center, radius, objects);
 }
 
 void SceneVK::copySceneData(CommandBufferVK* pTransferBuffer)
@@ -697,7 +768,8 @@ void SceneVK::copySceneData(CommandBufferVK* pTransferBuffer)
 			uint32_t numVertices = pMesh->getVertexCount();
 			uint32_t numIndices = pMesh->getIndexCount();
 
-			pTransferBuffer->copyBuffer(reinterpret_cast<BufferVK*>(pMesh->getVertexBuffer()), 0, m_pCombinedVertexBuffer, vertexBufferOffset * sizeof(Vertex), numVertices * sizeof(Vertex));
+			const VkDeviceSize vertexStride = VertexPacker::getStride(m_VertexFormat);
+			pTransferBuffer->copyBuffer(reinterpret_cast<BufferVK*>(pMesh->getVertexBuffer()), 0, m_pCombinedVertexBuffer, vertexBufferOffset * vertexStride, numVertices * vertexStride);
 			pTransferBuffer->copyBuffer(reinterpret_cast<BufferVK*>(pMesh->getIndexBuffer()), 0, m_pCombinedIndexBuffer, indexBufferOffset * sizeof(uint32_t), numIndices * sizeof(uint32_t));
 
 			for (auto& bottomLevelAccelerationStructure : m_FinalizedBottomLevelAccelerationStructures[pMesh])
@@ -729,7 +801,15 @@ void SceneVK::copySceneData(CommandBufferVK* pTransferBuffer)
 
 bool SceneVK::updateSceneData()
 {
-	if (m_pGarbageTransformsBufferGraphics || m_MaterialDataIsDirty)
+	m_FrameCounter++;
+	releaseRetiredDescriptorSets();
+
+	std::unordered_set<const ITexture2D*> residentTextures;
+	updateStreamedTextures(residentTextures);
+
+	//The ray tracer binds the combined image arrays of every material, those can only be rewritten while the device is idle
+	const bool rayTracingTexturesChanged = m_RayTracingEnabled && !residentTextures.empty();
+	if (m_pGarbageTransformsBufferGraphics || m_pGarbageInstanceIndicesBuffer || m_MaterialDataIsDirty || rayTracingTexturesChanged)
 	{
 		m_pDevice->wait();
 
@@ -737,6 +817,13 @@ bool SceneVK::updateSceneData()
 		{
 			instance.second.pDescriptorSets->writeStorageBufferDescriptor(m_pMaterialParametersBuffer, MATERIAL_PARAMETERS_BINDING);
 			instance.second.pDescriptorSets->writeStorageBufferDescriptor(m_pTransformsBufferGraphics, INSTANCE_TRANSFORMS_BINDING);
+			instance.second.pDescriptorSets->writeStorageBufferDescriptor(m_pInstanceIndicesBuffer, INSTANCE_INDICES_BINDING);
+
+			//Swap the placeholders for the textures that have finished loading
+			if (!residentTextures.empty())
+			{
+				writeMaterialDescriptors(instance.second.pDescriptorSets, instance.first.pMaterial);
+			}
 		}
 
 		cleanGarbage();
@@ -744,6 +831,11 @@ bool SceneVK::updateSceneData()
 		return true;
 	}
 
+	if (!residentTextures.empty())
+	{
+		replaceMaterialDescriptorSets(residentTextures);
+	}
+
 	return false;
 }
 
@@ -755,71 +847,159 @@ DescriptorSetVK* SceneVK::getDescriptorSetFromMeshAndMaterial(const MeshVK* pMes
 
 	if (m_MeshTable.count(filter) == 0)
 	{
-		DescriptorSetVK* pDescriptorSet = m_pDescriptorPool->allocDescriptorSet(m_pGeometryDescriptorSetLayout);
-		pDescriptorSet->writeUniformBufferDescriptor(m_pCameraBuffer, CAMERA_BUFFER_BINDING);
+		MeshPipeline meshPipeline = {};
+		meshPipeline.pDescriptorSets = createMeshDescriptorSet(pMesh, pMaterial);
 
-		BufferVK* pVertBuffer = reinterpret_cast<BufferVK*>(pMesh->getVertexBuffer());
-		pDescriptorSet->writeStorageBufferDescriptor(pVertBuffer, VERTEX_BUFFER_BINDING);
+		m_MeshTable.insert(std::make_pair(filter, meshPipeline));
+		return meshPipeline.pDescriptorSets;
+	}
 
-		SamplerVK* pSampler = reinterpret_cast<SamplerVK*>(pMaterial->getSampler());
+	MeshPipeline meshPipeline = m_MeshTable[filter];
+	return meshPipeline.pDescriptorSets;
+}
 
-		Texture2DVK* pAlbedo = m_pDefaultTexture;
-		if (pMaterial->hasAlbedoMap())
-		{
-			pAlbedo = reinterpret_cast<Texture2DVK*>(pMaterial->getAlbedoMap());
-		}
+DescriptorSetVK* SceneVK::createMeshDescriptorSet(const MeshVK* pMesh, const Material* pMaterial)
+{
+	DescriptorSetVK* pDescriptorSet = m_pDescriptorPool->allocDescriptorSet(m_pGeometryDescriptorSetLayout);
+	pDescriptorSet->writeUniformBufferDescriptor(m_pCameraBuffer, CAMERA_BUFFER_BINDING);
 
-		ImageViewVK* pAlbedoView = pAlbedo->getImageView();
-		pDescriptorSet->writeCombinedImageDescriptors(&pAlbedoView, &pSampler, 1, ALBEDO_MAP_BINDING);
+	BufferVK* pVertBuffer = reinterpret_cast<BufferVK*>(pMesh->getVertexBuffer());
+	pDescriptorSet->writeStorageBufferDescriptor(pVertBuffer, VERTEX_BUFFER_BINDING);
 
-		Texture2DVK* pNormal = m_pDefaultNormal;
-		if (pMaterial->hasNormalMap())
-		{
-			pNormal = reinterpret_cast<Texture2DVK*>(pMaterial->getNormalMap());
-		}
+	writeMaterialDescriptors(pDescriptorSet, pMaterial);
 
-		ImageViewVK* pNormalView = pNormal->getImageView();
-		pDescriptorSet->writeCombinedImageDescriptors(&pNormalView, &pSampler, 1, NORMAL_MAP_BINDING);
+	pDescriptorSet->writeStorageBufferDescriptor(m_pMaterialParametersBuffer, MATERIAL_PARAMETERS_BINDING);
+	pDescriptorSet->writeStorageBufferDescriptor(m_pTransformsBufferGraphics, INSTANCE_TRANSFORMS_BINDING);
+	pDescriptorSet->writeStorageBufferDescriptor(m_pInstanceIndicesBuffer, INSTANCE_INDICES_BINDING);
+	return pDescriptorSet;
+}
 
-		Texture2DVK* pAO = m_pDefaultTexture;
-		if (pMaterial->hasAmbientOcclusionMap())
+void SceneVK::replaceMaterialDescriptorSets(const std::unordered_set<const ITexture2D*>& residentTextures)
+{
+	for (auto& instance : m_MeshTable)
+	{
+		const Material* pMaterial = instance.first.pMaterial;
+		const bool usesResidentTexture =
+			residentTextures.count(pMaterial->getAlbedoMap()) > 0			||
+			residentTextures.count(pMaterial->getNormalMap()) > 0			||
+			residentTextures.count(pMaterial->getAmbientOcclusionMap()) > 0	||
+			residentTextures.count(pMaterial->getMetallicMap()) > 0			||
+			residentTextures.count(pMaterial->getRoughnessMap()) > 0;
+
+		if (usesResidentTexture)
 		{
-			pAO = reinterpret_cast<Texture2DVK*>(pMaterial->getAmbientOcclusionMap());
+			m_RetiredDescriptorSets.push_back({ instance.second.pDescriptorSets, m_FrameCounter });
+			instance.second.pDescriptorSets = createMeshDescriptorSet(instance.first.pMesh, pMaterial);
 		}
+	}
+}
 
-		ImageViewVK* pAOView = pAO->getImageView();
-		pDescriptorSet->writeCombinedImageDescriptors(&pAOView, &pSampler, 1, AO_MAP_BINDING);
-
-		Texture2DVK* pMetallic = m_pDefaultTexture;
-		if (pMaterial->hasMetallicMap())
+void SceneVK::releaseRetiredDescriptorSets()
+{
+	//The frame that rendered last before a set was retired has finished once as many frames as can be in flight have begun after it
+	auto firstInUse = std::remove_if(m_RetiredDescriptorSets.begin(), m_RetiredDescriptorSets.end(), [this](const RetiredDescriptorSet& retiredSet)
 		{
-			pMetallic = reinterpret_cast<Texture2DVK*>(pMaterial->getMetallicMap());
-		}
+			if (m_FrameCounter - retiredSet.Frame < MAX_FRAMES_IN_FLIGHT)
+			{
+				return false;
+			}
+
+			m_pDescriptorPool->deallocateDescriptorSet(retiredSet.pDescriptorSet);
+			return true;
+		});
+
+	m_RetiredDescriptorSets.erase(firstInUse, m_RetiredDescriptorSets.end());
+}
+
+void SceneVK::writeMaterialDescriptors(DescriptorSetVK* pDescriptorSet, const Material* pMaterial)
+{
+	SamplerVK* pSampler = reinterpret_cast<SamplerVK*>(pMaterial->getSampler());
+
+	ImageViewVK* pAlbedoView = getResidentTexture(pMaterial->getAlbedoMap(), m_pDefaultTexture)->getImageView();
+	pDescriptorSet->writeCombinedImageDescriptors(&pAlbedoView, &pSampler, 1, ALBEDO_MAP_BINDING);
+
+	ImageViewVK* pNormalView = getResidentTexture(pMaterial->getNormalMap(), m_pDefaultNormal)->getImageView();
+	pDescriptorSet->writeCombinedImageDescriptors(&pNormalView, &pSampler, 1, NORMAL_MAP_BINDING);
+
+	ImageViewVK* pAOView = getResidentTexture(pMaterial->getAmbientOcclusionMap(), m_pDefaultTexture)->getImageView();
+	pDescriptorSet->writeCombinedImageDescriptors(&pAOView, &pSampler, 1, AO_MAP_BINDING);
+
+	ImageViewVK* pMetallicView = getResidentTexture(pMaterial->getMetallicMap(), m_pDefaultTexture)->getImageView();
+	pDescriptorSet->writeCombinedImageDescriptors(&pMetallicView, &pSampler, 1, METALLIC_MAP_BINDING);
 
-		ImageViewVK* pMetallicView = pMetallic->getImageView();
-		pDescriptorSet->writeCombinedImageDescriptors(&pMetallicView, &pSampler, 1, METALLIC_MAP_BINDING);
+	ImageViewVK* pRoughnessView = getResidentTexture(pMaterial->getRoughnessMap(), m_pDefaultTexture)->getImageView();
+	pDescriptorSet->writeCombinedImageDescriptors(&pRoughnessView, &pSampler, 1, ROUGHNESS_MAP_BINDING);
+}
+
+Texture2DVK* SceneVK::getResidentTexture(ITexture2D* pTexture, Texture2DVK* pDefault)
+{
+	if (pTexture == nullptr)
+	{
+		return pDefault;
+	}
 
-		Texture2DVK* pRoughness = m_pDefaultTexture;
-		if (pMaterial->hasRoughnessMap())
+	std::scoped_lock<Spinlock> lock(m_StreamingLock);
+	return (m_StreamingTextures.count(pTexture) == 0) ? reinterpret_cast<Texture2DVK*>(pTexture) : pDefault;
+}
+
+void SceneVK::streamTexture(ITexture2D* pTexture, const std::string& filename, ETextureFormat format, ETextureCompression compression)
+{
+	{
+		std::scoped_lock<Spinlock> lock(m_StreamingLock);
+		if (m_StreamingTextures.size() == m_FailedTextureCount)
 		{
-			pRoughness = reinterpret_cast<Texture2DVK*>(pMaterial->getRoughnessMap());
+			m_StreamingStartTime = std::chrono::high_resolution_clock::now();
 		}
 
-		ImageViewVK* pRoughnessView = pRoughness->getImageView();
-		pDescriptorSet->writeCombinedImageDescriptors(&pRoughnessView, &pSampler, 1, ROUGHNESS_MAP_BINDING);
+		m_StreamingTextures.insert(pTexture);
+		m_StreamedTextureCount++;
+	}
 
-		pDescriptorSet->writeStorageBufferDescriptor(m_pMaterialParametersBuffer, MATERIAL_PARAMETERS_BINDING);
-		pDescriptorSet->writeStorageBufferDescriptor(m_pTransformsBufferGraphics, INSTANCE_TRANSFORMS_BINDING);
+	m_pTextureLoader->load(reinterpret_cast<Texture2DVK*>(pTexture), filename, format, true, compression);
+}
 
-		MeshPipeline meshPipeline = {};
-		meshPipeline.pDescriptorSets = pDescriptorSet;
+void SceneVK::updateStreamedTextures(std::unordered_set<const ITexture2D*>& residentTextures)
+{
+	std::vector<StreamedTextureVK> completedTextures;
+	m_pTextureLoader->update(completedTextures);
+	if (completedTextures.empty())
+	{
+		return;
+	}
 
-		m_MeshTable.insert(std::make_pair(filter, meshPipeline));
-		return pDescriptorSet;
+	bool isFinished = false;
+	{
+		std::scoped_lock<Spinlock> lock(m_StreamingLock);
+		for (const StreamedTextureVK& texture : completedTextures)
+		{
+			//Textures that failed to load keep their placeholder
+			if (texture.IsLoaded)
+			{
+				m_StreamingTextures.erase(texture.pTexture);
+				residentTextures.insert(texture.pTexture);
+				m_LoadedTextureCount++;
+			}
+			else
+			{
+				m_FailedTextureCount++;
+			}
+		}
+
+		isFinished = (m_StreamingTextures.size() == m_FailedTextureCount);
 	}
 
-	MeshPipeline meshPipeline = m_MeshTable[filter];
-	return meshPipeline.pDescriptorSets;
+	if (isFinished)
+	{
+		std::chrono::duration<double, std::milli> streamingTime = std::chrono::high_resolution_clock::now() - m_StreamingStartTime;
+		LOG("--- SceneVK: Streamed %u textures in %.2f ms, %u failed to load", m_LoadedTextureCount, streamingTime.count(), m_FailedTextureCount);
+		TextureCache::logVRAMReport();
+	}
+
+	//Ray tracing reads the textures of every material through the combined image arrays
+	if (m_RayTracingEnabled)
+	{
+		updateMaterials();
+	}
 }
 
 bool SceneVK::createDefaultTexturesAndSamplers()
@@ -884,19 +1064,41 @@ void SceneVK::initBuffers()
 
 	m_pTransformsBufferCompute = reinterpret_cast<BufferVK*>(m_pContext->createBuffer());
 	m_pTransformsBufferCompute->init(transformBufferParams);
+
+	createInstanceIndexBuffer(NUM_INITIAL_GRAPHICS_OBJECTS);
+}
+
+void SceneVK::createInstanceIndexBuffer(uint32_t objectCount)
+{
+	BufferParams instanceIndicesBufferParams = {};
+	instanceIndicesBufferParams.Usage			= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+	instanceIndicesBufferParams.MemoryProperty	= VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+	instanceIndicesBufferParams.SizeInBytes		= sizeof(uint32_t) * objectCount * INSTANCE_INDICES_PASS_COUNT * MAX_FRAMES_IN_FLIGHT;
+	instanceIndicesBufferParams.IsExclusive		= true;
+
+	m_pInstanceIndicesBuffer = reinterpret_cast<BufferVK*>(m_pContext->createBuffer());
+	m_pInstanceIndicesBuffer->init(instanceIndicesBufferParams);
+
+	void* pMappedIndices = nullptr;
+	m_pInstanceIndicesBuffer->map(&pMappedIndices);
+
+	m_pMappedInstanceIndices	= reinterpret_cast<uint32_t*>(pMappedIndices);
+	m_InstanceIndexCapacity		= objectCount;
 }
 
 bool SceneVK::createGeometryPipelineLayout()
 {
-	//Descriptorpool
+	//Descriptorpool, a streamed material can have a new set every frame while its old sets are retired, so there is room for one set per frame in flight on top
+	constexpr uint32_t setsPerMaterial = MAX_FRAMES_IN_FLIGHT + 1;
+
 	DescriptorCounts descriptorCounts = {};
-	descriptorCounts.m_SampledImages	= 4096;
+	descriptorCounts.m_SampledImages	= 4096 * setsPerMaterial;
 	descriptorCounts.m_StorageImages	= 1024;
-	descriptorCounts.m_StorageBuffers	= 2048;
-	descriptorCounts.m_UniformBuffers	= 1024;
+	descriptorCounts.m_StorageBuffers	= 2048 * setsPerMaterial;
+	descriptorCounts.m_UniformBuffers	= 1024 * setsPerMaterial;
 
 	m_pDescriptorPool = DBG_NEW DescriptorPoolVK(m_pContext->getDevice());
-	if (!m_pDescriptorPool->init(descriptorCounts, 512))
+	if (!m_pDescriptorPool->init(descriptorCounts, 512 * setsPerMaterial))
 	{
 		return false;
 	}
@@ -912,6 +1114,7 @@ bool SceneVK::createGeometryPipelineLayout()
 	m_pGeometryDescriptorSetLayout->addBindingCombinedImage(VK_SHADER_STAGE_FRAGMENT_BIT, nullptr, ROUGHNESS_MAP_BINDING, 1);
 	m_pGeometryDescriptorSetLayout->addBindingStorageBuffer(VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, MATERIAL_PARAMETERS_BINDING, 1);
 	m_pGeometryDescriptorSetLayout->addBindingStorageBuffer(VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, INSTANCE_TRANSFORMS_BINDING, 1);
+	m_pGeometryDescriptorSetLayout->addBindingStorageBuffer(VK_SHADER_STAGE_VERTEX_BIT, INSTANCE_INDICES_BINDING, 1);
 
 	if (!m_pGeometryDescriptorSetLayout->finalize())
 	{
@@ -975,7 +1178,8 @@ SceneVK::BottomLevelAccelerationStructure* SceneVK::createBLAS(const MeshVK* pMe
 	bottomLevelAccelerationStructure.Geometry.geometry.triangles.vertexData = ((BufferVK*)pMesh->getVertexBuffer())->getBuffer();
 	bottomLevelAccelerationStructure.Geometry.geometry.triangles.vertexOffset = 0;
 	bottomLevelAccelerationStructure.Geometry.geometry.triangles.vertexCount = pMesh->getVertexCount();
-	bottomLevelAccelerationStructure.Geometry.geometry.triangles.vertexStride = sizeof(Vertex);
+	//Both vertex formats start with a float position
+	bottomLevelAccelerationStructure.Geometry.geometry.triangles.vertexStride = VertexPacker::getStride(m_VertexFormat);
 	bottomLevelAccelerationStructure.Geometry.geometry.triangles.vertexFormat = VK_FORMAT_R32G32B32_SFLOAT;
 	bottomLevelAccelerationStructure.Geometry.geometry.triangles.indexData = ((BufferVK*)pMesh->getIndexBuffer())->getBuffer();
 	bottomLevelAccelerationStructure.Geometry.geometry.triangles.indexOffset = 0;
@@ -1302,6 +1506,7 @@ void SceneVK::cleanGarbage()
 
 	SAFEDELETE(m_pGarbageTransformsBufferGraphics);
 	SAFEDELETE(m_pGarbageTransformsBufferCompute);
+	SAFEDELETE(m_pGarbageInstanceIndicesBuffer);
 
 	if (m_OldTopLevelAccelerationStructure.Memory != VK_NULL_HANDLE)
 	{
@@ -1400,6 +1605,23 @@ void SceneVK::updateTransformBuffer()
 		m_pTransformsBufferCompute->init(transformBufferParams);
 	}
 
+	//The old buffer is still read by the frames in flight, it is deleted once the descriptors have been moved to the new one.
+	//A buffer that replaced it before that has never been bound, so it can go right away
+	const uint32_t objectCount = uint32_t(m_SceneTransforms.size());
+	if (m_InstanceIndexCapacity < objectCount)
+	{
+		if (m_pGarbageInstanceIndicesBuffer == nullptr)
+		{
+			m_pGarbageInstanceIndicesBuffer = m_pInstanceIndicesBuffer;
+		}
+		else
+		{
+			SAFEDELETE(m_pInstanceIndicesBuffer);
+		}
+
+		createInstanceIndexBuffer(objectCount);
+	}
+
 	m_TransformDataIsDirty = true;
 }
 
@@ -1421,7 +1643,7 @@ bool SceneVK::createCombinedGraphicsObjectData()
 
 	BufferParams vertexBufferParams = {};
 	vertexBufferParams.Usage			= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
-	vertexBufferParams.SizeInBytes		= sizeof(Vertex) * m_TotalNumberOfVertices;
+	vertexBufferParams.SizeInBytes		= VkDeviceSize(VertexPacker::getStride(m_VertexFormat)) * m_TotalNumberOfVertices;
 	vertexBufferParams.MemoryProperty	= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 	vertexBufferParams.IsExclusive		= true;
 
@@ -1504,6 +1726,40 @@ void SceneVK::renderUI()
 		m_DebugParametersDirty = m_DebugParametersDirty || ImGui::SliderFloat("Roughness Scale", &m_SceneParameters.RoughnessScale, 0.01f, 10.0f);
 		m_DebugParametersDirty = m_DebugParametersDirty || ImGui::SliderFloat("Metallic Scale", &m_SceneParameters.MetallicScale, 0.01f, 10.0f);
 		m_DebugParametersDirty = m_DebugParametersDirty || ImGui::SliderFloat("Ambient Occlusion Scale", &m_SceneParameters.AOScale, 0.01f, 1.0f);
+
+		uint32_t streamedTextureCount = 0;
+		{
+			std::scoped_lock<Spinlock> lock(m_StreamingLock);
+			streamedTextureCount = m_StreamedTextureCount;
+		}
+
+		const uint32_t completedTextureCount = m_LoadedTextureCount + m_FailedTextureCount;
+		const float progress = (streamedTextureCount > 0) ? float(completedTextureCount) / float(streamedTextureCount) : 1.0f;
+
+		char progressText[64];
+		snprintf(progressText, sizeof(progressText), "%u/%u textures", completedTextureCount, streamedTextureCount);
+		ImGui::Text("Streaming:");
+		ImGui::ProgressBar(progress, ImVec2(-1.0f, 0.0f), progressText);
+		if (m_FailedTextureCount > 0)
+		{
+			ImGui::Text("%u textures failed to load", m_FailedTextureCount);
+		}
+
+		ImGui::SliderInt("LOD Bias", &m_LODBias, -int32_t(MESH_MAX_LOD_COUNT - 1), int32_t(MESH_MAX_LOD_COUNT - 1));
+		ImGui::SliderInt("Shadow LOD Bias", &m_ShadowLODBias, -int32_t(MESH_MAX_LOD_COUNT - 1), int32_t(MESH_MAX_LOD_COUNT - 1));
+		ImGui::Checkbox("Meshlet Culling", &m_IsMeshletCullingEnabled);
+		ImGui::Checkbox("GPU Culling", &m_IsGPUCullingEnabled);
+		ImGui::Checkbox("Occlusion Culling", &m_IsOcclusionCullingEnabled);
+
+		ImGui::Text("Object BVH: %u objects, height %u", m_ObjectTree.getLeafCount(), m_ObjectTree.getHeight());
+
+		std::vector<uint32_t> litObjects;
+		const PointLight* pPointLights = m_LightSetup.getPointLights();
+		for (uint32_t i = 0; i < m_LightSetup.getPointLightCount(); i++)
+		{
+			queryGraphicsObjectsInSphere(pPointLights[i].getPosition(), pPointLights[i].getInfluenceRadius(), litObjects);
+			ImGui::Text("Point light %u: %u objects within %.1f", i, uint32_t(litObjects.size()), pPointLights[i].getInfluenceRadius());
+		}
 	}
 	ImGui::End();
 }
@@ -1,14 +1,20 @@
 #pragma once
 #include "Common/IScene.h"
 
+#include "Core/DynamicBVH.h"
 #include "Core/Material.h"
+#include "Core/ObjectCuller.h"
 #include "Vulkan/MeshVK.h"
 #include "Vulkan/ProfilerVK.h"
 #include "Vulkan/Texture2DVK.h"
 #include "Vulkan/VulkanCommon.h"
 
+#include "Core/Spinlock.h"
+
 #include <vector>
 #include <map>
+#include <chrono>
+#include <unordered_set>
 
 class BufferVK;
 class DescriptorPoolVK;
@@ -24,6 +30,7 @@ class SamplerVK;
 class Texture2DVK;
 class CommandPoolVK;
 class CommandBufferVK;
+class TextureLoaderVK;
 
 //Geometry pass
 #define CAMERA_BUFFER_BINDING		0
@@ -35,14 +42,34 @@ class CommandBufferVK;
 #define ROUGHNESS_MAP_BINDING		6
 #define MATERIAL_PARAMETERS_BINDING	7
 #define INSTANCE_TRANSFORMS_BINDING	8
+#define INSTANCE_INDICES_BINDING	9
+
+//Every pass of every frame in flight writes the transform indices of its instanced draws into its own region of the instance index buffer
+#define INSTANCE_INDICES_PASS_GEOMETRY		0
+#define INSTANCE_INDICES_PASS_SHADOW		1
+//Objects that the GPU culler finds only after the occlusion test has been redone on the depth of the frame
+#define INSTANCE_INDICES_PASS_GEOMETRY_LATE	2
+#define INSTANCE_INDICES_PASS_COUNT			3
 
 constexpr uint32_t NUM_INITIAL_GRAPHICS_OBJECTS = 10;
 
+//Largest RMS error of a detail level on screen, relative to half the height of the screen. 0.002 is about a pixel at 1080p, the RMS error is held
+//to half of that since single points of the surface can move a few times further than the RMS error
+#define LOD_MAX_SCREEN_ERROR	0.001f
+//Shadow maps are drawn this many levels coarser than the camera by default
+#define LOD_SHADOW_BIAS			1
+
+//Scenes with at least this many objects are frustum culled with the BVH, below that testing every object with SSE is as fast (see --benchmark-bvh)
+#define BVH_CULLING_MIN_OBJECT_COUNT	10000U
+
 struct GraphicsObjectVK
 {
 	const MeshVK* pMesh = nullptr;
 	const Material* pMaterial = nullptr;
 	uint32_t MaterialParametersIndex = 0;
+	//Detail levels of the mesh that are drawn for the camera and the shadow map, picked every frame from the size of the object on screen
+	uint32_t LOD = 0;
+	uint32_t ShadowLOD = 0;
 };
 
 //Meshfilter is key, returns a meshpipeline -> gets descriptorset with correct vertexbuffer, textures, etc.
@@ -51,6 +78,13 @@ struct MeshPipeline
 	DescriptorSetVK* pDescriptorSets;
 };
 
+//A descriptor set that was replaced while frames in flight could still be bound to it
+struct RetiredDescriptorSet
+{
+	DescriptorSetVK* pDescriptorSet;
+	uint64_t Frame;
+};
+
 struct MeshFilter
 {
 	const MeshVK*	pMesh		= nullptr;
@@ -138,7 +172,7 @@ public:
 
 	virtual bool loadFromFile(const std::string& dir, const std::string& fileName) override;
 
-	virtual bool init() override;
+	virtual bool init(EVertexFormat vertexFormat) override;
 	virtual bool finalize() override;
 	virtual void updateMeshesAndGraphicsObjects() override;
 	virtual void updateMaterials() override;
@@ -148,6 +182,8 @@ public:
 	virtual uint32_t submitGraphicsObject(const IMesh* pMesh, const Material* pMaterial, const glm::mat4& transform = glm::mat4(1.0f), uint8_t customMask = 0x80) override;
 	virtual void updateGraphicsObjectTransform(uint32_t index, const glm::mat4& transform) override;
 
+	virtual void streamTexture(ITexture2D* pTexture, const std::string& filename, ETextureFormat format, ETextureCompression compression) override;
+
 	// Used for geometry rendering
 	void UpdateSceneData();
 	DescriptorSetVK* getDescriptorSetFromMeshAndMaterial(const MeshVK* pMesh, const Material* pMaterial);
@@ -161,6 +197,11 @@ public:
 	virtual void updateDebugParameters() override;
 
 	virtual LightSetup& getLightSetup() override { return m_LightSetup; }
+	virtual EVertexFormat getVertexFormat() const override { return m_VertexFormat; }
+
+	//The queries replace the contents of objects with the indices of the graphics objects whose world space boxes they hit
+	void cullGraphicsObjects(const Frustum& frustum, std::vector<uint32_t>& objects) const;
+	void queryGraphicsObjectsInSphere(const glm::vec3& center, float radius, std::vector<uint32_t>& objects) const;
 
 	// Used for geometry rendering
 	bool updateSceneData();
@@ -168,6 +209,12 @@ public:
 
 	const Camera&							getCamera() const					{ return m_Camera; }
 	const std::vector<GraphicsObjectVK>&	getGraphicsObjects() const			{ return m_GraphicsObjects; }
+	const glm::mat4&						getTransform(uint32_t index) const	{ return m_SceneTransforms[index].Transform; }
+	glm::vec3								getObjectCenter(uint32_t index) const	{ return m_ObjectCuller.getCenter(index); }
+	const ObjectCuller&						getObjectCuller() const				{ return m_ObjectCuller; }
+	bool									isMeshletCullingEnabled() const		{ return m_IsMeshletCullingEnabled; }
+	bool									isGPUCullingEnabled() const			{ return m_IsGPUCullingEnabled; }
+	bool									isOcclusionCullingEnabled() const	{ return m_IsOcclusionCullingEnabled; }
 	PipelineLayoutVK*						getGeometryPipelineLayout() const	{ return m_pGeometryPipelineLayout; }
 
 	FORCEINLINE BufferVK*	getCombinedVertexBuffer() { return m_pCombinedVertexBuffer; }
@@ -183,6 +230,10 @@ public:
 	FORCEINLINE const std::vector<const SamplerVK*>&	getSamplers() const					{ return m_Samplers; }
 	FORCEINLINE const BufferVK*							getMaterialParametersBuffer() const	{ return m_pMaterialParametersBuffer; }
 	FORCEINLINE const BufferVK*							getTransformsBuffer() const			{ return m_pTransformsBufferGraphics; }
+	FORCEINLINE const BufferVK*							getInstanceIndicesBuffer() const	{ return m_pInstanceIndicesBuffer; }
+	//A region holds one index per graphics object, the first instance of a draw is its offset from the start of the buffer
+	FORCEINLINE uint32_t*								getInstanceIndices(uint32_t frameIndex, uint32_t pass)		{ return m_pMappedInstanceIndices + getFirstInstance(frameIndex, pass); }
+	FORCEINLINE uint32_t								getFirstInstance(uint32_t frameIndex, uint32_t pass) const	{ return (frameIndex * INSTANCE_INDICES_PASS_COUNT + pass) * m_InstanceIndexCapacity; }
 	FORCEINLINE const TopLevelAccelerationStructure&	getTLAS() const						{ return m_TopLevelAccelerationStructure; }
 
 private:
@@ -191,6 +242,7 @@ private:
 	bool createCombinedGraphicsObjectData();
 
 	void initBuffers();
+	void createInstanceIndexBuffer(uint32_t objectCount);
 	void initAccelerationStructureBuffers();
 
 	BottomLevelAccelerationStructure* createBLAS(const MeshVK* pMesh, const Material* pMaterial);
@@ -213,6 +265,17 @@ private:
 
 	uint32_t registerMaterial(const Material* pMaterial);
 
+	DescriptorSetVK* createMeshDescriptorSet(const MeshVK* pMesh, const Material* pMaterial);
+	void writeMaterialDescriptors(DescriptorSetVK* pDescriptorSet, const Material* pMaterial);
+	//Gives the materials that sample any of the textures new descriptor sets, the old sets may still be bound by frames in flight so they are retired instead of written to
+	void replaceMaterialDescriptorSets(const std::unordered_set<const ITexture2D*>& residentTextures);
+	void releaseRetiredDescriptorSets();
+	//Returns pDefault while the texture is missing or still streaming
+	Texture2DVK* getResidentTexture(ITexture2D* pTexture, Texture2DVK* pDefault);
+	//Drains the textures that finished loading since the last frame, the ones that can be sampled now are added to residentTextures
+	void updateStreamedTextures(std::unordered_set<const ITexture2D*>& residentTextures);
+	void selectLODs();
+
 private:
 	SceneParameters m_SceneParameters;
 	Camera m_Camera;
@@ -237,6 +300,9 @@ private:
 	DescriptorPoolVK* m_pDescriptorPool;
 	PipelineLayoutVK* m_pGeometryPipelineLayout;
 	DescriptorSetLayoutVK* m_pGeometryDescriptorSetLayout;
+	//Freed once every frame that could have bound them has finished on the GPU
+	std::vector<RetiredDescriptorSet> m_RetiredDescriptorSets;
+	uint64_t m_FrameCounter;
 
 	std::vector<const MeshVK*> m_AllMeshes;
 	uint32_t m_TotalNumberOfVertices;
@@ -262,6 +328,15 @@ private:
 	std::vector<GraphicsObjectTransforms> m_SceneTransforms;
 	BufferVK* m_pTransformsBufferGraphics;
 	BufferVK* m_pTransformsBufferCompute;
+	//Host visible, written while the draws are recorded
+	BufferVK* m_pInstanceIndicesBuffer;
+	uint32_t* m_pMappedInstanceIndices;
+	uint32_t m_InstanceIndexCapacity;
+	//World space bounds of the graphics objects, in the same order as the objects
+	ObjectCuller m_ObjectCuller;
+	//The same bounds in a tree, and the leaf of every graphics object
+	DynamicBVH m_ObjectTree;
+	std::vector<uint32_t> m_ObjectLeaves;
 
 	TopLevelAccelerationStructure m_OldTopLevelAccelerationStructure;
 	TopLevelAccelerationStructure m_TopLevelAccelerationStructure;
@@ -276,11 +351,33 @@ private:
 	BufferVK* m_pGarbageInstanceBuffer;
 	BufferVK* m_pGarbageTransformsBufferGraphics;
 	BufferVK* m_pGarbageTransformsBufferCompute;
+	BufferVK* m_pGarbageInstanceIndicesBuffer;
 
 	Texture2DVK* m_pDefaultTexture;
 	Texture2DVK* m_pDefaultNormal;
 	SamplerVK* m_pDefaultSampler;
 
+	//Texture streaming, the lock guards the textures that are still loading and the number of streamed textures
+	TextureLoaderVK* m_pTextureLoader;
+	Spinlock m_StreamingLock;
+	std::unordered_set<const ITexture2D*> m_StreamingTextures;
+	std::chrono::high_resolution_clock::time_point m_StreamingStartTime;
+	uint32_t m_StreamedTextureCount;
+	uint32_t m_LoadedTextureCount;
+	uint32_t m_FailedTextureCount;
+
+	EVertexFormat m_VertexFormat;
+
+	//Added to the detail level picked for each object, positive values draw coarser levels
+	int32_t m_LODBias;
+	int32_t m_ShadowLODBias;
+
+	bool m_IsMeshletCullingEnabled;
+	//Large scenes cull and draw the geometry pass from the GPU
+	bool m_IsGPUCullingEnabled;
+	//Only used together with GPU culling
+	bool m_IsOcclusionCullingEnabled;
+
 	bool m_BottomLevelIsDirty;
 	bool m_TopLevelIsDirty;
 	bool m_TransformDataIsDirty;
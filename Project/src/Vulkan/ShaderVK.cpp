@@ -1,6 +1,8 @@
 #include "ShaderVK.h"
 #include "DeviceVK.h"
 
+#include "Core/AssetArchive.h"
+
 #include <fstream>
 
 ShaderVK::ShaderVK(DeviceVK* pDevice)
@@ -25,6 +27,16 @@ ShaderVK::~ShaderVK()
 
 bool ShaderVK::initFromFile(EShader shaderType, const std::string& entrypoint, const std::string& filepath)
 {
+	//The byte code is kept until finalize, so it is copied out of the archive
+	AssetView view;
+	if (AssetArchive::read(filepath, view))
+	{
+		const char* pByteCode = reinterpret_cast<const char*>(view.getData());
+
+		D_LOG("Loaded shaderfile from archive: %s - Entrypoint: %s", filepath.c_str(), entrypoint.c_str());
+		return initFromByteCode(shaderType, entrypoint, std::vector<char>(pByteCode, pByteCode + view.getSizeInBytes()));
+	}
+
 	std::ifstream shaderFile(filepath, std::ios::ate | std::ios::binary);
 	if (shaderFile.is_open())
 	{
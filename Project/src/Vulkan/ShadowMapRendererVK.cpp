@@ -13,6 +13,7 @@
 #include "Vulkan/GraphicsContextVK.h"
 #include "Vulkan/ImageViewVK.h"
 #include "Vulkan/MeshVK.h"
+#include "Vulkan/ParallelRecorderVK.h"
 #include "Vulkan/Particles/ParticleEmitterHandlerVK.h"
 #include "Vulkan/PipelineLayoutVK.h"
 #include "Vulkan/PipelineVK.h"
@@ -29,6 +30,9 @@ ShadowMapRendererVK::ShadowMapRendererVK(GraphicsContextVK* pGraphicsContext, Re
 	:m_pGraphicsContext(pGraphicsContext),
 	m_pRenderingHandler(pRenderingHandler),
 	m_pProfiler(nullptr),
+	m_DrawQueue(VK_SHADER_STAGE_VERTEX_BIT, 0),
+	m_pRecorder(nullptr),
+	m_InheritanceInfo(),
 	m_pPipeline(nullptr),
 	m_pDescriptorSetLayout(nullptr),
 	m_pDescriptorPool(nullptr),
@@ -50,6 +54,8 @@ ShadowMapRendererVK::~ShadowMapRendererVK()
 		SAFEDELETE(m_ppCommandPools[i]);
 	}
 
+	SAFEDELETE(m_pRecorder);
+
 	SAFEDELETE(m_pDescriptorSetLayout);
 	SAFEDELETE(m_pDescriptorPool);
 	SAFEDELETE(m_pPipelineLayout);
@@ -92,28 +98,22 @@ void ShadowMapRendererVK::beginFrame(IScene* pScene)
 	uint32_t frameIndex = m_pRenderingHandler->getCurrentFrameIndex();
 
 	m_pProfiler->reset(frameIndex, m_pRenderingHandler->getCurrentGraphicsCommandBuffer());
+	m_TriangleCounter.value				= 0;
+	m_FullDetailTriangleCounter.value	= 0;
+	m_DrawQueue.reset();
 	m_ppCommandBuffers[frameIndex]->reset(false);
 	m_ppCommandPools[frameIndex]->reset();
 
 	// Needed to begin a secondary buffer
-	VkCommandBufferInheritanceInfo inheritanceInfo = {};
-	inheritanceInfo.sType		= VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
-	inheritanceInfo.pNext		= nullptr;
-	inheritanceInfo.renderPass	= m_pRenderingHandler->getShadowMapRenderPass()->getRenderPass();
-	inheritanceInfo.subpass		= 0;
-	inheritanceInfo.framebuffer = pFrameBuffer->getFrameBuffer();
-
-	m_ppCommandBuffers[frameIndex]->begin(&inheritanceInfo, VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT);
+	m_InheritanceInfo = {};
+	m_InheritanceInfo.sType			= VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	m_InheritanceInfo.pNext			= nullptr;
+	m_InheritanceInfo.renderPass	= m_pRenderingHandler->getShadowMapRenderPass()->getRenderPass();
+	m_InheritanceInfo.subpass		= 0;
+	m_InheritanceInfo.framebuffer	= pFrameBuffer->getFrameBuffer();
+
+	m_ppCommandBuffers[frameIndex]->begin(&m_InheritanceInfo, VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT);
 	m_pProfiler->beginFrame(m_ppCommandBuffers[frameIndex]);
-
-	m_ppCommandBuffers[frameIndex]->setViewports(&m_Viewport, 1);
-	m_ppCommandBuffers[frameIndex]->setScissorRects(&m_ScissorRect, 1);
-
-	m_ppCommandBuffers[frameIndex]->bindPipeline(m_pPipeline);
-
-	// Bind the directional light's descriptor set
-	DescriptorSetVK* pDescriptorSet = reinterpret_cast<DescriptorSetVK*>(pDirectionalLight->getDescriptorSet());
-	m_ppCommandBuffers[frameIndex]->bindDescriptorSet(VK_PIPELINE_BIND_POINT_GRAPHICS, m_pPipelineLayout, 1, 1, &pDescriptorSet, 0, nullptr);
 }
 
 void ShadowMapRendererVK::endFrame(IScene* pScene)
@@ -122,8 +122,43 @@ void ShadowMapRendererVK::endFrame(IScene* pScene)
 
 	uint32_t currentFrame = m_pRenderingHandler->getCurrentFrameIndex();
 
-	m_pProfiler->endFrame();
 	m_ppCommandBuffers[currentFrame]->end();
+
+	// The sorted draws are split into chunks that the frame workers record into their own secondary buffers
+	m_DrawQueue.prepare(m_pScene);
+
+	uint32_t chunkStarts[PARALLEL_RECORDER_MAX_CHUNKS + 1];
+	const uint32_t chunkCount = m_DrawQueue.split(m_pRecorder->getChunkCapacity(), chunkStarts);
+
+	DescriptorSetVK* pLightDescriptorSet = reinterpret_cast<DescriptorSetVK*>(m_pScene->getLightSetup().getDirectionalLight()->getDescriptorSet());
+
+	DrawQueueStatsVK chunkStats[PARALLEL_RECORDER_MAX_CHUNKS];
+	m_pRecorder->record(currentFrame, chunkCount, &m_InheritanceInfo, [&](CommandBufferVK* pCommandBuffer, uint32_t chunk)
+		{
+			pCommandBuffer->setViewports(&m_Viewport, 1);
+			pCommandBuffer->setScissorRects(&m_ScissorRect, 1);
+
+			// Bind the directional light's descriptor set
+			pCommandBuffer->bindDescriptorSet(VK_PIPELINE_BIND_POINT_GRAPHICS, m_pPipelineLayout, 1, 1, &pLightDescriptorSet, 0, nullptr);
+
+			m_DrawQueue.submitRange(pCommandBuffer, m_pPipelineLayout, m_pScene, currentFrame, INSTANCE_INDICES_PASS_SHADOW, chunkStarts[chunk], chunkStarts[chunk + 1], chunkStats[chunk]);
+
+			// The last chunk is executed last, so it ends the timestamps of the pass
+			if (chunk == chunkCount - 1) {
+				m_pProfiler->setProfiledCommandBuffer(pCommandBuffer);
+				m_pProfiler->endFrame();
+			}
+		});
+
+	for (uint32_t chunk = 0; chunk < chunkCount; chunk++) {
+		m_DrawQueue.addStats(chunkStats[chunk]);
+	}
+}
+
+void ShadowMapRendererVK::executePass(CommandBufferVK* pPrimaryBuffer, uint32_t frameIndex)
+{
+	pPrimaryBuffer->executeSecondary(m_ppCommandBuffers[frameIndex]);
+	m_pRecorder->execute(pPrimaryBuffer, frameIndex);
 }
 
 void ShadowMapRendererVK::renderUI()
@@ -154,19 +189,16 @@ void ShadowMapRendererVK::updateBuffers(SceneVK* pScene)
 	}
 }
 
-void ShadowMapRendererVK::submitMesh(const MeshVK* pMesh, const Material* pMaterial, uint32_t transformIndex)
+void ShadowMapRendererVK::submitMesh(const MeshVK* pMesh, const Material* pMaterial, uint32_t transformIndex, const IndexRangeVK& indexRange, float depth)
 {
-	uint32_t frameIndex = m_pRenderingHandler->getCurrentFrameIndex();
-
-	m_ppCommandBuffers[frameIndex]->pushConstants(m_pPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(uint32_t), &transformIndex);
-
-	BufferVK* pIndexBuffer = reinterpret_cast<BufferVK*>(pMesh->getIndexBuffer());
-	m_ppCommandBuffers[frameIndex]->bindIndexBuffer(pIndexBuffer, 0, VK_INDEX_TYPE_UINT32);
-
-	DescriptorSetVK* pDescriptorSet = m_pScene->getDescriptorSetFromMeshAndMaterial(pMesh, pMaterial);
-	m_ppCommandBuffers[frameIndex]->bindDescriptorSet(VK_PIPELINE_BIND_POINT_GRAPHICS, m_pPipelineLayout, 0, 1, &pDescriptorSet, 0, nullptr);
+	m_FullDetailTriangleCounter.value += pMesh->getIndexCount() / 3;
+	if (indexRange.IndexCount == 0)
+	{
+		return;
+	}
 
-	m_ppCommandBuffers[frameIndex]->drawIndexInstanced(pMesh->getIndexCount(), 1, 0, 0, 0);
+	m_DrawQueue.push(m_pPipeline, pMesh, pMaterial, indexRange, transformIndex, nullptr, depth);
+	m_TriangleCounter.value += indexRange.IndexCount / 3;
 }
 
 void ShadowMapRendererVK::setViewport(float width, float height, float minDepth, float maxDepth, float topX, float topY)
@@ -225,6 +257,11 @@ bool ShadowMapRendererVK::createCommandPoolAndBuffers()
 		}
 	}
 
+	m_pRecorder = DBG_NEW ParallelRecorderVK(pDevice);
+	if (!m_pRecorder->init(graphicsQueueIndex, "ShadowPass")) {
+		return false;
+	}
+
 	return true;
 }
 
@@ -258,13 +295,9 @@ bool ShadowMapRendererVK::createPipelineLayout()
 		return false;
 	}
 
-	VkPushConstantRange pushConstantRange = {};
-	pushConstantRange.size			= sizeof(uint32_t);
-	pushConstantRange.stageFlags	= VK_SHADER_STAGE_VERTEX_BIT;
-	pushConstantRange.offset		= 0;
-
+	// The transform of every instance is found through the instance indices of the mesh descriptor set, so nothing is pushed
 	m_pPipelineLayout = DBG_NEW PipelineLayoutVK(pDevice);
-	return m_pPipelineLayout->init({pMeshDescriptorSetLayout, m_pDescriptorSetLayout}, {pushConstantRange});
+	return m_pPipelineLayout->init({pMeshDescriptorSetLayout, m_pDescriptorSetLayout}, {});
 }
 
 bool ShadowMapRendererVK::createPipeline()
@@ -277,6 +310,9 @@ bool ShadowMapRendererVK::createPipeline()
 		return false;
 	}
 
+	SceneVK* pScene = reinterpret_cast<SceneVK*>(m_pRenderingHandler->getScene());
+	reinterpret_cast<ShaderVK*>(pVertexShader)->setSpecializationConstant<uint32_t>(0, uint32_t(pScene->getVertexFormat()));
+
 	m_pPipeline = DBG_NEW PipelineVK(m_pGraphicsContext->getDevice());
 
 	VkPipelineRasterizationStateCreateInfo rasterizerState = {};
@@ -319,6 +355,9 @@ bool ShadowMapRendererVK::createSampler()
 void ShadowMapRendererVK::createProfiler()
 {
 	m_pProfiler = DBG_NEW ProfilerVK("Shadow-Map Renderer", m_pGraphicsContext->getDevice());
+	m_pProfiler->initCounter(&m_TriangleCounter, "Triangles");
+	m_pProfiler->initCounter(&m_FullDetailTriangleCounter, "Triangles without LODs");
+	m_DrawQueue.initCounters(m_pProfiler);
 }
 
 bool ShadowMapRendererVK::createShadowMapResources(DirectionalLight* pDirectionalLight)
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "Common/IRenderer.h"
+#include "Vulkan/DrawQueueVK.h"
+#include "Vulkan/MeshletCullerVK.h"
 #include "Vulkan/ProfilerVK.h"
 #include "Vulkan/VulkanCommon.h"
 
@@ -12,6 +14,7 @@ class DescriptorSetVK;
 class DirectionalLight;
 class GraphicsContextVK;
 class MeshVK;
+class ParallelRecorderVK;
 class PipelineLayoutVK;
 class PipelineVK;
 class RenderingHandlerVK;
@@ -41,9 +44,13 @@ public:
 
 	void onWindowResize(uint32_t width, uint32_t height);
 
-	void submitMesh(const MeshVK* pMesh, const Material* pMaterial, uint32_t transformIndex);
+	void submitMesh(const MeshVK* pMesh, const Material* pMaterial, uint32_t transformIndex, const IndexRangeVK& indexRange, float depth);
+
+	// Executes the command buffer of the frame followed by the chunks of draws that were recorded in parallel
+	void executePass(CommandBufferVK* pPrimaryBuffer, uint32_t frameIndex);
 
 	FORCEINLINE CommandBufferVK*	getCommandBuffer(uint32_t frameindex) const { return m_ppCommandBuffers[frameindex]; }
+	FORCEINLINE ParallelRecorderVK*	getRecorder() const							{ return m_pRecorder; }
 	FORCEINLINE ProfilerVK*			getProfiler()								{ return m_pProfiler; }
 
 private:
@@ -59,9 +66,15 @@ private:
 	GraphicsContextVK* m_pGraphicsContext;
 	RenderingHandlerVK* m_pRenderingHandler;
 	ProfilerVK* m_pProfiler;
+	ProfilerCounter m_TriangleCounter;
+	ProfilerCounter m_FullDetailTriangleCounter;
+	DrawQueueVK m_DrawQueue;
 
+	// Only holds the start of the profiler, the draws are recorded into the chunks of the recorder
 	CommandBufferVK* m_ppCommandBuffers[MAX_FRAMES_IN_FLIGHT];
 	CommandPoolVK* m_ppCommandPools[MAX_FRAMES_IN_FLIGHT];
+	ParallelRecorderVK* m_pRecorder;
+	VkCommandBufferInheritanceInfo m_InheritanceInfo;
 
 	DescriptorSetLayoutVK* m_pDescriptorSetLayout;
 	DescriptorPoolVK* m_pDescriptorPool;
@@ -6,6 +6,9 @@
 #include "CopyHandlerVK.h"
 #include "GraphicsContextVK.h"
 
+#include "Core/AssetArchive.h"
+#include "Core/TextureCache.h"
+
 #include "stb_image.h"
 #include "BufferVK.h"
 #include "ImageVK.h"
@@ -28,21 +31,44 @@ Texture2DVK::~Texture2DVK()
 	SAFEDELETE(m_pTextureImageView);
 }
 
-bool Texture2DVK::initFromFile(const std::string& filename, ETextureFormat format, bool generateMips)
+bool Texture2DVK::initFromFile(const std::string& filename, ETextureFormat format, bool generateMips, ETextureCompression compression)
 {
+	if (resolveCompression(m_pDevice, filename, format, compression) != ETextureCompression::NONE)
+	{
+		TextureCache cache;
+		return cache.load(filename, compression) && initFromCache(cache, generateMips);
+	}
+
 	int texWidth	= 0; 
 	int texHeight	= 0;
 	int bpp			= 0;
 
+	//Archived images are decoded straight from the archive
+	AssetView view;
+	const bool isArchived = AssetArchive::read(filename, view);
+
 	void* pPixels = nullptr;
 	if (format == ETextureFormat::FORMAT_R8G8B8A8_UNORM)
 	{
-		pPixels = (void*)stbi_load(filename.c_str(), &texWidth, &texHeight, &bpp, STBI_rgb_alpha);
+		if (isArchived)
+		{
+			pPixels = (void*)stbi_load_from_memory(view.getData(), int(view.getSizeInBytes()), &texWidth, &texHeight, &bpp, STBI_rgb_alpha);
+		}
+		else
+		{
+			pPixels = (void*)stbi_load(filename.c_str(), &texWidth, &texHeight, &bpp, STBI_rgb_alpha);
+		}
 	}
 	else if (format == ETextureFormat::FORMAT_R32G32B32A32_FLOAT)
 	{
-
-		pPixels = (void*)stbi_loadf(filename.c_str(), &texWidth, &texHeight, &bpp, STBI_rgb_alpha);
+		if (isArchived)
+		{
+			pPixels = (void*)stbi_loadf_from_memory(view.getData(), int(view.getSizeInBytes()), &texWidth, &texHeight, &bpp, STBI_rgb_alpha);
+		}
+		else
+		{
+			pPixels = (void*)stbi_loadf(filename.c_str(), &texWidth, &texHeight, &bpp, STBI_rgb_alpha);
+		}
 	}
 	else
 	{
@@ -69,28 +95,11 @@ bool Texture2DVK::initFromMemory(const void* pData, uint32_t width, uint32_t hei
 	uint32_t miplevels = 1u;
 	if (generateMips)
 	{
-		miplevels = uint32_t(std::floor(std::log2(std::max(width, height)))) + 1u;
+		miplevels = calculateMiplevelCount(width, height);
+		usageFlags |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
 	}
 
-	ImageParams imageParams = {};
-	imageParams.Type			= VK_IMAGE_TYPE_2D;
-	imageParams.Extent.depth	= 1;
-	imageParams.Extent.width	= width;
-	imageParams.Extent.height	= height;
-	imageParams.MipLevels		= miplevels;
-	imageParams.Samples			= VK_SAMPLE_COUNT_1_BIT;
-	imageParams.ArrayLayers		= 1;
-	imageParams.MemoryProperty	= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-	imageParams.Usage			= VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | usageFlags;
-	imageParams.Format			= convertFormat(format);
-	
-	if (generateMips)
-	{
-		imageParams.Usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
-	}
-	
-	m_pTextureImage = DBG_NEW ImageVK(m_pDevice);
-	if (!m_pTextureImage->init(imageParams))
+	if (!initImage(width, height, format, miplevels, usageFlags))
 	{
 		return false;
 	}
@@ -108,6 +117,44 @@ bool Texture2DVK::initFromMemory(const void* pData, uint32_t width, uint32_t hei
 		}
 	}
 
+	return true;
+}
+
+bool Texture2DVK::initFromCache(const TextureCache& cache, bool generateMips)
+{
+	//The mip chain is always stored in full, without generateMips only the first miplevel is used
+	const uint32_t miplevels = generateMips ? cache.getMiplevelCount() : 1u;
+	if (!initImage(cache.getWidth(), cache.getHeight(), cache.getFormat(), miplevels, 0))
+	{
+		return false;
+	}
+
+	CopyHandlerVK* pCopyHandler = m_pDevice->getCopyHandler();
+	pCopyHandler->updateImageMiplevels(cache.getData(), cache.getMiplevelsSizeInBytes(miplevels), cache.getMiplevelOffsets(), m_pTextureImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 0);
+
+	return true;
+}
+
+bool Texture2DVK::initImage(uint32_t width, uint32_t height, ETextureFormat format, uint32_t miplevels, uint32_t usageFlags)
+{
+	ImageParams imageParams = {};
+	imageParams.Type			= VK_IMAGE_TYPE_2D;
+	imageParams.Extent.depth	= 1;
+	imageParams.Extent.width	= width;
+	imageParams.Extent.height	= height;
+	imageParams.MipLevels		= miplevels;
+	imageParams.Samples			= VK_SAMPLE_COUNT_1_BIT;
+	imageParams.ArrayLayers		= 1;
+	imageParams.MemoryProperty	= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	imageParams.Usage			= VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | usageFlags;
+	imageParams.Format			= convertFormat(format);
+
+	m_pTextureImage = DBG_NEW ImageVK(m_pDevice);
+	if (!m_pTextureImage->init(imageParams))
+	{
+		return false;
+	}
+
 	ImageViewParams imageViewParams = {};
 	imageViewParams.Type			= VK_IMAGE_VIEW_TYPE_2D;
 	imageViewParams.AspectFlags		= VK_IMAGE_ASPECT_COLOR_BIT;
@@ -119,3 +166,30 @@ bool Texture2DVK::initFromMemory(const void* pData, uint32_t width, uint32_t hei
 	m_pTextureImageView = DBG_NEW ImageViewVK(m_pDevice, m_pTextureImage);
 	return m_pTextureImageView->init(imageViewParams);
 }
+
+uint32_t Texture2DVK::calculateMiplevelCount(uint32_t width, uint32_t height)
+{
+	return uint32_t(std::floor(std::log2(std::max(width, height)))) + 1u;
+}
+
+ETextureCompression Texture2DVK::resolveCompression(DeviceVK* pDevice, const std::string& filename, ETextureFormat format, ETextureCompression compression)
+{
+	if (compression == ETextureCompression::NONE)
+	{
+		return ETextureCompression::NONE;
+	}
+	
+	if (format != ETextureFormat::FORMAT_R8G8B8A8_UNORM)
+	{
+		LOG("-- Texture2DVK: Compression is only supported for RGBA8 textures, loading '%s' uncompressed", filename.c_str());
+		return ETextureCompression::NONE;
+	}
+	
+	if (!pDevice->supportsTextureCompressionBC())
+	{
+		LOG("-- Texture2DVK: Device does not support BCn textures, loading '%s' uncompressed", filename.c_str());
+		return ETextureCompression::NONE;
+	}
+
+	return compression;
+}
@@ -3,6 +3,7 @@
 #include "VulkanCommon.h"
 
 class IGraphicsContext;
+class TextureCache;
 
 class ImageVK;
 class ImageViewVK;
@@ -18,12 +19,20 @@ public:
 	Texture2DVK(DeviceVK* pDevice);
 	~Texture2DVK();
 
-	virtual bool initFromFile(const std::string& filename, ETextureFormat format, bool generateMips) override;
+	virtual bool initFromFile(const std::string& filename, ETextureFormat format, bool generateMips, ETextureCompression compression) override;
 	virtual bool initFromMemory(const void* pData, uint32_t width, uint32_t height, ETextureFormat format, uint32_t usageFlags, bool generateMips) override;
 
+	bool initFromCache(const TextureCache& cache, bool generateMips);
+	//Creates the image and its view without uploading anything, used when the upload is recorded together with other textures
+	bool initImage(uint32_t width, uint32_t height, ETextureFormat format, uint32_t miplevels, uint32_t usageFlags);
+
 	FORCEINLINE ImageVK*		getImage() const		{ return m_pTextureImage; }
 	FORCEINLINE ImageViewVK*	getImageView() const	{ return m_pTextureImageView; }
 
+	static uint32_t calculateMiplevelCount(uint32_t width, uint32_t height);
+	//Returns NONE when the texture has to be loaded uncompressed
+	static ETextureCompression resolveCompression(DeviceVK* pDevice, const std::string& filename, ETextureFormat format, ETextureCompression compression);
+
 private:
 	DeviceVK* m_pDevice;
 	ImageVK* m_pTextureImage;
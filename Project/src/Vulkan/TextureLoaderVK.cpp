@@ -0,0 +1,505 @@
+#include "TextureLoaderVK.h"
+#include "BufferVK.h"
+#include "DeviceVK.h"
+#include "ImageVK.h"
+#include "Texture2DVK.h"
+#include "CommandPoolVK.h"
+#include "CommandBufferVK.h"
+
+#include "Core/AssetArchive.h"
+#include "Core/TextureCache.h"
+
+#include "stb_image.h"
+
+#include <mutex>
+#include <fstream>
+#include <algorithm>
+
+#ifdef max
+	#undef max
+#endif
+
+TextureLoaderVK::TextureLoaderVK(DeviceVK* pDevice)
+	: m_pDevice(pDevice),
+	m_pStagingBuffer(nullptr),
+	m_pStagingMemory(nullptr),
+	m_pCommandPool(nullptr),
+	m_Batches(),
+	m_FirstBatch(0),
+	m_BatchesInFlight(0),
+	m_StagingSize(0),
+	m_RingHead(0),
+	m_RingTail(0),
+	m_Lock(),
+	m_Requests(),
+	m_PreparedTextures(),
+	m_PreparedSizeInBytes(0),
+	m_ActiveReads(0),
+	m_Tasks(),
+	m_StartTime(),
+	m_UploadedSizeInBytes(0),
+	m_UploadedTextureCount(0),
+	m_SubmittedBatchCount(0),
+	m_IsIdle(true)
+{
+}
+
+TextureLoaderVK::~TextureLoaderVK()
+{
+	//Requests that have not been read yet are dropped, the tasks that are running finish before anything they use is deleted
+	{
+		std::scoped_lock<Spinlock> lock(m_Lock);
+		m_Requests.clear();
+	}
+
+	m_Tasks.wait();
+
+	for (UploadBatch& batch : m_Batches)
+	{
+		if (batch.pCommandBuffer != nullptr)
+		{
+			VkFence fence = batch.pCommandBuffer->getFence();
+			vkWaitForFences(m_pDevice->getDevice(), 1, &fence, VK_TRUE, UINT64_MAX);
+
+			m_pCommandPool->freeCommandBuffer(&batch.pCommandBuffer);
+		}
+	}
+
+	for (PreparedTexture& texture : m_PreparedTextures)
+	{
+		releasePreparedTexture(texture);
+	}
+	m_PreparedTextures.clear();
+
+	SAFEDELETE(m_pCommandPool);
+	SAFEDELETE(m_pStagingBuffer);
+
+	m_pDevice = nullptr;
+}
+
+bool TextureLoaderVK::init(VkDeviceSize stagingSizeInBytes)
+{
+	BufferParams params = {};
+	params.Usage			= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	params.MemoryProperty	= VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+	params.SizeInBytes		= stagingSizeInBytes;
+	params.IsExclusive		= true;
+
+	m_pStagingBuffer = DBG_NEW BufferVK(m_pDevice);
+	if (!m_pStagingBuffer->init(params))
+	{
+		LOG("--- TextureLoaderVK: Failed to create staging ring");
+		return false;
+	}
+
+	m_pStagingBuffer->setName("Texture Staging Ring");
+	m_pStagingBuffer->map((void**)&m_pStagingMemory);
+	m_StagingSize = stagingSizeInBytes;
+
+	//Mipmaps are generated with blits, so the uploads go through the graphics queue
+	m_pCommandPool = DBG_NEW CommandPoolVK(m_pDevice, m_pDevice->getQueueFamilyIndices().graphicsFamily.value());
+	if (!m_pCommandPool->init())
+	{
+		return false;
+	}
+
+	for (UploadBatch& batch : m_Batches)
+	{
+		batch.pCommandBuffer = m_pCommandPool->allocateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+		if (batch.pCommandBuffer == nullptr)
+		{
+			return false;
+		}
+
+		batch.RingEnd = 0;
+	}
+
+	return true;
+}
+
+void TextureLoaderVK::load(Texture2DVK* pTexture, const std::string& filename, ETextureFormat format, bool generateMips, ETextureCompression compression)
+{
+	TextureRequest request = {};
+	request.pTexture		= pTexture;
+	request.Filename		= filename;
+	request.Format			= format;
+	request.Compression		= compression;
+	request.GenerateMips	= generateMips;
+
+	std::scoped_lock<Spinlock> lock(m_Lock);
+	if (m_IsIdle)
+	{
+		m_StartTime	= std::chrono::high_resolution_clock::now();
+		m_IsIdle	= false;
+	}
+
+	m_Requests.push_back(std::move(request));
+	dispatchReads();
+}
+
+void TextureLoaderVK::update(std::vector<StreamedTextureVK>& completedTextures)
+{
+	retireBatches(completedTextures);
+
+	if (m_BatchesInFlight < TEXTURE_LOADER_BATCH_COUNT)
+	{
+		UploadBatch& batch = m_Batches[(m_FirstBatch + m_BatchesInFlight) % TEXTURE_LOADER_BATCH_COUNT];
+		bool isRecording = false;
+
+		while (true)
+		{
+			//Only this thread removes prepared textures, so the front stays the same while it is being uploaded
+			PreparedTexture texture = {};
+			{
+				std::scoped_lock<Spinlock> lock(m_Lock);
+				if (m_PreparedTextures.empty())
+				{
+					break;
+				}
+
+				texture = m_PreparedTextures.front();
+			}
+
+			if (!texture.IsLoaded)
+			{
+				completedTextures.push_back({ texture.pTexture, false });
+			}
+			else if (texture.SizeInBytes + TEXTURE_LOADER_ALIGNMENT > m_StagingSize)
+			{
+				//Too large for the ring, goes through the copy handler on its own
+				const bool isLoaded = texture.pCache ? texture.pTexture->initFromCache(*texture.pCache, texture.GenerateMips) : texture.pTexture->initFromMemory(texture.pPixels, texture.Width, texture.Height, texture.Format, 0, texture.GenerateMips);
+				completedTextures.push_back({ texture.pTexture, isLoaded });
+
+				m_UploadedSizeInBytes += texture.SizeInBytes;
+				m_UploadedTextureCount++;
+			}
+			else
+			{
+				VkDeviceSize stagingOffset = 0;
+				if (!allocateStaging(texture.SizeInBytes, stagingOffset))
+				{
+					//The ring is full until a batch in flight is done
+					break;
+				}
+
+				if (!isRecording)
+				{
+					batch.pCommandBuffer->reset(true);
+					batch.pCommandBuffer->begin(nullptr, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+					isRecording = true;
+				}
+
+				if (recordTexture(batch.pCommandBuffer, texture, stagingOffset))
+				{
+					batch.Textures.push_back(texture.pTexture);
+
+					m_UploadedSizeInBytes += texture.SizeInBytes;
+					m_UploadedTextureCount++;
+				}
+				else
+				{
+					LOG("--- TextureLoaderVK: Failed to create image for texture");
+					completedTextures.push_back({ texture.pTexture, false });
+				}
+			}
+
+			releasePreparedTexture(texture);
+			{
+				std::scoped_lock<Spinlock> lock(m_Lock);
+				m_PreparedSizeInBytes -= texture.SizeInBytes;
+				m_PreparedTextures.pop_front();
+			}
+		}
+
+		if (isRecording)
+		{
+			batch.pCommandBuffer->end();
+			batch.RingEnd = m_RingHead;
+
+			m_pDevice->executeGraphics(batch.pCommandBuffer, nullptr, nullptr, 0, nullptr, 0);
+			m_BatchesInFlight++;
+			m_SubmittedBatchCount++;
+		}
+	}
+
+	std::scoped_lock<Spinlock> lock(m_Lock);
+
+	//Uploads free up room for more reads
+	dispatchReads();
+
+	if (!m_IsIdle && m_Requests.empty() && m_ActiveReads == 0 && m_PreparedTextures.empty() && m_BatchesInFlight == 0)
+	{
+		logThroughput();
+
+		m_UploadedSizeInBytes	= 0;
+		m_UploadedTextureCount	= 0;
+		m_SubmittedBatchCount	= 0;
+		m_IsIdle				= true;
+	}
+}
+
+void TextureLoaderVK::dispatchReads()
+{
+	//Decoded images are not counted until they have been read, so at most TEXTURE_LOADER_MAX_ACTIVE_READS images can go over the cap
+	while (!m_Requests.empty() && m_ActiveReads < TEXTURE_LOADER_MAX_ACTIVE_READS && m_PreparedSizeInBytes < m_StagingSize)
+	{
+		m_ActiveReads++;
+
+		TaskDispatcher::execute([this, request = std::move(m_Requests.front())]() mutable
+			{
+				readTexture(request);
+			}, m_Tasks, ETaskPool::BACKGROUND);
+
+		m_Requests.pop_front();
+	}
+}
+
+void TextureLoaderVK::readTexture(TextureRequest& request)
+{
+	PreparedTexture texture = {};
+	texture.pTexture		= request.pTexture;
+	texture.GenerateMips	= request.GenerateMips;
+
+	const ETextureCompression compression = Texture2DVK::resolveCompression(m_pDevice, request.Filename, request.Format, request.Compression);
+	if (compression != ETextureCompression::NONE)
+	{
+		//The cache is mapped instead of read, and its miplevels are uploaded as they are so there is nothing to decode
+		TextureCache* pCache = DBG_NEW TextureCache();
+		if (pCache->load(request.Filename, compression))
+		{
+			const uint32_t miplevels = request.GenerateMips ? pCache->getMiplevelCount() : 1u;
+
+			texture.pCache		= pCache;
+			texture.SizeInBytes	= pCache->getMiplevelsSizeInBytes(miplevels);
+			texture.Width		= pCache->getWidth();
+			texture.Height		= pCache->getHeight();
+			texture.Format		= pCache->getFormat();
+			texture.IsLoaded	= true;
+
+			//Touch every page so that copying into the staging ring does not wait for the disk on the render thread
+			constexpr uint64_t pageSize = 4096;
+			const uint8_t* pData = pCache->getData();
+			volatile uint8_t pageSum = 0;
+			for (uint64_t offset = 0; offset < texture.SizeInBytes; offset += pageSize)
+			{
+				pageSum += pData[offset];
+			}
+		}
+		else
+		{
+			SAFEDELETE(pCache);
+		}
+
+		pushPreparedTexture(texture);
+		return;
+	}
+
+	//Archived images are already mapped, so there is no read to overlap with the decode of other files
+	AssetView view;
+	if (AssetArchive::read(request.Filename, view))
+	{
+		decodeTexture(request, view.getData(), view.getSizeInBytes());
+		return;
+	}
+
+	std::ifstream file(request.Filename, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+	{
+		LOG("Error loading texture file: %s", request.Filename.c_str());
+		pushPreparedTexture(texture);
+		return;
+	}
+
+	std::vector<uint8_t> fileData(size_t(file.tellg()));
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(fileData.data()), fileData.size());
+	file.close();
+
+	TaskDispatcher::execute([this, request = std::move(request), fileData = std::move(fileData)]() mutable
+		{
+			decodeTexture(request, fileData.data(), fileData.size());
+		}, m_Tasks, ETaskPool::BACKGROUND);
+}
+
+void TextureLoaderVK::decodeTexture(TextureRequest& request, const uint8_t* pFileData, uint64_t fileSize)
+{
+	int texWidth	= 0;
+	int texHeight	= 0;
+	int bpp			= 0;
+
+	void* pPixels = nullptr;
+	if (request.Format == ETextureFormat::FORMAT_R8G8B8A8_UNORM)
+	{
+		pPixels = (void*)stbi_load_from_memory(pFileData, int(fileSize), &texWidth, &texHeight, &bpp, STBI_rgb_alpha);
+	}
+	else if (request.Format == ETextureFormat::FORMAT_R32G32B32A32_FLOAT)
+	{
+		pPixels = (void*)stbi_loadf_from_memory(pFileData, int(fileSize), &texWidth, &texHeight, &bpp, STBI_rgb_alpha);
+	}
+	else
+	{
+		LOG("Error format not supported");
+	}
+
+	PreparedTexture texture = {};
+	texture.pTexture		= request.pTexture;
+	texture.pPixels			= pPixels;
+	texture.SizeInBytes		= uint64_t(texWidth) * uint64_t(texHeight) * textureFormatStride(request.Format);
+	texture.Width			= uint32_t(texWidth);
+	texture.Height			= uint32_t(texHeight);
+	texture.Format			= request.Format;
+	texture.GenerateMips	= request.GenerateMips;
+	texture.IsLoaded		= (pPixels != nullptr);
+
+	if (texture.IsLoaded)
+	{
+		LOG("-- LOADED TEXTURE: %s", request.Filename.c_str());
+	}
+	else
+	{
+		LOG("Error loading texture file: %s", request.Filename.c_str());
+		texture.SizeInBytes = 0;
+	}
+
+	pushPreparedTexture(texture);
+}
+
+void TextureLoaderVK::pushPreparedTexture(const PreparedTexture& texture)
+{
+	std::scoped_lock<Spinlock> lock(m_Lock);
+	m_PreparedTextures.push_back(texture);
+	m_PreparedSizeInBytes += texture.SizeInBytes;
+	m_ActiveReads--;
+
+	dispatchReads();
+}
+
+void TextureLoaderVK::releasePreparedTexture(PreparedTexture& texture)
+{
+	SAFEDELETE(texture.pCache);
+
+	if (texture.pPixels != nullptr)
+	{
+		stbi_image_free(texture.pPixels);
+		texture.pPixels = nullptr;
+	}
+}
+
+void TextureLoaderVK::retireBatches(std::vector<StreamedTextureVK>& completedTextures)
+{
+	//Batches finish in the order they were submitted
+	while (m_BatchesInFlight > 0)
+	{
+		UploadBatch& batch = m_Batches[m_FirstBatch];
+		if (vkGetFenceStatus(m_pDevice->getDevice(), batch.pCommandBuffer->getFence()) != VK_SUCCESS)
+		{
+			break;
+		}
+
+		for (const ITexture2D* pTexture : batch.Textures)
+		{
+			completedTextures.push_back({ pTexture, true });
+		}
+		batch.Textures.clear();
+
+		m_RingTail		= batch.RingEnd;
+		m_FirstBatch	= (m_FirstBatch + 1) % TEXTURE_LOADER_BATCH_COUNT;
+		m_BatchesInFlight--;
+	}
+
+	if (m_BatchesInFlight == 0)
+	{
+		m_RingHead = 0;
+		m_RingTail = 0;
+	}
+}
+
+bool TextureLoaderVK::recordTexture(CommandBufferVK* pCommandBuffer, const PreparedTexture& texture, VkDeviceSize stagingOffset)
+{
+	Texture2DVK* pTexture = texture.pTexture;
+	if (texture.pCache != nullptr)
+	{
+		//The mip chain is always stored in full, without generateMips only the first miplevel is used
+		const uint32_t miplevels = texture.GenerateMips ? texture.pCache->getMiplevelCount() : 1u;
+		if (!pTexture->initImage(texture.Width, texture.Height, texture.Format, miplevels, 0))
+		{
+			return false;
+		}
+
+		memcpy(m_pStagingMemory + stagingOffset, texture.pCache->getData(), texture.SizeInBytes);
+
+		ImageVK* pImage = pTexture->getImage();
+		pCommandBuffer->transitionImageLayout(pImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, miplevels, 0, 1);
+		for (uint32_t i = 0; i < miplevels; i++)
+		{
+			pCommandBuffer->copyBufferToImage(m_pStagingBuffer, stagingOffset + texture.pCache->getMiplevelOffset(i), pImage, std::max(texture.Width >> i, 1U), std::max(texture.Height >> i, 1U), i, 0);
+		}
+		pCommandBuffer->transitionImageLayout(pImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 0, miplevels, 0, 1);
+
+		return true;
+	}
+
+	const uint32_t miplevels	= texture.GenerateMips ? Texture2DVK::calculateMiplevelCount(texture.Width, texture.Height) : 1u;
+	const uint32_t usageFlags	= texture.GenerateMips ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT : 0;
+	if (!pTexture->initImage(texture.Width, texture.Height, texture.Format, miplevels, usageFlags))
+	{
+		return false;
+	}
+
+	memcpy(m_pStagingMemory + stagingOffset, texture.pPixels, texture.SizeInBytes);
+
+	ImageVK* pImage = pTexture->getImage();
+	pCommandBuffer->transitionImageLayout(pImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, miplevels, 0, 1);
+	pCommandBuffer->copyBufferToImage(m_pStagingBuffer, stagingOffset, pImage, texture.Width, texture.Height, 0, 0);
+
+	if (texture.GenerateMips)
+	{
+		pCommandBuffer->generateMips(pImage);
+	}
+	else
+	{
+		pCommandBuffer->transitionImageLayout(pImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 0, 1, 0, 1);
+	}
+
+	return true;
+}
+
+bool TextureLoaderVK::allocateStaging(VkDeviceSize sizeInBytes, VkDeviceSize& offset)
+{
+	//The head never catches up with the tail from behind, so they are only equal when the ring is empty
+	const VkDeviceSize alignedHead = (m_RingHead + TEXTURE_LOADER_ALIGNMENT - 1) & ~VkDeviceSize(TEXTURE_LOADER_ALIGNMENT - 1);
+	if (m_RingHead >= m_RingTail)
+	{
+		//Free space is between the head and the end, and between the start and the tail
+		if (alignedHead + sizeInBytes <= m_StagingSize)
+		{
+			offset		= alignedHead;
+			m_RingHead	= alignedHead + sizeInBytes;
+			return true;
+		}
+		else if (sizeInBytes < m_RingTail)
+		{
+			offset		= 0;
+			m_RingHead	= sizeInBytes;
+			return true;
+		}
+	}
+	else if (alignedHead + sizeInBytes < m_RingTail)
+	{
+		offset		= alignedHead;
+		m_RingHead	= alignedHead + sizeInBytes;
+		return true;
+	}
+
+	return false;
+}
+
+void TextureLoaderVK::logThroughput() const
+{
+	const std::chrono::duration<double> loadTime = std::chrono::high_resolution_clock::now() - m_StartTime;
+	const double seconds	= std::max(loadTime.count(), 0.000001);
+	const double megabytes	= double(m_UploadedSizeInBytes) / double(MB(1));
+
+	LOG("--- TextureLoaderVK: Uploaded %u textures (%.2f MB) in %u batches over %.2f ms, %.2f MB/s, %.2f images/s",
+		m_UploadedTextureCount, megabytes, m_SubmittedBatchCount, seconds * 1000.0, megabytes / seconds, double(m_UploadedTextureCount) / seconds);
+}
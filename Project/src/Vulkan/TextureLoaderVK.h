@@ -0,0 +1,129 @@
+#pragma once
+#include "VulkanCommon.h"
+
+#include "Core/Spinlock.h"
+#include "Core/TaskDispatcher.h"
+
+#include <deque>
+#include <chrono>
+#include <string>
+#include <vector>
+
+class DeviceVK;
+class BufferVK;
+class ITexture2D;
+class Texture2DVK;
+class TextureCache;
+class CommandPoolVK;
+class CommandBufferVK;
+
+//Default cap on the memory used by images that have been read but not uploaded yet, the staging ring has the same size
+#define TEXTURE_LOADER_STAGING_SIZE		MB(64)
+//Upload batches that can be in flight on the GPU at the same time, each batch is one submission
+#define TEXTURE_LOADER_BATCH_COUNT		3U
+//Files that are read and decoded at the same time
+#define TEXTURE_LOADER_MAX_ACTIVE_READS	8U
+//Copies of block compressed images have to start at a multiple of the block size
+#define TEXTURE_LOADER_ALIGNMENT		16U
+
+struct StreamedTextureVK
+{
+	const ITexture2D* pTexture;
+	bool IsLoaded;
+};
+
+//Loads textures in three stages: the file is read on a background task, decoded on another background task and then packed
+//into a staging ring together with other textures so that a whole batch is uploaded with a single submission.
+//Reads are only started while the decoded images waiting for upload fit within the staging size, which bounds the memory in flight
+class TextureLoaderVK
+{
+	struct TextureRequest
+	{
+		Texture2DVK* pTexture;
+		std::string Filename;
+		ETextureFormat Format;
+		ETextureCompression Compression;
+		bool GenerateMips;
+	};
+
+	//A texture that is ready for upload, either decoded pixels or a block compressed mip chain
+	struct PreparedTexture
+	{
+		Texture2DVK* pTexture;
+		TextureCache* pCache;
+		void* pPixels;
+		uint64_t SizeInBytes;
+		uint32_t Width;
+		uint32_t Height;
+		ETextureFormat Format;
+		bool GenerateMips;
+		bool IsLoaded;
+	};
+
+	struct UploadBatch
+	{
+		CommandBufferVK* pCommandBuffer;
+		std::vector<const ITexture2D*> Textures;
+		//Head of the staging ring after the batch was recorded, everything before it is free once the batch is done
+		VkDeviceSize RingEnd;
+	};
+
+public:
+	TextureLoaderVK(DeviceVK* pDevice);
+	~TextureLoaderVK();
+
+	DECL_NO_COPY(TextureLoaderVK);
+
+	bool init(VkDeviceSize stagingSizeInBytes);
+
+	//Thread safe, the texture is reported by update once it can be sampled
+	void load(Texture2DVK* pTexture, const std::string& filename, ETextureFormat format, bool generateMips, ETextureCompression compression);
+	//Called once per frame from the render thread. Records and submits the textures that are ready, and appends the textures
+	//whose uploads have finished on the GPU or that failed to load to completedTextures
+	void update(std::vector<StreamedTextureVK>& completedTextures);
+
+private:
+	//Starts reading requested files for as long as the memory cap allows, m_Lock has to be held
+	void dispatchReads();
+	void readTexture(TextureRequest& request);
+	void decodeTexture(TextureRequest& request, const uint8_t* pFileData, uint64_t fileSize);
+	void pushPreparedTexture(const PreparedTexture& texture);
+	void releasePreparedTexture(PreparedTexture& texture);
+
+	void retireBatches(std::vector<StreamedTextureVK>& completedTextures);
+	//Creates the image, copies the texture into the ring and records the upload, returns false if the image could not be created
+	bool recordTexture(CommandBufferVK* pCommandBuffer, const PreparedTexture& texture, VkDeviceSize stagingOffset);
+	//Returns false when the ring does not have room for sizeInBytes right now
+	bool allocateStaging(VkDeviceSize sizeInBytes, VkDeviceSize& offset);
+
+	void logThroughput() const;
+
+private:
+	DeviceVK* m_pDevice;
+	BufferVK* m_pStagingBuffer;
+	uint8_t* m_pStagingMemory;
+	CommandPoolVK* m_pCommandPool;
+	UploadBatch m_Batches[TEXTURE_LOADER_BATCH_COUNT];
+	uint32_t m_FirstBatch;
+	uint32_t m_BatchesInFlight;
+
+	VkDeviceSize m_StagingSize;
+	VkDeviceSize m_RingHead;
+	VkDeviceSize m_RingTail;
+
+	//Guards the requests, the reads in flight, the prepared textures and the start of the throughput measurement
+	Spinlock m_Lock;
+	std::deque<TextureRequest> m_Requests;
+	std::deque<PreparedTexture> m_PreparedTextures;
+	uint64_t m_PreparedSizeInBytes;
+	uint32_t m_ActiveReads;
+	//Every read and decode task, the loader waits for them before it is destroyed since they write to its members
+	TaskGroup m_Tasks;
+
+	//Throughput since the loader last went idle
+	std::chrono::high_resolution_clock::time_point m_StartTime;
+	uint64_t m_UploadedSizeInBytes;
+	uint32_t m_UploadedTextureCount;
+	uint32_t m_SubmittedBatchCount;
+	bool m_IsIdle;
+};
@@ -157,6 +157,7 @@ void VolumetricLightRendererVK::beginFrame(IScene* pScene)
 	m_ppCommandBuffersBuildLight[frameIndex]->reset(false);
 	m_ppCommandPools[frameIndex]->reset();
 	m_pProfilerBuildBuffer->reset(frameIndex, m_pRenderingHandler->getCurrentGraphicsCommandBuffer());
+	m_pProfilerApplyBuffer->reset(frameIndex, m_pRenderingHandler->getCurrentGraphicsCommandBuffer());
 
 	VkCommandBufferInheritanceInfo inheritanceInfo = {};
 	inheritanceInfo.sType		= VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
@@ -204,7 +205,6 @@ void VolumetricLightRendererVK::applyLightBuffer(RenderPassVK* pRenderPass, Fram
 	uint32_t frameIndex = m_pRenderingHandler->getCurrentFrameIndex();
 
 	m_ppCommandBuffersApplyLight[frameIndex]->reset(false);
-	m_pProfilerApplyBuffer->reset(frameIndex, m_pRenderingHandler->getCurrentGraphicsCommandBuffer());
 
 	VkCommandBufferInheritanceInfo inheritanceInfo = {};
 	inheritanceInfo.sType		= VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
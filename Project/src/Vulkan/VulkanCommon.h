@@ -89,6 +89,9 @@ inline VkFormat convertFormat(ETextureFormat format)
     case ETextureFormat::FORMAT_R16G16_FLOAT:       return VK_FORMAT_R16G16_SFLOAT;
     case ETextureFormat::FORMAT_R16G16B16A16_FLOAT: return VK_FORMAT_R16G16B16A16_SFLOAT;
     case ETextureFormat::FORMAT_R32G32B32A32_FLOAT: return VK_FORMAT_R32G32B32A32_SFLOAT;
+    case ETextureFormat::FORMAT_BC1_RGB_UNORM:      return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+    case ETextureFormat::FORMAT_BC4_UNORM:          return VK_FORMAT_BC4_UNORM_BLOCK;
+    case ETextureFormat::FORMAT_BC5_UNORM:          return VK_FORMAT_BC5_UNORM_BLOCK;
     }
 
     return VK_FORMAT_UNDEFINED;
@@ -1,17 +1,64 @@
 #include "Common/Debug.h"
 #include "Core/Application.h"
+#include "Core/TaskDispatcherBenchmark.h"
+#include "Core/VertexWelderBenchmark.h"
+#include "Core/MeshOptimizerBenchmark.h"
+#include "Core/TangentGeneratorBenchmark.h"
+#include "Core/DynamicBVHBenchmark.h"
+#include "Core/MeshCache.h"
+
+#include <cstring>
 
 int main(int argc, const char* argv[])
 {
-	UNREFERENCED_PARAMETER(argc);
-	UNREFERENCED_PARAMETER(argv);
-
 #if defined(_DEBUG) && defined(_WIN32)
 	_CrtSetDbgFlag (_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 #endif
 
+	//Run the benchmarks instead of the application
+	if (argc > 1 && strcmp(argv[1], "--benchmark-tasks") == 0)
+	{
+		TaskDispatcherBenchmark::run();
+		return 0;
+	}
+	else if (argc > 1 && strcmp(argv[1], "--benchmark-welding") == 0)
+	{
+		VertexWelderBenchmark::run();
+		return 0;
+	}
+	else if (argc > 1 && strcmp(argv[1], "--benchmark-mesh-optimization") == 0)
+	{
+		MeshOptimizerBenchmark::run();
+		return 0;
+	}
+	else if (argc > 1 && strcmp(argv[1], "--benchmark-tangents") == 0)
+	{
+		TangentGeneratorBenchmark::run();
+		return 0;
+	}
+	else if (argc > 1 && strcmp(argv[1], "--benchmark-bvh") == 0)
+	{
+		DynamicBVHBenchmark::run();
+		return 0;
+	}
+
+	EVertexFormat vertexFormat = EVertexFormat::STANDARD;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--no-mesh-optimization") == 0)
+		{
+			//Runs the application with meshes in their original order, to compare the geometry pass against an optimised run
+			MeshCache::setOptimizationEnabled(false);
+		}
+		else if (strcmp(argv[i], "--packed-vertices") == 0)
+		{
+			//Loads the scene with 24 byte vertices instead of 64 byte vertices
+			vertexFormat = EVertexFormat::PACKED;
+		}
+	}
+
 	Application app;
-	app.init();
+	app.init(vertexFormat);
 	app.run();
 	app.release();
 	return 0;
@@ -0,0 +1,38 @@
+#include "Core/AssetArchive.h"
+
+#include <cstring>
+
+//Packs the assets directory into a single archive that the application mounts at startup:
+//AssetPacker [directory] [archive] [--no-compression]
+int main(int argc, const char* argv[])
+{
+	const char* pDirectory	= "assets";
+	const char* pArchive	= "assets" ASSET_ARCHIVE_EXTENSION;
+	bool allowCompression	= true;
+
+	uint32_t positionalCount = 0;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--no-compression") == 0)
+		{
+			allowCompression = false;
+		}
+		else if (positionalCount == 0)
+		{
+			pDirectory = argv[i];
+			positionalCount++;
+		}
+		else if (positionalCount == 1)
+		{
+			pArchive = argv[i];
+			positionalCount++;
+		}
+		else
+		{
+			LOG("Usage: AssetPacker [directory] [archive] [--no-compression]");
+			return 1;
+		}
+	}
+
+	return AssetArchive::pack(pDirectory, pArchive, allowCompression) ? 0 : 1;
+}